@@ -0,0 +1,28 @@
+# Find liburing
+# Find the liburing includes and library
+#
+#  LIBURING_INCLUDE_DIRS - where to find liburing.h, etc.
+#  LIBURING_LIBRARIES    - List of libraries when using liburing.
+#  LIBURING_FOUND        - True if liburing found.
+#
+# Based on the FindZLIB.cmake module.
+
+IF (LIBURING_INCLUDE_DIR)
+  # Already in cache, be silent
+  SET(LIBURING_FIND_QUIETLY TRUE)
+ENDIF (LIBURING_INCLUDE_DIR)
+
+FIND_PATH(LIBURING_INCLUDE_DIR liburing.h PATH_SUFFIXES include)
+
+SET(LIBURING_NAMES uring)
+FIND_LIBRARY(LIBURING_LIBRARY NAMES ${LIBURING_NAMES} )
+MARK_AS_ADVANCED( LIBURING_LIBRARY LIBURING_INCLUDE_DIR )
+
+# Per-recommendation
+SET(LIBURING_INCLUDE_DIRS "${LIBURING_INCLUDE_DIR}")
+SET(LIBURING_LIBRARIES    "${LIBURING_LIBRARY}")
+
+# handle the QUIETLY and REQUIRED arguments and set LIBURING_FOUND to TRUE if
+# all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LibUring DEFAULT_MSG LIBURING_LIBRARIES LIBURING_INCLUDE_DIRS)
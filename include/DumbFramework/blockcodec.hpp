@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_BLOCK_CODEC_
+#define _DUMB_FW_BLOCK_CODEC_
+
+#include <stddef.h>
+
+namespace Dumb {
+
+/**
+ * @brief Fast block compression.
+ *
+ * Byte oriented LZ77 compressor producing the LZ4 block format. A block
+ * is a sequence of literal runs followed by back references of at least
+ * 4 bytes within the last 64KB. There is no entropy coding, so
+ * decompression is mostly made of memory copies.
+ *
+ * Blocks are independent: a large buffer can be split into blocks that
+ * are decompressed in parallel or as they are needed.
+ */
+class BlockCodec
+{
+    public:
+        /**
+         * Worst case compressed size.
+         * @param [in] size  Uncompressed size in bytes.
+         */
+        static size_t bound(size_t size);
+        /**
+         * Compress block.
+         * @param [in]  src       Uncompressed data.
+         * @param [in]  size      Uncompressed size in bytes.
+         * @param [out] dst       Compressed data.
+         * @param [in]  capacity  Size of the @a dst buffer.
+         * @return Compressed size, or 0 if it does not fit in @a dst.
+         */
+        static size_t compress(unsigned char const* src, size_t size, unsigned char* dst, size_t capacity);
+        /**
+         * Decompress block.
+         * Malformed input never reads or writes out of the buffers.
+         * @param [in]  src   Compressed data.
+         * @param [in]  size  Compressed size in bytes.
+         * @param [out] dst   Uncompressed data.
+         * @param [in]  len   Uncompressed size in bytes.
+         * @return false if the block is malformed or if it does not
+         *         decompress to exactly @a len bytes.
+         */
+        static bool decompress(unsigned char const* src, size_t size, unsigned char* dst, size_t len);
+};
+
+} // Dumb
+
+#endif /* _DUMB_FW_BLOCK_CODEC_ */
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <string>
+#include <vector>
 
 namespace Dumb {
 
@@ -26,6 +27,11 @@ namespace Dumb {
  * @brief File wrapper.
  * 
  * This is mainly a wrapper around the POSIX stream functions.
+ *
+ * Files opened in @a READ_ONLY mode are first looked up in the mounted
+ * packs (see Pack::mount). A packed file is read from the archive
+ * mapping and is always mapped. File::sync and File::flush fail on
+ * packed files.
  */
 class File
 {
@@ -92,6 +98,20 @@ class File
             END
         };
 
+        /**
+         * Memory access hints.
+         * Tell the system how the content of a mapped file will be read.
+         */
+        enum Access
+        {
+            /** No particular access pattern. **/
+            NORMAL,
+            /** The content will be read from start to end. **/
+            SEQUENTIAL,
+            /** The content will be read in random order. **/
+            RANDOM
+        };
+
     public:
         /** 
          * @brief Default constructor. 
@@ -178,10 +198,17 @@ class File
 
         /** @brief Check if the file is opened. */
         bool isOpened () const;
+        /** @brief Check if the file is read from a mounted pack. */
+        bool isPacked () const;
 
         /** @brief Get filename. */
         std::string const& name () const;
-        /** @brief Get file size in bytes. */
+        /**
+         * @brief Get file size in bytes.
+         *
+         * The size is retrieved with @c fstat. If the file was opened
+         * in @a READ_ONLY mode, it is only retrieved once.
+         */
         size_t size () const;
         /** @brief Get current file offset in bytes. */
         off_t tell () const;
@@ -232,7 +259,51 @@ class File
          * @return true if we reached the end of the file.
          */
         bool eof();
+
+        /**
+         * @brief Flush stream buffer.
+         *
+         * Hand buffered data over to the operating system.
+         * @return true if the buffer was successfully flushed.
+         */
+        bool flush();
+
+        /**
+         * @brief Synchronize file to storage.
+         *
+         * Flush stream buffer and wait until the data reached the
+         * storage device.
+         * @return true if the file was successfully synchronized.
+         */
+        bool sync();
     
+        /**
+         * @brief Map file content in memory.
+         *
+         * Give read-only access to the whole file content through
+         * File::data. On unix platforms, the file is mapped with
+         * @c mmap and @a access is passed to @c madvise. The content
+         * is then read directly from the page cache. If the file can
+         * not be mapped (unsupported platform, pipe, special file...),
+         * it is read into an internal buffer instead.
+         * The file must be opened in @a READ_ONLY mode. The content
+         * remains valid until File::unmap or File::close is called
+         * (File::close only for packed files).
+         * @param [in] access Expected access pattern.
+         * @return true if the file content is available.
+         */
+        bool map(File::Access access=File::SEQUENTIAL);
+        /** @brief Release the mapped file content. */
+        void unmap();
+        /** @brief Check if the file content is mapped. */
+        bool isMapped() const;
+        /**
+         * @brief Get mapped file content.
+         * @return Pointer to the File::size bytes of the file, or NULL
+         * if the file is not mapped.
+         */
+        unsigned char const* data() const;
+
         /**
          * @brief Return the current working directory.
          * @return Current working directory.
@@ -244,11 +315,30 @@ class File
          */
         static std::string executableDirectory();
         
+    protected:
+        /**
+         * @brief Read the whole file into the mapping buffer.
+         * @return true if the file was successfully read.
+         */
+        bool copy();
+        /**
+         * @brief Look the file up in the mounted packs.
+         * @return true if a mounted pack contains the file.
+         */
+        bool openPacked();
+
     protected:
         FILE *_handle;         /**< Handle. */
         File::OpenMode _mode;  /**< Open mode. */
         char _modeString[4];   /**< Open mode string. */
         std::string _filename; /**< Filename. */
+        mutable off_t _size;   /**< Cached file size, or -1. */
+        unsigned char const *_data; /**< Mapped content. */
+        size_t _dataSize;      /**< Mapped content size. */
+        bool _memoryMapped;    /**< Tell if the content was mapped by the system. */
+        std::vector<unsigned char> _buffer; /**< Content copy when the file can not be mapped. */
+        bool _packed;          /**< Tell if the file is read from a pack. */
+        size_t _position;      /**< Packed file offset. */
 };
 
 } // Dumb
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_FLIGHT_RECORDER_
+#define _DUMB_FW_FLIGHT_RECORDER_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <DumbFramework/log.hpp>
+
+namespace Dumb {
+namespace Log  {
+    /**
+     * @brief Crash-safe log output.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Keep the last messages in a circular buffer mapped to a file.
+     * As the mapping is shared, everything written to it reaches the
+     * page cache immediately and survives a crash of the process.
+     *
+     * Writers reserve room in the ring by atomically advancing its head
+     * and then copy the message. An entry is made of a small header
+     * (size, checksum, absolute position and timestamp) followed by
+     * the message. The position is written last and acts as a commit
+     * marker. FlightRecorder::read uses it to skip entries that were
+     * being written or overwritten when the process died.
+     *
+     * FlightRecorder::write is thread safe. The log processor calls it
+     * directly from the emitting threads instead of queueing messages
+     * (see OutputPolicyBase::concurrent).
+     *
+     * @note Only available on unix platforms.
+     */
+    class FlightRecorder : public OutputPolicyBase
+    {
+        public:
+            /** Default ring size in bytes. **/
+            static const size_t DefaultCapacity;
+
+            /** Message read back from a ring file. **/
+            struct Entry
+            {
+                /** Absolute position of the entry in the ring. **/
+                uint64_t    position;
+                /** Wall clock time in nanoseconds since epoch. **/
+                uint64_t    timestamp;
+                /** Message. **/
+                std::string message;
+            };
+
+        public:
+            /**
+             * Constructor.
+             * @param [in] filename  Ring file name.
+             * @param [in] capacity  Ring size in bytes. It is rounded up
+             *                       to the next power of two.
+             */
+            FlightRecorder(std::string const & filename, size_t capacity=DefaultCapacity);
+            /** Destructor. **/
+            ~FlightRecorder();
+            /**
+             * Create and map ring file.
+             * If the file already exists, it is first renamed to
+             * @b filename.1 so that the messages of the previous run
+             * are kept.
+             * @return false if the file could not be created.
+             */
+            bool setup();
+            /** Synchronize and unmap ring file. **/
+            void teardown();
+            /**
+             * Append message to the ring.
+             * @param [in] msg Log message.
+             * @return false if the ring is not mapped.
+             */
+            bool write(std::string & msg);
+            /** Messages are written by the emitting threads. **/
+            bool concurrent() const;
+            /**
+             * Append message to the ring.
+             * Messages larger than a quarter of the ring are truncated.
+             * @param [in] msg        Message.
+             * @param [in] len        Message length.
+             * @param [in] timestamp  Message timestamp.
+             * @return false if the ring is not mapped.
+             */
+            bool append(char const* msg, size_t len, uint64_t timestamp);
+            /** Ring file name. **/
+            std::string const & filename() const;
+            /** Ring size in bytes. **/
+            size_t capacity() const;
+
+            /**
+             * Read messages from a ring file.
+             * Messages are returned from the oldest to the newest.
+             * Incomplete or overwritten entries are skipped.
+             * @param [in]  filename  Ring file name.
+             * @param [out] entries   Messages.
+             * @return false if the file is not a valid ring file.
+             */
+            static bool read(std::string const & filename, std::vector<Entry> & entries);
+
+        private:
+            FlightRecorder(FlightRecorder const &);
+            FlightRecorder& operator= (FlightRecorder const &);
+
+        private:
+            std::string _filename; /**< Ring file name. **/
+            size_t      _capacity; /**< Ring size. **/
+            int         _fd;       /**< File descriptor. **/
+            size_t      _length;   /**< Mapping size. **/
+            char       *_map;      /**< Mapped file. **/
+            char       *_data;     /**< Ring start. **/
+    };
+
+} // Log
+} // Dumb
+
+#endif /* _DUMB_FW_FLIGHT_RECORDER_ */
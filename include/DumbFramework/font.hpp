@@ -686,7 +686,7 @@ namespace Dumb {
                  * @param [in] oversample Oversampled set.
                  * @param [in] font Font file data.
                  */
-                void packOversample(stbtt_pack_context &context, const Oversample &oversample, char *font);
+                void packOversample(stbtt_pack_context &context, const Oversample &oversample, const unsigned char *font);
             private:
                 /**
                  * Font atlas texture identifier.
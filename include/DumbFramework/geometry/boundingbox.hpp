@@ -82,6 +82,13 @@ class BoundingBox
          *  @param [in] ray Ray to be tested.
          */
         bool intersects(Ray3 const& ray);
+        /** Check if the current bounding box intersects the specified ray
+         *  and compute the entry distance.
+         *  @param [in]  ray      Ray to be tested.
+         *  @param [out] distance Distance from the ray origin to the entry
+         *                        point (0 if the origin is inside the box).
+         */
+        bool intersects(Ray3 const& ray, float& distance) const;
         /** Tell on which side of the specified plane the current bounding box is.
          *  @param [in] plane Plane.
          */
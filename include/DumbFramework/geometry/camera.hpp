@@ -21,12 +21,17 @@
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/dual_quaternion.hpp>
 
+#include <DumbFramework/geometry/frustum.hpp>
+
 namespace Dumb     {
 namespace Core     {
 namespace Geometry {
 
 /**
  * Camera.
+ * View, projection and frustum are computed on demand and cached until
+ * the camera or the screen size changes. As the cache is updated from
+ * const accessors, a camera must not be shared between threads.
  */
 class Camera
 {
@@ -60,14 +65,30 @@ class Camera
          */
         void perspective(float fovy, float near, float far);
         /**
-         * Compute view matrix.
+         * Set camera position and orientation.
+         * @param [in] eye           Camera position.
+         * @param [in] orientation   Camera orientation.
+         */
+        void place(glm::vec3 const& eye, glm::fquat const& orientation);
+        /**
+         * View matrix.
+         */
+        glm::mat4 const& viewMatrix() const;
+        /**
+         * Projection matrix for a given screen size.
+         * @param [in] size    Screen size.
+         */
+        glm::mat4 const& projectionMatrix(glm::ivec2 const& size) const;
+        /**
+         * View projection matrix for a given screen size.
+         * @param [in] size    Screen size.
          */
-        glm::mat4 viewMatrix() const;
+        glm::mat4 const& viewProjectionMatrix(glm::ivec2 const& size) const;
         /**
-         * Compute projection matrix for a given screen size.
+         * View frustum for a given screen size.
          * @param [in] size    Screen size.
          */
-        glm::mat4 projectionMatrix(glm::ivec2 const& size) const;
+        Frustum const& frustum(glm::ivec2 const& size) const;
         /**
          * Compute screen space position for a given screen size.
          * @param [in] world   World position.
@@ -75,7 +96,29 @@ class Camera
          * @return Screen position between [-1, 1].
          */
         glm::vec3 screenPosition(glm::vec3 const& world, glm::ivec2 const& size) const;
+        /**
+         * Compute screen space positions of a point list for a given
+         * screen size.
+         * @param [in]  world     World positions.
+         * @param [in]  count     Number of positions.
+         * @param [in]  size      Screen size.
+         * @param [out] screen    Screen positions between [-1, 1].
+         * @param [out] visible   Set to 1 if the point is in front of the
+         *                        camera and on screen, 0 otherwise.
+         * @return Number of visible points.
+         */
+        size_t screenPositions(glm::vec3 const* world, size_t count, glm::ivec2 const& size, glm::vec3* screen, uint8_t* visible) const;
         
+        /** Position. **/
+        glm::vec3 const& eye() const;
+        /** Orientation. **/
+        glm::fquat const& orientation() const;
+        /** Field of view. **/
+        float fov() const;
+        /** Near plane distance. **/
+        float near() const;
+        /** Far plane distance. **/
+        float far() const;
         /** Forward vector. **/
         glm::vec3 forward() const;
         /** Up vector. **/
@@ -83,17 +126,45 @@ class Camera
         /** Right vector. **/
         glm::vec3 right() const;
         
-    public:
+    private:
+        /** Update cached view matrix. **/
+        void updateView() const;
+        /** Update cached matrices and frustum. **/
+        void update(glm::ivec2 const& size) const;
+        
+    private:
+        /** Cache state. **/
+        enum
+        {
+            /** View matrix is outdated. **/
+            VIEW_DIRTY       = 1,
+            /** Projection matrix is outdated. **/
+            PROJECTION_DIRTY = 2,
+            /** View projection matrix and frustum are outdated. **/
+            FRUSTUM_DIRTY    = 4
+        };
         /** Position. **/
-        glm::vec3 eye;
+        glm::vec3 _eye;
         /** Orientation. **/
-        glm::fquat orientation;
+        glm::fquat _orientation;
         /** Field of view. **/
-        float fov;
+        float _fov;
         /** Near plane distance. **/
-        float near;
+        float _near;
         /** Far plane distance. **/
-        float far;
+        float _far;
+        /** Outdated cached values. **/
+        mutable int _dirty;
+        /** Screen size used for cached projection. **/
+        mutable glm::ivec2 _size;
+        /** Cached view matrix. **/
+        mutable glm::mat4 _view;
+        /** Cached projection matrix. **/
+        mutable glm::mat4 _projection;
+        /** Cached view projection matrix. **/
+        mutable glm::mat4 _viewProjection;
+        /** Cached frustum. **/
+        mutable Frustum _frustum;
 };
 
 } // Geometry
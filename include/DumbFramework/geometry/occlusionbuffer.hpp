@@ -0,0 +1,166 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_OCCLUSION_BUFFER_
+#define _DUMBFRAMEWORK_OCCLUSION_BUFFER_
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <DumbFramework/geometry/camera.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * Software occlusion buffer.
+ * Occluder triangles are rasterized on the CPU into a low resolution
+ * depth buffer. A coarse level holds the farthest depth of each 8x8
+ * pixel block, so most occludees are rejected without reading the full
+ * resolution buffer.
+ * Depth values are normalized device depth in [0, 1] (1 being the far
+ * plane). Pixel row 0 is the bottom of the screen.
+ * 
+ * The screen is split into tiles. Triangles are binned per tile when
+ * they are added, and each tile can then be rasterized independently:
+ * @code
+ * buffer.setup(camera, screenSize);
+ * buffer.clear();
+ * buffer.add(vertices, vertexCount, indices, triangleCount, model);
+ * // Dispatch buffer.rasterize(tile) over [0, buffer.tileCount()).
+ * bool draw = buffer.visible(box);
+ * @endcode
+ */
+class OcclusionBuffer
+{
+    public:
+        /** Size of the coarse depth blocks. **/
+        enum { BlockSize = 8 };
+        
+    public:
+        /**
+         * Constructor.
+         * @param [in] size     Buffer size. It is rounded up to a multiple of
+         *                      the tile size.
+         * @param [in] tileSize Tile size. It is rounded up to a multiple of
+         *                      the block size.
+         */
+        OcclusionBuffer(glm::ivec2 const& size=glm::ivec2(256, 128), glm::ivec2 const& tileSize=glm::ivec2(64, 32));
+        /**
+         * Destructor.
+         */
+        ~OcclusionBuffer();
+        /**
+         * Set view projection matrix.
+         * @param [in] viewProjection View projection matrix.
+         */
+        void setup(glm::mat4 const& viewProjection);
+        /**
+         * Set view projection matrix from camera.
+         * @param [in] camera Camera.
+         * @param [in] screen Screen size (used for the aspect ratio).
+         */
+        void setup(Camera const& camera, glm::ivec2 const& screen);
+        /**
+         * Clear depth buffer and remove all occluders.
+         */
+        void clear();
+        /**
+         * Add occluder mesh.
+         * Triangles are transformed, clipped against the near plane and
+         * binned. They are rasterized by the next call to rasterize.
+         * @param [in] vertices      Vertex positions.
+         * @param [in] vertexCount   Number of vertices.
+         * @param [in] indices       Triangle indices.
+         * @param [in] triangleCount Number of triangles.
+         * @param [in] model         Model matrix.
+         * @param [in] stride        Offset in floats between consecutive vertices.
+         */
+        void add(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount, glm::mat4 const& model, size_t stride=0);
+        /**
+         * Number of tiles.
+         */
+        size_t tileCount() const;
+        /**
+         * Rasterize the triangles binned into a tile.
+         * Different tiles can be rasterized concurrently.
+         * @param [in] tile Tile index.
+         */
+        void rasterize(size_t tile);
+        /**
+         * Rasterize all tiles.
+         */
+        void rasterize();
+        /**
+         * Test if a bounding box may be visible.
+         * Boxes crossing the near plane are considered visible.
+         * @param [in] box World space bounding box.
+         * @return false if the box is hidden by the occluders or outside
+         *         of the screen.
+         */
+        bool visible(BoundingBox const& box) const;
+        /**
+         * Buffer size.
+         */
+        glm::ivec2 const& size() const;
+        /**
+         * Retrieve pixel depth.
+         * @param [in] x Column.
+         * @param [in] y Row.
+         */
+        float depth(int x, int y) const;
+        
+    private:
+        /** Screen space triangle. **/
+        struct Triangle
+        {
+            /** Edge functions (a*x + b*y + c). **/
+            float a[3], b[3], c[3];
+            /** Depth plane. **/
+            float za, zb, zc;
+            /** Pixel bounds. **/
+            int x0, y0, x1, y1;
+        };
+        
+        /** Setup and bin a clip space triangle. **/
+        void bin(glm::vec4 const& v0, glm::vec4 const& v1, glm::vec4 const& v2);
+        
+    private:
+        /** Buffer size. **/
+        glm::ivec2 _size;
+        /** Tile size. **/
+        glm::ivec2 _tileSize;
+        /** Number of tiles per row and column. **/
+        glm::ivec2 _tiles;
+        /** View projection matrix. **/
+        glm::mat4 _viewProjection;
+        /** Depth buffer. **/
+        std::vector<float> _depth;
+        /** Farthest depth of each block. **/
+        std::vector<float> _coarse;
+        /** Triangles. **/
+        std::vector<Triangle> _triangles;
+        /** Triangles per tile. **/
+        std::vector<std::vector<uint32_t>> _bins;
+};
+
+} // Geometry
+} // Core
+} // Dumb
+
+#endif // _DUMBFRAMEWORK_OCCLUSION_BUFFER_
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_POINT_CLOUD_
+#define _DUMBFRAMEWORK_POINT_CLOUD_
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#include <DumbFramework/geometry/plane.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * @brief Point cloud kernels.
+ * 
+ * These functions operate on strided point arrays. Points are processed
+ * by blocks of PointCloud::Lanes elements which are first gathered into
+ * SoA registers. The per-lane loops are branchless so that the compiler
+ * can turn them into vector instructions.
+ *
+ * Unlike the bounding volume methods, @a stride is always expressed in
+ * bytes and is the offset between the beginning of two consecutive points.
+ */
+namespace PointCloud
+{
+    /** Number of points processed at once. **/
+    enum { Lanes = 8 };
+
+    /** Compute the bounds of a 3D point array.
+     *  @param [in]  buffer Pointer to the point array.
+     *  @param [in]  count  Number of points.
+     *  @param [in]  stride Offset in bytes between two consecutive points.
+     *  @param [out] pmin   Minimum point.
+     *  @param [out] pmax   Maximum point.
+     */
+    void bounds(const uint8_t* buffer, size_t count, size_t stride, glm::vec3& pmin, glm::vec3& pmax);
+    /** Compute the bounds of a 2D point array.
+     *  @param [in]  buffer Pointer to the point array.
+     *  @param [in]  count  Number of points.
+     *  @param [in]  stride Offset in bytes between two consecutive points.
+     *  @param [out] pmin   Minimum point.
+     *  @param [out] pmax   Maximum point.
+     */
+    void bounds(const uint8_t* buffer, size_t count, size_t stride, glm::vec2& pmin, glm::vec2& pmax);
+    /** Count the number of 3D points inside an axis aligned box (boundaries included).
+     *  @param [in] buffer Pointer to the point array.
+     *  @param [in] count  Number of points.
+     *  @param [in] stride Offset in bytes between two consecutive points.
+     *  @param [in] bmin   Box minimum point.
+     *  @param [in] bmax   Box maximum point.
+     */
+    size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec3 const& bmin, glm::vec3 const& bmax);
+    /** Count the number of 2D points inside an axis aligned quad (boundaries included).
+     *  @param [in] buffer Pointer to the point array.
+     *  @param [in] count  Number of points.
+     *  @param [in] stride Offset in bytes between two consecutive points.
+     *  @param [in] bmin   Quad minimum point.
+     *  @param [in] bmax   Quad maximum point.
+     */
+    size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec2 const& bmin, glm::vec2 const& bmax);
+    /** Count the number of 3D points inside a sphere (boundary included).
+     *  @param [in] buffer       Pointer to the point array.
+     *  @param [in] count        Number of points.
+     *  @param [in] stride       Offset in bytes between two consecutive points.
+     *  @param [in] center       Sphere center.
+     *  @param [in] squareRadius Sphere squared radius.
+     */
+    size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec3 const& center, float squareRadius);
+    /** Count the number of 2D points inside a circle (boundary included).
+     *  @param [in] buffer       Pointer to the point array.
+     *  @param [in] count        Number of points.
+     *  @param [in] stride       Offset in bytes between two consecutive points.
+     *  @param [in] center       Circle center.
+     *  @param [in] squareRadius Circle squared radius.
+     */
+    size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec2 const& center, float squareRadius);
+    /** Count the number of 3D points that are not behind any of the specified planes.
+     *  A point is behind a plane if its distance is less than -epsilon
+     *  (see Plane::classify).
+     *  @param [in] buffer     Pointer to the point array.
+     *  @param [in] count      Number of points.
+     *  @param [in] stride     Offset in bytes between two consecutive points.
+     *  @param [in] planes     Plane array.
+     *  @param [in] planeCount Number of planes.
+     */
+    size_t countInside(const uint8_t* buffer, size_t count, size_t stride, Plane const* planes, size_t planeCount);
+    /** Compute a bounding sphere of a 3D point array.
+     *  The initial sphere is built from the most distant pair of extreme
+     *  points along 7 directions (EPOS-14). It is then grown to enclose
+     *  all the points (Ritter).
+     *  @param [in]  buffer Pointer to the point array.
+     *  @param [in]  count  Number of points.
+     *  @param [in]  stride Offset in bytes between two consecutive points.
+     *  @param [out] center Sphere center.
+     *  @param [out] radius Sphere radius.
+     */
+    void boundingSphere(const uint8_t* buffer, size_t count, size_t stride, glm::vec3& center, float& radius);
+    /** Compute a bounding circle of a 2D point array.
+     *  Same as PointCloud::boundingSphere with 4 directions (EPOS-8).
+     *  @param [in]  buffer Pointer to the point array.
+     *  @param [in]  count  Number of points.
+     *  @param [in]  stride Offset in bytes between two consecutive points.
+     *  @param [out] center Circle center.
+     *  @param [out] radius Circle radius.
+     */
+    void boundingCircle(const uint8_t* buffer, size_t count, size_t stride, glm::vec2& center, float& radius);
+} // PointCloud
+
+} // Geometry
+} // Core
+} // Dumb
+
+#endif // _DUMBFRAMEWORK_POINT_CLOUD_
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_RAY_PACKET_
+#define _DUMBFRAMEWORK_RAY_PACKET_
+
+#include <sys/types.h>
+#include <glm/glm.hpp>
+
+#include <DumbFramework/geometry/ray.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * Packet of N 3 dimensional rays.
+ * Rays are stored in SoA layout (one array per component) so that
+ * the slab tests process all the lanes in a single pass.
+ * @param N Number of lanes (typically 4 or 8).
+ */
+template <unsigned int N>
+struct RayPacket
+{
+    /** Number of lanes. **/
+    enum { Width = N };
+    /** Constructor. 
+     *  All lanes are inactive.
+     */
+    RayPacket();
+    /** Constructor.
+     *  @param [in] rays  Ray array.
+     *  @param [in] count Number of rays (at most N).
+     */
+    RayPacket(Ray3 const* rays, unsigned int count);
+    /** Set ray and activate the associated lane.
+     *  @param [in] lane Lane index.
+     *  @param [in] ray  Ray.
+     */
+    void set(unsigned int lane, Ray3 const& ray);
+    /** Retrieve ray.
+     *  @param [in] lane Lane index.
+     */
+    Ray3 get(unsigned int lane) const;
+
+    /** Origins **/
+    float origin[3][N];
+    /** Directions **/
+    float direction[3][N];
+    /** Inverse of directions. **/
+    float inverseDirection[3][N];
+    /** Active lanes (bit i is set if lane i is active). **/
+    unsigned int mask;
+};
+
+/** 4 rays packet. **/
+typedef RayPacket<4> RayPacket4;
+/** 8 rays packet. **/
+typedef RayPacket<8> RayPacket8;
+
+/** Check which rays of the packet intersect the specified bounding box.
+ *  @param [in]  box      Bounding box.
+ *  @param [in]  packet   Ray packet.
+ *  @param [out] distance Entry distance for each lane (0 if the ray origin
+ *                        is inside the box, max float if there is no hit).
+ *  @return Hit mask (bit i is set if lane i hit the box).
+ */
+template <unsigned int N>
+unsigned int intersects(BoundingBox const& box, RayPacket<N> const& packet, float* distance);
+/** Find the nearest bounding box hit by each ray of the packet.
+ *  @param [in]  boxes    Bounding box array.
+ *  @param [in]  count    Number of bounding boxes.
+ *  @param [in]  packet   Ray packet.
+ *  @param [out] index    Index of the nearest box hit by each lane (-1 if none).
+ *  @param [out] distance Entry distance for each lane (max float if none).
+ *  @return Hit mask (bit i is set if lane i hit at least one box).
+ */
+template <unsigned int N>
+unsigned int intersects(BoundingBox const* boxes, size_t count, RayPacket<N> const& packet, int* index, float* distance);
+/** Find the nearest bounding box hit by the specified ray.
+ *  This is the scalar version of the packet traversal.
+ *  @param [in]  boxes    Bounding box array.
+ *  @param [in]  count    Number of bounding boxes.
+ *  @param [in]  ray      Ray.
+ *  @param [out] index    Index of the nearest box (-1 if none).
+ *  @param [out] distance Entry distance (max float if none).
+ *  @return true if the ray hit at least one box.
+ */
+bool intersects(BoundingBox const* boxes, size_t count, Ray3 const& ray, int& index, float& distance);
+
+} // Geometry
+} // Core
+} // Dumb
+
+#include "raypacket.inl"
+
+#endif // _DUMBFRAMEWORK_RAY_PACKET_
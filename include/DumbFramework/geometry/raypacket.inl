@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <limits>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/** Constructor. 
+ *  All lanes are inactive.
+ */
+template <unsigned int N>
+RayPacket<N>::RayPacket()
+    : mask(0)
+{
+    for(unsigned int j=0; j<3; j++)
+    {
+        for(unsigned int i=0; i<N; i++)
+        {
+            origin[j][i] = direction[j][i] = 0.0f;
+            inverseDirection[j][i] = std::numeric_limits<float>::infinity();
+        }
+    }
+}
+/** Constructor.
+ *  @param [in] rays  Ray array.
+ *  @param [in] count Number of rays (at most N).
+ */
+template <unsigned int N>
+RayPacket<N>::RayPacket(Ray3 const* rays, unsigned int count)
+    : RayPacket()
+{
+    if(count > N) { count = N; }
+    for(unsigned int i=0; i<count; i++)
+    {
+        set(i, rays[i]);
+    }
+}
+/** Set ray and activate the associated lane.
+ *  @param [in] lane Lane index.
+ *  @param [in] ray  Ray.
+ */
+template <unsigned int N>
+void RayPacket<N>::set(unsigned int lane, Ray3 const& ray)
+{
+    for(unsigned int j=0; j<3; j++)
+    {
+        origin[j][lane]           = ray.origin[j];
+        direction[j][lane]        = ray.direction[j];
+        inverseDirection[j][lane] = 1.0f / ray.direction[j];
+    }
+    mask |= 1 << lane;
+}
+/** Retrieve ray.
+ *  @param [in] lane Lane index.
+ */
+template <unsigned int N>
+Ray3 RayPacket<N>::get(unsigned int lane) const
+{
+    Ray3 ray;
+    ray.origin    = glm::vec3(origin[0][lane], origin[1][lane], origin[2][lane]);
+    ray.direction = glm::vec3(direction[0][lane], direction[1][lane], direction[2][lane]);
+    return ray;
+}
+
+/** Check which rays of the packet intersect the specified bounding box.
+ *  @param [in]  box      Bounding box.
+ *  @param [in]  packet   Ray packet.
+ *  @param [out] distance Entry distance for each lane (0 if the ray origin
+ *                        is inside the box, max float if there is no hit).
+ *  @return Hit mask (bit i is set if lane i hit the box).
+ */
+template <unsigned int N>
+unsigned int intersects(BoundingBox const& box, RayPacket<N> const& packet, float* distance)
+{
+    glm::vec3 const& bmin = box.getMin();
+    glm::vec3 const& bmax = box.getMax();
+
+    float tmin[N], tmax[N];
+    for(unsigned int i=0; i<N; i++)
+    {
+        tmin[i] = 0.0f;
+        tmax[i] = std::numeric_limits<float>::max();
+    }
+    // Slab tests. The inner loops are branchless so that the compiler
+    // can map them to vector instructions.
+    for(unsigned int j=0; j<3; j++)
+    {
+        float const* o   = packet.origin[j];
+        float const* inv = packet.inverseDirection[j];
+        for(unsigned int i=0; i<N; i++)
+        {
+            float t0 = (bmin[j] - o[i]) * inv[i];
+            float t1 = (bmax[j] - o[i]) * inv[i];
+            float tnear = (t0 < t1) ? t0 : t1;
+            float tfar  = (t0 < t1) ? t1 : t0;
+            tmin[i] = (tnear > tmin[i]) ? tnear : tmin[i];
+            tmax[i] = (tfar  < tmax[i]) ? tfar  : tmax[i];
+        }
+    }
+    unsigned int hit = 0;
+    for(unsigned int i=0; i<N; i++)
+    {
+        bool h = (tmin[i] <= tmax[i]);
+        distance[i] = h ? tmin[i] : std::numeric_limits<float>::max();
+        hit |= (h ? 1 : 0) << i;
+    }
+    return hit & packet.mask;
+}
+/** Find the nearest bounding box hit by each ray of the packet.
+ *  @param [in]  boxes    Bounding box array.
+ *  @param [in]  count    Number of bounding boxes.
+ *  @param [in]  packet   Ray packet.
+ *  @param [out] index    Index of the nearest box hit by each lane (-1 if none).
+ *  @param [out] distance Entry distance for each lane (max float if none).
+ *  @return Hit mask (bit i is set if lane i hit at least one box).
+ */
+template <unsigned int N>
+unsigned int intersects(BoundingBox const* boxes, size_t count, RayPacket<N> const& packet, int* index, float* distance)
+{
+    float current[N];
+    unsigned int hit = 0;
+    for(unsigned int i=0; i<N; i++)
+    {
+        index[i]    = -1;
+        distance[i] = std::numeric_limits<float>::max();
+    }
+    for(size_t k=0; k<count; k++)
+    {
+        unsigned int h = intersects(boxes[k], packet, current);
+        if(0 == h) { continue; }
+        for(unsigned int i=0; i<N; i++)
+        {
+            bool closer = ((h >> i) & 1) && (current[i] < distance[i]);
+            distance[i] = closer ? current[i] : distance[i];
+            index[i]    = closer ? (int)k : index[i];
+        }
+        hit |= h;
+    }
+    return hit;
+}
+
+} // Geometry
+} // Core
+} // Dumb
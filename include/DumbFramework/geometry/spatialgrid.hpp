@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_SPATIAL_GRID_
+#define _DUMBFRAMEWORK_SPATIAL_GRID_
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+
+#include <DumbFramework/geometry/ray.hpp>
+#include <DumbFramework/geometry/boundingquad.hpp>
+#include <DumbFramework/geometry/boundingcircle.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * 2D hashed uniform grid.
+ * Objects are stored as axis aligned quads in every cell they overlap.
+ * Cells are hashed into a fixed number of buckets, so the grid is
+ * unbounded. Moving an object without leaving its cells only updates
+ * its bounds.
+ */
+class SpatialGrid
+{
+    public:
+        /** Invalid object identifier. **/
+        static const size_t None;
+        
+    public:
+        /**
+         * Constructor.
+         * @param [in] cellSize    Cell size.
+         * @param [in] bucketCount Number of hash buckets. It is rounded
+         *                         up to the next power of 2.
+         */
+        SpatialGrid(float cellSize, size_t bucketCount=4096);
+        /**
+         * Destructor.
+         */
+        ~SpatialGrid();
+        /**
+         * Insert object.
+         * @param [in] quad Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingQuad const& quad);
+        /**
+         * Insert object.
+         * @param [in] circle Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingCircle const& circle);
+        /**
+         * Update object bounds.
+         * Unknown or removed objects are ignored.
+         * @param [in] id   Object identifier.
+         * @param [in] quad New bounds.
+         */
+        void move(size_t id, BoundingQuad const& quad);
+        /**
+         * Update object bounds.
+         * Unknown or removed objects are ignored.
+         * @param [in] id     Object identifier.
+         * @param [in] circle New bounds.
+         */
+        void move(size_t id, BoundingCircle const& circle);
+        /**
+         * Remove object.
+         * Its identifier may be reused by later insertions.
+         * @param [in] id Object identifier.
+         */
+        void remove(size_t id);
+        /**
+         * Remove all objects.
+         */
+        void clear();
+        /**
+         * Number of objects.
+         */
+        size_t size() const;
+        /**
+         * Find the objects overlapping a quad.
+         * @param [in]  quad Query region.
+         * @param [out] out  Object identifiers. Results are appended.
+         * @return Number of objects found.
+         */
+        size_t query(BoundingQuad const& quad, std::vector<size_t>& out) const;
+        /**
+         * Find the objects overlapping a circle.
+         * @param [in]  circle Query region.
+         * @param [out] out    Object identifiers. Results are appended.
+         * @return Number of objects found.
+         */
+        size_t query(BoundingCircle const& circle, std::vector<size_t>& out) const;
+        /**
+         * Find the objects crossed by a segment.
+         * Objects already reported are tracked with visit marks stored
+         * in the grid. Unlike the other queries, it must not run
+         * concurrently with any other call on the same grid.
+         * @param [in]  ray    Segment origin and direction.
+         * @param [in]  length Segment length, expressed in ray direction units.
+         *                     It must be finite.
+         * @param [out] out    Object identifiers, in traversal order.
+         *                     Results are appended.
+         * @return Number of objects found.
+         */
+        size_t query(Ray2 const& ray, float length, std::vector<size_t>& out);
+        /**
+         * Find all overlapping pairs.
+         * Each pair is reported once as (a, b) with a < b, and the list
+         * is sorted.
+         * @param [out] out Overlapping pairs. The list is cleared first.
+         * @return Number of pairs.
+         */
+        size_t pairs(std::vector<std::pair<size_t, size_t>>& out) const;
+        
+    private:
+        /** Cell range. **/
+        struct Range
+        {
+            int32_t x0, y0, x1, y1;
+        };
+        /** Bucket entry. **/
+        struct Entry
+        {
+            int32_t  x, y;
+            uint32_t id;
+        };
+        
+        /** Compute cell range. **/
+        Range cells(glm::vec2 const& bmin, glm::vec2 const& bmax) const;
+        /** Bucket index of a cell. **/
+        size_t bucket(int32_t x, int32_t y) const;
+        /** Add object to cells. **/
+        void link(uint32_t id, Range const& range);
+        /** Remove object from cells. **/
+        void unlink(uint32_t id, Range const& range);
+        
+    private:
+        /** Cell size. **/
+        float _cellSize;
+        /** Inverse cell size. **/
+        float _invCellSize;
+        /** Buckets. **/
+        std::vector<std::vector<Entry>> _buckets;
+        /** Object bounds. **/
+        std::vector<glm::vec2> _min, _max;
+        /** Object cell ranges. **/
+        std::vector<Range> _range;
+        /** Object liveness. **/
+        std::vector<uint8_t> _alive;
+        /** Free identifiers. **/
+        std::vector<size_t> _free;
+        /** Visit marks used by segment queries. **/
+        std::vector<uint32_t> _mark;
+        /** Current visit mark. **/
+        uint32_t _stamp;
+};
+
+} // Geometry
+} // Core
+} // Dumb
+
+#endif // _DUMBFRAMEWORK_SPATIAL_GRID_
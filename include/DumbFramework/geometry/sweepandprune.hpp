@@ -0,0 +1,313 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_SWEEP_AND_PRUNE_
+#define _DUMBFRAMEWORK_SWEEP_AND_PRUNE_
+
+#include <cstdint>
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/boundingquad.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * Incremental sweep and prune broadphase.
+ * Object endpoints are kept sorted along each axis in flat arrays.
+ * Each update re-sorts them with an insertion sort, which is close to
+ * linear when motion is coherent. Overlapping pairs are tracked across
+ * frames, and only their changes are reported to the listener.
+ * Objects touching on a face are not considered overlapping, unless
+ * both are flat at the same coordinate on that axis. Quads can then be
+ * inserted in a 3 axis sweep and prune.
+ */
+class SweepAndPrune
+{
+    public:
+        /**
+         * Pair listener.
+         */
+        class Listener
+        {
+            public:
+                /** Destructor. **/
+                virtual ~Listener() {}
+                /**
+                 * Called when 2 objects start overlapping.
+                 * @param [in] a First object (a < b).
+                 * @param [in] b Second object.
+                 */
+                virtual void added(size_t a, size_t b) = 0;
+                /**
+                 * Called when 2 objects stop overlapping or one of them
+                 * is removed.
+                 * @param [in] a First object (a < b).
+                 * @param [in] b Second object.
+                 */
+                virtual void removed(size_t a, size_t b) = 0;
+        };
+        
+    public:
+        /**
+         * Constructor.
+         * @param [in] axisCount Number of axis (2 for quads, 3 for boxes).
+         */
+        SweepAndPrune(unsigned int axisCount=3);
+        /**
+         * Destructor.
+         */
+        ~SweepAndPrune();
+        /**
+         * Set pair listener.
+         * @param [in] listener Pair listener (may be null).
+         */
+        void listener(Listener* listener);
+        /**
+         * Insert object.
+         * Its pairs are reported at the next update.
+         * @param [in] box Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingBox const& box);
+        /**
+         * Insert object.
+         * @param [in] quad Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingQuad const& quad);
+        /**
+         * Update object bounds.
+         * @param [in] id  Object identifier.
+         * @param [in] box New bounds.
+         */
+        void move(size_t id, BoundingBox const& box);
+        /**
+         * Update object bounds.
+         * @param [in] id   Object identifier.
+         * @param [in] quad New bounds.
+         */
+        void move(size_t id, BoundingQuad const& quad);
+        /**
+         * Remove object.
+         * Its pairs are reported as removed at the next update, after
+         * which its identifier may be reused. Unknown or removed objects
+         * are ignored.
+         * @param [in] id Object identifier.
+         */
+        void remove(size_t id);
+        /**
+         * Sort endpoints and report pair changes.
+         */
+        void update();
+        /**
+         * Number of objects.
+         */
+        size_t size() const;
+        /**
+         * Number of overlapping pairs.
+         */
+        size_t pairCount() const;
+        /**
+         * Check if 2 objects were overlapping at the last update.
+         */
+        bool overlapping(size_t a, size_t b) const;
+        
+    private:
+        /** Endpoint. Data holds the object id and a max flag in its lowest bit. **/
+        struct Endpoint
+        {
+            float    value;
+            uint32_t data;
+        };
+        
+        /** Insert object. **/
+        size_t insert(glm::vec3 const& bmin, glm::vec3 const& bmax);
+        /** Update object bounds. **/
+        void move(size_t id, glm::vec3 const& bmin, glm::vec3 const& bmax);
+        /** Check if 2 objects overlap on all axis. **/
+        bool overlap(uint32_t a, uint32_t b) const;
+        /** Pair key. **/
+        static uint64_t key(uint32_t a, uint32_t b);
+        
+    private:
+        /** Number of axis. **/
+        unsigned int _axisCount;
+        /** Sorted endpoints per axis. **/
+        std::vector<Endpoint> _endpoints[3];
+        /** Endpoint index per axis (2 per object). **/
+        std::vector<uint32_t> _index[3];
+        /** Object bounds. **/
+        std::vector<glm::vec3> _min, _max;
+        /** Object liveness. **/
+        std::vector<uint8_t> _alive;
+        /** Objects removed since the last update. **/
+        std::vector<size_t> _removed;
+        /** Free identifiers. **/
+        std::vector<size_t> _free;
+        /** Overlapping pairs. **/
+        std::unordered_set<uint64_t> _pairs;
+        /** Pair listener. **/
+        Listener* _listener;
+};
+
+/**
+ * Multi sweep and prune.
+ * The world is split into cubic regions, each having its own sweep and
+ * prune. Objects are inserted in every region they overlap, which keeps
+ * the sorted lists short for large worlds. Pairs found in several
+ * regions are reference counted so that each change is reported once.
+ * Changes are reported at the end of the update, once every region was
+ * processed, so that objects moving between regions keep their pairs.
+ */
+class MultiSweepAndPrune
+{
+    public:
+        /**
+         * Constructor.
+         * @param [in] regionSize Region size.
+         * @param [in] axisCount  Number of axis (2 for quads, 3 for boxes).
+         */
+        MultiSweepAndPrune(float regionSize, unsigned int axisCount=3);
+        /**
+         * Destructor.
+         */
+        ~MultiSweepAndPrune();
+        /**
+         * Set pair listener.
+         * @param [in] listener Pair listener (may be null).
+         */
+        void listener(SweepAndPrune::Listener* listener);
+        /**
+         * Insert object.
+         * @param [in] box Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingBox const& box);
+        /**
+         * Insert object.
+         * @param [in] quad Object bounds.
+         * @return Object identifier.
+         */
+        size_t insert(BoundingQuad const& quad);
+        /**
+         * Update object bounds.
+         * @param [in] id  Object identifier.
+         * @param [in] box New bounds.
+         */
+        void move(size_t id, BoundingBox const& box);
+        /**
+         * Update object bounds.
+         * @param [in] id   Object identifier.
+         * @param [in] quad New bounds.
+         */
+        void move(size_t id, BoundingQuad const& quad);
+        /**
+         * Remove object.
+         * Unknown or removed objects are ignored.
+         * @param [in] id Object identifier.
+         */
+        void remove(size_t id);
+        /**
+         * Update all regions and report pair changes.
+         */
+        void update();
+        /**
+         * Number of objects.
+         */
+        size_t size() const;
+        /**
+         * Number of regions.
+         */
+        size_t regionCount() const;
+        /**
+         * Number of overlapping pairs.
+         */
+        size_t pairCount() const;
+        
+    private:
+        /** Region. **/
+        struct Region : public SweepAndPrune::Listener
+        {
+            Region(MultiSweepAndPrune* owner, unsigned int axisCount);
+            void added(size_t a, size_t b);
+            void removed(size_t a, size_t b);
+            
+            MultiSweepAndPrune* owner;
+            SweepAndPrune sap;
+            /** Local to global object identifiers. **/
+            std::vector<size_t> global;
+        };
+        /** Region cell range. **/
+        struct Range
+        {
+            glm::ivec3 first, last;
+        };
+        /** Object membership in a region. **/
+        struct Membership
+        {
+            glm::ivec3 cell;
+            Region*    region;
+            size_t     local;
+        };
+        
+        /** Insert object. **/
+        size_t insert(glm::vec3 const& bmin, glm::vec3 const& bmax);
+        /** Update object bounds. **/
+        void move(size_t id, glm::vec3 const& bmin, glm::vec3 const& bmax);
+        /** Compute region range. **/
+        Range regions(glm::vec3 const& bmin, glm::vec3 const& bmax) const;
+        /** Region key. **/
+        static uint64_t key(glm::ivec3 const& cell);
+        /** Add object to a region. **/
+        void link(size_t id, glm::ivec3 const& cell, glm::vec3 const& bmin, glm::vec3 const& bmax);
+        /** Queue pair reference increment. **/
+        void added(size_t a, size_t b);
+        /** Queue pair reference decrement. **/
+        void removed(size_t a, size_t b);
+        
+    private:
+        /** Number of axis. **/
+        unsigned int _axisCount;
+        /** Inverse region size. **/
+        float _invRegionSize;
+        /** Regions. **/
+        std::unordered_map<uint64_t, Region*> _regions;
+        /** Object region range. **/
+        std::vector<Range> _range;
+        /** Object regions. **/
+        std::vector<std::vector<Membership>> _membership;
+        /** Objects removed since the last update. **/
+        std::vector<size_t> _removed;
+        /** Free identifiers. **/
+        std::vector<size_t> _free;
+        /** Pair reference counts. **/
+        std::unordered_map<uint64_t, unsigned int> _pairs;
+        /** Pair reference increments and decrements of the current update. **/
+        std::vector<uint64_t> _increments, _decrements;
+        /** Pair listener. **/
+        SweepAndPrune::Listener* _listener;
+};
+
+} // Geometry
+} // Core
+} // Dumb
+
+#endif // _DUMBFRAMEWORK_SWEEP_AND_PRUNE_
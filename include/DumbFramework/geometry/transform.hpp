@@ -16,6 +16,7 @@
 #ifndef _DUMBFRAMEWORK_TRANSFORM_
 #define _DUMBFRAMEWORK_TRANSFORM_
 
+#include <cstddef>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -73,6 +74,38 @@ class Transform
          * Interpolate between 2 transform.
          */
         friend Transform mix(Transform const& from, Transform const& to, float t);
+        /**
+         * Interpolate between 2 arrays of transforms.
+         * This is the batch version of mix. The results are normalized.
+         * @param [in]  from   Source transforms.
+         * @param [in]  to     Destination transforms.
+         * @param [in]  t      Per element interpolation factors.
+         * @param [out] out    Interpolated transforms.
+         * @param [in]  count  Number of transforms.
+         */
+        friend void mix(Transform const* from, Transform const* to, float const* t, Transform* out, size_t count);
+        /**
+         * Spherical interpolation between 2 arrays of transforms.
+         * Orientations are interpolated along the shortest arc and
+         * positions are linearly interpolated.
+         * @param [in]  from   Source transforms.
+         * @param [in]  to     Destination transforms.
+         * @param [in]  t      Per element interpolation factors.
+         * @param [out] out    Interpolated transforms.
+         * @param [in]  count  Number of transforms.
+         */
+        friend void slerp(Transform const* from, Transform const* to, float const* t, Transform* out, size_t count);
+        /**
+         * Weighted blend of several poses.
+         * Pose p is stored at poses[p*count], and the orientations are
+         * aligned on the hemisphere of the first pose.
+         * @param [in]  poses     Poses.
+         * @param [in]  weights   Per pose weights.
+         * @param [in]  poseCount Number of poses.
+         * @param [out] out       Blended transforms.
+         * @param [in]  count     Number of transforms per pose.
+         */
+        friend void accumulate(Transform const* poses, float const* weights, size_t poseCount, Transform* out, size_t count);
         /**
          * Concatenate transforms.
          */
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMBFRAMEWORK_TRANSFORM_HIERARCHY_
+#define _DUMBFRAMEWORK_TRANSFORM_HIERARCHY_
+
+#include <cstdint>
+#include <vector>
+#include <DumbFramework/geometry/transform.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * Transform hierarchy.
+ * Nodes are stored in breadth first order, so that every parent is
+ * processed before its children and each level forms a contiguous range.
+ * Local transforms are kept as structure of arrays. Only the subtrees
+ * of nodes modified since the last update have their world matrix
+ * recomputed.
+ * 
+ * The nodes of a given level only depend on the previous level. The
+ * dirty nodes of a level can then be split among several threads:
+ * @code
+ * hierarchy.build();
+ * for(unsigned int level=0; level<hierarchy.levelCount(); level++)
+ * {
+ *     size_t count = hierarchy.prepare(level);
+ *     // Dispatch hierarchy.compute(level, first, last) over [0, count).
+ * }
+ * @endcode
+ * 
+ * Nodes are referenced by handles which are not affected by the
+ * internal reordering.
+ */
+class TransformHierarchy
+{
+    public:
+        /** Invalid handle. Used as parent handle for root nodes. **/
+        static const size_t None;
+        
+    public:
+        /**
+         * Default constructor.
+         */
+        TransformHierarchy();
+        /**
+         * Destructor.
+         */
+        ~TransformHierarchy();
+        /**
+         * Add node.
+         * @param [in] parent Parent node handle or None for a root node.
+         * @param [in] local  Local transform.
+         * @return Node handle or None if the parent handle is invalid.
+         */
+        size_t add(size_t parent, Transform const& local);
+        /**
+         * Remove all nodes.
+         */
+        void clear();
+        /**
+         * Number of nodes.
+         */
+        size_t size() const;
+        /**
+         * Retrieve the parent of a node.
+         * @param [in] node Node handle.
+         * @return Parent handle or None for root nodes.
+         */
+        size_t parent(size_t node) const;
+        /**
+         * Retrieve local transform.
+         * @param [in] node Node handle.
+         */
+        Transform local(size_t node) const;
+        /**
+         * Set local transform.
+         * The node and its subtree will be updated at the next update.
+         * @param [in] node Node handle.
+         * @param [in] t    Local transform.
+         */
+        void local(size_t node, Transform const& t);
+        /**
+         * Set local orientation.
+         * @param [in] node Node handle.
+         * @param [in] q    Orientation.
+         */
+        void orientation(size_t node, glm::fquat const& q);
+        /**
+         * Set local position.
+         * @param [in] node Node handle.
+         * @param [in] p    Position.
+         */
+        void position(size_t node, glm::vec3 const& p);
+        /**
+         * Retrieve world matrix as computed by the last update.
+         * @param [in] node Node handle.
+         */
+        glm::mat4 const& world(size_t node) const;
+        /**
+         * Update the world matrices of all modified subtrees.
+         */
+        void update();
+        /**
+         * Rebuild breadth first layout if nodes were added since the
+         * last build. This must be called before any level is prepared.
+         */
+        void build();
+        /**
+         * Number of levels.
+         */
+        unsigned int levelCount() const;
+        /**
+         * Gather the dirty nodes of a level and flag their children.
+         * Levels must be prepared in order, and each level must be
+         * computed before the next one is prepared.
+         * @param [in] level Level.
+         * @return Number of nodes to compute.
+         */
+        size_t prepare(unsigned int level);
+        /**
+         * Compute world matrices for a range of the nodes of the last
+         * prepared level. Disjoint ranges can be computed concurrently.
+         * @param [in] first First prepared node.
+         * @param [in] last  Last prepared node (excluded).
+         */
+        void compute(size_t first, size_t last);
+        
+    private:
+        /** Flag node for update. **/
+        void touch(size_t slot);
+        
+    private:
+        /** Handle to slot. **/
+        std::vector<size_t> _slot;
+        /** Slot to handle. **/
+        std::vector<size_t> _handle;
+        /** Parent slot. **/
+        std::vector<size_t> _parent;
+        /** Depth. **/
+        std::vector<unsigned int> _level;
+        /** First child slot. **/
+        std::vector<size_t> _firstChild;
+        /** Number of children. **/
+        std::vector<size_t> _childCount;
+        /** Local orientation (x, y, z, w). **/
+        std::vector<float> _orientation[4];
+        /** Local position (x, y, z). **/
+        std::vector<float> _position[3];
+        /** World matrices. **/
+        std::vector<glm::mat4> _world;
+        /** Dirty flags. **/
+        std::vector<uint8_t> _dirty;
+        /** Nodes flagged for update, per level. **/
+        std::vector<std::vector<size_t>> _pending;
+        /** Nodes of the level being computed. **/
+        std::vector<size_t> _current;
+        /** Set when nodes were added since the last build. **/
+        bool _layout;
+};
+
+} // Geometry
+} // Core
+} // Dumb
+
+#endif // _DUMBFRAMEWORK_TRANSFORM_HIERARCHY_
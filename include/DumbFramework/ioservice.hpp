@@ -0,0 +1,249 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_IO_SERVICE_
+#define _DUMB_FW_IO_SERVICE_
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Dumb {
+
+/**
+ * @brief Asynchronous file reader.
+ *
+ * Read requests are queued by priority and served by background
+ * threads. When a request is done, it is put into a completion queue.
+ * The main loop calls IOService::poll to run the callbacks of the
+ * finished requests on its own thread.
+ *
+ * If the framework was built with liburing (@c HAVE_LIBURING) and the
+ * kernel supports io_uring reads, a single thread submits the reads to
+ * an io_uring. Otherwise a pool of threads reads the files with
+ * @c pread. Either way, files are read in chunks of
+ * IOService::ChunkSize bytes, so that a canceled request stops between
+ * two chunks.
+ *
+ * The number of bytes in flight is bounded. The bytes of a request are
+ * accounted for from the moment it is read until its callback returned.
+ * A request is only started if its size fits in the remaining budget,
+ * or if nothing else is in flight.
+ *
+ * @note Only available on unix platforms.
+ */
+class IOService
+{
+    public:
+        /** Request identifier. 0 is never a valid identifier. **/
+        typedef uint64_t Ticket;
+        /** Request outcome. **/
+        enum Status
+        {
+            /** The requested bytes were read. **/
+            COMPLETED,
+            /** The file could not be opened or read. **/
+            FAILED,
+            /** The request was canceled. **/
+            CANCELED
+        };
+        /** I/O backends. **/
+        enum Backend
+        {
+            /** The service is not running. **/
+            NONE,
+            /** Thread pool using @c pread. **/
+            PREAD,
+            /** Single thread driving an io_uring. **/
+            IO_URING
+        };
+        /** Finished request. **/
+        struct Completion
+        {
+            /** Request identifier. **/
+            Ticket ticket;
+            /** Request outcome. **/
+            Status status;
+            /** @c errno value if the request failed. **/
+            int error;
+            /** File name. **/
+            std::string path;
+            /** Offset of the first byte read. **/
+            off_t offset;
+            /**
+             * Bytes read. It may be shorter than the requested length
+             * if the end of the file was reached.
+             */
+            std::vector<unsigned char> data;
+        };
+        /**
+         * Completion callback.
+         * It is called by IOService::poll. The data can be swapped out
+         * of the completion.
+         */
+        typedef std::function<void(Completion &)> Callback;
+
+        /** Default number of reader threads. **/
+        static const unsigned int DefaultThreadCount;
+        /** Default maximum number of bytes in flight. **/
+        static const size_t DefaultInflightBytes;
+        /** Number of reads submitted at once to the io_uring. **/
+        static const unsigned int QueueDepth;
+        /** Maximum number of bytes read by a single call or submission. **/
+        static const size_t ChunkSize;
+
+    public:
+        /** Constructor. **/
+        IOService();
+        /**
+         * Destructor.
+         * Stop the service. Callbacks of unpolled requests are not called.
+         */
+        ~IOService();
+        /**
+         * Start reader threads.
+         * @param [in] threadCount       Number of reader threads (only
+         *                               used by the @c pread backend).
+         * @param [in] maxInflightBytes  Maximum number of bytes in flight.
+         * @return false if the service is already running or if the
+         *         threads could not be created.
+         */
+        bool start(unsigned int threadCount=DefaultThreadCount, size_t maxInflightBytes=DefaultInflightBytes);
+        /**
+         * Stop reader threads.
+         * Reads in progress are completed. Queued requests are
+         * canceled. Their completions are still delivered by
+         * IOService::poll.
+         */
+        void stop();
+        /**
+         * Queue read request.
+         * @param [in] path      File name.
+         * @param [in] offset    Offset of the first byte to read.
+         * @param [in] length    Number of bytes to read. 0 means up to
+         *                       the end of the file.
+         * @param [in] priority  Requests with a higher priority are
+         *                       served first. Requests with the same
+         *                       priority are served in order.
+         * @param [in] callback  Completion callback.
+         * @return Request identifier, or 0 if the service is not running.
+         */
+        Ticket read(std::string const& path, off_t offset, size_t length, int priority, Callback const& callback);
+        /**
+         * Cancel request.
+         * A queued request is removed from the queue. A request being
+         * read is completed with the @c CANCELED status and its data is
+         * discarded. In both cases the callback is still called.
+         * @param [in] ticket  Request identifier.
+         * @return false if the request was already finished.
+         */
+        bool cancel(Ticket ticket);
+        /**
+         * Run the callbacks of finished requests.
+         * This is typically called once per frame by the main loop.
+         * @return Number of callbacks called.
+         */
+        size_t poll();
+        /**
+         * Wait until every queued request is finished, or until the
+         * remaining ones can not start before some completions are
+         * polled (their bytes do not fit in the budget). In that case
+         * IOService::poll must be called before waiting again.
+         */
+        void wait();
+        /** Number of bytes in flight. **/
+        size_t inflight() const;
+        /** Number of queued or running requests. **/
+        size_t outstanding() const;
+        /** Current I/O backend. **/
+        Backend backend() const;
+
+    private:
+        IOService(IOService const&);
+        IOService& operator= (IOService const&);
+
+        /** Read request. **/
+        struct Job;
+        /** io_uring state. **/
+        struct Ring;
+
+        /** Reader thread routine (@c pread backend). **/
+        void readerRoutine();
+        /** Reader thread routine (io_uring backend). **/
+        void ringRoutine();
+        /**
+         * Take the next request.
+         * @param [in] block  Wait until a request is available.
+         * @return NULL if there is no request or if the service stopped.
+         */
+        Job* next(bool block);
+        /**
+         * Open file and compute read size.
+         * @return false if the file could not be opened.
+         */
+        bool prepare(Job* job);
+        /**
+         * Reserve bytes for a request.
+         * @param [in] block  Wait until the bytes fit in the budget.
+         * @return false if the bytes do not fit (or if the service
+         *         stopped while waiting).
+         */
+        bool reserve(Job* job, bool block);
+        /**
+         * Check if every reader holding a request waits for room in
+         * the budget. The lock must be held.
+         */
+        bool stalled() const;
+        /** Move request to the completion queue. **/
+        void finish(Job* job);
+
+    private:
+        mutable std::mutex      _lock;
+        std::condition_variable _work;
+        std::condition_variable _space;
+        std::condition_variable _idle;
+        std::vector<std::thread> _threads;
+
+        bool    _running;
+        Backend _backend;
+        Ticket  _last;
+        size_t  _maxInflight;
+        size_t  _inflight;
+        size_t  _outstanding;
+        /** Requests taken by a reader and not finished yet. **/
+        size_t  _active;
+        /** Readers waiting for room in the budget. **/
+        size_t  _starving;
+
+        /** Queued requests, ordered by decreasing priority then ticket. **/
+        std::set<std::pair<int, Ticket> > _queue;
+        /** Queued and running requests. **/
+        std::map<Ticket, Job*> _jobs;
+        /** Finished requests. **/
+        std::vector<Job*> _completed;
+
+        Ring *_ring;
+};
+
+} // Dumb
+
+#endif /* _DUMB_FW_IO_SERVICE_ */
@@ -17,13 +17,19 @@
 #define _DUMB_FW_LOG_
 
 #include <string>
-#include <list>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <stdarg.h>
+#include <stdint.h>
 #include <pthread.h>
 
 #include <DumbFramework/module.hpp>
 #include <DumbFramework/severity.hpp>
 #include <DumbFramework/file.hpp>
+#include <DumbFramework/logqueue.hpp>
+#include <DumbFramework/logargs.hpp>
 
 /**
  * @defgroup DUMB_FW_LOG Logging system.
@@ -61,8 +67,21 @@
  *      - Log_Warning (module, format, ...)
  *      - Log_Error (module, format, ...)
  *      - Log_Ex (module, severity, format, ...)
+ *
+ * Messages can be filtered before anything is built in two ways.
+ *      - At compile time by defining @c DUMB_LOG_MIN_SEVERITY (set by
+ *        the @c LOG_MIN_SEVERITY CMake option). The macros of a lower
+ *        severity expand to an empty statement and their arguments are
+ *        not evaluated. 0 keeps every message, 1 removes @c Log_Info,
+ *        2 keeps only @c Log_Error and 3 removes everything.
+ *      - At runtime with Dumb::Log::Thresholds. The macros check the
+ *        threshold of the module before evaluating their arguments.
  */
 
+#ifndef DUMB_LOG_MIN_SEVERITY
+#define DUMB_LOG_MIN_SEVERITY 0
+#endif
+
 /**
  * @def  Log_Info(module, format, ...)
  * @hideinitializer
@@ -226,7 +245,56 @@ namespace Log  {
         size_t      line;
         /** Name of the function/method where the log message was emitted. */
         char const* function;
-        // more?
+        /** Monotonic time in nanoseconds at which the message was emitted. */
+        uint64_t    timestamp;
+        /** Identifier of the emitting thread (starting at 1). */
+        unsigned int thread;
+    };
+
+    /**
+     * @brief Runtime log thresholds.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Minimum severity of the messages emitted by each module. Modules
+     * without their own threshold use the default one, which is
+     * initially Dumb::Severity::Info.
+     *
+     * Thresholds are stored in a table indexed by the module id, so
+     * checking a message costs a single relaxed load.
+     */
+    class Thresholds
+    {
+        public:
+            /**
+             * Set default threshold.
+             * @param [in] severity  Minimum severity.
+             */
+            static void set(Dumb::Severity const & severity);
+            /**
+             * Set module threshold.
+             * @param [in] module    Module ID.
+             * @param [in] severity  Minimum severity.
+             */
+            static void set(Dumb::Module::Identifier const & module, Dumb::Severity const & severity);
+            /**
+             * Discard every message of a module.
+             * @param [in] module    Module ID.
+             */
+            static void disable(Dumb::Module::Identifier const & module);
+            /** Remove module thresholds and restore the default one. **/
+            static void reset();
+            /**
+             * Tell if a message must be emitted.
+             * @param [in] module    Module ID.
+             * @param [in] severity  Message severity.
+             * @return true if @a severity is greater or equal to the
+             *         module threshold.
+             */
+            static inline bool enabled(Dumb::Module::Identifier const & module, Dumb::Severity const & severity);
+
+        private:
+            /** Module thresholds indexed by module id. **/
+            static std::atomic<uint8_t> _thresholds[Dumb::Module::Identifier::Capacity];
     };
 
     /**
@@ -260,6 +328,30 @@ namespace Log  {
          * @return false if an error occured.
          */
         virtual bool write(std::string & msg) = 0;
+        /**
+         * @brief Flush output.
+         *
+         * Called by the log processor when a flush was requested, when
+         * it stops, or when it is idle and the flush interval elapsed.
+         * @return false if an error occured.
+         */
+        virtual bool flush() { return true; }
+        /**
+         * @brief Flush interval.
+         *
+         * Delay after which the log processor flushes written messages
+         * while it is idle. 0 flushes as soon as the queue is empty.
+         * @return Flush interval in milliseconds.
+         */
+        virtual unsigned int flushInterval() const { return 0; }
+        /**
+         * @brief Tell if messages can be written concurrently.
+         *
+         * If true, the log processor calls @c write directly from the
+         * emitting threads instead of queueing messages.
+         * @return true if @c write is thread safe.
+         */
+        virtual bool concurrent() const { return false; }
     };
 
     /**
@@ -287,6 +379,15 @@ namespace Log  {
              * @return false if an error occured.
              */
             virtual bool build(std::string & out, Dumb::Module::Identifier const & module, Dumb::Severity const & severity, SourceInfos const & infos, char const * format, va_list args) = 0;
+            /**
+             * Tell if a message will be kept.
+             * This is used by the deferred formatting mode in order to
+             * filter messages before they are queued.
+             * @param [in]  module   Module ID. 
+             * @param [in]  severity Log severity (warning, info, error, ...).
+             * @return false if the message is discarded.
+             */
+            virtual bool accept(Dumb::Module::Identifier const & module, Dumb::Severity const & severity);
     };
 
     /**
@@ -332,12 +433,58 @@ namespace Log  {
              * @return false if an error occured.
              */
             virtual bool build(std::string & out, Dumb::Module::Identifier const & module, Dumb::Severity const & severity, SourceInfos const & infos, char const * format, va_list args);
+            /**
+             * Evaluate filter.
+             * @param [in]  module   Module ID. 
+             * @param [in]  severity Log severity (warning, info, error, ...).
+             * @return false if the message is discarded.
+             */
+            virtual bool accept(Dumb::Module::Identifier const & module, Dumb::Severity const & severity);
 
         private:
             FilterPolicy _filter; /**< Message filter. */
             FormatPolicy _format; /**< Used to build log string. */
     };
 
+    /**
+     * @brief Queued log message.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Log processor queue entry. Depending on @a kind, it either holds
+     * a message built by the log builder, or everything needed to build
+     * it later on the log processor thread.
+     */
+    struct Record
+    {
+        /** Record content. **/
+        enum Kind
+        {
+            /** @a text holds the message built by the emitting thread. **/
+            BUILT,
+            /** @a arguments holds the arguments packed by Dumb::Log::packArguments, followed by the format string. **/
+            PACKED,
+            /** @a arguments holds the formatted (and maybe truncated) arguments. **/
+            EXPANDED
+        };
+        /** Size of the packed argument buffer. **/
+        static const size_t ArgumentSize = 224;
+
+        /** Record content. **/
+        Kind        kind;
+        /** Log severity. **/
+        Dumb::Severity severity;
+        /** Source informations. **/
+        SourceInfos infos;
+        /** Number of bytes used by the packed arguments. **/
+        size_t      size;
+        /** Module ID. **/
+        Dumb::Module::Identifier module;
+        /** Packed or formatted arguments. **/
+        char        arguments[ArgumentSize];
+        /** Message built by the emitting thread. **/
+        std::string text;
+    };
+
     /**
      * @brief Log processor.
      * @ingroup DUMB_FW_LOG
@@ -349,12 +496,92 @@ namespace Log  {
      * pushed into a message queue. An asynchronous task (typically a 
      * thread) reads this message queue and outputs the message string
      * using the output policy.
-     * 
+     *
+     * The message queue is a bounded lock-free ring (see 
+     * Dumb::Log::BoundedQueue). Emitting threads never take a lock
+     * unless the queue is full and the overflow policy is @c BLOCK.
+     * The processor thread drains the queue in batches and sleeps on
+     * a condition variable when there is nothing left to write.
+     *
+     * In @c DEFERRED mode, only the log builder filter is evaluated by
+     * the emitting thread. The source infos, the raw argument values and
+     * the format string are copied into a preallocated Dumb::Log::Record.
+     * The message string is built by the processor thread, and the
+     * emitting thread does not allocate any memory.
+     *
+     * In @c PER_THREAD mode, every emitting thread gets its own queue
+     * and its own counters, so producers do not even share the queue
+     * tail. A producer publishes the timestamp of the message it is
+     * emitting, after a reservation made before reading the clock. The
+     * processor thread only writes messages older than every such
+     * pending timestamp, sorted by timestamp, so the output keeps the
+     * global emission order.
+     *
      * @note This is a singleton. You can only have instance of this
      * object.
      */
     class LogProcessor
     {
+        public:
+            /**
+             * @brief Overflow policies.
+             *
+             * Tells what to do when a message is emitted while the
+             * queue is full.
+             */
+            enum OverflowPolicy
+            {
+                /** Wait until the processor thread made some room. **/
+                BLOCK,
+                /** Discard the oldest queued message. **/
+                DROP_OLDEST,
+                /** Discard the message being emitted. **/
+                DROP_NEWEST
+            };
+            /**
+             * @brief Formatting modes.
+             *
+             * Tells which thread builds the message string.
+             */
+            enum Formatting
+            {
+                /** Messages are built by the emitting thread. **/
+                IMMEDIATE,
+                /** Messages are built by the processor thread. **/
+                DEFERRED
+            };
+            /**
+             * @brief Queueing modes.
+             *
+             * Tells where emitted messages are stored until the
+             * processor thread picks them.
+             */
+            enum Queueing
+            {
+                /** A single queue shared by all threads. **/
+                SHARED,
+                /**
+                 * One staging queue per emitting thread. Producers
+                 * never write to memory used by other producers. The
+                 * processor thread merges the queues by timestamp.
+                 */
+                PER_THREAD
+            };
+            /** Per thread message counters. **/
+            struct ThreadStatistics
+            {
+                /** Thread identifier (see SourceInfos::thread). **/
+                unsigned int thread;
+                /** Number of messages queued. **/
+                uint64_t emitted;
+                /** Number of messages discarded because the queue was full. **/
+                uint64_t dropped;
+            };
+            /** Default number of queued messages. **/
+            static const size_t DefaultCapacity;
+            /** Maximum number of messages dequeued at once. **/
+            static const size_t BatchSize;
+
         public:
             /** Destructor. **/
             ~LogProcessor();
@@ -374,8 +601,14 @@ namespace Log  {
              * Start logging task.
              * @param [in] builder       Log message builder.
              * @param [in] outputPolicy  Filter and log output.
+             * @param [in] overflow      What to do when the queue is full.
+             * @param [in] capacity      Maximum number of queued messages.
+             * @param [in] formatting    Which thread builds the messages.
+             * @param [in] queueing      Where messages are queued. With
+             *                           PER_THREAD, @a capacity is the
+             *                           size of each thread queue.
              */
-            bool start(BaseLogBuilder* builder, OutputPolicyBase* outputPolicy);
+            bool start(BaseLogBuilder* builder, OutputPolicyBase* outputPolicy, OverflowPolicy overflow=BLOCK, size_t capacity=DefaultCapacity, Formatting formatting=IMMEDIATE, Queueing queueing=SHARED);
             /** Stop logging task. **/
             bool stop();
             /** 
@@ -384,6 +617,18 @@ namespace Log  {
              * Wait until all emitted log messages have been processed.
              */
             void flush();
+            /** Number of messages written by the output policy. **/
+            uint64_t written() const;
+            /** Number of messages discarded because the queue was full. **/
+            uint64_t dropped() const;
+            /**
+             * Get per thread message counters.
+             * Only threads that emitted messages in PER_THREAD mode are
+             * listed. The queue of an exited thread is reused by the
+             * next thread that needs one, and so are its counters.
+             * @param [out] statistics  Message counters.
+             */
+            void statistics(std::vector<ThreadStatistics> & statistics) const;
             
         protected:
             /**
@@ -391,19 +636,55 @@ namespace Log  {
              * @param [in] param  Opaque pointer to log processor.
              */
             static void* taskRoutine(void *param);
+            /** Message queue and its counters. **/
+            struct Staging;
+            /** Get the staging queue of the calling thread. **/
+            Staging* staging();
+            /**
+             * Add record to message queue.
+             * @param [in] local   Destination queue.
+             * @param [in] writer  Functor filling the queued record.
+             */
+            template <typename F>
+            void queueMessage(Staging* local, F & writer);
+            /**
+             * Build record message.
+             * @param [in,out] record  Dequeued record.
+             * @return Message to output or NULL if it was filtered out.
+             */
+            std::string* build(Record & record);
+            /**
+             * Retrieve a batch of log messages and write them.
+             * @param [in] all  Write every staged message, even if an
+             *                  older one may still be queued.
+             * @return Number of messages dequeued or written.
+             */
+            size_t drain(bool all=false);
             /**
-             * Add string to message queue.
-             * @param [in] msg  Log message.
+             * Retrieve messages from the thread queues and write them
+             * in timestamp order.
+             * @param [in] all  Write every staged message, even if an
+             *                  older one may still be queued.
+             * @return Number of messages dequeued or written.
              */
-            void queueMessage(std::string const & msg);
+            size_t collect(bool all);
+            /** Tell if there is nothing to write. **/
+            bool idle() const;
+            /** Number of queued messages that will reach the processor thread. **/
+            uint64_t queued() const;
+            /** Tell if written messages have to be flushed now. **/
+            bool due() const;
             /**
-             * Retrieve log message from queue.
-             * @param [out] msg  Log message.
-             * @return false if the queue is empty.
+             * Wait until a message is queued, a flush is due or the
+             * processor stops.
              */
-            bool dequeueMessage(std::string & msg);
-            /** Return true if the thread must stop. **/
-            bool mustStop();
+            void park();
+            /** Wake up the processor thread if it is sleeping. **/
+            void wakeup();
+            /** Wake up threads waiting for free slots or for a flush. **/
+            void release();
+            /** Flush output and wake up threads waiting for a flush. **/
+            void sync();
 
         private:
             LogProcessor();
@@ -412,11 +693,32 @@ namespace Log  {
 
         private:
             pthread_mutex_t  _lock;
-            pthread_mutex_t  _alive;
-            pthread_cond_t   _empty;
+            pthread_cond_t   _wakeup;
+            pthread_cond_t   _space;
+            pthread_cond_t   _drained;
             pthread_t        _task;
 
-            std::list<std::string> _msgQueue;
+            Staging              *_shared;
+            std::atomic<Staging*> _stagings;
+            OverflowPolicy        _overflow;
+            Formatting            _formatting;
+            Queueing              _queueing;
+            size_t                _capacity;
+            bool                  _direct;
+            std::vector<Record>   _batch;
+            std::vector<Record>   _pending;
+            std::vector<size_t>   _order;
+            std::string           _text;
+            std::string           _message;
+
+            std::atomic<bool>     _running;
+            std::atomic<bool>     _sleeping;
+            std::atomic<unsigned> _waiting;
+            std::atomic<unsigned> _flushing;
+            std::atomic<uint64_t> _processed;
+            std::atomic<uint64_t> _synced;
+            std::atomic<uint64_t> _written;
+            std::chrono::steady_clock::time_point _lastSync;
 
             BaseLogBuilder   *_builder;
             OutputPolicyBase *_output; 
@@ -486,45 +788,151 @@ namespace Log  {
      *
      * Write log messages to a file. A new file is created at each
      * invocation of FileOutputPolicy::setup. The name of the newly
-     * created file is @b log_HHMMSS_ddmmYYYY.txt with
+     * created file is @b prefix_HHMMSS_ddmmYYYY.txt with
+     *      - @b prefix file prefix (@b log by default)
      *      - @b HH   hour between 00 and 23.
      *      - @b MM   minute between 00 and 59
      *      - @b SS   second between 00 and 59
      *      - @b dd   day of the month between 01 and 31
      *      - @b mm   month of the year between 01 and 12
      *      - @b YYYY year
+     *
+     * The file stays opened until FileOutputPolicy::teardown. Messages
+     * are appended to a buffer which is written when it is full, when
+     * the flush interval elapsed (the log processor checks it even
+     * when no message comes in), or when a flush is requested.
+     * FileOutputPolicy::teardown writes the buffer and waits until the
+     * file reached the storage device.
+     *
+     * When rotation is enabled, a new file is created once the current
+     * one grew past the maximum size or is older than the maximum age.
+     * If compression is enabled (and the framework was built with
+     * zlib), rotated files are then compressed to @b name.gz by a
+     * background thread.
      */
     class FileOutputPolicy : public OutputPolicyBase
     {
+        public:
+            /** Default buffer size in bytes. **/
+            static const size_t DefaultBufferSize;
+            /** Default flush interval in milliseconds. **/
+            static const unsigned int DefaultFlushInterval;
+
         public:
             /** Default contructor. **/
             FileOutputPolicy();
             /** Destructor. **/
             ~FileOutputPolicy();
+            /**
+             * Set filename prefix.
+             * @param [in] prefix  Filename prefix. It may contain a
+             *                     directory.
+             */
+            void setPrefix(std::string const & prefix);
+            /**
+             * Set buffer size.
+             * @param [in] size  Buffer size in bytes.
+             */
+            void setBufferSize(size_t size);
+            /**
+             * Set flush interval.
+             * @param [in] milliseconds  Maximum delay between two
+             *                           writes of the buffer.
+             */
+            void setFlushInterval(unsigned int milliseconds);
+            /**
+             * Set rotation.
+             * @param [in] maxSize  Maximum file size in bytes (0 means
+             *                      no limit).
+             * @param [in] maxAge   Maximum file age in seconds (0 means
+             *                      no limit).
+             */
+            void setRotation(size_t maxSize, unsigned int maxAge);
+            /**
+             * Enable or disable compression of rotated files.
+             * @param [in] enable  Compress rotated files.
+             */
+            void setCompression(bool enable);
+            /** Current log filename. **/
+            std::string const & filename() const;
             /** 
-             * Build log filename using current datetime.
-             * @return Allways true
+             * Build log filename using current datetime and open it.
+             * @return false if the file could not be opened.
              */
             bool setup();
+            /** Write buffer and close file. **/
+            void teardown();
             /**
-             * Write to log file.
+             * Append message to the file buffer.
              * @param [in] msg Log message.
-             * @return true if the message was succesfully written to
-             *         the file.
+             * @return false if the buffer could not be written.
              */
             bool write(std::string & msg);
+            /**
+             * Write buffer to file.
+             * @return false if the buffer could not be written.
+             */
+            bool flush();
+            /** Flush interval in milliseconds. **/
+            unsigned int flushInterval() const;
+
         private:
-            std::string _filename; /**< Log filename. **/
+            /** Open a new log file. **/
+            bool open();
+            /** Close the current file and open a new one. **/
+            bool rotate();
+            /**
+             * Compress file and remove it.
+             * @param [in] filename  Name of the file to compress.
+             */
+            static void compress(std::string filename);
+
+        private:
+            std::string  _prefix;        /**< Log filename prefix. **/
+            std::string  _filename;      /**< Log filename. **/
+            File         _file;          /**< Log file. **/
+            std::string  _buffer;        /**< Pending messages. **/
+            size_t       _bufferSize;    /**< Buffer size. **/
+            unsigned int _flushInterval; /**< Flush interval in milliseconds. **/
+            size_t       _maxSize;       /**< Maximum file size. **/
+            unsigned int _maxAge;        /**< Maximum file age in seconds. **/
+            bool         _compress;      /**< Compress rotated files. **/
+            size_t       _fileSize;      /**< Bytes written to the current file. **/
+            unsigned int _sequence;      /**< Suffix of files created in the same second. **/
+            std::string  _base;          /**< Last filename without suffix. **/
+            std::chrono::steady_clock::time_point _opened;    /**< Current file creation time. **/
+            std::chrono::steady_clock::time_point _lastFlush; /**< Last buffer write. **/
+            std::thread  _compressor;    /**< Background compression task. **/
     };
 
 } // Log
 } // Dumb
 
-#define Log_Info(module, format, ...)    do { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Info,    Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } while(0);
-#define Log_Warning(module, format, ...) do { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Warning, Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } while(0);
-#define Log_Error(module, format, ...)   do { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Error,   Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } while(0);
-
-#define Log_Ex(module, severity, format, ...) do { Dumb::Log::LogProcessor::instance().write(module, severity, Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } while(0);
+#if (DUMB_LOG_MIN_SEVERITY <= 0)
+#define Log_Info(module, format, ...)    do { if(Dumb::Log::Thresholds::enabled(module, Dumb::Severity::Info))    { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Info,    Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } } while(0);
+#else
+#define Log_Info(module, format, ...)    do {} while(0);
+#endif
+
+#if (DUMB_LOG_MIN_SEVERITY <= 1)
+#define Log_Warning(module, format, ...) do { if(Dumb::Log::Thresholds::enabled(module, Dumb::Severity::Warning)) { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Warning, Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } } while(0);
+#else
+#define Log_Warning(module, format, ...) do {} while(0);
+#endif
+
+#if (DUMB_LOG_MIN_SEVERITY <= 2)
+#define Log_Error(module, format, ...)   do { if(Dumb::Log::Thresholds::enabled(module, Dumb::Severity::Error))   { Dumb::Log::LogProcessor::instance().write(module, Dumb::Severity::Error,   Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } } while(0);
+#else
+#define Log_Error(module, format, ...)   do {} while(0);
+#endif
+
+#if (DUMB_LOG_MIN_SEVERITY <= 0)
+#define Log_Ex(module, severity, format, ...) do { if(Dumb::Log::Thresholds::enabled(module, severity)) { Dumb::Log::LogProcessor::instance().write(module, severity, Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } } while(0);
+#elif (DUMB_LOG_MIN_SEVERITY <= 2)
+#define Log_Ex(module, severity, format, ...) do { if((Dumb::Severity(severity).value >= DUMB_LOG_MIN_SEVERITY) && Dumb::Log::Thresholds::enabled(module, severity)) { Dumb::Log::LogProcessor::instance().write(module, severity, Dumb::Log::SourceInfos(__FILE__, __LINE__, __FUNCTION__), format, ##__VA_ARGS__); } } while(0);
+#else
+#define Log_Ex(module, severity, format, ...) do {} while(0);
+#endif
 
 #define SIMPLE_LOGGING(procesor) \
 Dumb::Log::LogBuilder<Dumb::Log::AllPassFilter, Dumb::Log::SimpleMessageFormat> msgBuilder;\
@@ -16,6 +16,12 @@
 namespace Dumb {
 namespace Log  {
 
+    // Tell if a message must be emitted
+    bool Thresholds::enabled(Dumb::Module::Identifier const & module, Dumb::Severity const & severity)
+    {
+        return ((uint32_t)severity.value >= _thresholds[module.id()].load(std::memory_order_relaxed));
+    }
+
     // Constructor
     template <class FilterPolicy, class FormatPolicy>
         LogBuilder<FilterPolicy, FormatPolicy>::LogBuilder()
@@ -43,5 +49,12 @@ namespace Log  {
         return false;
     }
 
+    // Evaluate filter
+    template <class FilterPolicy, class FormatPolicy>
+    bool LogBuilder<FilterPolicy, FormatPolicy>::accept(Dumb::Module::Identifier const & module, Dumb::Severity const & severity)
+    {
+        return _filter.eval(module, severity);
+    }
+
 } // Log
 } // Dumb
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_LOG_ARGS_
+#define _DUMB_FW_LOG_ARGS_
+
+#include <string>
+#include <stddef.h>
+#include <stdarg.h>
+
+namespace Dumb {
+namespace Log  {
+    /**
+     * @brief Pack format arguments.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Walk the @c printf format string and copy the raw value of each
+     * argument into @a buffer. Strings are copied with their terminating
+     * null character so that the caller does not have to keep them
+     * alive. Nothing is allocated.
+     *
+     * The packing fails if @a buffer is too small or if the format
+     * string contains a conversion that can not be deferred (@c %n or
+     * wide strings).
+     *
+     * @param [out] buffer    Destination buffer.
+     * @param [in]  capacity  Destination buffer size.
+     * @param [out] used      Number of bytes written to @a buffer.
+     * @param [in]  format    Format string.
+     * @param [in]  args      Format string arguments.
+     * @return false if the arguments could not be packed.
+     */
+    bool packArguments(char* buffer, size_t capacity, size_t & used, char const* format, va_list args);
+    /**
+     * @brief Format packed arguments.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Build the string that @c vsnprintf would have produced from
+     * @a format and the arguments packed by Dumb::Log::packArguments.
+     *
+     * @param [out] out     Output string.
+     * @param [in]  format  Format string used to pack the arguments.
+     * @param [in]  data    Packed arguments.
+     * @param [in]  size    Size of packed arguments.
+     */
+    void unpackArguments(std::string & out, char const* format, char const* data, size_t size);
+
+} // Log
+} // Dumb
+
+#endif /* _DUMB_FW_LOG_ARGS_ */
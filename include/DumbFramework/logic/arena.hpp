@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 Stoned Xander
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DUMB_LOGIC_ARENA
+#define DUMB_LOGIC_ARENA
+
+#include <cstddef>
+#include <vector>
+
+#define DEFAULT_ARENA_CHUNK 65536
+namespace Dumb {
+    namespace Logic {
+
+        /**
+         * Memory arena.
+         *
+         * Hands out blocks carved from large chunks. Released blocks are
+         * kept in per-size free lists and recycled by later allocations.
+         * Chunks are only returned to the system when the arena is
+         * destroyed. Objects living in the arena are not destroyed by it.
+         */
+        class Arena {
+            public:
+                /**
+                 * Constructor.
+                 * @param chunk Chunk size in bytes.
+                 */
+                Arena(size_t chunk = DEFAULT_ARENA_CHUNK);
+                /**
+                 * Destructor.
+                 * Release all chunks.
+                 */
+                ~Arena();
+                /**
+                 * Allocate a block.
+                 * @param size Block size in bytes.
+                 * @return Pointer to the block.
+                 */
+                void* allocate(size_t size);
+                /**
+                 * Give a block back to the arena.
+                 * @param block Block allocated by this arena.
+                 * @param size Size used at allocation.
+                 */
+                void release(void* block, size_t size);
+            private:
+                Arena(const Arena&) = delete;
+                Arena& operator=(const Arena&) = delete;
+            private:
+                /** Block alignment. */
+                static const size_t Alignment = 16;
+                /** Free block link. */
+                struct Link {
+                    Link* next;
+                };
+                /** Allocated chunks. */
+                std::vector<char*> _chunks;
+                /** Free lists, indexed by block size in alignment units. */
+                std::vector<Link*> _free;
+                /** Next available byte in the current chunk. */
+                char*              _cursor;
+                /** Bytes left in the current chunk. */
+                size_t             _available;
+                /** Chunk size. */
+                size_t             _chunk;
+        };
+
+        inline Arena::Arena(size_t chunk) :
+            _cursor(nullptr), _available(0), _chunk(chunk) {
+            }
+
+        inline Arena::~Arena() {
+            for(std::vector<char*>::iterator it = _chunks.begin(); it != _chunks.end(); ++it) {
+                delete [](*it);
+            }
+        }
+
+        inline void* Arena::allocate(size_t size) {
+            size_t units = (size + Alignment - 1) / Alignment;
+            if(units < _free.size() && (nullptr != _free[units])) {
+                Link* link = _free[units];
+                _free[units] = link->next;
+                return link;
+            }
+            size = units * Alignment;
+            if(size > _available) {
+                // Oversized blocks get a chunk of their own.
+                size_t chunk = (size > _chunk) ? size : _chunk;
+                _cursor = new char[chunk + Alignment];
+                _chunks.push_back(_cursor);
+                size_t misalign = reinterpret_cast<size_t>(_cursor) % Alignment;
+                if(misalign) {
+                    _cursor += Alignment - misalign;
+                }
+                _available = chunk;
+            }
+            void* block = _cursor;
+            _cursor += size;
+            _available -= size;
+            return block;
+        }
+
+        inline void Arena::release(void* block, size_t size) {
+            if(nullptr == block) {
+                return;
+            }
+            size_t units = (size + Alignment - 1) / Alignment;
+            if(units >= _free.size()) {
+                _free.resize(units + 1, nullptr);
+            }
+            Link* link = static_cast<Link*>(block);
+            link->next = _free[units];
+            _free[units] = link;
+        }
+
+    } // Namespace 'Logic'
+} // Namespace 'Dumb'
+
+#endif
@@ -0,0 +1,596 @@
+/*
+ * Copyright 2015 Stoned Xander
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DUMB_LOGIC_LOOSE_OCTREE
+#define DUMB_LOGIC_LOOSE_OCTREE
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/ray.hpp>
+
+namespace Dumb {
+    namespace Logic {
+        namespace LooseOctree {
+
+            /**
+             * Loose Octree.
+             *
+             * Elements are stored with their bounding box in the deepest
+             * cell whose loose bounds (the cell bounds scaled by the
+             * looseness factor) can hold them. As the cell is chosen from
+             * the box center and size, an element moving within the loose
+             * bounds of its cell stays where it is.
+             * Cells are pooled by blocks of 8 siblings, and each cell keeps
+             * its elements in contiguous arrays.
+             * @param <E> Element type. The tree only stores pointers.
+             */
+            template <typename E> class Tree {
+                public:
+                    /**
+                     * Default visitor. The region is the loose bounds of
+                     * the visited cell.
+                     */
+                    class Visitor {
+                        public:
+                            void enter(const Core::Geometry::BoundingBox&) {}
+                            void exit(const Core::Geometry::BoundingBox&) {}
+                            void inspect(E**, unsigned int) {}
+                            void inspect(E*) {}
+                    };
+                    /** Invalid handle. */
+                    static const unsigned int None = 0xffffffff;
+                public:
+                    /**
+                     * Constructor.
+                     * @param world World bounds. Elements outside of it are
+                     *     kept in the root cell.
+                     * @param depth Maximum depth.
+                     * @param looseness Loose bounds scale factor (greater than 1).
+                     */
+                    Tree(const Core::Geometry::BoundingBox& world,
+                            unsigned int depth = 6, float looseness = 2.0f);
+                    /**
+                     * Destructor.
+                     */
+                    ~Tree();
+                    /**
+                     * Add an element.
+                     * @param element Element.
+                     * @param box Element bounding box.
+                     * @return Element handle.
+                     */
+                    unsigned int add(E* element, const Core::Geometry::BoundingBox& box);
+                    /**
+                     * Remove an element.
+                     * @param handle Element handle.
+                     */
+                    void remove(unsigned int handle);
+                    /**
+                     * Move an element.
+                     * This is constant time as long as the element stays within
+                     * the loose bounds of its cell.
+                     * @param handle Element handle.
+                     * @param box New bounding box.
+                     */
+                    void move(unsigned int handle, const Core::Geometry::BoundingBox& box);
+                    /**
+                     * Get element.
+                     * @param handle Element handle.
+                     */
+                    E* element(unsigned int handle) const;
+                    /**
+                     * Get element bounding box.
+                     * @param handle Element handle.
+                     */
+                    const Core::Geometry::BoundingBox& box(unsigned int handle) const;
+                    /**
+                     * Number of elements.
+                     */
+                    unsigned int size() const;
+                    /**
+                     * Retrieve elements whose bounding box is inside or
+                     * intersects a volume.
+                     * @param volume Search volume.
+                     * @param buffer Storage for eligible elements.
+                     * @param size Size of the buffer.
+                     * @param visitor Optional visitor.
+                     * @param <S> Volume type (Frustum, BoundingSphere or
+                     *     BoundingBox). Must implement:
+                     *   ContainmentType::Value contains(const BoundingBox&);
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements.
+                     */
+                    template <typename S, typename V = Visitor> unsigned int retrieve(const S& volume,
+                            E** buffer, unsigned int size, V* visitor = nullptr) const;
+                    /**
+                     * Retrieve elements whose bounding box is hit by a ray.
+                     * @param ray Ray.
+                     * @param buffer Storage for eligible elements.
+                     * @param size Size of the buffer.
+                     * @param visitor Optional visitor.
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements.
+                     */
+                    template <typename V = Visitor> unsigned int retrieve(const Core::Geometry::Ray3& ray,
+                            E** buffer, unsigned int size, V* visitor = nullptr) const;
+                    /**
+                     * Recursive visit of the tree.
+                     * @param <V> Visitor concept.
+                     *   Must implement 'void enter(const BoundingBox &)',
+                     *   'void exit(const BoundingBox &)' and
+                     *   'void inspect(E **, unsigned int count)'.
+                     * @param visitor Visitor.
+                     */
+                    template <typename V> void visit(V& visitor);
+
+                private:
+                    /** Tree cell. */
+                    struct Cell {
+                        /** Cell center. */
+                        glm::vec3 center;
+                        /** Cell half size. */
+                        float half;
+                        /** Loose bounds. */
+                        Core::Geometry::BoundingBox loose;
+                        /** Parent cell. */
+                        unsigned int parent;
+                        /** First child cell. 'None' if leaf. */
+                        unsigned int children;
+                        /** Cell depth. */
+                        unsigned int depth;
+                        /** Number of elements in the cell and its subtree. */
+                        unsigned int count;
+                        /** Stored elements. */
+                        std::vector<E*> elements;
+                        /** Stored element bounding boxes. */
+                        std::vector<Core::Geometry::BoundingBox> boxes;
+                        /** Stored element handles. */
+                        std::vector<unsigned int> handles;
+                    };
+                    /** Element slot. */
+                    struct Slot {
+                        /** Hosting cell. 'None' if the slot is free. */
+                        unsigned int cell;
+                        /** Index in the cell arrays. */
+                        unsigned int index;
+                    };
+                private:
+                    /**
+                     * Find the cell that should host a box, creating
+                     * cells as needed.
+                     */
+                    unsigned int locate(const Core::Geometry::BoundingBox& box);
+                    /**
+                     * Check if a box can stay in a cell.
+                     */
+                    bool fits(const Cell& cell, const Core::Geometry::BoundingBox& box) const;
+                    /**
+                     * Store an element in a cell.
+                     */
+                    void link(unsigned int handle, E* element, const Core::Geometry::BoundingBox& box);
+                    /**
+                     * Remove an element from its cell.
+                     */
+                    void unlink(unsigned int handle);
+                    /**
+                     * Allocate the children of a cell.
+                     */
+                    void divide(unsigned int cell);
+                    /**
+                     * Release the children of a cell (and their own children).
+                     */
+                    void release(unsigned int cell);
+                    /**
+                     * Recursive volume search.
+                     */
+                    template <typename S, typename V> unsigned int search(unsigned int cell, S& volume,
+                            E** buffer, unsigned int size, V* visitor) const;
+                    /**
+                     * Recursive ray search.
+                     */
+                    template <typename V> unsigned int search(unsigned int cell, const Core::Geometry::Ray3& ray,
+                            E** buffer, unsigned int size, V* visitor) const;
+                    /**
+                     * Fetch the entire content of a subtree.
+                     */
+                    template <typename V> unsigned int fetch(unsigned int cell,
+                            E** buffer, unsigned int size, V* visitor) const;
+                    /**
+                     * Recursive visit.
+                     */
+                    template <typename V> void visit(unsigned int cell, V& visitor);
+                private:
+                    /** Cell pool. Cell 0 is the root. */
+                    std::vector<Cell>         _cells;
+                    /** Released children blocks. */
+                    std::vector<unsigned int> _freeCells;
+                    /** Element slots. */
+                    std::vector<Slot>         _slots;
+                    /** Free element slots. */
+                    std::vector<unsigned int> _freeSlots;
+                    /** Maximum depth. */
+                    unsigned int              _depth;
+                    /** Looseness factor. */
+                    float                     _looseness;
+            };
+
+            template <typename E>
+                Tree<E>::Tree(const Core::Geometry::BoundingBox& world, unsigned int depth, float looseness) :
+                    _cells(1), _depth(depth), _looseness(looseness) {
+                        Cell& root = _cells[0];
+                        glm::vec3 extent = world.getExtent();
+                        root.center = world.getCenter();
+                        root.half = glm::max(extent.x, glm::max(extent.y, extent.z));
+                        root.loose = Core::Geometry::BoundingBox(root.center - glm::vec3(root.half * _looseness),
+                                root.center + glm::vec3(root.half * _looseness));
+                        root.parent = None;
+                        root.children = None;
+                        root.depth = 0;
+                        root.count = 0;
+                    }
+
+            template <typename E>
+                Tree<E>::~Tree() {
+                }
+
+            template <typename E>
+                bool Tree<E>::fits(const Cell& cell, const Core::Geometry::BoundingBox& box) const {
+                    const glm::vec3& bmin = box.getMin();
+                    const glm::vec3& bmax = box.getMax();
+                    const glm::vec3& lmin = cell.loose.getMin();
+                    const glm::vec3& lmax = cell.loose.getMax();
+                    return (bmin.x >= lmin.x) && (bmin.y >= lmin.y) && (bmin.z >= lmin.z) &&
+                        (bmax.x <= lmax.x) && (bmax.y <= lmax.y) && (bmax.z <= lmax.z);
+                }
+
+            template <typename E>
+                void Tree<E>::divide(unsigned int index) {
+                    unsigned int first;
+                    if(_freeCells.empty()) {
+                        first = static_cast<unsigned int>(_cells.size());
+                        _cells.resize(_cells.size() + 8);
+                    } else {
+                        first = _freeCells.back();
+                        _freeCells.pop_back();
+                    }
+                    Cell& cell = _cells[index];
+                    float half = cell.half * 0.5f;
+                    float loose = half * _looseness;
+                    for(unsigned int i = 0; i < 8; ++i) {
+                        Cell& child = _cells[first + i];
+                        child.center = cell.center + glm::vec3((i & 1) ? half : -half,
+                                (i & 2) ? half : -half, (i & 4) ? half : -half);
+                        child.half = half;
+                        child.loose = Core::Geometry::BoundingBox(child.center - glm::vec3(loose),
+                                child.center + glm::vec3(loose));
+                        child.parent = index;
+                        child.children = None;
+                        child.depth = cell.depth + 1;
+                        child.count = 0;
+                    }
+                    cell.children = first;
+                }
+
+            template <typename E>
+                void Tree<E>::release(unsigned int index) {
+                    unsigned int first = _cells[index].children;
+                    if(None == first) {
+                        return;
+                    }
+                    for(unsigned int i = 0; i < 8; ++i) {
+                        release(first + i);
+                        _cells[first + i].elements.clear();
+                        _cells[first + i].boxes.clear();
+                        _cells[first + i].handles.clear();
+                    }
+                    _cells[index].children = None;
+                    _freeCells.push_back(first);
+                }
+
+            template <typename E>
+                unsigned int Tree<E>::locate(const Core::Geometry::BoundingBox& box) {
+                    glm::vec3 center = box.getCenter();
+                    glm::vec3 extent = box.getExtent();
+                    float size = glm::max(extent.x, glm::max(extent.y, extent.z));
+                    unsigned int index = 0;
+                    const Cell& root = _cells[0];
+                    glm::vec3 offset = glm::abs(center - root.center);
+                    if((offset.x > root.half) || (offset.y > root.half) || (offset.z > root.half)) {
+                        return index;
+                    }
+                    // Go down as long as the box fits in the loose bounds of the
+                    // child holding its center.
+                    while(_cells[index].depth < _depth) {
+                        float half = _cells[index].half * 0.5f;
+                        if(size > (half * (_looseness - 1.0f))) {
+                            break;
+                        }
+                        if(None == _cells[index].children) {
+                            divide(index);
+                        }
+                        const Cell& cell = _cells[index];
+                        unsigned int child = ((center.x >= cell.center.x) ? 1 : 0) |
+                            ((center.y >= cell.center.y) ? 2 : 0) |
+                            ((center.z >= cell.center.z) ? 4 : 0);
+                        index = cell.children + child;
+                    }
+                    return index;
+                }
+
+            template <typename E>
+                void Tree<E>::link(unsigned int handle, E* element, const Core::Geometry::BoundingBox& box) {
+                    unsigned int index = locate(box);
+                    Cell& cell = _cells[index];
+                    _slots[handle].cell = index;
+                    _slots[handle].index = static_cast<unsigned int>(cell.elements.size());
+                    cell.elements.push_back(element);
+                    cell.boxes.push_back(box);
+                    cell.handles.push_back(handle);
+                    for(; None != index; index = _cells[index].parent) {
+                        ++_cells[index].count;
+                    }
+                }
+
+            template <typename E>
+                void Tree<E>::unlink(unsigned int handle) {
+                    Slot& slot = _slots[handle];
+                    unsigned int index = slot.cell;
+                    Cell& cell = _cells[index];
+                    unsigned int last = static_cast<unsigned int>(cell.elements.size() - 1);
+                    if(slot.index != last) {
+                        cell.elements[slot.index] = cell.elements[last];
+                        cell.boxes[slot.index] = cell.boxes[last];
+                        cell.handles[slot.index] = cell.handles[last];
+                        _slots[cell.handles[last]].index = slot.index;
+                    }
+                    cell.elements.pop_back();
+                    cell.boxes.pop_back();
+                    cell.handles.pop_back();
+                    for(; None != index; index = _cells[index].parent) {
+                        --_cells[index].count;
+                    }
+                    // Release empty subtrees.
+                    for(index = slot.cell; None != index; index = _cells[index].parent) {
+                        const Cell& current = _cells[index];
+                        if(current.count != current.elements.size()) {
+                            break;
+                        }
+                        release(index);
+                    }
+                    slot.cell = None;
+                }
+
+            template <typename E>
+                unsigned int Tree<E>::add(E* element, const Core::Geometry::BoundingBox& box) {
+                    unsigned int handle;
+                    if(_freeSlots.empty()) {
+                        handle = static_cast<unsigned int>(_slots.size());
+                        _slots.push_back(Slot());
+                    } else {
+                        handle = _freeSlots.back();
+                        _freeSlots.pop_back();
+                    }
+                    link(handle, element, box);
+                    return handle;
+                }
+
+            template <typename E>
+                void Tree<E>::remove(unsigned int handle) {
+                    if((handle >= _slots.size()) || (None == _slots[handle].cell)) {
+                        return;
+                    }
+                    unlink(handle);
+                    _freeSlots.push_back(handle);
+                }
+
+            template <typename E>
+                void Tree<E>::move(unsigned int handle, const Core::Geometry::BoundingBox& box) {
+                    Slot& slot = _slots[handle];
+                    Cell& cell = _cells[slot.cell];
+                    glm::vec3 extent = box.getExtent();
+                    float size = glm::max(extent.x, glm::max(extent.y, extent.z));
+                    if(fits(cell, box) && (size <= (cell.half * (_looseness - 1.0f)))) {
+                        cell.boxes[slot.index] = box;
+                        return;
+                    }
+                    E* element = cell.elements[slot.index];
+                    unlink(handle);
+                    link(handle, element, box);
+                }
+
+            template <typename E>
+                E* Tree<E>::element(unsigned int handle) const {
+                    const Slot& slot = _slots[handle];
+                    return _cells[slot.cell].elements[slot.index];
+                }
+
+            template <typename E>
+                const Core::Geometry::BoundingBox& Tree<E>::box(unsigned int handle) const {
+                    const Slot& slot = _slots[handle];
+                    return _cells[slot.cell].boxes[slot.index];
+                }
+
+            template <typename E>
+                unsigned int Tree<E>::size() const {
+                    return _cells[0].count;
+                }
+
+            template <typename E>
+                template <typename S, typename V>
+                unsigned int Tree<E>::retrieve(const S& volume, E** buffer, unsigned int size, V* visitor) const {
+                    // Containment tests are not const.
+                    S search(volume);
+                    return this->search(0, search, buffer, size, visitor);
+                }
+
+            template <typename E>
+                template <typename V>
+                unsigned int Tree<E>::retrieve(const Core::Geometry::Ray3& ray, E** buffer, unsigned int size, V* visitor) const {
+                    return search(0, ray, buffer, size, visitor);
+                }
+
+            template <typename E>
+                template <typename S, typename V>
+                unsigned int Tree<E>::search(unsigned int index, S& volume, E** buffer, unsigned int size, V* visitor) const {
+                    const Cell& cell = _cells[index];
+                    if((0 == cell.count) || (0 == size)) {
+                        return 0;
+                    }
+                    // The root also holds the elements outside of its loose bounds.
+                    bool overflow = (None == cell.parent);
+                    Core::Geometry::ContainmentType::Value containment = volume.contains(cell.loose);
+                    if(!overflow) {
+                        if(Core::Geometry::ContainmentType::Disjoints == containment) {
+                            return 0;
+                        }
+                        if(Core::Geometry::ContainmentType::Contains == containment) {
+                            return fetch(index, buffer, size, visitor);
+                        }
+                    }
+                    if(nullptr != visitor) {
+                        visitor->enter(cell.loose);
+                    }
+                    E** dest = buffer;
+                    unsigned int remaining = size;
+                    unsigned int count = static_cast<unsigned int>(cell.elements.size());
+                    for(unsigned int i = 0; (i < count) && (remaining > 0); ++i) {
+                        if(Core::Geometry::ContainmentType::Disjoints != volume.contains(cell.boxes[i])) {
+                            if(nullptr != visitor) {
+                                visitor->inspect(cell.elements[i]);
+                            }
+                            *dest = cell.elements[i];
+                            ++dest;
+                            --remaining;
+                        }
+                    }
+                    if((None != cell.children) && (Core::Geometry::ContainmentType::Disjoints != containment)) {
+                        unsigned int retrieved;
+                        for(unsigned int i = 0; i < 8; ++i) {
+                            retrieved = search(cell.children + i, volume, dest, remaining, visitor);
+                            remaining -= retrieved;
+                            dest += retrieved;
+                        }
+                    }
+                    if(nullptr != visitor) {
+                        visitor->exit(cell.loose);
+                    }
+                    return size - remaining;
+                }
+
+            template <typename E>
+                template <typename V>
+                unsigned int Tree<E>::search(unsigned int index, const Core::Geometry::Ray3& ray, E** buffer, unsigned int size, V* visitor) const {
+                    const Cell& cell = _cells[index];
+                    if((0 == cell.count) || (0 == size)) {
+                        return 0;
+                    }
+                    // The root also holds the elements outside of its loose bounds.
+                    float distance;
+                    bool hit = cell.loose.intersects(ray, distance);
+                    if(!hit && (None != cell.parent)) {
+                        return 0;
+                    }
+                    if(nullptr != visitor) {
+                        visitor->enter(cell.loose);
+                    }
+                    E** dest = buffer;
+                    unsigned int remaining = size;
+                    unsigned int count = static_cast<unsigned int>(cell.elements.size());
+                    for(unsigned int i = 0; (i < count) && (remaining > 0); ++i) {
+                        if(cell.boxes[i].intersects(ray, distance)) {
+                            if(nullptr != visitor) {
+                                visitor->inspect(cell.elements[i]);
+                            }
+                            *dest = cell.elements[i];
+                            ++dest;
+                            --remaining;
+                        }
+                    }
+                    if((None != cell.children) && hit) {
+                        unsigned int retrieved;
+                        for(unsigned int i = 0; i < 8; ++i) {
+                            retrieved = search(cell.children + i, ray, dest, remaining, visitor);
+                            remaining -= retrieved;
+                            dest += retrieved;
+                        }
+                    }
+                    if(nullptr != visitor) {
+                        visitor->exit(cell.loose);
+                    }
+                    return size - remaining;
+                }
+
+            template <typename E>
+                template <typename V>
+                unsigned int Tree<E>::fetch(unsigned int index, E** buffer, unsigned int size, V* visitor) const {
+                    const Cell& cell = _cells[index];
+                    if((0 == cell.count) || (0 == size)) {
+                        return 0;
+                    }
+                    if(nullptr != visitor) {
+                        visitor->enter(cell.loose);
+                    }
+                    unsigned int count = static_cast<unsigned int>(cell.elements.size());
+                    if((nullptr != visitor) && count) {
+                        visitor->inspect(const_cast<E**>(&cell.elements[0]), count);
+                    }
+                    unsigned int result = size < count ? size : count;
+                    E** dest = buffer;
+                    for(unsigned int i = 0; i < result; ++i, ++dest) {
+                        *dest = cell.elements[i];
+                    }
+                    unsigned int remaining = size - result;
+                    if(None != cell.children) {
+                        unsigned int retrieved;
+                        for(unsigned int i = 0; i < 8; ++i) {
+                            retrieved = fetch(cell.children + i, dest, remaining, visitor);
+                            remaining -= retrieved;
+                            dest += retrieved;
+                        }
+                    }
+                    if(nullptr != visitor) {
+                        visitor->exit(cell.loose);
+                    }
+                    return size - remaining;
+                }
+
+            template <typename E>
+                template <typename V>
+                void Tree<E>::visit(V& visitor) {
+                    visit(0, visitor);
+                }
+
+            template <typename E>
+                template <typename V>
+                void Tree<E>::visit(unsigned int index, V& visitor) {
+                    Cell& cell = _cells[index];
+                    visitor.enter(cell.loose);
+                    visitor.inspect(cell.elements.empty() ? nullptr : &cell.elements[0],
+                            static_cast<unsigned int>(cell.elements.size()));
+                    if(None != cell.children) {
+                        unsigned int first = cell.children;
+                        for(unsigned int i = 0; i < 8; ++i) {
+                            visit(first + i, visitor);
+                        }
+                    }
+                    visitor.exit(_cells[index].loose);
+                }
+
+        } // Namespace 'LooseOctree'
+    } // Namespace 'Logic'
+} // Namespace 'Dumb'
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 Stoned Xander
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DUMB_LOGIC_SEARCH_REGION
+#define DUMB_LOGIC_SEARCH_REGION
+
+#include <glm/glm.hpp>
+#include <DumbFramework/geometry/boundingquad.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+
+namespace Dumb {
+    namespace Logic {
+        namespace SearchTree {
+
+            /**
+             * Search tree region built on an axis aligned bounding volume.
+             *
+             * Implements the Region concept of 'SearchTree::Node', including
+             * the distance bounds used by nearest neighbour queries.
+             * Key containment is half-open (min <= key < max) so that keys on
+             * a boundary belong to a single sub-region. Sub-regions are
+             * numbered in Z-order: bit 'i' of the index selects the upper
+             * half along axis 'i'.
+             * @param <B> Bounding volume (BoundingQuad or BoundingBox).
+             * @param <V> Key vector type.
+             * @param <D> Number of axis.
+             */
+            template <typename B, typename V, int D> class BoundingRegion {
+                public:
+                    /**
+                     * Default constructor.
+                     */
+                    BoundingRegion();
+                    /**
+                     * Constructor.
+                     * @param bounds Region bounds.
+                     */
+                    BoundingRegion(const B& bounds);
+                    /**
+                     * Region bounds.
+                     */
+                    const B& bounds() const;
+                    /**
+                     * Key containment.
+                     * @param key Key.
+                     */
+                    bool contains(const V& key) const;
+                    /**
+                     * Number of sub-regions.
+                     */
+                    unsigned int dimension() const;
+                    /**
+                     * Divide the region.
+                     * @return Array of 'dimension()' sub-regions, to be
+                     *     released with 'delete []'.
+                     */
+                    BoundingRegion* divide() const;
+                    /**
+                     * Lower bound of the distance between a key and any key
+                     * of the region.
+                     * @param key Key.
+                     */
+                    float distance(const V& key) const;
+                    /**
+                     * Distance between two keys.
+                     * @param k0 First key.
+                     * @param k1 Second key.
+                     */
+                    float distance(const V& k0, const V& k1) const;
+                private:
+                    /** Bounds. */
+                    B _bounds;
+            };
+
+            /** Quadtree region. */
+            typedef BoundingRegion<Core::Geometry::BoundingQuad, glm::vec2, 2> QuadRegion;
+            /** Octree region. */
+            typedef BoundingRegion<Core::Geometry::BoundingBox, glm::vec3, 3> BoxRegion;
+
+            template <typename B, typename V, int D>
+                BoundingRegion<B, V, D>::BoundingRegion() {
+                }
+
+            template <typename B, typename V, int D>
+                BoundingRegion<B, V, D>::BoundingRegion(const B& bounds) : _bounds(bounds) {
+                }
+
+            template <typename B, typename V, int D>
+                const B& BoundingRegion<B, V, D>::bounds() const {
+                    return _bounds;
+                }
+
+            template <typename B, typename V, int D>
+                bool BoundingRegion<B, V, D>::contains(const V& key) const {
+                    const V& bmin = _bounds.getMin();
+                    const V& bmax = _bounds.getMax();
+                    for(int i = 0; i < D; ++i) {
+                        if((key[i] < bmin[i]) || (key[i] >= bmax[i])) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+            template <typename B, typename V, int D>
+                unsigned int BoundingRegion<B, V, D>::dimension() const {
+                    return 1 << D;
+                }
+
+            template <typename B, typename V, int D>
+                BoundingRegion<B, V, D>* BoundingRegion<B, V, D>::divide() const {
+                    const V& bmin = _bounds.getMin();
+                    const V& bmax = _bounds.getMax();
+                    V center = (bmin + bmax) / 2.0f;
+                    BoundingRegion<B, V, D>* regions = new BoundingRegion<B, V, D>[1 << D];
+                    for(unsigned int i = 0; i < (1U << D); ++i) {
+                        V lo, hi;
+                        for(int j = 0; j < D; ++j) {
+                            bool upper = (i >> j) & 1;
+                            lo[j] = upper ? center[j] : bmin[j];
+                            hi[j] = upper ? bmax[j] : center[j];
+                        }
+                        regions[i] = BoundingRegion<B, V, D>(B(lo, hi));
+                    }
+                    return regions;
+                }
+
+            template <typename B, typename V, int D>
+                float BoundingRegion<B, V, D>::distance(const V& key) const {
+                    V nearest = glm::clamp(key, _bounds.getMin(), _bounds.getMax());
+                    return glm::distance(key, nearest);
+                }
+
+            template <typename B, typename V, int D>
+                float BoundingRegion<B, V, D>::distance(const V& k0, const V& k1) const {
+                    return glm::distance(k0, k1);
+                }
+
+        } // Namespace 'SearchTree'
+    } // Namespace 'Logic'
+} // Namespace 'Dumb'
+
+#endif
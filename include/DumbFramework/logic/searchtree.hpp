@@ -16,12 +16,60 @@
 #ifndef DUMB_LOGIC_SEARCH_TREE
 #define DUMB_LOGIC_SEARCH_TREE
 
+#include <new>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <DumbFramework/logic/arena.hpp>
+
 #define DEFAULT_CARD 16
 #define VISIT_BUFFER_SIZE 32
 namespace Dumb {
     namespace Logic {
         namespace SearchTree {
 
+            template <typename K, typename R, typename E> class Linear;
+
+            /**
+             * Query callback storing elements in a fixed size buffer.
+             * Stops the query when the buffer is full.
+             */
+            template <typename E> class BufferOutput {
+                public:
+                    BufferOutput(E** buffer, unsigned int size) :
+                        _buffer(buffer), _size(size), _count(0) {}
+                    bool operator()(E* element) {
+                        if(_count >= _size) {
+                            return false;
+                        }
+                        _buffer[_count] = element;
+                        ++_count;
+                        return _count < _size;
+                    }
+                    /** Number of stored elements. */
+                    unsigned int count() const { return _count; }
+                private:
+                    E**          _buffer;
+                    unsigned int _size;
+                    unsigned int _count;
+            };
+
+            /**
+             * Query callback appending elements to a vector.
+             */
+            template <typename E> class VectorOutput {
+                public:
+                    VectorOutput(std::vector<E*>& output) : _output(&output) {}
+                    bool operator()(E* element) {
+                        _output->push_back(element);
+                        return true;
+                    }
+                private:
+                    std::vector<E*>* _output;
+            };
+
             /**
              * Search Tree Node.
              *
@@ -45,8 +93,15 @@ namespace Dumb {
              *         const K& key() const;
              *     Set the key.
              *         void key(const K&);
+             *
+             * Nodes and element arrays are allocated from an arena owned by
+             * the root node. Sub-nodes are stored contiguously, with their
+             * region inline. Elements that no split can tell apart, such as
+             * elements sharing a key, are kept in a leaf that grows past the
+             * cardinality.
              */
             template <typename K, typename R, typename E> class Node {
+                friend class Linear<K, R, E>;
                 public:
                     class Visitor {
                         public:
@@ -61,8 +116,10 @@ namespace Dumb {
                      * At creation, the node is a leaf and does not contains
                      * elements.
                      * @param region A node is defined for a particular region key.
+                     *     The region is copied.
                      * @param cardinality Maximum number of stored elements.
-                     * @param parent optional parent. nullptr if root.
+                     * @param parent optional parent. nullptr if root. The
+                     *     root node owns the arena shared by the whole tree.
                      */
                     Node(const R* region,
                             unsigned int cardinality = DEFAULT_CARD, Node *parent = nullptr);
@@ -87,22 +144,108 @@ namespace Dumb {
                      */
                     void move(E* element, K &key);
                     /**
-                     * Retrieve elements with a certain distance from the
-                     * specified key.
+                     * Move a batch of elements within the tree.
+                     * The search for the target leaf starts from the current
+                     * leaf of each element and only walks up as far as needed.
+                     * Merging of sparse nodes is done once for the whole batch.
+                     * @param elements Elements to be moved.
+                     * @param keys Target keys.
+                     * @param count Number of elements.
+                     */
+                    void move(E** elements, const K* keys, unsigned int count);
+                    /**
+                     * Replace the content of the tree.
+                     * Elements are partitioned top-down among the sub-regions
+                     * in a single pass, without the intermediate splits of
+                     * repeated 'add()' calls. Must be called on the root node.
+                     * @param elements Elements to store.
+                     * @param count Number of elements.
+                     */
+                    void build(E* const* elements, unsigned int count);
+                    /**
+                     * Stream elements with a certain distance from the
+                     * specified key to a callback.
+                     * Sub-trees fully contained by the search function are
+                     * streamed without testing their elements.
                      * @param func Search function.
-                     * @param buffer Storage for eligible elements.
-                     * @param size Size of the buffer.
+                     * @param callback Called for each eligible element.
                      * @param visitor Optional visitor.
                      * @param <S> Search function type. This concept must implement
                      * the following methods:
                      *   int contains(const R&); <- Partially or fully contains a region.
                      *   bool contains(const K&); <- Contains a key.
+                     * @param <F> Callback type. Must implement:
+                     *   bool operator()(E*); <- Returns false to stop the query.
                      * @param <V> Visitor concept.
-                     * @return Number of eligible elements. If there's more
-                     * eligible elements than 'size', return the negative value.
+                     * @return false if the query was stopped by the callback.
+                     */
+                    template <typename S, typename F, typename V = Visitor> bool query(const S& func,
+                            F callback, V* visitor = nullptr) const;
+                    /**
+                     * Retrieve elements with a certain distance from the
+                     * specified key.
+                     * @param func Search function.
+                     * @param buffer Storage for eligible elements.
+                     * @param size Size of the buffer.
+                     * @param visitor Optional visitor.
+                     * @param <S> Search function type. See 'query()'.
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements. The query stops
+                     * when the buffer is full.
                      */
                     template <typename S, typename V = Visitor> unsigned int retrieve(const S& func,
                             E** buffer, unsigned int size, V* visitor = nullptr) const;
+                    /**
+                     * Retrieve elements with a certain distance from the
+                     * specified key.
+                     * @param func Search function.
+                     * @param output Vector to which eligible elements are appended.
+                     * @param visitor Optional visitor.
+                     * @param <S> Search function type. See 'query()'.
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements.
+                     */
+                    template <typename S, typename V = Visitor> unsigned int retrieve(const S& func,
+                            std::vector<E*>& output, V* visitor = nullptr) const;
+                    /**
+                     * Find the nearest elements of a key.
+                     * Nodes are explored best-first, by increasing lower bound
+                     * of their distance to the key. The search ends when no
+                     * node can hold an element closer than the k-th best one.
+                     * The region must implement:
+                     *   float distance(const K&) const; <- Lower bound of the distance to a key.
+                     *   float distance(const K&, const K&) const; <- Distance between two keys.
+                     * @param key Reference key.
+                     * @param k Maximum number of elements to find.
+                     * @param buffer Storage for at least 'k' elements, sorted
+                     *     by increasing distance.
+                     * @param distances Optional storage for at least 'k' distances.
+                     * @param radius Maximum distance.
+                     * @return Number of found elements.
+                     */
+                    unsigned int nearest(const K& key, unsigned int k, E** buffer,
+                            float* distances = nullptr,
+                            float radius = std::numeric_limits<float>::max()) const;
+                    /**
+                     * Stream elements within a given distance of a key to a
+                     * callback.
+                     * The region must implement the distance methods
+                     * described in 'nearest()'.
+                     * @param key Reference key.
+                     * @param radius Maximum distance.
+                     * @param callback Called for each eligible element.
+                     * @param <F> Callback type. See 'query()'.
+                     * @return false if the query was stopped by the callback.
+                     */
+                    template <typename F> bool within(const K& key, float radius, F callback) const;
+                    /**
+                     * Retrieve elements within a given distance of a key.
+                     * @param key Reference key.
+                     * @param radius Maximum distance.
+                     * @param output Vector to which eligible elements are appended.
+                     * @return Number of retrieved elements.
+                     */
+                    unsigned int within(const K& key, float radius, std::vector<E*>& output) const;
                     /**
                      * Recursive visit of the tree.
                      * @param <V> Visitor concept.
@@ -118,64 +261,135 @@ namespace Dumb {
 
                 private:
                     /**
-                     * Fetch the entire content of the tree.
-                     * @param buffer Array in which to fetch elements.
-                     * @param size Size of this array.
+                     * Recursive part of 'query()'.
+                     */
+                    template <typename S, typename F, typename V> bool search(const S& func,
+                            F& callback, V* visitor) const;
+                    /**
+                     * Stream the entire content of the tree.
+                     * @param callback Called for each element.
                      * @param visitor Optional visitor.
+                     * @param <F> Callback type.
                      * @param <V> Visitor concept.
-                     * @return Number of retrieved elements.
+                     * @return false if stopped by the callback.
+                     */
+                    template <typename F, typename V> bool fetch(F& callback, V* visitor) const;
+                    /**
+                     * Recursive part of 'within()'.
                      */
-                    template <typename V = Visitor> unsigned int fetch(E** buffer,
-                            unsigned int size, V* visitor = nullptr) const;
+                    template <typename F> bool around(const K& key, float radius, F& callback) const;
                     /**
                      * Find the leaf that can possibly host the key.
                      * @param key Node key to locate.
                      * @return A leaf or nullptr if the key is outside the master region.
                      */
                     Node* find(const K& key);
+                    /**
+                     * Allocate and build sub-nodes.
+                     */
+                    void divide();
+                    /**
+                     * Store an element in a leaf, splitting it as needed.
+                     * @param leaf Leaf hosting the element key.
+                     * @param element Element to store.
+                     */
+                    void insert(Node* leaf, E* element);
+                    /**
+                     * Append an element to this leaf, growing its storage
+                     * if needed.
+                     * @param element Element to append.
+                     */
+                    void append(E* element);
+                    /**
+                     * Check if splitting this node separates elements from
+                     * a key. The node must be divided.
+                     * @param key Reference key.
+                     * @param elements Elements to check.
+                     * @param count Number of elements.
+                     * @return false if all the elements fall in the
+                     *     sub-region holding the key.
+                     */
+                    bool separable(const K& key, E* const* elements, unsigned int count) const;
+                    /**
+                     * Remove an element from this leaf.
+                     * @param element Element to remove.
+                     * @return true if the element was found.
+                     */
+                    bool detach(E* element);
+                    /**
+                     * Merge ancestors holding few enough elements.
+                     */
+                    void collapse();
+                    /**
+                     * Distribute elements in this subtree.
+                     * @param elements Elements to store. The array is reordered.
+                     * @param count Number of elements.
+                     */
+                    void partition(E** elements, unsigned int count);
+                private:
+                    Node(const Node&) = delete;
+                    Node& operator=(const Node&) = delete;
                 private:
                     /** Region of interest. */
-                    const R*                 _region;
-                    /** Stored elements. 'null' if not leaf. */
+                    R                        _region;
+                    /** Stored elements. Only relevant for leaves. */
                     E**                      _elements;
                     /** Element or node count. */
                     unsigned int             _count;
                     /** Maximum number of elements. */
                     unsigned int             _cardinality;
-                    /** Sub-node. 'null' if leaf. */
-                    Node<K, R, E>**          _nodes;
+                    /** Size of the element array. */
+                    unsigned int             _capacity;
+                    /** Contiguous sub-nodes. 'null' if never divided. */
+                    Node<K, R, E>*           _nodes;
                     /** Parent node. */
                     Node<K, R, E>*           _parent;
+                    /** Node and element storage. */
+                    Arena*                   _arena;
                     /** Leaf indicator. Indirect recycling info. */
                     bool                     _leaf;
             };
 
             template <typename K, typename R, typename E>
                 Node<K, R, E>::Node(const R* region, unsigned int card, Node<K, R, E>* parent) :
-                    _region(region), _elements(new E*[card]), _count(0),
-                    _cardinality(card), _nodes(nullptr), _parent(parent), _leaf(true) {
+                    _region(*region), _elements(nullptr), _count(0),
+                    _cardinality(card), _capacity(card), _nodes(nullptr), _parent(parent),
+                    _arena(nullptr != parent ? parent->_arena : new Arena()), _leaf(true) {
+                        _elements = static_cast<E**>(_arena->allocate(card * sizeof(E*)));
                     }
 
             template <typename K, typename R, typename E>
                 Node<K, R, E>::~Node() {
-                    delete []_elements;
                     if(_nodes != nullptr) {
-                        unsigned int dimension = _region->dimension();
-                        const R* region = _nodes[0]->_region;
+                        unsigned int dimension = _region.dimension();
                         for(unsigned int i = 0; i < dimension; ++i) {
-                            delete _nodes[i];
+                            _nodes[i].~Node();
                         }
-                        delete []region;
-                        delete []_nodes;
+                        _arena->release(_nodes, dimension * sizeof(Node<K, R, E>));
+                    }
+                    _arena->release(_elements, _capacity * sizeof(E*));
+                    if(nullptr == _parent) {
+                        delete _arena;
                     }
                 }
 
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::divide() {
+                    unsigned int dimension = _region.dimension();
+                    const R* regions = _region.divide();
+                    _nodes = static_cast<Node<K, R, E>*>(_arena->allocate(dimension * sizeof(Node<K, R, E>)));
+                    for(unsigned int i = 0; i < dimension; ++i) {
+                        new (_nodes + i) Node<K, R, E>(regions + i, _cardinality, this);
+                    }
+                    delete []regions;
+                }
+
             template <typename K, typename R, typename E>
                 Node<K, R, E>* Node<K, R, E>::find(const K& key) {
                     Node<K, R, E>* result;
-                    if(_region->contains(key)) {
+                    if(_region.contains(key)) {
                         result = this;
-                        Node<K, R, E>** nodes;
+                        Node<K, R, E>* nodes;
 #ifdef TREE_DEBUG
                         bool loop;
 #endif
@@ -185,8 +399,8 @@ namespace Dumb {
                             loop = true;
 #endif
                             for(unsigned int i = 0; i < result->_count; ++i) {
-                                if(nodes[i]->_region->contains(key)) {
-                                    result = nodes[i];
+                                if(nodes[i]._region.contains(key)) {
+                                    result = nodes + i;
 #ifdef TREE_DEBUG
                                     loop = false;
 #endif
@@ -207,113 +421,248 @@ namespace Dumb {
                 }
 
             template <typename K, typename R, typename E>
-                void Node<K, R, E>::add(E* element) {
+                void Node<K, R, E>::insert(Node<K, R, E>* node, E* element) {
                     const K& key = element->key();
-                    Node<K, R, E>* node = find(key);
-                    if(nullptr != node) {
-                        while(_cardinality == node->_count) {
-                            node->_leaf = false;
-                            unsigned int dimension = node->_region->dimension();
-                            if(nullptr == node->_nodes) {
-                                node->_nodes = new Node<K, R, E>*[dimension];
-                                const R* regions = node->_region->divide();
-                                for(unsigned int i = 0; i < dimension; ++i) {
-                                    node->_nodes[i] = new Node<K, R, E>(regions + i, _cardinality, node);
+                    while(node->_count >= _cardinality) {
+                        unsigned int dimension = node->_region.dimension();
+                        if(nullptr == node->_nodes) {
+                            node->divide();
+                        }
+                        if(!node->separable(key, node->_elements, node->_count)) {
+                            break;
+                        }
+                        node->_leaf = false;
+                        E** toShare = node->_elements;
+                        unsigned int shareCount = node->_count;
+                        Node<K, R, E>* target;
+                        for(unsigned int i = 0; i < dimension; ++i) {
+                            target = node->_nodes + i;
+                            target->_leaf = true;
+                            target->_count = 0;
+                            for(unsigned int j = 0; j < shareCount;) {
+                                if(target->_region.contains(toShare[j]->key())) {
+                                    target->append(toShare[j]);
+                                    --shareCount;
+                                    toShare[j] = toShare[shareCount];
+                                } else {
+                                    ++j;
                                 }
                             }
-                            E** toShare = node->_elements;
-                            unsigned int shareCount = node->_count;
-                            Node<K, R, E>* target;
-                            for(unsigned int i = 0; i < dimension; ++i) {
-                                target = node->_nodes[i];
-                                target->_count = 0;
-                                for(unsigned int j = 0; j < shareCount;) {
-                                    if(target->_region->contains(toShare[j]->key())) {
-                                        target->_elements[target->_count] = toShare[j];
-                                        ++target->_count;
-                                        --shareCount;
-                                        toShare[j] = toShare[shareCount];
-                                    } else {
-                                        ++j;
-                                    }
-                                }
+                        }
+                        node->_count = dimension;
+                        for(unsigned int i = 0; i < dimension; ++i) {
+                            target = node->_nodes + i;
+                            if(target->_region.contains(key)) {
+                                node = target;
+                                break;
                             }
-                            node->_count = dimension;
-                            for(unsigned int i = 0; i < dimension; ++i) {
-                                target = node->_nodes[i];
-                                if(target->_region->contains(key)) {
-                                    node = target;
-                                    break;
+                        }
+                    }
+                    node->append(element);
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::append(E* element) {
+                    if(_count == _capacity) {
+                        unsigned int capacity = 2 * _capacity;
+                        E** elements = static_cast<E**>(_arena->allocate(capacity * sizeof(E*)));
+                        std::copy(_elements, _elements + _count, elements);
+                        _arena->release(_elements, _capacity * sizeof(E*));
+                        _elements = elements;
+                        _capacity = capacity;
+                    }
+                    _elements[_count] = element;
+                    ++_count;
+                }
+
+            template <typename K, typename R, typename E>
+                bool Node<K, R, E>::separable(const K& key, E* const* elements, unsigned int count) const {
+                    unsigned int dimension = _region.dimension();
+                    for(unsigned int i = 0; i < dimension; ++i) {
+                        const Node<K, R, E>* target = _nodes + i;
+                        if(target->_region.contains(key)) {
+                            for(unsigned int j = 0; j < count; ++j) {
+                                if(!target->_region.contains(elements[j]->key())) {
+                                    return true;
                                 }
                             }
+                            return false;
                         }
-                        node->_elements[node->_count] = element;
-                        ++node->_count;
                     }
+                    return false;
                 }
 
             template <typename K, typename R, typename E>
-                void Node<K, R, E>::remove(E* element) {
-                    const K& key = element->key();
-                    Node<K, R, E>* node = find(key);
-                    if(nullptr != node) {
+                bool Node<K, R, E>::detach(E* element) {
+                    E** elements = _elements;
+                    for(unsigned int i = 0; i < _count; ++i, ++elements) {
+                        if(element == (*elements)) {
+                            --_count;
+                            *elements = _elements[_count];
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::collapse() {
+                    Node<K, R, E>* node = this;
+                    while(nullptr != node->_parent) {
+                        node = node->_parent;
+                        if(node->_leaf) {
+                            // Already merged by a previous collapse of the batch.
+                            break;
+                        }
+                        unsigned int global = 0;
                         unsigned int count = node->_count;
-                        E** elements = node->_elements;
-                        for(unsigned int i = 0; i < count; ++i, ++elements) {
-                            if(element == (*elements)) {
-                                --node->_count;
-                                *elements = node->_elements[node->_count];
-                                break;
+                        for(unsigned int i = 0; i < count; ++i) {
+                            if(node->_nodes[i]._leaf) {
+                                global += node->_nodes[i]._count;
+                            } else {
+                                global += _cardinality + 1;
                             }
                         }
-
-                        while(nullptr != node->_parent) {
-                            node = node->_parent;
-                            unsigned int global = 0;
-                            unsigned int count = node->_count;
+                        if(global <= _cardinality) {
+                            node->_leaf = true;
+                            node->_count = 0;
                             for(unsigned int i = 0; i < count; ++i) {
-                                if(node->_nodes[i]->_leaf) {
-                                    global += node->_nodes[i]->_count;
-                                } else {
-                                    global += _cardinality + 1;
+                                Node<K, R, E>* target = node->_nodes + i;
+                                unsigned int toRetrieve = target->_count;
+                                for(unsigned int j = 0; j < toRetrieve; ++j) {
+                                    node->_elements[node->_count] = target->_elements[j];
+                                    ++node->_count;
                                 }
                             }
-                            if(global <= _cardinality) {
-                                node->_leaf = true;
-                                node->_count = 0;
-                                for(unsigned int i = 0; i < count; ++i) {
-                                    Node<K, R, E>* target = node->_nodes[i];
-                                    unsigned int toRetrieve = target->_count;
-                                    for(unsigned int j = 0; j < toRetrieve; ++j) {
-                                        node->_elements[node->_count] = target->_elements[j];
-                                        ++node->_count;
-                                    }
-                                }
-                            } else {
-                                break;
-                            }
+                        } else {
+                            break;
                         }
                     }
                 }
 
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::add(E* element) {
+                    Node<K, R, E>* node = find(element->key());
+                    if(nullptr != node) {
+                        insert(node, element);
+                    }
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::remove(E* element) {
+                    Node<K, R, E>* node = find(element->key());
+                    if(nullptr != node) {
+                        node->detach(element);
+                        node->collapse();
+                    }
+                }
+
             template <typename K, typename R, typename E>
                 void Node<K, R, E>::move(E* element, K& key) {
-                    const K& elementKey = element->key();
-                    element->key(key);
-                    Node<K, R, E>* sourceNode = find(elementKey);
-                    Node<K, R, E>* destinationNode = find(key);
-                    if(destinationNode != sourceNode) {
-                        destinationNode->add(element);
-                        sourceNode->remove(element);
+                    move(&element, &key, 1);
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::move(E** elements, const K* keys, unsigned int count) {
+                    // Leaves that lost elements. Their parents are merged at the end.
+                    std::vector<Node<K, R, E>*> sources;
+                    sources.reserve(count);
+                    for(unsigned int i = 0; i < count; ++i) {
+                        E* element = elements[i];
+                        Node<K, R, E>* source = find(element->key());
+                        element->key(keys[i]);
+                        if((nullptr == source) || !source->detach(element)) {
+                            continue;
+                        }
+                        sources.push_back(source);
+                        Node<K, R, E>* node = source;
+                        while((nullptr != node->_parent) && !node->_region.contains(keys[i])) {
+                            node = node->_parent;
+                        }
+                        node = node->find(keys[i]);
+                        if(nullptr != node) {
+                            insert(node, element);
+                        }
+                    }
+                    std::sort(sources.begin(), sources.end());
+                    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+                    for(typename std::vector<Node<K, R, E>*>::iterator it = sources.begin(); it != sources.end(); ++it) {
+                        (*it)->collapse();
+                    }
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::build(E* const* elements, unsigned int count) {
+                    std::vector<E*> inside;
+                    inside.reserve(count);
+                    for(unsigned int i = 0; i < count; ++i) {
+                        if(_region.contains(elements[i]->key())) {
+                            inside.push_back(elements[i]);
+                        }
+                    }
+                    partition(inside.empty() ? nullptr : &inside[0], static_cast<unsigned int>(inside.size()));
+                }
+
+            template <typename K, typename R, typename E>
+                void Node<K, R, E>::partition(E** elements, unsigned int count) {
+                    if(count > _cardinality) {
+                        if(nullptr == _nodes) {
+                            divide();
+                        }
+                    }
+                    if((count <= _cardinality) || !separable(elements[0]->key(), elements + 1, count - 1)) {
+                        _leaf = true;
+                        _count = 0;
+                        for(unsigned int i = 0; i < count; ++i) {
+                            append(elements[i]);
+                        }
+                        return;
+                    }
+                    _leaf = false;
+                    unsigned int dimension = _region.dimension();
+                    _count = dimension;
+                    E** first = elements;
+                    E** last = elements + count;
+                    for(unsigned int i = 0; i < dimension; ++i) {
+                        Node<K, R, E>* target = _nodes + i;
+                        E** middle = std::partition(first, last,
+                                [target](E* element) { return target->_region.contains(element->key()); });
+                        target->partition(first, static_cast<unsigned int>(middle - first));
+                        first = middle;
                     }
                 }
 
+            template <typename K, typename R, typename E>
+                template <typename S, typename F, typename V>
+                bool Node<K, R, E>::query(const S& func, F callback, V* visitor) const {
+                    return search(func, callback, visitor);
+                }
+
             template <typename K, typename R, typename E>
                 template <typename S, typename V>
                 unsigned int Node<K, R, E>::retrieve(const S& func, E** buffer, unsigned int size, V* visitor) const {
-                    unsigned int result;
+                    BufferOutput<E> output(buffer, size);
+                    if(size > 0) {
+                        search(func, output, visitor);
+                    }
+                    return output.count();
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename S, typename V>
+                unsigned int Node<K, R, E>::retrieve(const S& func, std::vector<E*>& output, V* visitor) const {
+                    size_t first = output.size();
+                    VectorOutput<E> callback(output);
+                    search(func, callback, visitor);
+                    return static_cast<unsigned int>(output.size() - first);
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename S, typename F, typename V>
+                bool Node<K, R, E>::search(const S& func, F& callback, V* visitor) const {
+                    bool proceed = true;
                     if(nullptr != visitor) {
-                        visitor->enter(*_region);
+                        visitor->enter(_region);
                     }
                     // Here comes the fun.
                     if(_leaf) {
@@ -321,113 +670,576 @@ namespace Dumb {
                         // 1. This leaf intersects with the search function.
                         // 2. This leaf is the root node and might not be relevant ...
                         // In all case, we must confront all the elements to 'func'.
-                        unsigned int max = size < _count ? size : _count;
-                        E** dest = buffer;
                         E** cur = _elements;
-                        result = 0;
-                        for(unsigned int i = 0; i < max; ++i, ++cur) {
+                        for(unsigned int i = 0; proceed && (i < _count); ++i, ++cur) {
                             if(func.contains((*cur)->key())) {
                                 if(nullptr != visitor) {
                                     visitor->inspect(*cur);
                                 }
-                                *dest = *cur;
-                                ++dest;
-                                ++result;
+                                proceed = callback(*cur);
                             }
                         }
                     } else {
                         // We're in a node.
                         // Let's test all the subs against the 'func'. In some cases,
                         // fetch the whole sub-tree, in other cases, just recurse the retrieval.
-                        E** dest = buffer;
-                        unsigned int remaining = size;
-                        unsigned int retrieved;
                         int intersects;
-                        Node<K, R, E>** nodes = _nodes;
-                        for(unsigned int i = 0; i < _count; ++i, ++nodes) {
-                            intersects = func.contains(*((*nodes)->_region));
+                        const Node<K, R, E>* nodes = _nodes;
+                        for(unsigned int i = 0; proceed && (i < _count); ++i, ++nodes) {
+                            intersects = func.contains(nodes->_region);
                             if(intersects >= 0) {
                                 if(intersects != 0) {
-                                    retrieved = (*nodes)->fetch(dest, remaining, visitor);
+                                    proceed = nodes->fetch(callback, visitor);
                                 } else {
-                                    retrieved = (*nodes)->retrieve(func, dest, remaining, visitor);
+                                    proceed = nodes->search(func, callback, visitor);
                                 }
-                                remaining -= retrieved;
-                                dest += retrieved;
                             }
                         }
-                        result = size - remaining;
                     }
                     if(nullptr != visitor) {
-                        visitor->exit(*_region);
+                        visitor->exit(_region);
                     }
-                    return result;
+                    return proceed;
                 }
 
             template <typename K, typename R, typename E>
-                template <typename V>
-                unsigned int Node<K, R, E>::fetch(E** buffer, unsigned int size, V* visitor) const {
+                template <typename F, typename V>
+                bool Node<K, R, E>::fetch(F& callback, V* visitor) const {
+                    bool proceed = true;
                     if(nullptr != visitor) {
-                        visitor->enter(*_region);
+                        visitor->enter(_region);
                     }
-                    unsigned int result;
                     if(_leaf) {
                         if(nullptr != visitor) {
                             visitor->inspect(_elements, _count);
                         }
                         // Get all the elements.
-                        result = size < _count ? size : _count;
-                        E** dest = buffer;
                         E** src = _elements;
-                        for(unsigned int i = 0; i < result; ++i, ++dest, ++src) {
-                            *dest = *src;
+                        for(unsigned int i = 0; proceed && (i < _count); ++i, ++src) {
+                            proceed = callback(*src);
                         }
                     } else {
-                        result = 0;
-                        E** dest = buffer;
-                        unsigned int remaining = size;
-                        unsigned int retrieved;
-                        for(unsigned int i = 0; i < _count; ++i) {
-                            retrieved = _nodes[i]->fetch(dest, remaining);
-                            remaining -= retrieved;
-                            dest += retrieved;
+                        for(unsigned int i = 0; proceed && (i < _count); ++i) {
+                            proceed = _nodes[i].fetch(callback, visitor);
                         }
-                        result = size - remaining;
                     }
                     if(nullptr != visitor) {
-                        visitor->exit(*_region);
+                        visitor->exit(_region);
                     }
-                    return result;
+                    return proceed;
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Node<K, R, E>::nearest(const K& key, unsigned int k, E** buffer, float* distances, float radius) const {
+                    if(0 == k) {
+                        return 0;
+                    }
+                    // Nodes to explore, as a min-heap on distance lower bound.
+                    typedef std::pair<float, const Node<K, R, E>*> Pending;
+                    std::vector<Pending> pending;
+                    pending.reserve(64);
+                    // Best candidates so far, as a max-heap on distance.
+                    typedef std::pair<float, E*> Candidate;
+                    std::vector<Candidate> best;
+                    best.reserve(k);
+                    float bound = radius;
+                    pending.push_back(Pending(0.0f, this));
+                    while(!pending.empty()) {
+                        std::pop_heap(pending.begin(), pending.end(), std::greater<Pending>());
+                        Pending current = pending.back();
+                        pending.pop_back();
+                        if(current.first > bound) {
+                            break;
+                        }
+                        const Node<K, R, E>* node = current.second;
+                        if(node->_leaf) {
+                            E** cur = node->_elements;
+                            for(unsigned int i = 0; i < node->_count; ++i, ++cur) {
+                                float d = _region.distance(key, (*cur)->key());
+                                if(d > bound) {
+                                    continue;
+                                }
+                                if(best.size() == k) {
+                                    std::pop_heap(best.begin(), best.end());
+                                    best.back() = Candidate(d, *cur);
+                                } else {
+                                    best.push_back(Candidate(d, *cur));
+                                }
+                                std::push_heap(best.begin(), best.end());
+                                if(best.size() == k) {
+                                    bound = best.front().first < radius ? best.front().first : radius;
+                                }
+                            }
+                        } else {
+                            const Node<K, R, E>* nodes = node->_nodes;
+                            for(unsigned int i = 0; i < node->_count; ++i, ++nodes) {
+                                if(nodes->_leaf && (0 == nodes->_count)) {
+                                    continue;
+                                }
+                                float d = nodes->_region.distance(key);
+                                if(d <= bound) {
+                                    pending.push_back(Pending(d, nodes));
+                                    std::push_heap(pending.begin(), pending.end(), std::greater<Pending>());
+                                }
+                            }
+                        }
+                    }
+                    std::sort_heap(best.begin(), best.end());
+                    unsigned int count = static_cast<unsigned int>(best.size());
+                    for(unsigned int i = 0; i < count; ++i) {
+                        buffer[i] = best[i].second;
+                        if(nullptr != distances) {
+                            distances[i] = best[i].first;
+                        }
+                    }
+                    return count;
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename F>
+                bool Node<K, R, E>::within(const K& key, float radius, F callback) const {
+                    return around(key, radius, callback);
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Node<K, R, E>::within(const K& key, float radius, std::vector<E*>& output) const {
+                    size_t first = output.size();
+                    VectorOutput<E> callback(output);
+                    around(key, radius, callback);
+                    return static_cast<unsigned int>(output.size() - first);
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename F>
+                bool Node<K, R, E>::around(const K& key, float radius, F& callback) const {
+                    if(_leaf) {
+                        E** cur = _elements;
+                        for(unsigned int i = 0; i < _count; ++i, ++cur) {
+                            if((_region.distance(key, (*cur)->key()) <= radius) && !callback(*cur)) {
+                                return false;
+                            }
+                        }
+                        return true;
+                    }
+                    const Node<K, R, E>* nodes = _nodes;
+                    for(unsigned int i = 0; i < _count; ++i, ++nodes) {
+                        if((nodes->_region.distance(key) <= radius) && !nodes->around(key, radius, callback)) {
+                            return false;
+                        }
+                    }
+                    return true;
                 }
 
             template <typename K, typename R, typename E>
                 template <typename V>
                 void Node<K, R, E>::visit(V &visitor) {
-                    visitor.enter(*_region);
+                    visitor.enter(_region);
                     if(_leaf) {
                         visitor.inspect(_elements, _count);
                     } else {
                         for(unsigned int i = 0; i < _count; ++i) {
-                            _nodes[i]->visit(visitor);
+                            _nodes[i].visit(visitor);
                         }
                     }
-                    visitor.exit(*_region);
+                    visitor.exit(_region);
                 }
 
 #ifdef TREE_DEBUG
             template <typename K, typename R, typename E>
                 template <typename V>
                 void Node<K, R, E>::deepVisit(V &visitor) {
-                    visitor.visit(this, _region, _elements, _nodes, _parent, _leaf, _count, _cardinality);
+                    visitor.visit(this, &_region, _elements, _nodes, _parent, _leaf, _count, _cardinality);
                     if(_nodes) {
-                        unsigned int dimension = _region->dimension();
+                        unsigned int dimension = _region.dimension();
                         for(unsigned int i = 0; i < dimension; ++i) {
-                            _nodes[i]->deepVisit(visitor);
+                            _nodes[i].deepVisit(visitor);
                         }
                     }
                 }
 #endif
 
+            /**
+             * Linearized Search Tree.
+             *
+             * Read-only copy of a tree, meant for read-mostly data. Nodes are
+             * stored in depth-first order, sub-nodes in the order given by
+             * 'R::divide()' (which is the Morton order for Z-ordered
+             * subdivisions). Elements of any subtree are stored contiguously.
+             * Queries are then a forward walk over two arrays: skipped
+             * subtrees are jumped over and fully contained subtrees are
+             * fetched with a single copy.
+             * Element keys are copied along with the elements, so queries
+             * never read the elements themselves.
+             * The copy must be rebuilt when the source tree changes.
+             */
+            template <typename K, typename R, typename E> class Linear {
+                public:
+                    typedef typename Node<K, R, E>::Visitor Visitor;
+                public:
+                    /**
+                     * Constructor.
+                     * Build an empty tree.
+                     */
+                    Linear();
+                    /**
+                     * Constructor.
+                     * @param root Tree to linearize.
+                     */
+                    Linear(const Node<K, R, E>& root);
+                    /**
+                     * Rebuild from a tree.
+                     * @param root Tree to linearize.
+                     */
+                    void build(const Node<K, R, E>& root);
+                    /**
+                     * Number of stored elements.
+                     */
+                    unsigned int size() const;
+                    /**
+                     * Stream elements to a callback. Same as 'Node::query()'.
+                     * @param func Search function.
+                     * @param callback Called for each eligible element.
+                     * @param visitor Optional visitor.
+                     * @param <S> Search function type.
+                     * @param <F> Callback type.
+                     * @param <V> Visitor concept.
+                     * @return false if the query was stopped by the callback.
+                     */
+                    template <typename S, typename F, typename V = Visitor> bool query(const S& func,
+                            F callback, V* visitor = nullptr) const;
+                    /**
+                     * Retrieve elements. Same as 'Node::retrieve()'.
+                     * @param func Search function.
+                     * @param buffer Storage for eligible elements.
+                     * @param size Size of the buffer.
+                     * @param visitor Optional visitor.
+                     * @param <S> Search function type.
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements.
+                     */
+                    template <typename S, typename V = Visitor> unsigned int retrieve(const S& func,
+                            E** buffer, unsigned int size, V* visitor = nullptr) const;
+                    /**
+                     * Retrieve elements. Same as 'Node::retrieve()'.
+                     * @param func Search function.
+                     * @param output Vector to which eligible elements are appended.
+                     * @param visitor Optional visitor.
+                     * @param <S> Search function type.
+                     * @param <V> Visitor concept.
+                     * @return Number of retrieved elements.
+                     */
+                    template <typename S, typename V = Visitor> unsigned int retrieve(const S& func,
+                            std::vector<E*>& output, V* visitor = nullptr) const;
+                    /**
+                     * Find the nearest elements of a key. Same as 'Node::nearest()'.
+                     * @param key Reference key.
+                     * @param k Maximum number of elements to find.
+                     * @param buffer Storage for at least 'k' elements.
+                     * @param distances Optional storage for at least 'k' distances.
+                     * @param radius Maximum distance.
+                     * @return Number of found elements.
+                     */
+                    unsigned int nearest(const K& key, unsigned int k, E** buffer,
+                            float* distances = nullptr,
+                            float radius = std::numeric_limits<float>::max()) const;
+                    /**
+                     * Stream elements within a given distance of a key to a
+                     * callback. Same as 'Node::within()'.
+                     * @param key Reference key.
+                     * @param radius Maximum distance.
+                     * @param callback Called for each eligible element.
+                     * @param <F> Callback type.
+                     * @return false if the query was stopped by the callback.
+                     */
+                    template <typename F> bool within(const K& key, float radius, F callback) const;
+                    /**
+                     * Retrieve elements within a given distance of a key.
+                     * @param key Reference key.
+                     * @param radius Maximum distance.
+                     * @param output Vector to which eligible elements are appended.
+                     * @return Number of retrieved elements.
+                     */
+                    unsigned int within(const K& key, float radius, std::vector<E*>& output) const;
+                    /**
+                     * Visit of the tree. Same as 'Node::visit()'.
+                     * @param <V> Visitor concept.
+                     * @param visitor Visitor.
+                     */
+                    template <typename V> void visit(V& visitor) const;
+                private:
+                    /** Linearized node. */
+                    struct Cell {
+                        /** Region of interest. */
+                        R            region;
+                        /** Index of the node following the subtree. */
+                        unsigned int next;
+                        /** First element of the subtree. */
+                        unsigned int first;
+                        /** Past the last element of the subtree. */
+                        unsigned int last;
+                        /** Leaf indicator. */
+                        bool         leaf;
+                    };
+                    /**
+                     * Append a subtree.
+                     */
+                    void flatten(const Node<K, R, E>& node);
+                private:
+                    /** Nodes in depth-first order. */
+                    std::vector<Cell> _cells;
+                    /** Elements in depth-first order. */
+                    std::vector<E*>   _elements;
+                    /** Element keys. */
+                    std::vector<K>    _keys;
+            };
+
+            template <typename K, typename R, typename E>
+                Linear<K, R, E>::Linear() {
+                }
+
+            template <typename K, typename R, typename E>
+                Linear<K, R, E>::Linear(const Node<K, R, E>& root) {
+                    build(root);
+                }
+
+            template <typename K, typename R, typename E>
+                void Linear<K, R, E>::build(const Node<K, R, E>& root) {
+                    _cells.clear();
+                    _elements.clear();
+                    _keys.clear();
+                    flatten(root);
+                }
+
+            template <typename K, typename R, typename E>
+                void Linear<K, R, E>::flatten(const Node<K, R, E>& node) {
+                    unsigned int index = static_cast<unsigned int>(_cells.size());
+                    Cell cell = { node._region, 0, static_cast<unsigned int>(_elements.size()), 0, node._leaf };
+                    _cells.push_back(cell);
+                    if(node._leaf) {
+                        _elements.insert(_elements.end(), node._elements, node._elements + node._count);
+                        for(unsigned int i = 0; i < node._count; ++i) {
+                            _keys.push_back(node._elements[i]->key());
+                        }
+                    } else {
+                        for(unsigned int i = 0; i < node._count; ++i) {
+                            flatten(node._nodes[i]);
+                        }
+                    }
+                    _cells[index].next = static_cast<unsigned int>(_cells.size());
+                    _cells[index].last = static_cast<unsigned int>(_elements.size());
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Linear<K, R, E>::size() const {
+                    return static_cast<unsigned int>(_elements.size());
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename S, typename V>
+                unsigned int Linear<K, R, E>::retrieve(const S& func, E** buffer, unsigned int size, V* visitor) const {
+                    BufferOutput<E> output(buffer, size);
+                    if(size > 0) {
+                        query(func, std::ref(output), visitor);
+                    }
+                    return output.count();
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename S, typename V>
+                unsigned int Linear<K, R, E>::retrieve(const S& func, std::vector<E*>& output, V* visitor) const {
+                    size_t first = output.size();
+                    query(func, VectorOutput<E>(output), visitor);
+                    return static_cast<unsigned int>(output.size() - first);
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename S, typename F, typename V>
+                bool Linear<K, R, E>::query(const S& func, F callback, V* visitor) const {
+                    // Nodes entered by the visitor and not exited yet.
+                    std::vector<unsigned int> open;
+                    bool proceed = true;
+                    unsigned int count = static_cast<unsigned int>(_cells.size());
+                    for(unsigned int i = 0; proceed && (i < count);) {
+                        if(nullptr != visitor) {
+                            while(!open.empty() && (_cells[open.back()].next <= i)) {
+                                visitor->exit(_cells[open.back()].region);
+                                open.pop_back();
+                            }
+                        }
+                        const Cell& cell = _cells[i];
+                        // As in 'Node::query()', the root region is not tested.
+                        int intersects = (0 == i) ? 0 : func.contains(cell.region);
+                        if(intersects < 0) {
+                            i = cell.next;
+                        } else if(intersects != 0) {
+                            // Fetch the whole subtree.
+                            if(nullptr != visitor) {
+                                visitor->enter(cell.region);
+                                if(cell.first < cell.last) {
+                                    visitor->inspect(const_cast<E**>(&_elements[cell.first]), cell.last - cell.first);
+                                }
+                                visitor->exit(cell.region);
+                            }
+                            for(unsigned int j = cell.first; proceed && (j < cell.last); ++j) {
+                                proceed = callback(_elements[j]);
+                            }
+                            i = cell.next;
+                        } else if(cell.leaf) {
+                            if(nullptr != visitor) {
+                                visitor->enter(cell.region);
+                            }
+                            for(unsigned int j = cell.first; proceed && (j < cell.last); ++j) {
+                                E* element = _elements[j];
+                                if(func.contains(_keys[j])) {
+                                    if(nullptr != visitor) {
+                                        visitor->inspect(element);
+                                    }
+                                    proceed = callback(element);
+                                }
+                            }
+                            if(nullptr != visitor) {
+                                visitor->exit(cell.region);
+                            }
+                            i = cell.next;
+                        } else {
+                            // Go down.
+                            if(nullptr != visitor) {
+                                visitor->enter(cell.region);
+                                open.push_back(i);
+                            }
+                            ++i;
+                        }
+                    }
+                    if(nullptr != visitor) {
+                        while(!open.empty()) {
+                            visitor->exit(_cells[open.back()].region);
+                            open.pop_back();
+                        }
+                    }
+                    return proceed;
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Linear<K, R, E>::nearest(const K& key, unsigned int k, E** buffer, float* distances, float radius) const {
+                    if((0 == k) || _cells.empty()) {
+                        return 0;
+                    }
+                    const R& metric = _cells[0].region;
+                    // Nodes to explore, as a min-heap on distance lower bound.
+                    typedef std::pair<float, unsigned int> Pending;
+                    std::vector<Pending> pending;
+                    pending.reserve(64);
+                    // Best candidates so far, as a max-heap on distance.
+                    typedef std::pair<float, unsigned int> Candidate;
+                    std::vector<Candidate> best;
+                    best.reserve(k);
+                    float bound = radius;
+                    pending.push_back(Pending(0.0f, 0));
+                    while(!pending.empty()) {
+                        std::pop_heap(pending.begin(), pending.end(), std::greater<Pending>());
+                        Pending current = pending.back();
+                        pending.pop_back();
+                        if(current.first > bound) {
+                            break;
+                        }
+                        const Cell& cell = _cells[current.second];
+                        if(cell.leaf) {
+                            for(unsigned int j = cell.first; j < cell.last; ++j) {
+                                float d = metric.distance(key, _keys[j]);
+                                if(d > bound) {
+                                    continue;
+                                }
+                                if(best.size() == k) {
+                                    std::pop_heap(best.begin(), best.end());
+                                    best.back() = Candidate(d, j);
+                                } else {
+                                    best.push_back(Candidate(d, j));
+                                }
+                                std::push_heap(best.begin(), best.end());
+                                if(best.size() == k) {
+                                    bound = best.front().first < radius ? best.front().first : radius;
+                                }
+                            }
+                        } else {
+                            for(unsigned int i = current.second + 1; i < cell.next; i = _cells[i].next) {
+                                const Cell& child = _cells[i];
+                                if(child.first == child.last) {
+                                    continue;
+                                }
+                                float d = child.region.distance(key);
+                                if(d <= bound) {
+                                    pending.push_back(Pending(d, i));
+                                    std::push_heap(pending.begin(), pending.end(), std::greater<Pending>());
+                                }
+                            }
+                        }
+                    }
+                    std::sort_heap(best.begin(), best.end());
+                    unsigned int count = static_cast<unsigned int>(best.size());
+                    for(unsigned int i = 0; i < count; ++i) {
+                        buffer[i] = _elements[best[i].second];
+                        if(nullptr != distances) {
+                            distances[i] = best[i].first;
+                        }
+                    }
+                    return count;
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename F>
+                bool Linear<K, R, E>::within(const K& key, float radius, F callback) const {
+                    unsigned int count = static_cast<unsigned int>(_cells.size());
+                    for(unsigned int i = 0; i < count;) {
+                        const Cell& cell = _cells[i];
+                        if((0 != i) && (cell.region.distance(key) > radius)) {
+                            i = cell.next;
+                        } else if(cell.leaf) {
+                            for(unsigned int j = cell.first; j < cell.last; ++j) {
+                                if((cell.region.distance(key, _keys[j]) <= radius) && !callback(_elements[j])) {
+                                    return false;
+                                }
+                            }
+                            i = cell.next;
+                        } else {
+                            ++i;
+                        }
+                    }
+                    return true;
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Linear<K, R, E>::within(const K& key, float radius, std::vector<E*>& output) const {
+                    size_t first = output.size();
+                    within(key, radius, VectorOutput<E>(output));
+                    return static_cast<unsigned int>(output.size() - first);
+                }
+
+            template <typename K, typename R, typename E>
+                template <typename V>
+                void Linear<K, R, E>::visit(V& visitor) const {
+                    std::vector<unsigned int> open;
+                    unsigned int count = static_cast<unsigned int>(_cells.size());
+                    for(unsigned int i = 0; i < count; ++i) {
+                        while(!open.empty() && (_cells[open.back()].next <= i)) {
+                            visitor.exit(_cells[open.back()].region);
+                            open.pop_back();
+                        }
+                        const Cell& cell = _cells[i];
+                        visitor.enter(cell.region);
+                        if(cell.leaf) {
+                            visitor.inspect((cell.first < cell.last) ? const_cast<E**>(&_elements[cell.first]) : nullptr,
+                                    cell.last - cell.first);
+                            visitor.exit(cell.region);
+                        } else {
+                            open.push_back(i);
+                        }
+                    }
+                    while(!open.empty()) {
+                        visitor.exit(_cells[open.back()].region);
+                        open.pop_back();
+                    }
+                }
+
         } // Namespace 'SearchTree'
     } // Namespace 'Logic'
 } // Namespace 'Dumb'
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2015 Stoned Xander
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DUMB_LOGIC_SNAPSHOT
+#define DUMB_LOGIC_SNAPSHOT
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <DumbFramework/logic/searchtree.hpp>
+
+#define SNAPSHOT_CACHE_LINE 64
+namespace Dumb {
+    namespace Logic {
+        namespace SearchTree {
+
+            /**
+             * Search Tree Snapshots.
+             *
+             * A single writer publishes linearized copies of a tree, while
+             * reader threads query the last published copy without locks.
+             * A reader keeps a consistent view of the tree for as long as it
+             * holds it, whatever the writer publishes in the meantime.
+             *
+             * Each publication starts a new epoch, and each reader announces
+             * the copy it pins in its own slot. A retired copy is recycled
+             * once no reader announces it, so at most 'readers + 2' copies
+             * exist whatever the readers do. Recycled copies keep their
+             * storage, so steady state publishing does not allocate.
+             */
+            template <typename K, typename R, typename E> class Snapshots {
+                private:
+                    /** Published copy. */
+                    struct Copy {
+                        /** Linearized tree. */
+                        Linear<K, R, E> tree;
+                        /** Publication epoch. */
+                        uint64_t        epoch;
+                    };
+                public:
+                    /**
+                     * Reader view. Pins the last published copy until
+                     * destroyed.
+                     */
+                    class View {
+                        public:
+                            /**
+                             * Constructor.
+                             * @param snapshots Snapshot publisher.
+                             * @param reader Reader slot, unique to the calling thread.
+                             */
+                            View(const Snapshots& snapshots, unsigned int reader);
+                            /**
+                             * Destructor.
+                             * Release the pinned copy.
+                             */
+                            ~View();
+                            /**
+                             * Pinned copy.
+                             */
+                            const Linear<K, R, E>& tree() const;
+                            /**
+                             * Pinned copy.
+                             */
+                            const Linear<K, R, E>* operator->() const;
+                            /**
+                             * Epoch in which the copy was published.
+                             */
+                            uint64_t epoch() const;
+                        private:
+                            View(const View&) = delete;
+                            View& operator=(const View&) = delete;
+                        private:
+                            /** Publisher. */
+                            const Snapshots& _snapshots;
+                            /** Reader slot. */
+                            unsigned int     _reader;
+                            /** Pinned copy. */
+                            const Copy*      _copy;
+                    };
+                public:
+                    /**
+                     * Constructor.
+                     * An empty copy is published at creation.
+                     * @param readers Number of reader slots.
+                     */
+                    Snapshots(unsigned int readers);
+                    /**
+                     * Destructor.
+                     * No view must be alive.
+                     */
+                    ~Snapshots();
+                    /**
+                     * Publish a copy of a tree. Writer thread only.
+                     * @param root Tree to publish.
+                     * @return Epoch of the publication.
+                     */
+                    uint64_t publish(const Node<K, R, E>& root);
+                    /**
+                     * Number of allocated copies.
+                     */
+                    unsigned int capacity() const;
+                private:
+                    Snapshots(const Snapshots&) = delete;
+                    Snapshots& operator=(const Snapshots&) = delete;
+                    /**
+                     * Pin the current copy.
+                     * @param reader Reader slot.
+                     */
+                    const Copy* acquire(unsigned int reader) const;
+                    /**
+                     * Unpin the current copy.
+                     * @param reader Reader slot.
+                     */
+                    void release(unsigned int reader) const;
+                    /**
+                     * Check if a retired copy can be recycled.
+                     * @param copy Retired copy.
+                     */
+                    bool reclaimable(const Copy* copy) const;
+                private:
+                    /** Reader slot, padded to avoid false sharing. */
+                    struct Slot {
+                        /** Pinned copy. 'null' if idle. */
+                        std::atomic<const Copy*> copy;
+                        /** Padding. */
+                        char padding[SNAPSHOT_CACHE_LINE - sizeof(std::atomic<const Copy*>)];
+                    };
+                private:
+                    /** Reader slots. */
+                    Slot*                                 _slots;
+                    /** Number of reader slots. */
+                    unsigned int                          _readers;
+                    /** Current copy. */
+                    std::atomic<Copy*>                    _current;
+                    /** Last publication epoch. Writer only. */
+                    uint64_t                              _epoch;
+                    /** Retired copies. Writer only. */
+                    std::vector<Copy*>                    _retired;
+                    /** Number of allocated copies. */
+                    unsigned int                          _capacity;
+            };
+
+            template <typename K, typename R, typename E>
+                Snapshots<K, R, E>::View::View(const Snapshots<K, R, E>& snapshots, unsigned int reader) :
+                    _snapshots(snapshots), _reader(reader), _copy(snapshots.acquire(reader)) {
+                    }
+
+            template <typename K, typename R, typename E>
+                Snapshots<K, R, E>::View::~View() {
+                    _snapshots.release(_reader);
+                }
+
+            template <typename K, typename R, typename E>
+                const Linear<K, R, E>& Snapshots<K, R, E>::View::tree() const {
+                    return _copy->tree;
+                }
+
+            template <typename K, typename R, typename E>
+                const Linear<K, R, E>* Snapshots<K, R, E>::View::operator->() const {
+                    return &_copy->tree;
+                }
+
+            template <typename K, typename R, typename E>
+                uint64_t Snapshots<K, R, E>::View::epoch() const {
+                    return _copy->epoch;
+                }
+
+            template <typename K, typename R, typename E>
+                Snapshots<K, R, E>::Snapshots(unsigned int readers) :
+                    _slots(new Slot[readers]), _readers(readers),
+                    _current(new Copy()), _epoch(1), _capacity(1) {
+                        _current.load()->epoch = 1;
+                        for(unsigned int i = 0; i < readers; ++i) {
+                            _slots[i].copy.store(nullptr);
+                        }
+                    }
+
+            template <typename K, typename R, typename E>
+                Snapshots<K, R, E>::~Snapshots() {
+                    delete _current.load();
+                    for(typename std::vector<Copy*>::iterator it = _retired.begin(); it != _retired.end(); ++it) {
+                        delete *it;
+                    }
+                    delete []_slots;
+                }
+
+            template <typename K, typename R, typename E>
+                const typename Snapshots<K, R, E>::Copy* Snapshots<K, R, E>::acquire(unsigned int reader) const {
+                    // Announce the copy, then check that it was not retired in the
+                    // meantime. Once announced, it is not recycled until released.
+                    const Copy* copy = _current.load();
+                    for(;;) {
+                        _slots[reader].copy.store(copy);
+                        const Copy* current = _current.load();
+                        if(current == copy) {
+                            return copy;
+                        }
+                        copy = current;
+                    }
+                }
+
+            template <typename K, typename R, typename E>
+                void Snapshots<K, R, E>::release(unsigned int reader) const {
+                    _slots[reader].copy.store(nullptr);
+                }
+
+            template <typename K, typename R, typename E>
+                bool Snapshots<K, R, E>::reclaimable(const Copy* copy) const {
+                    for(unsigned int i = 0; i < _readers; ++i) {
+                        if(_slots[i].copy.load() == copy) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+            template <typename K, typename R, typename E>
+                uint64_t Snapshots<K, R, E>::publish(const Node<K, R, E>& root) {
+                    Copy* copy = nullptr;
+                    for(typename std::vector<Copy*>::iterator it = _retired.begin(); it != _retired.end(); ++it) {
+                        if(reclaimable(*it)) {
+                            copy = *it;
+                            *it = _retired.back();
+                            _retired.pop_back();
+                            break;
+                        }
+                    }
+                    if(nullptr == copy) {
+                        copy = new Copy();
+                        ++_capacity;
+                    }
+                    copy->tree.build(root);
+                    copy->epoch = ++_epoch;
+                    _retired.push_back(_current.exchange(copy));
+                    return copy->epoch;
+                }
+
+            template <typename K, typename R, typename E>
+                unsigned int Snapshots<K, R, E>::capacity() const {
+                    return _capacity;
+                }
+
+        } // Namespace 'SearchTree'
+    } // Namespace 'Logic'
+} // Namespace 'Dumb'
+
+#endif
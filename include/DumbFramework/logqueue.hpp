@@ -0,0 +1,221 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_LOG_QUEUE_
+#define _DUMB_FW_LOG_QUEUE_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Dumb {
+namespace Log  {
+    /**
+     * @brief Bounded lock-free queue.
+     * @ingroup DUMB_FW_LOG
+     *
+     * Fixed size ring where every slot carries its own sequence number.
+     * Producers claim a slot by advancing the tail with a CAS, the
+     * consumer does the same on the head. No lock is ever taken and
+     * slot storage is allocated once, at construction.
+     * Although the log processor only has a single consumer, @c pop
+     * is safe to call concurrently so that producers may evict the
+     * oldest entry when the queue is full.
+     *
+     * Values are exchanged with @c std::swap. This way a slot keeps
+     * the buffer of the value it last handed out, and strings stored
+     * in the ring stop allocating once they reached their usual size.
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+        public:
+            /**
+             * Constructor.
+             * @param [in] capacity  Number of slots. It is rounded up to
+             *                       the next power of two.
+             */
+            explicit BoundedQueue(size_t capacity);
+            /** Destructor. **/
+            ~BoundedQueue();
+            /**
+             * Push value.
+             * On success @a value is swapped with the slot content.
+             * @param [in,out] value  Value to push.
+             * @return false if the queue is full.
+             */
+            bool push(T & value);
+            /**
+             * Push value in place.
+             * @a writer is called with the claimed slot content. The
+             * slot is published once it returns. It is only called if
+             * a slot was available.
+             * @param [in] writer  Functor filling the slot.
+             * @return false if the queue is full.
+             */
+            template <typename F>
+            bool emplace(F & writer);
+            /**
+             * Pop value.
+             * On success @a value is swapped with the slot content.
+             * @param [out] value  Popped value.
+             * @return false if the queue is empty.
+             */
+            bool pop(T & value);
+            /** Return true if the queue looks empty. **/
+            bool empty() const;
+            /** Number of slots. **/
+            size_t capacity() const;
+
+        private:
+            BoundedQueue(BoundedQueue const &);
+            BoundedQueue& operator= (BoundedQueue const &);
+
+            /** Swap pushed value with the slot content. **/
+            struct Exchange
+            {
+                T & value;
+                explicit Exchange(T & v) : value(v) {}
+                void operator() (T & slot) { std::swap(slot, value); }
+            };
+
+        private:
+            /** Cache line size used to keep head and tail apart. **/
+            enum { CacheLine = 64 };
+            /** Ring slot. **/
+            struct Slot
+            {
+                std::atomic<size_t> sequence;
+                T value;
+            };
+
+            Slot  *_slots;
+            size_t _mask;
+            char   _pad0[CacheLine];
+            std::atomic<size_t> _tail;
+            char   _pad1[CacheLine];
+            std::atomic<size_t> _head;
+            char   _pad2[CacheLine];
+    };
+
+    // Constructor.
+    template <typename T>
+    BoundedQueue<T>::BoundedQueue(size_t capacity)
+        : _slots(NULL)
+        , _mask(0)
+        , _tail(0)
+        , _head(0)
+    {
+        size_t count = 2;
+        while(count < capacity) { count <<= 1; }
+        _slots = new Slot[count];
+        _mask  = count - 1;
+        for(size_t i=0; i<count; i++)
+        {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    // Destructor.
+    template <typename T>
+    BoundedQueue<T>::~BoundedQueue()
+    {
+        delete [] _slots;
+    }
+    // Push value.
+    template <typename T>
+    bool BoundedQueue<T>::push(T & value)
+    {
+        Exchange writer(value);
+        return emplace(writer);
+    }
+    // Push value in place.
+    template <typename T>
+    template <typename F>
+    bool BoundedQueue<T>::emplace(F & writer)
+    {
+        size_t position = _tail.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot *slot = &_slots[position & _mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t delta = (intptr_t)sequence - (intptr_t)position;
+            if(0 == delta)
+            {
+                if(_tail.compare_exchange_weak(position, position+1, std::memory_order_relaxed))
+                {
+                    writer(slot->value);
+                    slot->sequence.store(position+1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(delta < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // Pop value.
+    template <typename T>
+    bool BoundedQueue<T>::pop(T & value)
+    {
+        size_t position = _head.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot *slot = &_slots[position & _mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t delta = (intptr_t)sequence - (intptr_t)(position+1);
+            if(0 == delta)
+            {
+                if(_head.compare_exchange_weak(position, position+1, std::memory_order_relaxed))
+                {
+                    std::swap(slot->value, value);
+                    slot->sequence.store(position+_mask+1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(delta < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    // Return true if the queue looks empty.
+    template <typename T>
+    bool BoundedQueue<T>::empty() const
+    {
+        size_t position = _head.load(std::memory_order_relaxed);
+        size_t sequence = _slots[position & _mask].sequence.load(std::memory_order_acquire);
+        return (sequence != (position+1));
+    }
+    // Number of slots.
+    template <typename T>
+    size_t BoundedQueue<T>::capacity() const
+    {
+        return _mask + 1;
+    }
+
+} // Log
+} // Dumb
+
+#endif /* _DUMB_FW_LOG_QUEUE_ */
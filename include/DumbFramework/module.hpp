@@ -17,32 +17,56 @@
 #define _DUMB_FW_MODULE_
 
 #include <string>
+#include <stdint.h>
 
 namespace Dumb   {
 namespace Module {
 /// @brief Application module identifier.
 /// @ingroup DUMB_FW_LOG
 /// Identifier of the current application module.
+///
+/// Module names are interned in a process-wide registry. Each name is
+/// given a small integer the first time it is seen, and identifiers
+/// only hold this integer. Copies and comparisons are integer
+/// operations, and the integer can directly index per-module tables
+/// (see Dumb::Log::Thresholds).
+///
+/// The registry holds at most Identifier::Capacity names. Once it is
+/// full, new names are mapped to the Base module.
 class Identifier
 {
     public:
+        /// Maximum number of modules.
+        static const uint32_t Capacity = 256;
+        /// Default constructor.
+        /// The identifier refers to the Base module.
+        constexpr Identifier() : _id(0) {}
         /// Constructor.
         /// @param [in] name Module name.
         Identifier(std::string const& name);
-        /// Destructor.
-        ~Identifier();
         /// Check if two identifiers are equal.
         /// @param [in] id Module identifier.
-        bool operator== (Identifier const& id);
+        bool operator== (Identifier const& id) const { return (_id == id._id); }
         /// Check if two identifiers are different.
         /// @param [in] id Module identifier.
-        bool operator!= (Identifier const& id);
+        bool operator!= (Identifier const& id) const { return (_id != id._id); }
         /// Get module name.
         /// @return Module name.
         std::string const& toString() const;
+        /// Get module index.
+        /// @return Index in [0, Capacity[.
+        uint32_t id() const { return _id; }
+        /// Number of registered modules.
+        static uint32_t count();
     private:
-        /// Module name.
-        std::string _name;
+        /// Constructor used by the built-in modules.
+        /// @param [in] id Module index.
+        constexpr explicit Identifier(uint32_t id) : _id(id) {}
+        /// Built-in module identifiers.
+        friend struct BuiltIn;
+    private:
+        /// Module index.
+        uint32_t _id;
 };
 
 /// @defgroup DUMB_FW_LOG_MODULES Module identifiers.
@@ -51,13 +75,13 @@ class Identifier
 
 /// Base module identifier.
 /// @ingroup DUMB_FW_LOG_MODULES
-static const Identifier Base("Base");
+extern const Identifier Base;
 /// App module identifier.
 /// @ingroup DUMB_FW_LOG_MODULES
-static const Identifier App("App");
+extern const Identifier App;
 /// Render module identifier.
 /// @ingroup DUMB_FW_LOG_MODULES
-static const Identifier Render("Render");
+extern const Identifier Render;
 } // Module
 } // Dumb
 
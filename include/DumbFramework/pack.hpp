@@ -0,0 +1,251 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _DUMB_FW_PACK_
+#define _DUMB_FW_PACK_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <DumbFramework/file.hpp>
+
+namespace Dumb {
+
+/**
+ * @brief Read-only resource archive.
+ *
+ * A pack stores many small files in a single one. It is laid out as
+ * follows (little endian):
+ *     - a header,
+ *     - the table of contents, sorted by path,
+ *     - an open addressing hash table indexing the table of contents,
+ *     - the paths,
+ *     - the entries data. Each entry starts on a multiple of the
+ *       alignment stored in the header.
+ *
+ * The archive is mapped with File::map. Paths are resolved with a
+ * single hash table probe in the general case. Uncompressed entries
+ * are accessed in place. Compressed entries are inflated on demand.
+ *
+ * Entries compressed with the @a BLOCKS method are split into blocks
+ * of the same uncompressed size, compressed independently with
+ * BlockCodec. The stored data starts with the block size, the block
+ * count and the end offset of each block. A block whose stored size is
+ * its uncompressed size is stored as is. Blocks can be decompressed in
+ * parallel (see Pack::extract) or one after the other into the
+ * destination buffer (see Pack::extractBlock).
+ *
+ * Once a pack is mounted (see Pack::mount), File::open transparently
+ * serves the files it contains when they are opened in @a READ_ONLY
+ * mode. The loaders do not need to know about packs.
+ */
+class Pack
+{
+    public:
+        /** Entry compression method. **/
+        enum Compression
+        {
+            /** Stored as is. **/
+            NONE = 0,
+            /** zlib stream (only available if built with zlib). **/
+            DEFLATE = 1,
+            /** Independent BlockCodec blocks. **/
+            BLOCKS = 2
+        };
+
+        /** Archive entry. **/
+        struct Entry
+        {
+            /** Absolute offset of the data in the archive. **/
+            uint64_t offset;
+            /** Uncompressed size in bytes. **/
+            uint64_t size;
+            /** Stored size in bytes. **/
+            uint64_t storedSize;
+            /** Path hash. **/
+            uint32_t hash;
+            /** Offset of the path in the path table. **/
+            uint32_t pathOffset;
+            /** Path length in bytes. **/
+            uint32_t pathLength;
+            /** Compression method. **/
+            uint32_t compression;
+        };
+
+        /** Default entry alignment in bytes. **/
+        static const uint32_t DefaultAlignment;
+        /** Default uncompressed block size in bytes (@a BLOCKS method). **/
+        static const uint32_t DefaultBlockSize;
+
+        /**
+         * @brief Pack writer.
+         *
+         * Collect files and write them into a new archive.
+         */
+        class Builder
+        {
+            public:
+                /** Constructor. **/
+                Builder();
+                /**
+                 * Add file.
+                 * @param [in] path         Path of the entry in the archive.
+                 * @param [in] filename     Name of the file to store.
+                 * @param [in] compression  Compression method. The entry is
+                 *                          stored as is if the compressed
+                 *                          data is not smaller.
+                 */
+                void add(std::string const& path, std::string const& filename, Pack::Compression compression=Pack::NONE);
+                /**
+                 * Set block size.
+                 * @param [in] size  Uncompressed size in bytes of the
+                 *                   blocks of the @a BLOCKS method.
+                 */
+                void setBlockSize(uint32_t size);
+                /**
+                 * Write archive.
+                 * @param [in] filename   Archive file name.
+                 * @param [in] alignment  Entry alignment in bytes. It is
+                 *                        rounded up to the next power of two.
+                 * @return false if a file could not be read, if two files
+                 *         have the same path or if the archive could not
+                 *         be written.
+                 */
+                bool write(std::string const& filename, uint32_t alignment=Pack::DefaultAlignment);
+                /** Number of bytes stored in the last written archive. **/
+                uint64_t storedSize() const;
+                /** Number of bytes of the files of the last written archive. **/
+                uint64_t originalSize() const;
+
+            private:
+                struct Source
+                {
+                    std::string path;
+                    std::string filename;
+                    Pack::Compression compression;
+                };
+                std::vector<Source> _sources;
+                uint32_t _blockSize;
+                uint64_t _storedSize;
+                uint64_t _originalSize;
+        };
+
+    public:
+        /** Constructor. **/
+        Pack();
+        /** Destructor. **/
+        ~Pack();
+        /**
+         * Open and map archive.
+         * @param [in] filename  Archive file name.
+         * @return false if the file could not be mapped or is not a
+         *         valid archive.
+         */
+        bool open(std::string const& filename);
+        /**
+         * Close archive.
+         * The pack is unmounted if needed.
+         */
+        void close();
+        /** Check if the archive is opened. **/
+        bool isOpened() const;
+        /** Number of entries. **/
+        size_t count() const;
+        /**
+         * Get entry.
+         * Entries are sorted by path.
+         * @param [in] index  Entry index.
+         */
+        Entry const& entry(size_t index) const;
+        /** Get entry path. **/
+        std::string path(Entry const& entry) const;
+        /**
+         * Find entry.
+         * @param [in] path  Entry path.
+         * @return NULL if the archive does not contain @a path.
+         */
+        Entry const* find(std::string const& path) const;
+        /**
+         * Get stored data.
+         * @return Pointer to the Entry::storedSize bytes of the entry.
+         */
+        unsigned char const* data(Entry const& entry) const;
+        /**
+         * Read entry content.
+         * @param [in]  entry    Archive entry.
+         * @param [out] out      Uncompressed content.
+         * @param [in]  threads  Maximum number of threads decompressing
+         *                       the blocks of a @a BLOCKS entry.
+         * @return false if the entry could not be decompressed.
+         */
+        bool extract(Entry const& entry, std::vector<unsigned char>& out, unsigned int threads=1) const;
+        /**
+         * Get the number of blocks of an entry.
+         * Entries that are not compressed with the @a BLOCKS method are
+         * made of a single block.
+         * @return 0 if the block table is invalid.
+         */
+        size_t blockCount(Entry const& entry) const;
+        /** Get the uncompressed block size of an entry. **/
+        size_t blockSize(Entry const& entry) const;
+        /**
+         * Read entry block.
+         * @param [in]  entry  Archive entry.
+         * @param [in]  index  Block index.
+         * @param [out] out    Destination of the whole entry content.
+         *                     The block is written at its offset in the
+         *                     entry (@a index times Pack::blockSize).
+         * @return false if the block could not be decompressed.
+         */
+        bool extractBlock(Entry const& entry, size_t index, unsigned char* out) const;
+
+        /**
+         * Mount archive.
+         * Files whose name starts with @a directory followed by a path
+         * separator are looked up in the archive. An empty @a directory
+         * matches relative file names. Packs are searched from the last
+         * mounted to the first one.
+         * @param [in] pack       Archive. It must remain opened while it
+         *                        is mounted.
+         * @param [in] directory  Mount point.
+         * @return false if the archive is not opened.
+         */
+        static bool mount(Pack* pack, std::string const& directory);
+        /** Unmount archive. **/
+        static void unmount(Pack* pack);
+        /**
+         * Resolve file name against the mounted packs.
+         * @param [in]  filename  File name.
+         * @param [out] entry     Archive entry.
+         * @return Pack containing the file, or NULL.
+         */
+        static Pack const* resolve(std::string const& filename, Entry const*& entry);
+
+    private:
+        Pack(Pack const&);
+        Pack& operator= (Pack const&);
+
+    private:
+        File _file;
+        Entry const* _entries;
+        uint32_t const* _slots;
+        char const* _paths;
+        uint32_t _count;
+        uint32_t _slotCount;
+};
+
+} // Dumb
+
+#endif /* _DUMB_FW_PACK_ */
@@ -8,8 +8,6 @@
 
 #include <DumbFramework/file.hpp>
 
-#define PARSER_HANDLER_BUFFER_SIZE 65536
-
 namespace XML {
 
 
@@ -24,13 +22,11 @@ template <typename T> class Parser {
 public:
 
   static void parse(T *target, const char *filename) {
-    char buffer[PARSER_HANDLER_BUFFER_SIZE];
-    
     Dumb::File input;
     bool ret;
-    size_t rdLen;
     
-    ret = input.open(filename, Dumb::File::READ_ONLY);
+    // The document is parsed directly from the mapped file.
+    ret = input.open(filename, Dumb::File::READ_ONLY) && input.map(Dumb::File::SEQUENTIAL);
     if(!ret) {
       std::cerr << "Can't read " << filename << "!" << std::endl;
       return;
@@ -40,14 +36,11 @@ public:
     XML_SetUserData(parser, target);
     XML_SetElementHandler(parser, startElementHandler, endElementHandler);
 
-    while((rdLen = input.read(buffer, PARSER_HANDLER_BUFFER_SIZE)) > 0) {
-      if(!XML_Parse(parser,
-                    buffer,
-                    rdLen,
-                    rdLen < PARSER_HANDLER_BUFFER_SIZE)) {
-        // TODO ERROR
-        break;
-      }
+    if(!XML_Parse(parser,
+                  reinterpret_cast<const char*>(input.data()),
+                  (int)input.size(),
+                  1)) {
+      // TODO ERROR
     }
   
     XML_ParserFree(parser);
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <DumbFramework/file.hpp>
+#include <DumbFramework/ioservice.hpp>
+
+using namespace Dumb;
+
+template <typename F>
+static double measure(F f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/** Reference implementation: files read one after the other. **/
+static size_t referenceRead(std::vector<std::string> const& names)
+{
+    size_t total = 0;
+    // Keep the contents like a loader would.
+    std::vector<std::vector<unsigned char> > contents(names.size());
+    for(size_t i=0; i<names.size(); i++)
+    {
+        File file;
+        if(!file.open(names[i], File::READ_ONLY))
+        {
+            continue;
+        }
+        contents[i].resize(file.size());
+        total += file.read(contents[i].data(), contents[i].size());
+        file.close();
+    }
+    return total;
+}
+
+static size_t serviceRead(std::vector<std::string> const& names, unsigned int threads)
+{
+    size_t total = 0;
+    std::vector<std::vector<unsigned char> > contents;
+    contents.reserve(names.size());
+    IOService service;
+    service.start(threads);
+    for(size_t i=0; i<names.size(); i++)
+    {
+        service.read(names[i], 0, 0, 0, [&total, &contents](IOService::Completion &completion)
+        {
+            total += completion.data.size();
+            contents.push_back(std::vector<unsigned char>());
+            contents.back().swap(completion.data);
+        });
+    }
+    while(service.outstanding())
+    {
+        service.wait();
+        service.poll();
+    }
+    service.poll();
+    service.stop();
+    return total;
+}
+
+int main()
+{
+    const size_t count = 2048;
+    const size_t size  = 16 * 1024;
+    std::vector<std::string> names(count);
+    std::vector<char> content(size, 'x');
+    char buffer[64];
+    for(size_t i=0; i<count; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "bench_io_%04d.bin", (int)i);
+        names[i] = buffer;
+        FILE *out = fopen(buffer, "wb");
+        fwrite(content.data(), 1, content.size(), out);
+        fclose(out);
+    }
+    double megabytes = (count * size) / (1024.0 * 1024.0);
+
+    size_t total = 0;
+    double ref = measure([&]() { total = referenceRead(names); });
+    std::cout << "sequential      " << ref << " ms, " << megabytes * 1000.0 / ref << " MB/s" << std::endl;
+
+    unsigned int threads[] = { 1, 4, 8 };
+    for(size_t i=0; i<3; i++)
+    {
+        size_t read = 0;
+        double opt = measure([&]() { read = serviceRead(names, threads[i]); });
+        std::cout << "service " << threads[i] << " thread(s) " << opt << " ms, " << megabytes * 1000.0 / opt
+                  << " MB/s (x" << ref/opt << ")" << ((read != total) ? " size mismatch" : "") << std::endl;
+    }
+
+    for(size_t i=0; i<count; i++)
+    {
+        remove(names[i].c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#include <DumbFramework/blockcodec.hpp>
+#include <DumbFramework/pack.hpp>
+
+using namespace Dumb;
+
+template <typename F>
+static double measure(F f, size_t loops)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<loops; i++) { f(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+/** Asset-like content: xml, vertex data and image. **/
+static std::vector<unsigned char> generate(int kind, size_t size, uint32_t seed)
+{
+    std::vector<unsigned char> data;
+    data.reserve(size);
+    char buffer[128];
+    for(size_t i=0; data.size()<size; i++)
+    {
+        seed = seed * 1664525U + 1013904223U;
+        if(0 == kind)
+        {
+            int len = snprintf(buffer, sizeof(buffer), "<frame name=\"walk_%d\" x=\"%d\" y=\"%d\" w=\"32\" h=\"32\"/>\n",
+                               (int)(i % 24), (int)((seed >> 20) % 1024), (int)((seed >> 8) % 1024));
+            data.insert(data.end(), buffer, buffer + len);
+        }
+        else if(1 == kind)
+        {
+            float vertex[8] = { std::cos(i * 0.01f), std::sin(i * 0.01f), (float)(i % 64), 0.0f, 0.0f, 1.0f,
+                                (i % 64) / 64.0f, (i / 64) / 64.0f };
+            unsigned char const* bytes = reinterpret_cast<unsigned char const*>(vertex);
+            data.insert(data.end(), bytes, bytes + sizeof(vertex));
+        }
+        else
+        {
+            size_t x = i % 1024, y = i / 1024;
+            unsigned char pixel[4] = { (unsigned char)(x / 4), (unsigned char)(y / 4),
+                                       (unsigned char)((x ^ y) + ((seed >> 28) & 3)), 255 };
+            data.insert(data.end(), pixel, pixel + 4);
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+int main()
+{
+    const size_t count = 48;
+    const size_t size  = 1 << 20;
+    const size_t loops = 4;
+    unsigned int threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+    std::vector<std::vector<unsigned char> > assets(count);
+    std::vector<std::string> names(count);
+    Pack::Builder raw, blocks, deflate;
+    char buffer[64];
+    for(size_t i=0; i<count; i++)
+    {
+        assets[i] = generate(i % 3, size, (uint32_t)i);
+        snprintf(buffer, sizeof(buffer), "bench_pack_%02d.bin", (int)i);
+        names[i] = buffer;
+        FILE *out = fopen(buffer, "wb");
+        fwrite(assets[i].data(), 1, assets[i].size(), out);
+        fclose(out);
+        raw.add(names[i], names[i]);
+        blocks.add(names[i], names[i], Pack::BLOCKS);
+        deflate.add(names[i], names[i], Pack::DEFLATE);
+    }
+    double megabytes = (count * size) / (1024.0 * 1024.0);
+
+    // Codec throughput on a single block.
+    std::vector<unsigned char> compressed(BlockCodec::bound(Pack::DefaultBlockSize));
+    std::vector<unsigned char> output(Pack::DefaultBlockSize);
+    const char* kinds[3] = { "xml   ", "vertex", "image " };
+    for(int k=0; k<3; k++)
+    {
+        unsigned char const* src = assets[k].data();
+        size_t len = 0;
+        double ms = measure([&]() { len = BlockCodec::compress(src, Pack::DefaultBlockSize, compressed.data(), compressed.size()); }, 16);
+        double cmb = (Pack::DefaultBlockSize / (1024.0 * 1024.0)) * 1000.0 / ms;
+        ms = measure([&]() { BlockCodec::decompress(compressed.data(), len, output.data(), output.size()); }, 64);
+        double dmb = (Pack::DefaultBlockSize / (1024.0 * 1024.0)) * 1000.0 / ms;
+        std::cout << "block codec " << kinds[k] << " ratio " << (double)Pack::DefaultBlockSize / len
+                  << ", compress " << cmb << " MB/s, decompress " << dmb << " MB/s" << std::endl;
+#if defined(HAVE_ZLIB)
+        uLongf zlen = compressBound(Pack::DefaultBlockSize);
+        std::vector<unsigned char> zbuffer(zlen);
+        compress2(zbuffer.data(), &zlen, src, Pack::DefaultBlockSize, Z_BEST_COMPRESSION);
+        ms = measure([&]() { uLongf n = output.size(); uncompress(output.data(), &n, zbuffer.data(), zlen); }, 16);
+        std::cout << "zlib        " << kinds[k] << " ratio " << (double)Pack::DefaultBlockSize / zlen
+                  << ", decompress " << (Pack::DefaultBlockSize / (1024.0 * 1024.0)) * 1000.0 / ms << " MB/s" << std::endl;
+#endif
+    }
+
+    // Load times (files are in the page cache).
+    raw.write("bench_raw.pack");
+    blocks.write("bench_blocks.pack");
+    deflate.write("bench_deflate.pack");
+    std::cout << "stored size: raw " << raw.storedSize() << ", blocks " << blocks.storedSize()
+              << ", zlib " << deflate.storedSize() << std::endl;
+
+    std::vector<unsigned char> content;
+    double ref = measure([&]()
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            File file;
+            file.open(names[i], File::READ_ONLY);
+            content.resize(file.size());
+            file.read(content.data(), content.size());
+        }
+    }, loops);
+    std::cout << "load files             " << ref << " ms, " << megabytes * 1000.0 / ref << " MB/s" << std::endl;
+
+    struct Run
+    {
+        char const* label;
+        char const* filename;
+        unsigned int threads;
+    };
+    Run runs[] =
+    {
+        { "load raw pack         ", "bench_raw.pack",     1 },
+        { "load block pack       ", "bench_blocks.pack",  1 },
+        { "load block pack (MT)  ", "bench_blocks.pack",  threads },
+        { "load zlib pack        ", "bench_deflate.pack", 1 },
+    };
+    for(size_t r=0; r<sizeof(runs)/sizeof(runs[0]); r++)
+    {
+        Pack pack;
+        pack.open(runs[r].filename);
+        bool ok = true;
+        double opt = measure([&]()
+        {
+            for(size_t i=0; i<count; i++)
+            {
+                Pack::Entry const* entry = pack.find(names[i]);
+                ok = ok && (NULL != entry) && pack.extract(*entry, content, runs[r].threads);
+            }
+        }, loops);
+        std::cout << runs[r].label << opt << " ms, " << megabytes * 1000.0 / opt << " MB/s (x" << ref/opt << ")"
+                  << (ok ? "" : " failed") << std::endl;
+    }
+
+    for(size_t i=0; i<count; i++)
+    {
+        remove(names[i].c_str());
+    }
+    remove("bench_raw.pack");
+    remove("bench_blocks.pack");
+    remove("bench_deflate.pack");
+    return 0;
+}
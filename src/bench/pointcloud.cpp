@@ -0,0 +1,97 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/boundingsphere.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+/** Reference implementation: bounds computed point per point. **/
+static void referenceBounds(const uint8_t* buffer, size_t count, size_t stride, glm::vec3& pmin, glm::vec3& pmax)
+{
+    const float* ptr = (const float*)buffer;
+    pmin = pmax = glm::vec3(ptr[0], ptr[1], ptr[2]);
+    buffer += stride;
+    for(size_t i=1; i<count; i++, buffer+=stride)
+    {
+        ptr = (const float*)buffer;
+        glm::vec3 dummy(ptr[0], ptr[1], ptr[2]);
+        pmin = glm::min(pmin, dummy);
+        pmax = glm::max(pmax, dummy);
+    }
+}
+/** Reference implementation: point in sphere test using distance. **/
+static size_t referenceCountInside(const float* buffer, size_t count, size_t stride, glm::vec3 const& center, float radius)
+{
+    size_t offset = 0, inc = stride + 3;
+    size_t inside = 0;
+    for(size_t i=0; i<count; i++, offset+=inc)
+    {
+        glm::vec3 point(buffer[offset], buffer[offset+1], buffer[offset+2]);
+        inside += (radius < glm::distance(center, point)) ? 0 : 1;
+    }
+    return inside;
+}
+
+template <typename F>
+static double measure(F f, size_t loops)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<loops; i++) { f(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+int main()
+{
+    const size_t count  = 1 << 20;
+    const size_t loops  = 16;
+    // Interleaved position + normal + uv vertex layout.
+    const size_t floats = 8;
+    std::vector<float> vertices(count * floats);
+    for(size_t i=0; i<count; i++)
+    {
+        glm::vec3 p = glm::ballRand(100.0f) * glm::vec3(1.0f, 0.25f, 0.5f);
+        vertices[i*floats  ] = p.x;
+        vertices[i*floats+1] = p.y;
+        vertices[i*floats+2] = p.z;
+    }
+    const uint8_t* buffer = reinterpret_cast<const uint8_t*>(&vertices[0]);
+    size_t stride = floats * sizeof(float);
+    
+    glm::vec3 pmin, pmax;
+    double ref = measure([&]() { referenceBounds(buffer, count, stride, pmin, pmax); }, loops);
+    double opt = measure([&]() { PointCloud::bounds(buffer, count, stride, pmin, pmax); }, loops);
+    std::cout << "bounds        reference " << ref << " ms, kernel " << opt << " ms (x" << ref/opt << ")" << std::endl;
+    
+    BoundingSphere sphere;
+    glm::vec3 delta = pmax - pmin;
+    float boxRadius = glm::length(delta) / 2.0f;
+    opt = measure([&]() { sphere = BoundingSphere(buffer, count, stride); }, loops);
+    std::cout << "sphere        ritter " << opt << " ms, radius " << sphere.getRadius() << " (box diagonal radius " << boxRadius << ")" << std::endl;
+    
+    size_t inside = 0;
+    ref = measure([&]() { inside = referenceCountInside(&vertices[0], count, floats-3, sphere.getCenter(), sphere.getRadius() * 0.5f); }, loops);
+    float r2 = sphere.getSquareRadius() * 0.25f;
+    opt = measure([&]() { inside = PointCloud::countInside(buffer, count, stride, sphere.getCenter(), r2); }, loops);
+    std::cout << "sphere points reference " << ref << " ms, kernel " << opt << " ms (x" << ref/opt << ")" << std::endl;
+    
+    return (inside > count) ? 1 : 0;
+}
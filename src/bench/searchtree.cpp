@@ -0,0 +1,177 @@
+/*
+ * Copyright 2015 Stoned Xander
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <glm/glm.hpp>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/logic/searchtree.hpp>
+#include <DumbFramework/logic/searchregion.hpp>
+
+/** Square region split into 4 quadrants. **/
+struct Region
+{
+    Region() {}
+    Region(glm::vec2 const& lo, glm::vec2 const& hi) : min(lo), max(hi) {}
+    bool contains(glm::vec2 const& p) const
+    {
+        return (p.x >= min.x) && (p.y >= min.y) && (p.x < max.x) && (p.y < max.y);
+    }
+    unsigned int dimension() const { return 4; }
+    Region* divide() const
+    {
+        glm::vec2 center = (min + max) / 2.0f;
+        Region* regions = new Region[4];
+        regions[0] = Region(min, center);
+        regions[1] = Region(glm::vec2(center.x, min.y), glm::vec2(max.x, center.y));
+        regions[2] = Region(glm::vec2(min.x, center.y), glm::vec2(center.x, max.y));
+        regions[3] = Region(center, max);
+        return regions;
+    }
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+struct Entity
+{
+    glm::vec2 const& key() const { return position; }
+    void key(glm::vec2 const& p) { position = p; }
+    glm::vec2 position;
+};
+
+/** Square search function. **/
+struct Square
+{
+    Square(glm::vec2 const& c, float e) : min(c - e), max(c + e) {}
+    int contains(Region const& region) const
+    {
+        if((region.max.x < min.x) || (region.min.x > max.x) || (region.max.y < min.y) || (region.min.y > max.y)) { return -1; }
+        return ((region.min.x >= min.x) && (region.max.x <= max.x) && (region.min.y >= min.y) && (region.max.y <= max.y)) ? 1 : 0;
+    }
+    bool contains(glm::vec2 const& p) const
+    {
+        return (p.x >= min.x) && (p.y >= min.y) && (p.x <= max.x) && (p.y <= max.y);
+    }
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+typedef Dumb::Logic::SearchTree::Node<glm::vec2, Region, Entity> Tree;
+typedef Dumb::Logic::SearchTree::Linear<glm::vec2, Region, Entity> LinearTree;
+
+template <typename F>
+static double measure(F f, size_t loops)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<loops; i++) { f(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+static void run(size_t count, size_t moves)
+{
+    const float size = 4096.0f;
+    Region region(glm::vec2(0.0f), glm::vec2(size));
+    std::vector<Entity> entities(count);
+    std::vector<Entity*> pointers(count);
+    for(size_t i=0; i<count; i++)
+    {
+        entities[i].position = glm::linearRand(glm::vec2(0.0f), glm::vec2(size - 1.0f));
+        pointers[i] = &entities[i];
+    }
+
+    double add = measure([&]()
+    {
+        Tree tree(&region);
+        for(size_t i=0; i<count; i++) { tree.add(pointers[i]); }
+    }, 1);
+    Tree tree(&region);
+    double build = measure([&]() { tree.build(&pointers[0], count); }, 1);
+    std::cout << count << " elements: add " << add << " ms, build " << build << " ms" << std::endl;
+
+    std::vector<Entity*> moved(moves);
+    std::vector<glm::vec2> targets(moves);
+    for(size_t i=0; i<moves; i++)
+    {
+        moved[i] = pointers[(i * 7919) % count];
+    }
+    auto jitter = [&]()
+    {
+        for(size_t i=0; i<moves; i++)
+        {
+            targets[i] = glm::clamp(moved[i]->position + glm::circularRand(2.0f), glm::vec2(0.0f), glm::vec2(size - 1.0f));
+        }
+    };
+    double single = measure([&]()
+    {
+        jitter();
+        for(size_t i=0; i<moves; i++) { tree.move(moved[i], targets[i]); }
+    }, 8);
+    double batch = measure([&]()
+    {
+        jitter();
+        tree.move(&moved[0], &targets[0], moves);
+    }, 8);
+    std::cout << moves << " moves: single " << single << " ms, batch " << batch << " ms" << std::endl;
+
+    LinearTree linear(tree);
+    std::vector<Entity*> output;
+    output.reserve(count);
+    std::vector<Square> squares;
+    for(size_t i=0; i<256; i++)
+    {
+        squares.push_back(Square(glm::linearRand(glm::vec2(0.0f), glm::vec2(size)), 64.0f));
+    }
+    size_t found = 0;
+    double node = measure([&]()
+    {
+        for(size_t i=0; i<squares.size(); i++) { output.clear(); found += tree.retrieve(squares[i], output); }
+    }, 4);
+    double flat = measure([&]()
+    {
+        for(size_t i=0; i<squares.size(); i++) { output.clear(); found += linear.retrieve(squares[i], output); }
+    }, 4);
+    std::cout << squares.size() << " queries: tree " << node << " ms, linear " << flat << " ms (" << found << ")" << std::endl;
+
+    typedef Dumb::Logic::SearchTree::QuadRegion QuadRegion;
+    QuadRegion quad(Dumb::Core::Geometry::BoundingQuad(glm::vec2(0.0f), glm::vec2(size)));
+    Dumb::Logic::SearchTree::Node<glm::vec2, QuadRegion, Entity> quadTree(&quad);
+    quadTree.build(&pointers[0], count);
+    const unsigned int k = 8;
+    Entity* nearest[k];
+    std::vector<glm::vec2> keys(4096);
+    for(size_t i=0; i<keys.size(); i++)
+    {
+        keys[i] = glm::linearRand(glm::vec2(0.0f), glm::vec2(size));
+    }
+    found = 0;
+    double knn = measure([&]()
+    {
+        for(size_t i=0; i<keys.size(); i++) { found += quadTree.nearest(keys[i], k, nearest); }
+    }, 4);
+    double around = measure([&]()
+    {
+        for(size_t i=0; i<keys.size(); i++) { output.clear(); found += quadTree.within(keys[i], 16.0f, output); }
+    }, 4);
+    std::cout << keys.size() << " queries: " << k << " nearest " << knn << " ms, within " << around << " ms (" << found << ")" << std::endl;
+}
+
+int main()
+{
+    run(50000, 2000);
+    run(500000, 20000);
+    return 0;
+}
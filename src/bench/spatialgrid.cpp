@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/spatialgrid.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+template <typename F>
+static double measure(F f, size_t loops)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<loops; i++) { f(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+/** Brute force overlapping pairs. **/
+static size_t bruteForce(std::vector<glm::vec2> const& position, float radius)
+{
+    size_t count = 0;
+    for(size_t i=0; i<position.size(); i++)
+    {
+        for(size_t j=i+1; j<position.size(); j++)
+        {
+            glm::vec2 delta = glm::abs(position[i] - position[j]);
+            count += ((delta.x <= 2.0f*radius) && (delta.y <= 2.0f*radius)) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+static void run(size_t count, bool brute)
+{
+    const float radius = 1.0f;
+    // Keep a constant density.
+    const float size = std::sqrt(static_cast<float>(count)) * 8.0f;
+    
+    std::vector<glm::vec2> position(count), velocity(count);
+    SpatialGrid grid(4.0f * radius, count);
+    for(size_t i=0; i<count; i++)
+    {
+        position[i] = glm::linearRand(glm::vec2(0.0f), glm::vec2(size));
+        velocity[i] = glm::circularRand(0.25f);
+        grid.insert(BoundingCircle(position[i], radius));
+    }
+    
+    std::vector<std::pair<size_t, size_t>> pairs;
+    double move = measure([&]()
+    {
+        for(size_t i=0; i<count; i++)
+        {
+            position[i] += velocity[i];
+            grid.move(i, BoundingCircle(position[i], radius));
+        }
+    }, 16);
+    double overlap = measure([&]() { grid.pairs(pairs); }, 16);
+    std::cout << count << " objects: move " << move << " ms, pairs " << overlap << " ms (" << pairs.size() << " pairs)";
+    if(brute)
+    {
+        size_t expected = 0;
+        double t = measure([&]() { expected = bruteForce(position, radius); }, 1);
+        std::cout << ", brute force " << t << " ms (" << expected << " pairs)";
+    }
+    std::cout << std::endl;
+}
+
+int main()
+{
+    run(1000, true);
+    run(10000, true);
+    run(100000, false);
+    return 0;
+}
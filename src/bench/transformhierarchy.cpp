@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/transformhierarchy.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+template <typename F>
+static double measure(F f, size_t loops)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for(size_t i=0; i<loops; i++) { f(); }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / loops;
+}
+
+int main()
+{
+    const size_t count = 50000;
+    const size_t loops = 64;
+    
+    TransformHierarchy hierarchy;
+    for(size_t i=0; i<count; i++)
+    {
+        // Wide and shallow scene: a few hundred roots with small subtrees.
+        size_t parent = (i < 256) ? TransformHierarchy::None : (i/4 + std::rand() % (i/4 + 1));
+        glm::fquat q = glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f));
+        hierarchy.add(parent, Transform(q, glm::ballRand(10.0f)));
+    }
+    
+    double full = measure([&]() { hierarchy.build(); hierarchy.update(); }, 1);
+    std::cout << count << " nodes, " << hierarchy.levelCount() << " levels" << std::endl;
+    std::cout << "full update    " << full << " us" << std::endl;
+    
+    for(size_t moving=1; moving<=1024; moving*=8)
+    {
+        double t = measure([&]()
+        {
+            for(size_t i=0; i<moving; i++)
+            {
+                hierarchy.position(std::rand() % count, glm::ballRand(10.0f));
+            }
+            hierarchy.update();
+        }, loops);
+        std::cout << moving << " moving nodes " << t << " us" << std::endl;
+    }
+    
+    return 0;
+}
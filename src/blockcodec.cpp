@@ -0,0 +1,283 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include <DumbFramework/blockcodec.hpp>
+
+namespace Dumb {
+
+namespace {
+
+/** Minimum match length. **/
+const size_t MinMatch = 4;
+/** The last bytes of a block are always literals. **/
+const size_t LastLiterals = 5;
+/** No match may start in the last bytes of a block. **/
+const size_t MatchStartLimit = 12;
+/** Maximum back reference distance. **/
+const size_t MaxDistance = 65535;
+/** Match finder hash table size (log2). **/
+const unsigned int HashLog = 12;
+
+inline uint32_t read32(unsigned char const* ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HashLog);
+}
+
+/** Write a length continuation (runs of 255). **/
+inline unsigned char* writeLength(unsigned char* op, size_t len)
+{
+    for(; len >= 255; len -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/**
+ * Write sequence.
+ * @return NULL if the sequence does not fit.
+ */
+unsigned char* writeSequence(unsigned char* op, unsigned char* end, unsigned char const* literals, size_t literalCount, size_t distance, size_t matchLength)
+{
+    size_t required = 1 + literalCount + (literalCount / 255) + 1;
+    if(matchLength)
+    {
+        required += 2 + ((matchLength - MinMatch) / 255) + 1;
+    }
+    if(required > (size_t)(end - op))
+    {
+        return NULL;
+    }
+    unsigned char *token = op++;
+    *token = (unsigned char)(((literalCount < 15) ? literalCount : 15) << 4);
+    if(literalCount >= 15)
+    {
+        op = writeLength(op, literalCount - 15);
+    }
+    if(literalCount)
+    {
+        memcpy(op, literals, literalCount);
+        op += literalCount;
+    }
+    if(matchLength)
+    {
+        *op++ = (unsigned char)(distance & 0xff);
+        *op++ = (unsigned char)(distance >> 8);
+        size_t len = matchLength - MinMatch;
+        *token |= (unsigned char)((len < 15) ? len : 15);
+        if(len >= 15)
+        {
+            op = writeLength(op, len - 15);
+        }
+    }
+    return op;
+}
+
+/**
+ * Read a length continuation.
+ * @return false if the input is truncated.
+ */
+inline bool readLength(unsigned char const*& ip, unsigned char const* end, size_t& len)
+{
+    unsigned char byte;
+    do
+    {
+        if(ip >= end)
+        {
+            return false;
+        }
+        byte = *ip++;
+        len += byte;
+    } while(255 == byte);
+    return true;
+}
+
+} // anonymous
+
+/**
+ * Worst case compressed size.
+ * @param [in] size  Uncompressed size in bytes.
+ */
+size_t BlockCodec::bound(size_t size)
+{
+    return size + (size / 255) + 16;
+}
+/**
+ * Compress block.
+ * @param [in]  src       Uncompressed data.
+ * @param [in]  size      Uncompressed size in bytes.
+ * @param [out] dst       Compressed data.
+ * @param [in]  capacity  Size of the @a dst buffer.
+ * @return Compressed size, or 0 if it does not fit in @a dst.
+ */
+size_t BlockCodec::compress(unsigned char const* src, size_t size, unsigned char* dst, size_t capacity)
+{
+    unsigned char *op  = dst;
+    unsigned char *end = dst + capacity;
+    size_t anchor = 0;
+
+    if(size > MatchStartLimit)
+    {
+        std::vector<uint32_t> table(1 << HashLog, 0);
+        size_t limit      = size - MatchStartLimit;
+        size_t matchLimit = size - LastLiterals;
+        size_t ip = 1;
+        while(ip < limit)
+        {
+            // Look for a match. The step grows with the number of
+            // consecutive literals to skip uncompressible data quickly.
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = hash(sequence);
+            size_t ref = table[h];
+            table[h] = (uint32_t)ip;
+            if(((ip - ref) > MaxDistance) || (sequence != read32(src + ref)))
+            {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            // Extend the match backward then forward.
+            while((ip > anchor) && (ref > 0) && (src[ip-1] == src[ref-1]))
+            {
+                ip--;
+                ref--;
+            }
+            size_t len = MinMatch;
+            while(((ip + len) < matchLimit) && (src[ip + len] == src[ref + len]))
+            {
+                len++;
+            }
+            op = writeSequence(op, end, src + anchor, ip - anchor, ip - ref, len);
+            if(NULL == op)
+            {
+                return 0;
+            }
+            ip += len;
+            anchor = ip;
+            if(ip < limit)
+            {
+                table[hash(read32(src + ip - 2))] = (uint32_t)(ip - 2);
+            }
+        }
+    }
+    // Last literals.
+    op = writeSequence(op, end, src + anchor, size - anchor, 0, 0);
+    if(NULL == op)
+    {
+        return 0;
+    }
+    return op - dst;
+}
+/**
+ * Decompress block.
+ * @param [in]  src   Compressed data.
+ * @param [in]  size  Compressed size in bytes.
+ * @param [out] dst   Uncompressed data.
+ * @param [in]  len   Uncompressed size in bytes.
+ * @return false if the block is malformed.
+ */
+bool BlockCodec::decompress(unsigned char const* src, size_t size, unsigned char* dst, size_t len)
+{
+    unsigned char const* ip = src;
+    unsigned char const* srcEnd = src + size;
+    unsigned char *op = dst;
+    unsigned char *dstEnd = dst + len;
+
+    while(ip < srcEnd)
+    {
+        unsigned int token = *ip++;
+
+        // Literals.
+        size_t count = token >> 4;
+        if((15 == count) && !readLength(ip, srcEnd, count))
+        {
+            return false;
+        }
+        if((count > (size_t)(srcEnd - ip)) || (count > (size_t)(dstEnd - op)))
+        {
+            return false;
+        }
+        if((count <= 16) && ((srcEnd - ip) >= 16) && ((dstEnd - op) >= 16))
+        {
+            // Short run, copy a fixed amount. The extra bytes are
+            // overwritten by the next sequence.
+            memcpy(op, ip, 16);
+        }
+        else if(count)
+        {
+            memcpy(op, ip, count);
+        }
+        ip += count;
+        op += count;
+        if(ip == srcEnd)
+        {
+            // The last sequence has no match.
+            break;
+        }
+
+        // Match.
+        if((srcEnd - ip) < 2)
+        {
+            return false;
+        }
+        size_t distance = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if((0 == distance) || (distance > (size_t)(op - dst)))
+        {
+            return false;
+        }
+        count = token & 15;
+        if((15 == count) && !readLength(ip, srcEnd, count))
+        {
+            return false;
+        }
+        count += MinMatch;
+        if(count > (size_t)(dstEnd - op))
+        {
+            return false;
+        }
+        unsigned char const* ref = op - distance;
+        if((distance >= 8) && ((size_t)(dstEnd - op) >= (count + 8)))
+        {
+            // Copy 8 bytes at a time, possibly a little too much.
+            for(size_t i=0; i<count; i+=8)
+            {
+                memcpy(op + i, ref + i, 8);
+            }
+        }
+        else
+        {
+            // Overlapping copy: repeat the last bytes.
+            for(size_t i=0; i<count; i++)
+            {
+                op[i] = ref[i];
+            }
+        }
+        op += count;
+    }
+    return (op == dstEnd);
+}
+
+} // Dumb
@@ -13,7 +13,11 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <sys/stat.h>
+#include <cstring>
+#include <algorithm>
 #include <DumbFramework/file.hpp>
+#include <DumbFramework/pack.hpp>
 
 namespace Dumb {
 /** 
@@ -27,6 +31,13 @@ File::File()
     : _handle(NULL)
     , _mode(File::INVALID)
     , _filename()
+    , _size(-1)
+    , _data(NULL)
+    , _dataSize(0)
+    , _memoryMapped(false)
+    , _buffer()
+    , _packed(false)
+    , _position(0)
 {}
 
 /** 
@@ -127,6 +138,10 @@ bool File::open()
         return false;
     }
     
+    if(openPacked())
+    {
+        return true;
+    }
     // Open file.
     _handle = fopen(_filename.c_str(), _modeString);
     return (NULL != _handle);
@@ -155,6 +170,10 @@ bool File::open(File::OpenMode mode)
         return false;
     }
     
+    if(openPacked())
+    {
+        return true;
+    }
     // Open file.
     _handle = fopen(_filename.c_str(), _modeString);
     return (NULL != _handle);
@@ -184,6 +203,10 @@ bool File::open(std::string const& name, File::OpenMode mode)
         return false;
     }
     
+    if(openPacked())
+    {
+        return true;
+    }
     // Open file.
     _handle = fopen(_filename.c_str(), _modeString);
     return (NULL != _handle);
@@ -199,6 +222,10 @@ bool File::open(std::string const& name, File::OpenMode mode)
  */
 void File::close()
 {
+    _packed = false;
+    _position = 0;
+    unmap();
+    _size = -1;
     if(_handle)
     {
         fclose(_handle);
@@ -209,7 +236,13 @@ void File::close()
 /** @brief Check if the file is opened. */
 bool File::isOpened() const
 {
-    return (_handle != NULL);
+    return (_handle != NULL) || _packed;
+}
+
+/** @brief Check if the file is read from a mounted pack. */
+bool File::isPacked() const
+{
+    return _packed;
 }
 
 /** @brief Get filename. */
@@ -220,26 +253,43 @@ std::string const& File::name() const
 /** @brief Get file size in bytes. */
 size_t File::size() const
 {
-    if(_handle)
+    if(_packed)
     {
-        size_t size;
-        off_t currentOffset = ftell(_handle);
-        
-        fseek(_handle, 0, SEEK_END);
-        size = ftell(_handle);
-        fseek(_handle, 0, SEEK_SET);
-        size -= ftell(_handle);
-        fseek(_handle, currentOffset, SEEK_SET);
-        
-        return size;
+        return _dataSize;
     }
-    
-    return 0;
+    if(NULL == _handle)
+    {
+        return 0;
+    }
+    if(_size >= 0)
+    {
+        return _size;
+    }
+    if(_mode & (File::WRITE_ONLY | File::APPEND))
+    {
+        // Buffered data is not seen by fstat.
+        fflush(_handle);
+    }
+    struct stat infos;
+    if(0 != fstat(fileno(_handle), &infos))
+    {
+        return 0;
+    }
+    if(File::READ_ONLY == _mode)
+    {
+        // The file is not modified through this handle.
+        _size = infos.st_size;
+    }
+    return infos.st_size;
 }
 
 /** @brief Get current file offset in bytes. */
 off_t File::tell() const
 {
+    if(_packed)
+    {
+        return _position;
+    }
     if(_handle)
     {
         return ftell(_handle);
@@ -266,6 +316,16 @@ File::OpenMode File::mode() const
  */
 size_t File::read (void* buffer, size_t len)
 {
+    if(_packed)
+    {
+        len = std::min(len, _dataSize - std::min(_position, _dataSize));
+        if(len)
+        {
+            memcpy(buffer, _data + _position, len);
+            _position += len;
+        }
+        return len;
+    }
     if(NULL == _handle)
     {
         return 0;
@@ -305,6 +365,16 @@ size_t File::write(void* buffer, size_t len)
  */
 bool File::seek(off_t offset, File::Origin origin)
 {
+    if(_packed)
+    {
+        off_t base = (File::START == origin) ? 0 : ((File::END == origin) ? (off_t)_dataSize : (off_t)_position);
+        if((base + offset) < 0)
+        {
+            return false;
+        }
+        _position = base + offset;
+        return true;
+    }
     int whence;
     switch(origin)
     {
@@ -335,6 +405,10 @@ bool File::seek(off_t offset, File::Origin origin)
  */
 bool File::eof()
 {
+    if(_packed)
+    {
+        return (_position >= _dataSize);
+    }
     if(NULL == _handle)
     {
         return true;
@@ -342,4 +416,100 @@ bool File::eof()
     return (0 != feof(_handle));
 }
 
+/** @brief Check if the file content is mapped. */
+bool File::isMapped() const
+{
+    return (NULL != _data);
+}
+
+/**
+ * @brief Get mapped file content.
+ * @return Pointer to the File::size bytes of the file, or NULL
+ * if the file is not mapped.
+ */
+unsigned char const* File::data() const
+{
+    return _data;
+}
+
+/**
+ * @brief Read the whole file into the mapping buffer.
+ * @return true if the file was successfully read.
+ */
+bool File::copy()
+{
+    size_t len = size();
+    off_t offset = ftell(_handle);
+    // Keep a valid pointer for empty files.
+    _buffer.resize(len ? len : 1);
+    if(fseek(_handle, 0, SEEK_SET) < 0)
+    {
+        return false;
+    }
+    size_t count = fread(&_buffer[0], 1, len, _handle);
+    fseek(_handle, offset, SEEK_SET);
+    if(count != len)
+    {
+        _buffer.clear();
+        return false;
+    }
+    _data = &_buffer[0];
+    _dataSize = len;
+    _memoryMapped = false;
+    return true;
+}
+
+/**
+ * @brief Look the file up in the mounted packs.
+ * @return true if a mounted pack contains the file.
+ */
+bool File::openPacked()
+{
+    if(File::READ_ONLY != _mode)
+    {
+        return false;
+    }
+    Pack::Entry const* entry;
+    Pack const* pack = Pack::resolve(_filename, entry);
+    if(NULL == pack)
+    {
+        return false;
+    }
+    if(Pack::NONE == entry->compression)
+    {
+        // Read in place from the archive mapping.
+        _data = pack->data(*entry);
+    }
+    else
+    {
+        if(!pack->extract(*entry, _buffer))
+        {
+            return false;
+        }
+        // Keep a valid pointer for empty files.
+        _buffer.reserve(1);
+        _data = _buffer.data();
+    }
+    _dataSize = entry->size;
+    _memoryMapped = false;
+    _packed = true;
+    _position = 0;
+    return true;
+}
+
+/**
+ * @brief Flush stream buffer.
+ *
+ * Hand buffered data over to the operating system.
+ * @return true if the buffer was successfully flushed.
+ */
+bool File::flush()
+{
+    if(NULL == _handle)
+    {
+        return false;
+    }
+    return (0 == fflush(_handle));
+}
+
 } // Dumb
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <DumbFramework/file.hpp>
+#include <DumbFramework/flightrecorder.hpp>
+
+namespace Dumb {
+namespace Log  {
+
+namespace {
+    /** Ring file header. **/
+    struct Header
+    {
+        /** File identifier. **/
+        char     magic[8];
+        /** Format version. **/
+        uint32_t version;
+        /** Header size in bytes. **/
+        uint32_t headerSize;
+        /** Ring size in bytes. **/
+        uint64_t capacity;
+        /** Number of bytes reserved since the creation of the ring. **/
+        uint64_t head;
+        /** Unused. **/
+        uint8_t  reserved[32];
+    };
+    /** Ring file identifier. **/
+    const char Magic[8] = { 'D', 'U', 'M', 'B', 'F', 'L', 'R', '\0' };
+    /** Ring file format version. **/
+    const uint32_t Version = 1;
+    /**
+     * Entry header size.
+     * Entries start with 3 words:
+     *      - message length (low 32 bits) and checksum (high 32 bits),
+     *      - absolute position (commit marker),
+     *      - timestamp.
+     */
+    const size_t EntryHeaderSize = 3 * sizeof(uint64_t);
+    /** Entry alignment. **/
+    const size_t EntryAlignment = sizeof(uint64_t);
+
+    static_assert(sizeof(Header) == 64, "Unexpected ring file header size");
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "64 bits atomics must be lock free");
+
+    /** FNV-1a hash of the message. **/
+    uint32_t checksum(char const* data, size_t len)
+    {
+        uint32_t hash = 2166136261u;
+        for(size_t i=0; i<len; i++)
+        {
+            hash ^= (uint8_t)data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+    /** Copy data into the ring. **/
+    void store(char* ring, size_t capacity, uint64_t position, char const* src, size_t len)
+    {
+        size_t offset = (size_t)(position & (capacity-1));
+        size_t first  = std::min(len, capacity - offset);
+        memcpy(ring + offset, src, first);
+        memcpy(ring, src + first, len - first);
+    }
+    /** Copy data from the ring. **/
+    void load(char const* ring, size_t capacity, uint64_t position, char* dst, size_t len)
+    {
+        size_t offset = (size_t)(position & (capacity-1));
+        size_t first  = std::min(len, capacity - offset);
+        memcpy(dst, ring + offset, first);
+        memcpy(dst + first, ring, len - first);
+    }
+    /** Word of the ring at a given position. **/
+    uint64_t* word(char* ring, size_t capacity, uint64_t position)
+    {
+        return reinterpret_cast<uint64_t*>(ring + (size_t)(position & (capacity-1)));
+    }
+} // anonymous
+
+    /** Default ring size in bytes. **/
+    const size_t FlightRecorder::DefaultCapacity = 4 * 1024 * 1024;
+
+    /**
+     * Constructor.
+     * @param [in] filename  Ring file name.
+     * @param [in] capacity  Ring size in bytes.
+     */
+    FlightRecorder::FlightRecorder(std::string const & filename, size_t capacity)
+        : _filename(filename)
+        , _capacity(4096)
+        , _fd(-1)
+        , _length(0)
+        , _map(NULL)
+        , _data(NULL)
+    {
+        while(_capacity < capacity) { _capacity <<= 1; }
+    }
+    /** Destructor. **/
+    FlightRecorder::~FlightRecorder()
+    {
+        teardown();
+    }
+    /**
+     * Create and map ring file.
+     * @return false if the file could not be created.
+     */
+    bool FlightRecorder::setup()
+    {
+        teardown();
+
+        struct stat infos;
+        if(0 == stat(_filename.c_str(), &infos))
+        {
+            std::string previous = _filename + ".1";
+            rename(_filename.c_str(), previous.c_str());
+        }
+
+        _fd = ::open(_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(_fd < 0)
+        {
+            return false;
+        }
+        _length = sizeof(Header) + _capacity;
+        if(0 != ftruncate(_fd, _length))
+        {
+            teardown();
+            return false;
+        }
+        void *map = mmap(NULL, _length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if(MAP_FAILED == map)
+        {
+            teardown();
+            return false;
+        }
+        _map  = static_cast<char*>(map);
+        _data = _map + sizeof(Header);
+
+        Header *header = reinterpret_cast<Header*>(_map);
+        memcpy(header->magic, Magic, sizeof(Magic));
+        header->version    = Version;
+        header->headerSize = sizeof(Header);
+        header->capacity   = _capacity;
+        header->head       = 0;
+        return true;
+    }
+    /** Synchronize and unmap ring file. **/
+    void FlightRecorder::teardown()
+    {
+        if(NULL != _map)
+        {
+            msync(_map, _length, MS_SYNC);
+            munmap(_map, _length);
+            _map  = NULL;
+            _data = NULL;
+        }
+        if(_fd >= 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+    /**
+     * Append message to the ring.
+     * @param [in] msg Log message.
+     * @return false if the ring is not mapped.
+     */
+    bool FlightRecorder::write(std::string & msg)
+    {
+        uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        return append(msg.c_str(), msg.size(), timestamp);
+    }
+    /** Messages are written by the emitting threads. **/
+    bool FlightRecorder::concurrent() const
+    {
+        return true;
+    }
+    /**
+     * Append message to the ring.
+     * @param [in] msg        Message.
+     * @param [in] len        Message length.
+     * @param [in] timestamp  Message timestamp.
+     * @return false if the ring is not mapped.
+     */
+    bool FlightRecorder::append(char const* msg, size_t len, uint64_t timestamp)
+    {
+        if(NULL == _data)
+        {
+            return false;
+        }
+        size_t limit = (_capacity / 4) - EntryHeaderSize;
+        if(len > limit)
+        {
+            len = limit;
+        }
+        size_t size = (EntryHeaderSize + len + EntryAlignment - 1) & ~(EntryAlignment - 1);
+
+        std::atomic<uint64_t> *head = reinterpret_cast<std::atomic<uint64_t>*>(&reinterpret_cast<Header*>(_map)->head);
+        uint64_t position = head->fetch_add(size, std::memory_order_relaxed);
+
+        store(_data, _capacity, position + EntryHeaderSize, msg, len);
+        *word(_data, _capacity, position) = (uint64_t)len | ((uint64_t)checksum(msg, len) << 32);
+        *word(_data, _capacity, position + 2*sizeof(uint64_t)) = timestamp;
+        // The position is the commit marker, it must be written last.
+        reinterpret_cast<std::atomic<uint64_t>*>(word(_data, _capacity, position + sizeof(uint64_t)))->store(position, std::memory_order_release);
+        return true;
+    }
+    /** Ring file name. **/
+    std::string const & FlightRecorder::filename() const
+    {
+        return _filename;
+    }
+    /** Ring size in bytes. **/
+    size_t FlightRecorder::capacity() const
+    {
+        return _capacity;
+    }
+    /**
+     * Read messages from a ring file.
+     * @param [in]  filename  Ring file name.
+     * @param [out] entries   Messages.
+     * @return false if the file is not a valid ring file.
+     */
+    bool FlightRecorder::read(std::string const & filename, std::vector<Entry> & entries)
+    {
+        entries.clear();
+
+        File file;
+        if(!file.open(filename, File::READ_ONLY))
+        {
+            return false;
+        }
+        Header header;
+        if(sizeof(Header) != file.read(&header, sizeof(Header)))
+        {
+            return false;
+        }
+        if(memcmp(header.magic, Magic, sizeof(Magic)) || (Version != header.version) || (sizeof(Header) != header.headerSize))
+        {
+            return false;
+        }
+        size_t capacity = (size_t)header.capacity;
+        if((capacity < 4096) || (capacity & (capacity-1)))
+        {
+            return false;
+        }
+        std::vector<char> ring(capacity);
+        if(capacity != file.read(&ring[0], capacity))
+        {
+            return false;
+        }
+
+        uint64_t end   = header.head;
+        uint64_t begin = (end > capacity) ? (end - capacity) : 0;
+        std::string message;
+        for(uint64_t position=begin; (position + EntryHeaderSize) <= end; )
+        {
+            uint64_t words[3];
+            load(&ring[0], capacity, position, reinterpret_cast<char*>(words), sizeof(words));
+            size_t   len  = (size_t)(words[0] & 0xffffffff);
+            uint32_t hash = (uint32_t)(words[0] >> 32);
+            size_t   size = (EntryHeaderSize + len + EntryAlignment - 1) & ~(EntryAlignment - 1);
+            // Resynchronize on the next word if the entry is not valid.
+            if((words[1] != position) || (size > (capacity/4)) || ((position + size) > end))
+            {
+                position += EntryAlignment;
+                continue;
+            }
+            message.resize(len);
+            if(len)
+            {
+                load(&ring[0], capacity, position + EntryHeaderSize, &message[0], len);
+            }
+            if(checksum(message.c_str(), len) != hash)
+            {
+                position += EntryAlignment;
+                continue;
+            }
+            Entry entry;
+            entry.position  = position;
+            entry.timestamp = words[2];
+            entry.message   = message;
+            entries.push_back(entry);
+            position += size;
+        }
+        return true;
+    }
+
+} // Log
+} // Dumb
@@ -18,11 +18,11 @@
 #define STB_RECT_PACK_IMPLEMENTATION
 
 #include <iostream>
-#include <fstream>
 #include <array>
 #include <algorithm>
 
 #include <DumbFramework/font.hpp>
+#include <DumbFramework/file.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -528,7 +528,7 @@ namespace Dumb {
         }
 
         //   ------------------------
-        void Delegate::packOversample(stbtt_pack_context &context, const Oversample &oversample, char *font) {
+        void Delegate::packOversample(stbtt_pack_context &context, const Oversample &oversample, const unsigned char *font) {
             std::vector<Range> specs = oversample.getRanges();
             std::vector<Range>::size_type count = specs.size();
             stbtt_pack_range *packRange = new stbtt_pack_range[count];
@@ -547,7 +547,8 @@ namespace Dumb {
             }
             glm::vec2 ovr = oversample.getOversample();
             stbtt_PackSetOversampling(&context, (unsigned int) ovr.x, (unsigned int) ovr.y);
-            if(stbtt_PackFontRanges(&context, reinterpret_cast<unsigned char*>(font),
+            // stb_truetype only reads the font data.
+            if(stbtt_PackFontRanges(&context, const_cast<unsigned char*>(font),
                         0, packRange, count) == 0) {
                 Log_Error(Dumb::Module::App, "Font range loading failure");
             }
@@ -556,22 +557,16 @@ namespace Dumb {
 
         //   ------------------
         void Delegate::packFont(stbtt_pack_context &context, const Resource &resource) {
-            std::ifstream fontFile;
-            fontFile.open(resource.getPath().c_str(), std::ios::binary|std::ios::ate|std::ios::in);
+            Dumb::File fontFile;
             // Font file check.
-            if(fontFile.is_open()) {
+            if(fontFile.open(resource.getPath(), Dumb::File::READ_ONLY) && fontFile.map(Dumb::File::RANDOM)) {
                 Log_Info(Dumb::Module::App, "Loading '%s'", resource.getPath().c_str());
-                // Font file is ok. Let's load it.
-                std::streampos size = fontFile.tellg();
-                char *fontFileContent = new char[size];
-                fontFile.seekg(0, std::ios::beg);
-                fontFile.read(fontFileContent, size);
-                fontFile.close();
+                // Font file is ok. Glyphs are read directly from the mapped file.
                 for(auto &i : resource.getSpecs()) {
-                    packOversample(context, i, fontFileContent);
+                    packOversample(context, i, fontFile.data());
                 }
                 // We're done here.
-                delete []fontFileContent;
+                fontFile.close();
             } else {
                 Log_Error(Dumb::Module::App, "Failed to open '%s'", resource.getPath().c_str());
             }
@@ -13,8 +13,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <limits>
 #include <DumbFramework/geometry/boundingsphere.hpp>
 #include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
 
 namespace Dumb     {
 namespace Core     {
@@ -44,16 +46,7 @@ BoundingBox::BoundingBox(glm::vec3 const& bmin, glm::vec3 const& bmax)
 */
 BoundingBox::BoundingBox(const uint8_t* buffer, size_t count, size_t stride)
 {
-    float* ptr = (float*)buffer;
-    _min = _max = glm::vec3(ptr[0], ptr[1], ptr[2]);
-    buffer+=stride;
-    for(size_t i=1; i<count; i++, buffer+=stride)
-    {
-        ptr = (float*)buffer;
-        glm::vec3 dummy(glm::vec3(ptr[0], ptr[1], ptr[2]));
-        _min = glm::min(_min, dummy);
-        _max = glm::max(_max, dummy);
-    }
+    PointCloud::bounds(buffer, count, stride, _min, _max);
     _update();
 }
 /** Constructor.
@@ -156,15 +149,7 @@ ContainmentType::Value BoundingBox::contains(BoundingSphere const& sphere)
 */
 ContainmentType::Value BoundingBox::contains(const float* buffer, size_t count, size_t stride)
 {
-    off_t offset = 0, inc = stride + 3;
-    size_t inside = 0;
-    for(size_t i=0; i<count; i++, offset+=inc)
-    {
-        glm::vec3 point(buffer[offset], buffer[offset+1], buffer[offset+2]);
-        inside += ((point.x >= _min.x) && (point.x <= _max.x) &&
-                   (point.y >= _min.y) && (point.y <= _max.y) &&
-                   (point.z >= _min.z) && (point.z <= _max.z));
-    }
+    size_t inside = PointCloud::countInside(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 3) * sizeof(float), _min, _max);
     if(inside == 0) { return ContainmentType::Disjoints;  }
     if(inside < count) { return ContainmentType::Intersects; }
     return ContainmentType::Contains;
@@ -189,6 +174,17 @@ ContainmentType::Value BoundingBox::contains(glm::vec3 const& point)
 *  @param [in] ray Ray to be tested.
 */
 bool BoundingBox::intersects(Ray3 const& ray)
+{
+    float distance;
+    return intersects(ray, distance);
+}
+/** Check if the current bounding box intersects the specified ray
+ *  and compute the entry distance.
+ *  @param [in]  ray      Ray to be tested.
+ *  @param [out] distance Distance from the ray origin to the entry
+ *                        point (0 if the origin is inside the box).
+ */
+bool BoundingBox::intersects(Ray3 const& ray, float& distance) const
 {
     glm::vec3 t0 = (_min - ray.origin) / ray.direction;
     glm::vec3 t1 = (_max - ray.origin) / ray.direction;
@@ -200,7 +196,11 @@ bool BoundingBox::intersects(Ray3 const& ray)
     float tmax = glm::min(glm::min(t3.x, t3.y), t3.z);
 
     if((tmax < 0) || (tmin > tmax))
-    { return false; }
+    {
+        distance = std::numeric_limits<float>::max();
+        return false;
+    }
+    distance = glm::max(tmin, 0.0f);
     return true;
 }
 /** Tell on which side of the specified plane the current bounding box is.
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include <DumbFramework/geometry/boundingcircle.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
 
 namespace Dumb     {
 namespace Core     {
@@ -35,25 +36,16 @@ BoundingCircle::BoundingCircle(glm::vec2 const& c, float r)
     , _squareRadius(r*r)
 {}
 /** Constructor.
+ *  The circle is computed using the extreme points of the point cloud
+ *  along 4 directions followed by a Ritter growing pass.
  *  @param [in] buffer Pointer to the point array.
  *  @param [in] count  Number of points 
  *  @param [in] stride Offset between two consecutive points. (default=0)
  */
 BoundingCircle::BoundingCircle(const float* buffer, size_t count, size_t stride)
 {
-    glm::vec2 pmin;
-    glm::vec2 pmax;
-    size_t inc = stride + 2;
-    pmin = pmax = glm::vec2(buffer[0], buffer[1]);
-    for(size_t i=1; i<count; i++, buffer+=inc)
-    {
-        glm::vec2 dummy(buffer[0], buffer[1]);
-        pmin = glm::min(pmin, dummy);
-        pmax = glm::max(pmax, dummy);
-    }
-    _center = (pmax + pmin) / 2.0f;
-    _squareRadius = glm::dot(pmax-pmin, pmax-pmin) / 4.0f;
-    _radius = sqrt(_squareRadius);
+    PointCloud::boundingCircle(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 2) * sizeof(float), _center, _radius);
+    _squareRadius = _radius * _radius;
 }
 /** Constructor.
  *  Merge two bounding circles.
@@ -107,15 +99,7 @@ ContainmentType::Value BoundingCircle::contains(BoundingCircle const& circle)
  */
 ContainmentType::Value BoundingCircle::contains(const float* buffer, size_t count, size_t stride)
 {
-    off_t offset = 0, inc = stride + 2;
-    size_t inside = 0;
-    for(size_t i=0; i<count; i++, offset+=inc)
-    {
-        glm::vec2 point(buffer[offset] - _center.x, buffer[offset+1] - _center.y);
-        float squareDistance = glm::dot(point, point);
-        inside += (_squareRadius < squareDistance) ? 0 : 1;
-    }
-
+    size_t inside = PointCloud::countInside(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 2) * sizeof(float), _center, _squareRadius);
     if(inside == 0) { return ContainmentType::Disjoints;  }
     if(inside < count) { return ContainmentType::Intersects; }
     return ContainmentType::Contains;
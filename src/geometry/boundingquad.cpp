@@ -15,6 +15,7 @@
  */
 #include <DumbFramework/geometry/boundingcircle.hpp>
 #include <DumbFramework/geometry/boundingquad.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
 
 namespace Dumb     {
 namespace Core     {
@@ -44,18 +45,7 @@ BoundingQuad::BoundingQuad(glm::vec2 const& bmin, glm::vec2 const& bmax)
 */
 BoundingQuad::BoundingQuad(const float* buffer, size_t count, size_t stride)
 {
-    off_t offset, inc;
-    inc = stride + 2;
-    offset = inc;
-    
-    _min = _max = glm::vec2(buffer[0], buffer[1]);
-    for(size_t i=1; i<count; i++, offset+=inc)
-    {
-        glm::vec2 dummy(buffer[offset], buffer[offset+1]);
-        _min = glm::min(_min, dummy);
-        _max = glm::max(_max, dummy);
-    }
-    
+    PointCloud::bounds(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 2) * sizeof(float), _min, _max);
     _update();
 }
 /** Constructor.
@@ -152,15 +142,7 @@ ContainmentType::Value BoundingQuad::contains(BoundingCircle const& circle)
 */
 ContainmentType::Value BoundingQuad::contains(const float* buffer, size_t count, size_t stride)
 {
-    off_t offset = 0, inc = stride + 2;
-    size_t inside = 0;
-    for(size_t i=0; i<count; i++, offset+=inc)
-    {
-        glm::vec2 point(buffer[offset], buffer[offset+1]);
-        inside += ((point.x >= _min.x) && (point.x <= _max.x) &&
-                   (point.y >= _min.y) && (point.y <= _max.y));
-    }
-
+    size_t inside = PointCloud::countInside(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 2) * sizeof(float), _min, _max);
     if(inside == 0) { return ContainmentType::Disjoints;  }
     if(inside < count) { return ContainmentType::Intersects; }
     return ContainmentType::Contains;
@@ -15,6 +15,7 @@
  */
 #include <DumbFramework/geometry/boundingbox.hpp>
 #include <DumbFramework/geometry/boundingsphere.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
 
 namespace Dumb     {
 namespace Core     {
@@ -35,29 +36,17 @@ BoundingSphere::BoundingSphere(glm::vec3 const& c, float r)
     , _radius(r)
     , _squareRadius(r*r)
 {}
-/** Constructor
+/** Constructor.
+ *  The sphere is computed using the extreme points of the point cloud
+ *  along 7 directions followed by a Ritter growing pass.
  *  @param [in] buffer Pointer to the point array.
  *  @param [in] count  Number of points 
  *  @param [in] stride Offset between two consecutive points.
  */
 BoundingSphere::BoundingSphere(const uint8_t* buffer, size_t count, size_t stride)
 {
-    float *ptr = (float*)buffer;
-    glm::vec3 pmin, pmax;
-    pmin = pmax = glm::vec3(ptr[0], ptr[1], ptr[2]);
-    buffer+=stride;
-    for(size_t i=1; i<count; i++, buffer+=stride)
-    {
-        ptr = (float*)buffer;
-        glm::vec3 dummy(ptr[0], ptr[1], ptr[2]);
-        pmin = glm::min(pmin, dummy);
-        pmax = glm::max(pmax, dummy);
-    }
-    
-    glm::vec3 delta = pmax - pmin;
-    _center = (pmin+pmax) / 2.0f;
-    _squareRadius = glm::dot(delta, delta) / 4.0f;
-    _radius = sqrt(_squareRadius);
+    PointCloud::boundingSphere(buffer, count, stride, _center, _radius);
+    _squareRadius = _radius * _radius;
 }
 /** Constructor.
  *  Merge two bounding spheres.
@@ -99,27 +88,25 @@ ContainmentType::Value BoundingSphere::contains(BoundingBox const& box)
     glm::vec3 eMin = diffMin * diffMin;
     glm::vec3 eMax = diffMax * diffMax;
     
+    // Squared distances to the nearest and farthest box points.
     float dmin = 0.0f;
+    float dmax = 0.0f;
     for(int i=0; i<3; i++)
     {
         if     (diffMin[i] < 0.0f) { dmin += eMin[i]; }
         else if(diffMax[i] < 0.0f) { dmin += eMax[i]; }
+        dmax += glm::max(eMin[i], eMax[i]);
     }
 
-    if(dmin <= _squareRadius)
+    if(dmin > _squareRadius)
     {
-        bool all=true, any=false;
-        for(int i=0; i<3; i++)
-        {
-            bool tMin = (eMin[i] <= _squareRadius);
-            bool tMax(eMax[i] <= _squareRadius);
-            all = all && (tMin && tMax);
-            any = any || (tMin || tMax);
-        }
-        if(all) { return ContainmentType::Contains;   }
-        if(any) { return ContainmentType::Intersects; }
+        return ContainmentType::Disjoints;
     }
-    return ContainmentType::Disjoints;
+    if(dmax <= _squareRadius)
+    {
+        return ContainmentType::Contains;
+    }
+    return ContainmentType::Intersects;
 }
 /** Check if the current bounding sphere contains the specified bounding sphere. */
 ContainmentType::Value BoundingSphere::contains(BoundingSphere const& sphere)
@@ -143,15 +130,7 @@ ContainmentType::Value BoundingSphere::contains(BoundingSphere const& sphere)
  */
 ContainmentType::Value BoundingSphere::contains(const float* buffer, size_t count, size_t stride)
 {
-    off_t offset = 0, inc = stride + 3;
-    size_t inside = 0;
-    for(size_t i=0; i<count; i++, offset+=inc)
-    {
-        glm::vec3 point(buffer[offset], buffer[offset+1], buffer[offset+2]);
-        float distance = glm::distance(_center, point);
-        inside += (_radius < distance) ? 0 : 1;
-    }
-
+    size_t inside = PointCloud::countInside(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 3) * sizeof(float), _center, _squareRadius);
     if(inside == 0) { return ContainmentType::Disjoints;  }
     if(inside < count) { return ContainmentType::Intersects; }
     return ContainmentType::Contains;
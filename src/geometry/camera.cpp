@@ -20,21 +20,40 @@ namespace Dumb     {
 namespace Core     {
 namespace Geometry {
 
+namespace {
+
+enum { Lanes = 8 };
+
+} // anonymous
+
 /**
  * Default constructor.
  */
 Camera::Camera()
+    : _eye(0.0f)
+    , _orientation()
+    , _fov(glm::radians(60.0f))
+    , _near(1.0f)
+    , _far(100.0f)
+    , _dirty(VIEW_DIRTY | PROJECTION_DIRTY | FRUSTUM_DIRTY)
+    , _size(0)
 {}
 /**
  * Copy constructor.
  * @param [in] cam    Input camera.
  */
 Camera::Camera(Camera const& cam)
-    : eye(cam.eye)
-    , orientation(cam.orientation)
-    , fov(cam.fov)
-    , near(cam.near)
-    , far(cam.far)
+    : _eye(cam._eye)
+    , _orientation(cam._orientation)
+    , _fov(cam._fov)
+    , _near(cam._near)
+    , _far(cam._far)
+    , _dirty(cam._dirty)
+    , _size(cam._size)
+    , _view(cam._view)
+    , _projection(cam._projection)
+    , _viewProjection(cam._viewProjection)
+    , _frustum(cam._frustum)
 {}
 /**
  * Copy operator.
@@ -42,11 +61,17 @@ Camera::Camera(Camera const& cam)
  */
 Camera& Camera::operator=(Camera const& cam)
 {
-    eye = cam.eye;
-    orientation = cam.orientation;
-    fov = cam.fov;
-    near = cam.near;
-    far  = cam.far;
+    _eye            = cam._eye;
+    _orientation    = cam._orientation;
+    _fov            = cam._fov;
+    _near           = cam._near;
+    _far            = cam._far;
+    _dirty          = cam._dirty;
+    _size           = cam._size;
+    _view           = cam._view;
+    _projection     = cam._projection;
+    _viewProjection = cam._viewProjection;
+    _frustum        = cam._frustum;
     return *this;
 }
 /**
@@ -57,7 +82,6 @@ Camera& Camera::operator=(Camera const& cam)
  */
 void Camera::lookAt(glm::vec3 const& eye, glm::vec3 const& center, glm::vec3 const& up)
 {
-    this->eye  = eye;
     glm::mat3 m;
     
     glm::vec3 f = glm::normalize(center - eye);
@@ -66,7 +90,7 @@ void Camera::lookAt(glm::vec3 const& eye, glm::vec3 const& center, glm::vec3 con
 
     m[0] = l; m[1] = u; m[2] = f;
 
-    this->orientation = glm::quat_cast(m);
+    place(eye, glm::quat_cast(m));
 }
 /**
  * Set perspective information.
@@ -76,39 +100,111 @@ void Camera::lookAt(glm::vec3 const& eye, glm::vec3 const& center, glm::vec3 con
  */
 void Camera::perspective(float fovy, float near, float far)
 {
-    this->fov  = fovy;
-    this->near = near;
-    this->far  = far;
+    _fov  = fovy;
+    _near = near;
+    _far  = far;
+    _dirty |= PROJECTION_DIRTY | FRUSTUM_DIRTY;
+}
+/**
+ * Set camera position and orientation.
+ * @param [in] eye           Camera position.
+ * @param [in] orientation   Camera orientation.
+ */
+void Camera::place(glm::vec3 const& eye, glm::fquat const& orientation)
+{
+    _eye = eye;
+    _orientation = orientation;
+    _dirty |= VIEW_DIRTY | FRUSTUM_DIRTY;
 }
 /**
- * Compute view matrix.
+ * Update cached view matrix.
  */
-glm::mat4 Camera::viewMatrix() const
+void Camera::updateView() const
 {
-    glm::mat4 result = glm::mat4_cast(glm::inverse(orientation));
+    if(0 == (_dirty & VIEW_DIRTY))
+    {
+        return;
+    }
+    _view = glm::mat4_cast(glm::inverse(_orientation));
 
-    result[3][0] =  (result[0][0]*eye.x + result[1][0]*eye.y + result[2][0]*eye.z);
-    result[3][1] = -(result[0][1]*eye.x + result[1][1]*eye.y + result[2][1]*eye.z);
-    result[3][2] =  (result[0][2]*eye.x + result[1][2]*eye.y + result[2][2]*eye.z);
+    _view[3][0] =  (_view[0][0]*_eye.x + _view[1][0]*_eye.y + _view[2][0]*_eye.z);
+    _view[3][1] = -(_view[0][1]*_eye.x + _view[1][1]*_eye.y + _view[2][1]*_eye.z);
+    _view[3][2] =  (_view[0][2]*_eye.x + _view[1][2]*_eye.y + _view[2][2]*_eye.z);
 
-    result[0][0] *= -1.0f;
-    result[1][0] *= -1.0f;
-    result[2][0] *= -1.0f;
+    _view[0][0] *= -1.0f;
+    _view[1][0] *= -1.0f;
+    _view[2][0] *= -1.0f;
 
-    result[0][2] *= -1.0f;
-    result[1][2] *= -1.0f;
-    result[2][2] *= -1.0f;
+    _view[0][2] *= -1.0f;
+    _view[1][2] *= -1.0f;
+    _view[2][2] *= -1.0f;
 
-    return result;
+    _dirty &= ~VIEW_DIRTY;
+}
+/**
+ * Update cached matrices and frustum.
+ * @param [in] size    Screen size.
+ */
+void Camera::update(glm::ivec2 const& size) const
+{
+    if(size != _size)
+    {
+        _size   = size;
+        _dirty |= PROJECTION_DIRTY | FRUSTUM_DIRTY;
+    }
+    if(0 == _dirty)
+    {
+        return;
+    }
+    updateView();
+    if(_dirty & PROJECTION_DIRTY)
+    {
+        // A minimized viewport may be empty.
+        float aspect = 1.0f;
+        if((_size.x > 0) && (_size.y > 0))
+        {
+            aspect = _size.x / (float)_size.y;
+        }
+        _projection = glm::perspective(_fov, aspect, _near, _far);
+    }
+    _viewProjection = _projection * _view;
+    _frustum = Frustum(_view, _projection);
+    _dirty = 0;
+}
+/**
+ * View matrix.
+ */
+glm::mat4 const& Camera::viewMatrix() const
+{
+    updateView();
+    return _view;
+}
+/**
+ * Projection matrix for a given screen size.
+ * @param [in] size    Screen size.
+ */
+glm::mat4 const& Camera::projectionMatrix(glm::ivec2 const& size) const
+{
+    update(size);
+    return _projection;
 }
 /**
- * Compute projection matrix for a given screen size.
+ * View projection matrix for a given screen size.
  * @param [in] size    Screen size.
  */
-glm::mat4 Camera::projectionMatrix(glm::ivec2 const& size) const
+glm::mat4 const& Camera::viewProjectionMatrix(glm::ivec2 const& size) const
 {
-    float aspect = size.x / (float)size.y;
-    return glm::perspective(fov, aspect, near, far);
+    update(size);
+    return _viewProjection;
+}
+/**
+ * View frustum for a given screen size.
+ * @param [in] size    Screen size.
+ */
+Frustum const& Camera::frustum(glm::ivec2 const& size) const
+{
+    update(size);
+    return _frustum;
 }
 /**
  * Compute screen space position for a given screen size.
@@ -118,18 +214,72 @@ glm::mat4 Camera::projectionMatrix(glm::ivec2 const& size) const
  */
 glm::vec3 Camera::screenPosition(glm::vec3 const& world, glm::ivec2 const& size) const
 {
-    glm::vec4 tmp = glm::vec4(world, 1.0f);
-    tmp  = viewMatrix() * tmp;
-    tmp  = projectionMatrix(size) * tmp;
+    glm::vec4 tmp = viewProjectionMatrix(size) * glm::vec4(world, 1.0f);
     tmp /= tmp.w;
     return glm::vec3(tmp);
 }
+/**
+ * Compute screen space positions of a point list for a given
+ * screen size.
+ * @param [in]  world     World positions.
+ * @param [in]  count     Number of positions.
+ * @param [in]  size      Screen size.
+ * @param [out] screen    Screen positions between [-1, 1].
+ * @param [out] visible   Set to 1 if the point is in front of the
+ *                        camera and on screen, 0 otherwise.
+ * @return Number of visible points.
+ */
+size_t Camera::screenPositions(glm::vec3 const* world, size_t count, glm::ivec2 const& size, glm::vec3* screen, uint8_t* visible) const
+{
+    glm::mat4 const& m = viewProjectionMatrix(size);
+    size_t total = 0;
+    for(size_t i=0; i<count; i+=Lanes)
+    {
+        size_t n = ((i+Lanes) <= count) ? Lanes : (count-i);
+        float x[Lanes], y[Lanes], z[Lanes], w[Lanes];
+        for(size_t l=0; l<Lanes; l++)
+        {
+            glm::vec3 const& p = world[i + ((l < n) ? l : 0)];
+            x[l] = m[0][0]*p.x + m[1][0]*p.y + m[2][0]*p.z + m[3][0];
+            y[l] = m[0][1]*p.x + m[1][1]*p.y + m[2][1]*p.z + m[3][1];
+            z[l] = m[0][2]*p.x + m[1][2]*p.y + m[2][2]*p.z + m[3][2];
+            w[l] = m[0][3]*p.x + m[1][3]*p.y + m[2][3]*p.z + m[3][3];
+        }
+        uint8_t mask[Lanes];
+        for(size_t l=0; l<Lanes; l++)
+        {
+            float aw = glm::abs(w[l]);
+            mask[l] = (w[l] > 0.0f) & (glm::abs(x[l]) <= aw) & (glm::abs(y[l]) <= aw) & (glm::abs(z[l]) <= aw);
+            float inv = 1.0f / w[l];
+            x[l] *= inv;
+            y[l] *= inv;
+            z[l] *= inv;
+        }
+        for(size_t l=0; l<n; l++)
+        {
+            screen[i+l]  = glm::vec3(x[l], y[l], z[l]);
+            visible[i+l] = mask[l];
+            total += mask[l];
+        }
+    }
+    return total;
+}
+/** Position. **/
+glm::vec3 const& Camera::eye() const { return _eye; }
+/** Orientation. **/
+glm::fquat const& Camera::orientation() const { return _orientation; }
+/** Field of view. **/
+float Camera::fov() const { return _fov; }
+/** Near plane distance. **/
+float Camera::near() const { return _near; }
+/** Far plane distance. **/
+float Camera::far() const { return _far; }
 /** Forward vector. **/
-glm::vec3 Camera::forward() const { return glm::rotate(orientation, glm::vec3(0.0, 0.0, 1.0f)); }
+glm::vec3 Camera::forward() const { return glm::rotate(_orientation, glm::vec3(0.0, 0.0, 1.0f)); }
 /** Up vector. **/
-glm::vec3 Camera::up() const { return glm::rotate(orientation, glm::vec3(0.0, 1.0, 0.0f)); }
+glm::vec3 Camera::up() const { return glm::rotate(_orientation, glm::vec3(0.0, 1.0, 0.0f)); }
 /** Right vector. **/
-glm::vec3 Camera::right() const { return glm::rotate(orientation, glm::vec3(-1.0, 0.0, 0.0f)); }
+glm::vec3 Camera::right() const { return glm::rotate(_orientation, glm::vec3(-1.0, 0.0, 0.0f)); }
 
 } // Geometry
 } // Core
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include <DumbFramework/geometry/frustum.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
 
 namespace Dumb     {
 namespace Core     {
@@ -130,6 +131,7 @@ ContainmentType::Value Frustum::contains(BoundingBox const& box)
     
     glm::vec3 neg;
     glm::vec3 pos;
+    bool intersects = false;
 
     for(int i=0; i<FRUSTUM_PLANE_COUNT; i++)
     {
@@ -140,17 +142,18 @@ ContainmentType::Value Frustum::contains(BoundingBox const& box)
         pos.y = (pnormal.y > 0) ? bmax.y : bmin.y;
         neg.z = (pnormal.z > 0) ? bmin.z : bmax.z;
         pos.z = (pnormal.z > 0) ? bmax.z : bmin.z;
-        if(_planes[i].distance(neg) < 0)
+        // The box is outside if its farthest corner along the plane normal is behind it.
+        if(_planes[i].distance(pos) < 0)
         {
             return ContainmentType::Disjoints;
         }
-        if(_planes[i].distance(pos) < 0)
+        if(_planes[i].distance(neg) < 0)
         {
-            return ContainmentType::Intersects;
+            intersects = true;
         }
     }
 
-    return ContainmentType::Contains;
+    return intersects ? ContainmentType::Intersects : ContainmentType::Contains;
 }
 /** Check if the current bounding frustum contains the specified bounding sphere. */
 ContainmentType::Value Frustum::contains(BoundingSphere const& sphere)
@@ -182,22 +185,10 @@ ContainmentType::Value Frustum::contains(Frustum const& frustum)
  */
 ContainmentType::Value Frustum::contains(const float* buffer, size_t count, size_t stride)
 {
-    Side side;
-    size_t out = 0;
-    stride += 3;
-    for(size_t j=0; j<count; j++, buffer+=stride)
-    {
-        glm::vec3 point(buffer[0], buffer[1], buffer[2]);
-        side = Side::Front;
-        for(int i=0; (i<FRUSTUM_PLANE_COUNT) && (Side::Back != side); i++)
-        {
-            side = _planes[i].classify(point);
-        }
-        out += (Side::Back != side);
-    }
-    if(out == count)
+    size_t in = PointCloud::countInside(reinterpret_cast<const uint8_t*>(buffer), count, (stride + 3) * sizeof(float), _planes, FRUSTUM_PLANE_COUNT);
+    if(in == count)
     { return ContainmentType::Contains; }
-    if(out == 0)
+    if(in == 0)
     { return ContainmentType::Disjoints; }
     return ContainmentType::Intersects;
 }
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <DumbFramework/geometry/occlusionbuffer.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/** Round up to a multiple. **/
+static inline int roundUp(int value, int multiple)
+{
+    return ((std::max(value, 1) + multiple - 1) / multiple) * multiple;
+}
+
+/**
+ * Constructor.
+ * @param [in] size     Buffer size. It is rounded up to a multiple of
+ *                      the tile size.
+ * @param [in] tileSize Tile size. It is rounded up to a multiple of
+ *                      the block size.
+ */
+OcclusionBuffer::OcclusionBuffer(glm::ivec2 const& size, glm::ivec2 const& tileSize)
+    : _viewProjection(1.0f)
+{
+    _tileSize.x = roundUp(tileSize.x, BlockSize);
+    _tileSize.y = roundUp(tileSize.y, BlockSize);
+    _size.x = roundUp(size.x, _tileSize.x);
+    _size.y = roundUp(size.y, _tileSize.y);
+    _tiles.x = _size.x / _tileSize.x;
+    _tiles.y = _size.y / _tileSize.y;
+    _depth.resize(_size.x * _size.y);
+    _coarse.resize((_size.x / BlockSize) * (_size.y / BlockSize));
+    _bins.resize(_tiles.x * _tiles.y);
+    clear();
+}
+/**
+ * Destructor.
+ */
+OcclusionBuffer::~OcclusionBuffer()
+{}
+/**
+ * Set view projection matrix.
+ * @param [in] viewProjection View projection matrix.
+ */
+void OcclusionBuffer::setup(glm::mat4 const& viewProjection)
+{
+    _viewProjection = viewProjection;
+}
+/**
+ * Set view projection matrix from camera.
+ * @param [in] camera Camera.
+ * @param [in] screen Screen size (used for the aspect ratio).
+ */
+void OcclusionBuffer::setup(Camera const& camera, glm::ivec2 const& screen)
+{
+    _viewProjection = camera.viewProjectionMatrix(screen);
+}
+/**
+ * Clear depth buffer and remove all occluders.
+ */
+void OcclusionBuffer::clear()
+{
+    std::fill(_depth.begin(), _depth.end(), 1.0f);
+    std::fill(_coarse.begin(), _coarse.end(), 1.0f);
+    _triangles.clear();
+    for(size_t i=0; i<_bins.size(); i++)
+    {
+        _bins[i].clear();
+    }
+}
+/**
+ * Add occluder mesh.
+ * Triangles are transformed, clipped against the near plane and
+ * binned. They are rasterized by the next call to rasterize.
+ * @param [in] vertices      Vertex positions.
+ * @param [in] vertexCount   Number of vertices.
+ * @param [in] indices       Triangle indices.
+ * @param [in] triangleCount Number of triangles.
+ * @param [in] model         Model matrix.
+ * @param [in] stride        Offset in floats between consecutive vertices.
+ */
+void OcclusionBuffer::add(const float* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount, glm::mat4 const& model, size_t stride)
+{
+    glm::mat4 m = _viewProjection * model;
+    std::vector<glm::vec4> clip(vertexCount);
+    size_t inc = stride + 3;
+    for(size_t i=0, offset=0; i<vertexCount; i++, offset+=inc)
+    {
+        clip[i] = m * glm::vec4(vertices[offset], vertices[offset+1], vertices[offset+2], 1.0f);
+    }
+    
+    for(size_t i=0; i<triangleCount; i++, indices+=3)
+    {
+        glm::vec4 const* v[3] = { &clip[indices[0]], &clip[indices[1]], &clip[indices[2]] };
+        float d[3];
+        int inside = 0;
+        for(int j=0; j<3; j++)
+        {
+            d[j] = v[j]->z + v[j]->w;
+            inside += (d[j] >= 0.0f) ? 1 : 0;
+        }
+        if(3 == inside)
+        {
+            bin(*v[0], *v[1], *v[2]);
+            continue;
+        }
+        if(0 == inside)
+        {
+            continue;
+        }
+        // Clip against the near plane.
+        glm::vec4 polygon[4];
+        int count = 0;
+        for(int j=0; j<3; j++)
+        {
+            int k = (j+1) % 3;
+            if(d[j] >= 0.0f)
+            {
+                polygon[count++] = *v[j];
+            }
+            if((d[j] >= 0.0f) != (d[k] >= 0.0f))
+            {
+                float t = d[j] / (d[j] - d[k]);
+                polygon[count++] = *v[j] + (*v[k] - *v[j]) * t;
+            }
+        }
+        for(int j=2; j<count; j++)
+        {
+            bin(polygon[0], polygon[j-1], polygon[j]);
+        }
+    }
+}
+/** Setup and bin a clip space triangle. **/
+void OcclusionBuffer::bin(glm::vec4 const& v0, glm::vec4 const& v1, glm::vec4 const& v2)
+{
+    glm::vec4 const* v[3] = { &v0, &v1, &v2 };
+    float x[3], y[3], z[3];
+    for(int i=0; i<3; i++)
+    {
+        if(v[i]->w <= 0.0f)
+        {
+            return;
+        }
+        float invW = 1.0f / v[i]->w;
+        x[i] = (v[i]->x * invW * 0.5f + 0.5f) * _size.x;
+        y[i] = (v[i]->y * invW * 0.5f + 0.5f) * _size.y;
+        z[i] = (v[i]->z * invW * 0.5f + 0.5f);
+    }
+    
+    Triangle t;
+    t.x0 = std::max(static_cast<int>(std::ceil (std::min(x[0], std::min(x[1], x[2])) - 0.5f)), 0);
+    t.y0 = std::max(static_cast<int>(std::ceil (std::min(y[0], std::min(y[1], y[2])) - 0.5f)), 0);
+    t.x1 = std::min(static_cast<int>(std::floor(std::max(x[0], std::max(x[1], x[2])) - 0.5f)), _size.x-1);
+    t.y1 = std::min(static_cast<int>(std::floor(std::max(y[0], std::max(y[1], y[2])) - 0.5f)), _size.y-1);
+    if((t.x0 > t.x1) || (t.y0 > t.y1))
+    {
+        return;
+    }
+    
+    // Edge i goes from vertex i to vertex i+1 and is positive inside.
+    for(int i=0; i<3; i++)
+    {
+        int j = (i+1) % 3;
+        t.a[i] = y[i] - y[j];
+        t.b[i] = x[j] - x[i];
+        t.c[i] = -(t.a[i]*x[i] + t.b[i]*y[i]);
+    }
+    float area = t.a[0]*x[2] + t.b[0]*y[2] + t.c[0];
+    if(std::abs(area) < 1e-6f)
+    {
+        return;
+    }
+    if(area < 0.0f)
+    {
+        for(int i=0; i<3; i++)
+        {
+            t.a[i] = -t.a[i];
+            t.b[i] = -t.b[i];
+            t.c[i] = -t.c[i];
+        }
+        area = -area;
+    }
+    // The barycentric weight of a vertex is given by its opposite edge.
+    float invArea = 1.0f / area;
+    t.za = (t.a[1]*z[0] + t.a[2]*z[1] + t.a[0]*z[2]) * invArea;
+    t.zb = (t.b[1]*z[0] + t.b[2]*z[1] + t.b[0]*z[2]) * invArea;
+    t.zc = (t.c[1]*z[0] + t.c[2]*z[1] + t.c[0]*z[2]) * invArea;
+    
+    uint32_t index = static_cast<uint32_t>(_triangles.size());
+    _triangles.push_back(t);
+    for(int ty=t.y0/_tileSize.y; ty<=t.y1/_tileSize.y; ty++)
+    {
+        for(int tx=t.x0/_tileSize.x; tx<=t.x1/_tileSize.x; tx++)
+        {
+            _bins[tx + ty*_tiles.x].push_back(index);
+        }
+    }
+}
+/**
+ * Number of tiles.
+ */
+size_t OcclusionBuffer::tileCount() const
+{
+    return _bins.size();
+}
+/**
+ * Rasterize the triangles binned into a tile.
+ * Different tiles can be rasterized concurrently.
+ * @param [in] tile Tile index.
+ */
+void OcclusionBuffer::rasterize(size_t tile)
+{
+    int tx0 = static_cast<int>(tile % _tiles.x) * _tileSize.x;
+    int ty0 = static_cast<int>(tile / _tiles.x) * _tileSize.y;
+    int tx1 = tx0 + _tileSize.x - 1;
+    int ty1 = ty0 + _tileSize.y - 1;
+    
+    std::vector<uint32_t> const& triangles = _bins[tile];
+    for(size_t i=0; i<triangles.size(); i++)
+    {
+        Triangle const& t = _triangles[triangles[i]];
+        int x0 = std::max(t.x0, tx0), x1 = std::min(t.x1, tx1);
+        int y0 = std::max(t.y0, ty0), y1 = std::min(t.y1, ty1);
+        for(int y=y0; y<=y1; y++)
+        {
+            float py = y + 0.5f;
+            float e0 = t.b[0]*py + t.c[0];
+            float e1 = t.b[1]*py + t.c[1];
+            float e2 = t.b[2]*py + t.c[2];
+            float zr = t.zb*py + t.zc;
+            float* row = &_depth[y*_size.x];
+            // Branchless span, so that the compiler can vectorize it.
+            for(int x=x0; x<=x1; x++)
+            {
+                float px = x + 0.5f;
+                bool inside = ((t.a[0]*px + e0) >= 0.0f) & ((t.a[1]*px + e1) >= 0.0f) & ((t.a[2]*px + e2) >= 0.0f);
+                float z = t.za*px + zr;
+                row[x] = (inside && (z < row[x])) ? z : row[x];
+            }
+        }
+    }
+    
+    // Update coarse level.
+    int blocksPerRow = _size.x / BlockSize;
+    for(int by=ty0; by<=ty1; by+=BlockSize)
+    {
+        for(int bx=tx0; bx<=tx1; bx+=BlockSize)
+        {
+            float farthest = 0.0f;
+            for(int y=by; y<(by+BlockSize); y++)
+            {
+                float const* row = &_depth[y*_size.x + bx];
+                for(int x=0; x<BlockSize; x++)
+                {
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+            _coarse[(bx/BlockSize) + (by/BlockSize)*blocksPerRow] = farthest;
+        }
+    }
+}
+/**
+ * Rasterize all tiles.
+ */
+void OcclusionBuffer::rasterize()
+{
+    for(size_t i=0; i<_bins.size(); i++)
+    {
+        rasterize(i);
+    }
+}
+/**
+ * Test if a bounding box may be visible.
+ * Boxes crossing the near plane are considered visible.
+ * @param [in] box World space bounding box.
+ * @return false if the box is hidden by the occluders or outside
+ *         of the screen.
+ */
+bool OcclusionBuffer::visible(BoundingBox const& box) const
+{
+    glm::vec3 const& bmin = box.getMin();
+    glm::vec3 const& bmax = box.getMax();
+    glm::vec2 smin( std::numeric_limits<float>::max());
+    glm::vec2 smax(-std::numeric_limits<float>::max());
+    float nearest = 1.0f;
+    for(int i=0; i<8; i++)
+    {
+        glm::vec4 corner((i & 1) ? bmax.x : bmin.x, (i & 2) ? bmax.y : bmin.y, (i & 4) ? bmax.z : bmin.z, 1.0f);
+        glm::vec4 p = _viewProjection * corner;
+        if((p.w <= 0.0f) || (p.z < -p.w))
+        {
+            return true;
+        }
+        glm::vec3 ndc = glm::vec3(p) / p.w;
+        glm::vec2 s((ndc.x * 0.5f + 0.5f) * _size.x, (ndc.y * 0.5f + 0.5f) * _size.y);
+        smin = glm::min(smin, s);
+        smax = glm::max(smax, s);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+    
+    int x0 = std::max(static_cast<int>(std::floor(smin.x)), 0);
+    int y0 = std::max(static_cast<int>(std::floor(smin.y)), 0);
+    int x1 = std::min(static_cast<int>(std::floor(smax.x)), _size.x-1);
+    int y1 = std::min(static_cast<int>(std::floor(smax.y)), _size.y-1);
+    if((x0 > x1) || (y0 > y1) || (nearest > 1.0f))
+    {
+        return false;
+    }
+    
+    int blocksPerRow = _size.x / BlockSize;
+    for(int by=y0/BlockSize; by<=y1/BlockSize; by++)
+    {
+        for(int bx=x0/BlockSize; bx<=x1/BlockSize; bx++)
+        {
+            if(_coarse[bx + by*blocksPerRow] <= nearest)
+            {
+                continue;
+            }
+            int px0 = std::max(x0, bx*BlockSize), px1 = std::min(x1, bx*BlockSize + BlockSize - 1);
+            int py0 = std::max(y0, by*BlockSize), py1 = std::min(y1, by*BlockSize + BlockSize - 1);
+            for(int y=py0; y<=py1; y++)
+            {
+                float const* row = &_depth[y*_size.x];
+                for(int x=px0; x<=px1; x++)
+                {
+                    if(row[x] > nearest)
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+/**
+ * Buffer size.
+ */
+glm::ivec2 const& OcclusionBuffer::size() const
+{
+    return _size;
+}
+/**
+ * Retrieve pixel depth.
+ * @param [in] x Column.
+ * @param [in] y Row.
+ */
+float OcclusionBuffer::depth(int x, int y) const
+{
+    return _depth[x + y*_size.x];
+}
+
+} // Geometry
+} // Core
+} // Dumb
@@ -0,0 +1,417 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <limits>
+#include <DumbFramework/geometry/pointcloud.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+namespace PointCloud {
+
+namespace {
+
+/** Maximum number of directions used for extreme point search. **/
+const size_t MaxDirections = 7;
+/** EPOS-14 directions (unnormalized). **/
+const float Directions3[MaxDirections][3] =
+{
+    { 1.0f, 0.0f, 0.0f },
+    { 0.0f, 1.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f },
+    { 1.0f, 1.0f, 1.0f },
+    { 1.0f, 1.0f,-1.0f },
+    { 1.0f,-1.0f, 1.0f },
+    { 1.0f,-1.0f,-1.0f }
+};
+/** EPOS-8 directions (unnormalized). **/
+const float Directions2[4][2] =
+{
+    { 1.0f, 0.0f },
+    { 0.0f, 1.0f },
+    { 1.0f, 1.0f },
+    { 1.0f,-1.0f }
+};
+
+/** Load a single point. **/
+template <int D, typename vec_t>
+inline vec_t load(const uint8_t* buffer)
+{
+    const float* ptr = reinterpret_cast<const float*>(buffer);
+    vec_t p;
+    for(int j=0; j<D; j++) { p[j] = ptr[j]; }
+    return p;
+}
+/** Gather a block of points into SoA lanes. **/
+template <int D>
+inline void gather(const uint8_t* buffer, size_t stride, float p[D][Lanes])
+{
+    for(size_t l=0; l<Lanes; l++, buffer+=stride)
+    {
+        const float* ptr = reinterpret_cast<const float*>(buffer);
+        for(int j=0; j<D; j++) { p[j][l] = ptr[j]; }
+    }
+}
+/** Bounds kernel. **/
+template <int D, typename vec_t>
+void computeBounds(const uint8_t* buffer, size_t count, size_t stride, vec_t& pmin, vec_t& pmax)
+{
+    if(0 == count)
+    {
+        pmin = pmax = vec_t(0.0f);
+        return;
+    }
+    
+    float lo[D][Lanes], hi[D][Lanes];
+    const float* first = reinterpret_cast<const float*>(buffer);
+    for(int j=0; j<D; j++)
+    {
+        for(size_t l=0; l<Lanes; l++) { lo[j][l] = hi[j][l] = first[j]; }
+    }
+    
+    size_t i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, buffer+=Lanes*stride)
+    {
+        float p[D][Lanes];
+        gather<D>(buffer, stride, p);
+        for(int j=0; j<D; j++)
+        {
+            for(size_t l=0; l<Lanes; l++)
+            {
+                lo[j][l] = (p[j][l] < lo[j][l]) ? p[j][l] : lo[j][l];
+                hi[j][l] = (p[j][l] > hi[j][l]) ? p[j][l] : hi[j][l];
+            }
+        }
+    }
+    
+    for(int j=0; j<D; j++)
+    {
+        pmin[j] = lo[j][0];
+        pmax[j] = hi[j][0];
+        for(size_t l=1; l<Lanes; l++)
+        {
+            pmin[j] = glm::min(pmin[j], lo[j][l]);
+            pmax[j] = glm::max(pmax[j], hi[j][l]);
+        }
+    }
+    
+    for(; i<count; i++, buffer+=stride)
+    {
+        vec_t p = load<D, vec_t>(buffer);
+        pmin = glm::min(pmin, p);
+        pmax = glm::max(pmax, p);
+    }
+}
+/** Box containment kernel. **/
+template <int D, typename vec_t>
+size_t countInsideBox(const uint8_t* buffer, size_t count, size_t stride, vec_t const& bmin, vec_t const& bmax)
+{
+    unsigned int inside[Lanes] = { 0 };
+    size_t i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, buffer+=Lanes*stride)
+    {
+        float p[D][Lanes];
+        gather<D>(buffer, stride, p);
+        unsigned int in[Lanes];
+        for(size_t l=0; l<Lanes; l++) { in[l] = 1; }
+        for(int j=0; j<D; j++)
+        {
+            for(size_t l=0; l<Lanes; l++)
+            {
+                in[l] &= (p[j][l] >= bmin[j]) & (p[j][l] <= bmax[j]);
+            }
+        }
+        for(size_t l=0; l<Lanes; l++) { inside[l] += in[l]; }
+    }
+    
+    size_t result = 0;
+    for(size_t l=0; l<Lanes; l++) { result += inside[l]; }
+    
+    for(; i<count; i++, buffer+=stride)
+    {
+        vec_t p = load<D, vec_t>(buffer);
+        bool in = true;
+        for(int j=0; j<D; j++)
+        {
+            in = in && (p[j] >= bmin[j]) && (p[j] <= bmax[j]);
+        }
+        result += in ? 1 : 0;
+    }
+    return result;
+}
+/** Ball containment kernel. **/
+template <int D, typename vec_t>
+size_t countInsideBall(const uint8_t* buffer, size_t count, size_t stride, vec_t const& center, float squareRadius)
+{
+    unsigned int inside[Lanes] = { 0 };
+    size_t i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, buffer+=Lanes*stride)
+    {
+        float p[D][Lanes];
+        gather<D>(buffer, stride, p);
+        float d2[Lanes] = { 0.0f };
+        for(int j=0; j<D; j++)
+        {
+            for(size_t l=0; l<Lanes; l++)
+            {
+                float delta = p[j][l] - center[j];
+                d2[l] += delta * delta;
+            }
+        }
+        for(size_t l=0; l<Lanes; l++) { inside[l] += (d2[l] <= squareRadius) ? 1 : 0; }
+    }
+    
+    size_t result = 0;
+    for(size_t l=0; l<Lanes; l++) { result += inside[l]; }
+    
+    for(; i<count; i++, buffer+=stride)
+    {
+        vec_t delta = load<D, vec_t>(buffer) - center;
+        result += (glm::dot(delta, delta) <= squareRadius) ? 1 : 0;
+    }
+    return result;
+}
+/** Extreme points + Ritter bounding ball. **/
+template <int D, typename vec_t>
+void computeBall(const uint8_t* buffer, size_t count, size_t stride, const float (*directions)[D], size_t directionCount, vec_t& center, float& radius)
+{
+    if(0 == count)
+    {
+        center = vec_t(0.0f);
+        radius = 0.0f;
+        return;
+    }
+    
+    // Find extreme points along each direction.
+    float  lo[MaxDirections][Lanes],    hi[MaxDirections][Lanes];
+    size_t loIdx[MaxDirections][Lanes], hiIdx[MaxDirections][Lanes];
+    {
+        vec_t first = load<D, vec_t>(buffer);
+        for(size_t k=0; k<directionCount; k++)
+        {
+            float proj = 0.0f;
+            for(int j=0; j<D; j++) { proj += directions[k][j] * first[j]; }
+            for(size_t l=0; l<Lanes; l++)
+            {
+                lo[k][l] = hi[k][l] = proj;
+                loIdx[k][l] = hiIdx[k][l] = 0;
+            }
+        }
+    }
+    
+    const uint8_t* ptr = buffer;
+    size_t i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, ptr+=Lanes*stride)
+    {
+        float p[D][Lanes];
+        gather<D>(ptr, stride, p);
+        for(size_t k=0; k<directionCount; k++)
+        {
+            for(size_t l=0; l<Lanes; l++)
+            {
+                float proj = 0.0f;
+                for(int j=0; j<D; j++) { proj += directions[k][j] * p[j][l]; }
+                bool below = (proj < lo[k][l]);
+                bool above = (proj > hi[k][l]);
+                lo[k][l]    = below ? proj  : lo[k][l];
+                loIdx[k][l] = below ? (i+l) : loIdx[k][l];
+                hi[k][l]    = above ? proj  : hi[k][l];
+                hiIdx[k][l] = above ? (i+l) : hiIdx[k][l];
+            }
+        }
+    }
+    
+    size_t pmin[MaxDirections], pmax[MaxDirections];
+    for(size_t k=0; k<directionCount; k++)
+    {
+        float vmin = lo[k][0], vmax = hi[k][0];
+        pmin[k] = loIdx[k][0];
+        pmax[k] = hiIdx[k][0];
+        for(size_t l=1; l<Lanes; l++)
+        {
+            if(lo[k][l] < vmin) { vmin = lo[k][l]; pmin[k] = loIdx[k][l]; }
+            if(hi[k][l] > vmax) { vmax = hi[k][l]; pmax[k] = hiIdx[k][l]; }
+        }
+        for(size_t n=i; n<count; n++)
+        {
+            vec_t q = load<D, vec_t>(buffer + n*stride);
+            float proj = 0.0f;
+            for(int j=0; j<D; j++) { proj += directions[k][j] * q[j]; }
+            if(proj < vmin) { vmin = proj; pmin[k] = n; }
+            if(proj > vmax) { vmax = proj; pmax[k] = n; }
+        }
+    }
+    
+    // Initial ball from the most distant pair of extreme points.
+    vec_t a, b;
+    float best = -1.0f;
+    for(size_t k=0; k<directionCount; k++)
+    {
+        vec_t p0 = load<D, vec_t>(buffer + pmin[k]*stride);
+        vec_t p1 = load<D, vec_t>(buffer + pmax[k]*stride);
+        vec_t delta = p1 - p0;
+        float d2 = glm::dot(delta, delta);
+        if(d2 > best)
+        {
+            best = d2;
+            a = p0;
+            b = p1;
+        }
+    }
+    center = (a + b) / 2.0f;
+    radius = sqrt(best) / 2.0f;
+    float squareRadius = radius * radius;
+
+    // Grow the ball so that it encloses every point.
+    // Whole blocks are skipped when all their points are already inside.
+    ptr = buffer;
+    i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, ptr+=Lanes*stride)
+    {
+        float p[D][Lanes];
+        gather<D>(ptr, stride, p);
+        float d2[Lanes] = { 0.0f };
+        for(int j=0; j<D; j++)
+        {
+            for(size_t l=0; l<Lanes; l++)
+            {
+                float delta = p[j][l] - center[j];
+                d2[l] += delta * delta;
+            }
+        }
+        unsigned int outside = 0;
+        for(size_t l=0; l<Lanes; l++) { outside |= (d2[l] > squareRadius) ? 1 : 0; }
+        if(0 == outside) { continue; }
+        
+        for(size_t l=0; l<Lanes; l++)
+        {
+            vec_t q = load<D, vec_t>(ptr + l*stride);
+            vec_t delta = q - center;
+            float sq = glm::dot(delta, delta);
+            if(sq > squareRadius)
+            {
+                float distance = sqrt(sq);
+                float r = (radius + distance) / 2.0f;
+                center += delta * ((r - radius) / distance);
+                radius = r;
+                squareRadius = r * r;
+            }
+        }
+    }
+    for(; i<count; i++, ptr+=stride)
+    {
+        vec_t delta = load<D, vec_t>(ptr) - center;
+        float sq = glm::dot(delta, delta);
+        if(sq > squareRadius)
+        {
+            float distance = sqrt(sq);
+            float r = (radius + distance) / 2.0f;
+            center += delta * ((r - radius) / distance);
+            radius = r;
+            squareRadius = r * r;
+        }
+    }
+    // Guard against rounding errors accumulated while moving the center.
+    radius += radius * 4.0f * std::numeric_limits<float>::epsilon();
+}
+
+} // anonymous
+
+/** Compute the bounds of a 3D point array. **/
+void bounds(const uint8_t* buffer, size_t count, size_t stride, glm::vec3& pmin, glm::vec3& pmax)
+{
+    computeBounds<3>(buffer, count, stride, pmin, pmax);
+}
+/** Compute the bounds of a 2D point array. **/
+void bounds(const uint8_t* buffer, size_t count, size_t stride, glm::vec2& pmin, glm::vec2& pmax)
+{
+    computeBounds<2>(buffer, count, stride, pmin, pmax);
+}
+/** Count the number of 3D points inside an axis aligned box. **/
+size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    return countInsideBox<3>(buffer, count, stride, bmin, bmax);
+}
+/** Count the number of 2D points inside an axis aligned quad. **/
+size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec2 const& bmin, glm::vec2 const& bmax)
+{
+    return countInsideBox<2>(buffer, count, stride, bmin, bmax);
+}
+/** Count the number of 3D points inside a sphere. **/
+size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec3 const& center, float squareRadius)
+{
+    return countInsideBall<3>(buffer, count, stride, center, squareRadius);
+}
+/** Count the number of 2D points inside a circle. **/
+size_t countInside(const uint8_t* buffer, size_t count, size_t stride, glm::vec2 const& center, float squareRadius)
+{
+    return countInsideBall<2>(buffer, count, stride, center, squareRadius);
+}
+/** Count the number of 3D points that are not behind any of the specified planes. **/
+size_t countInside(const uint8_t* buffer, size_t count, size_t stride, Plane const* planes, size_t planeCount)
+{
+    // Same threshold as Plane::classify.
+    const float epsilon = 1e-6f;
+    unsigned int inside[Lanes] = { 0 };
+    size_t i = 0;
+    for(; (i+Lanes)<=count; i+=Lanes, buffer+=Lanes*stride)
+    {
+        float p[3][Lanes];
+        gather<3>(buffer, stride, p);
+        unsigned int in[Lanes];
+        for(size_t l=0; l<Lanes; l++) { in[l] = 1; }
+        for(size_t k=0; k<planeCount; k++)
+        {
+            glm::vec3 const& n = planes[k].getNormal();
+            float d = planes[k].getDistance();
+            for(size_t l=0; l<Lanes; l++)
+            {
+                float distance = n.x*p[0][l] + n.y*p[1][l] + n.z*p[2][l] + d;
+                in[l] &= (distance >= -epsilon);
+            }
+        }
+        for(size_t l=0; l<Lanes; l++) { inside[l] += in[l]; }
+    }
+    
+    size_t result = 0;
+    for(size_t l=0; l<Lanes; l++) { result += inside[l]; }
+    
+    for(; i<count; i++, buffer+=stride)
+    {
+        glm::vec3 p = load<3, glm::vec3>(buffer);
+        bool in = true;
+        for(size_t k=0; in && (k<planeCount); k++)
+        {
+            in = (planes[k].distance(p) >= -epsilon);
+        }
+        result += in ? 1 : 0;
+    }
+    return result;
+}
+/** Compute a bounding sphere of a 3D point array. **/
+void boundingSphere(const uint8_t* buffer, size_t count, size_t stride, glm::vec3& center, float& radius)
+{
+    computeBall<3>(buffer, count, stride, Directions3, MaxDirections, center, radius);
+}
+/** Compute a bounding circle of a 2D point array. **/
+void boundingCircle(const uint8_t* buffer, size_t count, size_t stride, glm::vec2& center, float& radius)
+{
+    computeBall<2>(buffer, count, stride, Directions2, 4, center, radius);
+}
+
+} // PointCloud
+} // Geometry
+} // Core
+} // Dumb
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <limits>
+#include <DumbFramework/geometry/raypacket.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/** Find the nearest bounding box hit by the specified ray.
+ *  This is the scalar version of the packet traversal.
+ *  @param [in]  boxes    Bounding box array.
+ *  @param [in]  count    Number of bounding boxes.
+ *  @param [in]  ray      Ray.
+ *  @param [out] index    Index of the nearest box (-1 if none).
+ *  @param [out] distance Entry distance (max float if none).
+ *  @return true if the ray hit at least one box.
+ */
+bool intersects(BoundingBox const* boxes, size_t count, Ray3 const& ray, int& index, float& distance)
+{
+    float current;
+    index    = -1;
+    distance = std::numeric_limits<float>::max();
+    for(size_t k=0; k<count; k++)
+    {
+        if(boxes[k].intersects(ray, current) && (current < distance))
+        {
+            distance = current;
+            index    = (int)k;
+        }
+    }
+    return (index >= 0);
+}
+
+} // Geometry
+} // Core
+} // Dumb
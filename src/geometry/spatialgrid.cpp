@@ -0,0 +1,417 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <DumbFramework/geometry/spatialgrid.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+const size_t SpatialGrid::None = static_cast<size_t>(-1);
+
+/** Check if 2 quads overlap. **/
+static inline bool overlap(glm::vec2 const& min0, glm::vec2 const& max0, glm::vec2 const& min1, glm::vec2 const& max1)
+{
+    return (min0.x <= max1.x) && (min1.x <= max0.x) && (min0.y <= max1.y) && (min1.y <= max0.y);
+}
+/** Check if a quad and a circle overlap. **/
+static inline bool overlap(glm::vec2 const& bmin, glm::vec2 const& bmax, glm::vec2 const& center, float squareRadius)
+{
+    glm::vec2 delta = glm::clamp(center, bmin, bmax) - center;
+    return glm::dot(delta, delta) <= squareRadius;
+}
+/** Check if a quad is crossed by a segment. **/
+static inline bool overlap(glm::vec2 const& bmin, glm::vec2 const& bmax, glm::vec2 const& origin, glm::vec2 const& invDirection, float length)
+{
+    glm::vec2 t0 = (bmin - origin) * invDirection;
+    glm::vec2 t1 = (bmax - origin) * invDirection;
+    glm::vec2 t2 = glm::min(t0, t1);
+    glm::vec2 t3 = glm::max(t0, t1);
+    float tmin = glm::max(glm::max(t2.x, t2.y), 0.0f);
+    float tmax = glm::min(glm::min(t3.x, t3.y), length);
+    return tmin <= tmax;
+}
+
+/**
+ * Constructor.
+ * @param [in] cellSize    Cell size.
+ * @param [in] bucketCount Number of hash buckets. It is rounded
+ *                         up to the next power of 2.
+ */
+SpatialGrid::SpatialGrid(float cellSize, size_t bucketCount)
+    : _cellSize(cellSize)
+    , _invCellSize(1.0f / cellSize)
+    , _stamp(0)
+{
+    size_t count = 1;
+    while(count < bucketCount)
+    {
+        count <<= 1;
+    }
+    _buckets.resize(count);
+}
+/**
+ * Destructor.
+ */
+SpatialGrid::~SpatialGrid()
+{}
+/** Compute cell range. **/
+SpatialGrid::Range SpatialGrid::cells(glm::vec2 const& bmin, glm::vec2 const& bmax) const
+{
+    Range range;
+    range.x0 = static_cast<int32_t>(std::floor(bmin.x * _invCellSize));
+    range.y0 = static_cast<int32_t>(std::floor(bmin.y * _invCellSize));
+    range.x1 = static_cast<int32_t>(std::floor(bmax.x * _invCellSize));
+    range.y1 = static_cast<int32_t>(std::floor(bmax.y * _invCellSize));
+    return range;
+}
+/** Bucket index of a cell. **/
+size_t SpatialGrid::bucket(int32_t x, int32_t y) const
+{
+    uint32_t h = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u);
+    return h & (_buckets.size() - 1);
+}
+/** Add object to cells. **/
+void SpatialGrid::link(uint32_t id, Range const& range)
+{
+    Entry entry;
+    entry.id = id;
+    for(entry.y=range.y0; entry.y<=range.y1; entry.y++)
+    {
+        for(entry.x=range.x0; entry.x<=range.x1; entry.x++)
+        {
+            _buckets[bucket(entry.x, entry.y)].push_back(entry);
+        }
+    }
+}
+/** Remove object from cells. **/
+void SpatialGrid::unlink(uint32_t id, Range const& range)
+{
+    for(int32_t y=range.y0; y<=range.y1; y++)
+    {
+        for(int32_t x=range.x0; x<=range.x1; x++)
+        {
+            std::vector<Entry>& entries = _buckets[bucket(x, y)];
+            for(size_t i=0; i<entries.size(); i++)
+            {
+                if((entries[i].id == id) && (entries[i].x == x) && (entries[i].y == y))
+                {
+                    entries[i] = entries.back();
+                    entries.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+/**
+ * Insert object.
+ * @param [in] quad Object bounds.
+ * @return Object identifier.
+ */
+size_t SpatialGrid::insert(BoundingQuad const& quad)
+{
+    size_t id;
+    if(_free.empty())
+    {
+        id = _alive.size();
+        _min.push_back(quad.getMin());
+        _max.push_back(quad.getMax());
+        _range.push_back(Range());
+        _alive.push_back(1);
+        _mark.push_back(0);
+    }
+    else
+    {
+        id = _free.back();
+        _free.pop_back();
+        _min[id] = quad.getMin();
+        _max[id] = quad.getMax();
+        _alive[id] = 1;
+    }
+    _range[id] = cells(_min[id], _max[id]);
+    link(static_cast<uint32_t>(id), _range[id]);
+    return id;
+}
+/**
+ * Insert object.
+ * @param [in] circle Object bounds.
+ * @return Object identifier.
+ */
+size_t SpatialGrid::insert(BoundingCircle const& circle)
+{
+    return insert(BoundingQuad(circle));
+}
+/**
+ * Update object bounds.
+ * Unknown or removed objects are ignored.
+ * @param [in] id   Object identifier.
+ * @param [in] quad New bounds.
+ */
+void SpatialGrid::move(size_t id, BoundingQuad const& quad)
+{
+    if((id >= _alive.size()) || !_alive[id])
+    {
+        return;
+    }
+    _min[id] = quad.getMin();
+    _max[id] = quad.getMax();
+    Range range = cells(_min[id], _max[id]);
+    Range& current = _range[id];
+    if((range.x0 != current.x0) || (range.y0 != current.y0) || (range.x1 != current.x1) || (range.y1 != current.y1))
+    {
+        unlink(static_cast<uint32_t>(id), current);
+        link(static_cast<uint32_t>(id), range);
+        current = range;
+    }
+}
+/**
+ * Update object bounds.
+ * Unknown or removed objects are ignored.
+ * @param [in] id     Object identifier.
+ * @param [in] circle New bounds.
+ */
+void SpatialGrid::move(size_t id, BoundingCircle const& circle)
+{
+    move(id, BoundingQuad(circle));
+}
+/**
+ * Remove object.
+ * Its identifier may be reused by later insertions.
+ * @param [in] id Object identifier.
+ */
+void SpatialGrid::remove(size_t id)
+{
+    if((id >= _alive.size()) || !_alive[id])
+    {
+        return;
+    }
+    unlink(static_cast<uint32_t>(id), _range[id]);
+    _alive[id] = 0;
+    _free.push_back(id);
+}
+/**
+ * Remove all objects.
+ */
+void SpatialGrid::clear()
+{
+    for(size_t i=0; i<_buckets.size(); i++)
+    {
+        _buckets[i].clear();
+    }
+    _min.clear();
+    _max.clear();
+    _range.clear();
+    _alive.clear();
+    _free.clear();
+    _mark.clear();
+    _stamp = 0;
+}
+/**
+ * Number of objects.
+ */
+size_t SpatialGrid::size() const
+{
+    return _alive.size() - _free.size();
+}
+/**
+ * Find the objects overlapping a quad.
+ * @param [in]  quad Query region.
+ * @param [out] out  Object identifiers. Results are appended.
+ * @return Number of objects found.
+ */
+size_t SpatialGrid::query(BoundingQuad const& quad, std::vector<size_t>& out) const
+{
+    size_t start = out.size();
+    glm::vec2 const& qmin = quad.getMin();
+    glm::vec2 const& qmax = quad.getMax();
+    Range range = cells(qmin, qmax);
+    
+    // Scanning the objects is cheaper than visiting more cells than there are buckets.
+    double cellCount = (double(range.x1) - range.x0 + 1.0) * (double(range.y1) - range.y0 + 1.0);
+    if(cellCount > _buckets.size())
+    {
+        for(size_t i=0; i<_alive.size(); i++)
+        {
+            if(_alive[i] && overlap(_min[i], _max[i], qmin, qmax))
+            {
+                out.push_back(i);
+            }
+        }
+        return out.size() - start;
+    }
+    
+    for(int32_t y=range.y0; y<=range.y1; y++)
+    {
+        for(int32_t x=range.x0; x<=range.x1; x++)
+        {
+            std::vector<Entry> const& entries = _buckets[bucket(x, y)];
+            for(size_t i=0; i<entries.size(); i++)
+            {
+                Entry const& entry = entries[i];
+                if((entry.x != x) || (entry.y != y))
+                {
+                    continue;
+                }
+                // Only report the object in the first cell shared with the query.
+                Range const& r = _range[entry.id];
+                if((std::max(r.x0, range.x0) != x) || (std::max(r.y0, range.y0) != y))
+                {
+                    continue;
+                }
+                if(overlap(_min[entry.id], _max[entry.id], qmin, qmax))
+                {
+                    out.push_back(entry.id);
+                }
+            }
+        }
+    }
+    return out.size() - start;
+}
+/**
+ * Find the objects overlapping a circle.
+ * @param [in]  circle Query region.
+ * @param [out] out    Object identifiers. Results are appended.
+ * @return Number of objects found.
+ */
+size_t SpatialGrid::query(BoundingCircle const& circle, std::vector<size_t>& out) const
+{
+    size_t start = out.size();
+    query(BoundingQuad(circle), out);
+    
+    glm::vec2 const& center = circle.getCenter();
+    float squareRadius = circle.getSquareRadius();
+    size_t last = start;
+    for(size_t i=start; i<out.size(); i++)
+    {
+        if(overlap(_min[out[i]], _max[out[i]], center, squareRadius))
+        {
+            out[last++] = out[i];
+        }
+    }
+    out.resize(last);
+    return last - start;
+}
+/**
+ * Find the objects crossed by a segment.
+ * @param [in]  ray    Segment origin and direction.
+ * @param [in]  length Segment length, expressed in ray direction units.
+ * @param [out] out    Object identifiers, in traversal order.
+ *                     Results are appended.
+ * @return Number of objects found.
+ */
+size_t SpatialGrid::query(Ray2 const& ray, float length, std::vector<size_t>& out)
+{
+    size_t start = out.size();
+    if(0 == ++_stamp)
+    {
+        std::fill(_mark.begin(), _mark.end(), 0);
+        _stamp = 1;
+    }
+    
+    const float infinity = std::numeric_limits<float>::infinity();
+    glm::vec2 const& origin = ray.origin;
+    glm::vec2 const& direction = ray.direction;
+    glm::vec2 invDirection = 1.0f / direction;
+    
+    // Cell traversal (Amanatides & Woo).
+    int32_t x = static_cast<int32_t>(std::floor(origin.x * _invCellSize));
+    int32_t y = static_cast<int32_t>(std::floor(origin.y * _invCellSize));
+    int32_t stepX = (direction.x < 0.0f) ? -1 : 1;
+    int32_t stepY = (direction.y < 0.0f) ? -1 : 1;
+    float deltaX = (0.0f == direction.x) ? infinity : std::abs(_cellSize * invDirection.x);
+    float deltaY = (0.0f == direction.y) ? infinity : std::abs(_cellSize * invDirection.y);
+    float tx = (0.0f == direction.x) ? infinity : (((x + (stepX > 0 ? 1 : 0)) * _cellSize - origin.x) * invDirection.x);
+    float ty = (0.0f == direction.y) ? infinity : (((y + (stepY > 0 ? 1 : 0)) * _cellSize - origin.y) * invDirection.y);
+    
+    for(;;)
+    {
+        std::vector<Entry> const& entries = _buckets[bucket(x, y)];
+        for(size_t i=0; i<entries.size(); i++)
+        {
+            Entry const& entry = entries[i];
+            if((entry.x != x) || (entry.y != y) || (_mark[entry.id] == _stamp))
+            {
+                continue;
+            }
+            _mark[entry.id] = _stamp;
+            if(overlap(_min[entry.id], _max[entry.id], origin, invDirection, length))
+            {
+                out.push_back(entry.id);
+            }
+        }
+        
+        if(tx < ty)
+        {
+            if(tx > length) { break; }
+            x  += stepX;
+            tx += deltaX;
+        }
+        else
+        {
+            if(ty > length) { break; }
+            y  += stepY;
+            ty += deltaY;
+        }
+    }
+    return out.size() - start;
+}
+/**
+ * Find all overlapping pairs.
+ * Each pair is reported once as (a, b) with a < b, and the list
+ * is sorted.
+ * @param [out] out Overlapping pairs. The list is cleared first.
+ * @return Number of pairs.
+ */
+size_t SpatialGrid::pairs(std::vector<std::pair<size_t, size_t>>& out) const
+{
+    out.clear();
+    for(size_t b=0; b<_buckets.size(); b++)
+    {
+        std::vector<Entry> const& entries = _buckets[b];
+        for(size_t i=0; i<entries.size(); i++)
+        {
+            Entry const& e0 = entries[i];
+            Range const& r0 = _range[e0.id];
+            for(size_t j=i+1; j<entries.size(); j++)
+            {
+                Entry const& e1 = entries[j];
+                if((e0.x != e1.x) || (e0.y != e1.y))
+                {
+                    continue;
+                }
+                // Only report the pair in the first cell both objects share.
+                Range const& r1 = _range[e1.id];
+                if((std::max(r0.x0, r1.x0) != e0.x) || (std::max(r0.y0, r1.y0) != e0.y))
+                {
+                    continue;
+                }
+                if(overlap(_min[e0.id], _max[e0.id], _min[e1.id], _max[e1.id]))
+                {
+                    out.push_back(std::make_pair(std::min(e0.id, e1.id), std::max(e0.id, e1.id)));
+                }
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out.size();
+}
+
+} // Geometry
+} // Core
+} // Dumb
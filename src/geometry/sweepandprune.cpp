@@ -0,0 +1,583 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <DumbFramework/geometry/sweepandprune.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/**
+ * Constructor.
+ * @param [in] axisCount Number of axis (2 for quads, 3 for boxes).
+ */
+SweepAndPrune::SweepAndPrune(unsigned int axisCount)
+    : _axisCount(std::min(std::max(axisCount, 1U), 3U))
+    , _listener(NULL)
+{}
+/**
+ * Destructor.
+ */
+SweepAndPrune::~SweepAndPrune()
+{}
+/**
+ * Set pair listener.
+ * @param [in] listener Pair listener (may be null).
+ */
+void SweepAndPrune::listener(Listener* listener)
+{
+    _listener = listener;
+}
+/** Insert object. **/
+size_t SweepAndPrune::insert(BoundingBox const& box)
+{
+    return insert(box.getMin(), box.getMax());
+}
+/** Insert object. **/
+size_t SweepAndPrune::insert(BoundingQuad const& quad)
+{
+    return insert(glm::vec3(quad.getMin(), 0.0f), glm::vec3(quad.getMax(), 0.0f));
+}
+/** Update object bounds. **/
+void SweepAndPrune::move(size_t id, BoundingBox const& box)
+{
+    move(id, box.getMin(), box.getMax());
+}
+/** Update object bounds. **/
+void SweepAndPrune::move(size_t id, BoundingQuad const& quad)
+{
+    move(id, glm::vec3(quad.getMin(), 0.0f), glm::vec3(quad.getMax(), 0.0f));
+}
+/** Insert object. **/
+size_t SweepAndPrune::insert(glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    size_t id;
+    if(_free.empty())
+    {
+        id = _min.size();
+        _min.push_back(bmin);
+        _max.push_back(bmax);
+        _alive.push_back(1);
+        for(unsigned int axis=0; axis<_axisCount; axis++)
+        {
+            _index[axis].push_back(0);
+            _index[axis].push_back(0);
+        }
+    }
+    else
+    {
+        id = _free.back();
+        _free.pop_back();
+        _min[id] = bmin;
+        _max[id] = bmax;
+        _alive[id] = 1;
+    }
+    // New endpoints are appended and will be sorted during the next update.
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        std::vector<Endpoint>& endpoints = _endpoints[axis];
+        Endpoint e;
+        e.value = bmin[axis];
+        e.data  = static_cast<uint32_t>(id << 1);
+        _index[axis][2*id] = static_cast<uint32_t>(endpoints.size());
+        endpoints.push_back(e);
+        e.value = bmax[axis];
+        e.data  = static_cast<uint32_t>((id << 1) | 1);
+        _index[axis][2*id+1] = static_cast<uint32_t>(endpoints.size());
+        endpoints.push_back(e);
+    }
+    return id;
+}
+/** Update object bounds. **/
+void SweepAndPrune::move(size_t id, glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    if((id >= _alive.size()) || !_alive[id])
+    {
+        return;
+    }
+    _min[id] = bmin;
+    _max[id] = bmax;
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        _endpoints[axis][_index[axis][2*id  ]].value = bmin[axis];
+        _endpoints[axis][_index[axis][2*id+1]].value = bmax[axis];
+    }
+}
+/**
+ * Remove object.
+ * Its pairs are reported as removed at the next update, after
+ * which its identifier may be reused. Unknown or removed objects
+ * are ignored.
+ * @param [in] id Object identifier.
+ */
+void SweepAndPrune::remove(size_t id)
+{
+    if((id >= _alive.size()) || !_alive[id])
+    {
+        return;
+    }
+    // Removed objects are pushed past the end of every axis.
+    glm::vec3 infinity(std::numeric_limits<float>::infinity());
+    move(id, infinity, infinity);
+    _alive[id] = 0;
+    _removed.push_back(id);
+}
+/** Pair key. **/
+uint64_t SweepAndPrune::key(uint32_t a, uint32_t b)
+{
+    return (a < b) ? ((static_cast<uint64_t>(a) << 32) | b) : ((static_cast<uint64_t>(b) << 32) | a);
+}
+/** Check if 2 objects overlap on all axis. **/
+bool SweepAndPrune::overlap(uint32_t a, uint32_t b) const
+{
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        if((_max[a][axis] <= _min[b][axis]) || (_max[b][axis] <= _min[a][axis]))
+        {
+            // Objects flat on the same plane (quads in a 3 axis sweep
+            // and prune) still overlap on this axis.
+            bool flat = (_min[a][axis] == _max[a][axis]) && (_min[b][axis] == _max[b][axis]) && (_min[a][axis] == _min[b][axis]);
+            if(!flat)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+/**
+ * Sort endpoints and report pair changes.
+ */
+void SweepAndPrune::update()
+{
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        std::vector<Endpoint>& endpoints = _endpoints[axis];
+        std::vector<uint32_t>& index = _index[axis];
+        for(size_t i=1; i<endpoints.size(); i++)
+        {
+            Endpoint e = endpoints[i];
+            size_t j = i;
+            // Each swap is a change of order between 2 endpoints that
+            // belong to different objects.
+            for(; (j > 0) && (e.value < endpoints[j-1].value); j--)
+            {
+                Endpoint const& other = endpoints[j-1];
+                uint32_t a = e.data >> 1, b = other.data >> 1;
+                bool eMax = (e.data & 1), otherMax = (other.data & 1);
+                if(!eMax && otherMax)
+                {
+                    // Min passed a max: the objects may start overlapping.
+                    if(overlap(a, b) && _pairs.insert(key(a, b)).second && _listener)
+                    {
+                        _listener->added(std::min(a, b), std::max(a, b));
+                    }
+                }
+                else if(eMax && !otherMax)
+                {
+                    // Max passed a min: the objects are now separated.
+                    if(_pairs.erase(key(a, b)) && _listener)
+                    {
+                        _listener->removed(std::min(a, b), std::max(a, b));
+                    }
+                }
+                endpoints[j] = other;
+                index[endpoints[j].data] = static_cast<uint32_t>(j);
+            }
+            endpoints[j] = e;
+            index[e.data] = static_cast<uint32_t>(j);
+        }
+    }
+    
+    if(_removed.empty())
+    {
+        return;
+    }
+    // Removed objects never swap with each other, so their common
+    // pairs are still there.
+    if(_removed.size() > 1)
+    {
+        std::vector<uint8_t> removed(_min.size(), 0);
+        for(size_t i=0; i<_removed.size(); i++)
+        {
+            removed[_removed[i]] = 1;
+        }
+        for(std::unordered_set<uint64_t>::iterator it=_pairs.begin(); it!=_pairs.end(); )
+        {
+            uint32_t a = static_cast<uint32_t>(*it >> 32), b = static_cast<uint32_t>(*it);
+            if(removed[a] && removed[b])
+            {
+                it = _pairs.erase(it);
+                if(_listener)
+                {
+                    _listener->removed(a, b);
+                }
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    // Removed objects endpoints are now at the end of each axis.
+    size_t count = 2 * _removed.size();
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        _endpoints[axis].resize(_endpoints[axis].size() - count);
+    }
+    _free.insert(_free.end(), _removed.begin(), _removed.end());
+    _removed.clear();
+}
+/**
+ * Number of objects.
+ */
+size_t SweepAndPrune::size() const
+{
+    return _endpoints[0].size()/2 - _removed.size();
+}
+/**
+ * Number of overlapping pairs.
+ */
+size_t SweepAndPrune::pairCount() const
+{
+    return _pairs.size();
+}
+/**
+ * Check if 2 objects were overlapping at the last update.
+ */
+bool SweepAndPrune::overlapping(size_t a, size_t b) const
+{
+    return _pairs.count(key(static_cast<uint32_t>(a), static_cast<uint32_t>(b))) != 0;
+}
+
+/** Constructor. **/
+MultiSweepAndPrune::Region::Region(MultiSweepAndPrune* o, unsigned int axisCount)
+    : owner(o)
+    , sap(axisCount)
+{
+    sap.listener(this);
+}
+/** Forward pair to owner. **/
+void MultiSweepAndPrune::Region::added(size_t a, size_t b)
+{
+    owner->added(global[a], global[b]);
+}
+/** Forward pair to owner. **/
+void MultiSweepAndPrune::Region::removed(size_t a, size_t b)
+{
+    owner->removed(global[a], global[b]);
+}
+
+/**
+ * Constructor.
+ * @param [in] regionSize Region size.
+ * @param [in] axisCount  Number of axis (2 for quads, 3 for boxes).
+ */
+MultiSweepAndPrune::MultiSweepAndPrune(float regionSize, unsigned int axisCount)
+    : _axisCount(std::min(std::max(axisCount, 1U), 3U))
+    , _invRegionSize(1.0f / regionSize)
+    , _listener(NULL)
+{}
+/**
+ * Destructor.
+ */
+MultiSweepAndPrune::~MultiSweepAndPrune()
+{
+    for(std::unordered_map<uint64_t, Region*>::iterator it=_regions.begin(); it!=_regions.end(); ++it)
+    {
+        delete it->second;
+    }
+}
+/**
+ * Set pair listener.
+ * @param [in] listener Pair listener (may be null).
+ */
+void MultiSweepAndPrune::listener(SweepAndPrune::Listener* listener)
+{
+    _listener = listener;
+}
+/** Insert object. **/
+size_t MultiSweepAndPrune::insert(BoundingBox const& box)
+{
+    return insert(box.getMin(), box.getMax());
+}
+/** Insert object. **/
+size_t MultiSweepAndPrune::insert(BoundingQuad const& quad)
+{
+    return insert(glm::vec3(quad.getMin(), 0.0f), glm::vec3(quad.getMax(), 0.0f));
+}
+/** Update object bounds. **/
+void MultiSweepAndPrune::move(size_t id, BoundingBox const& box)
+{
+    move(id, box.getMin(), box.getMax());
+}
+/** Update object bounds. **/
+void MultiSweepAndPrune::move(size_t id, BoundingQuad const& quad)
+{
+    move(id, glm::vec3(quad.getMin(), 0.0f), glm::vec3(quad.getMax(), 0.0f));
+}
+/** Compute region range. **/
+MultiSweepAndPrune::Range MultiSweepAndPrune::regions(glm::vec3 const& bmin, glm::vec3 const& bmax) const
+{
+    Range range;
+    range.first = range.last = glm::ivec3(0);
+    for(unsigned int axis=0; axis<_axisCount; axis++)
+    {
+        range.first[axis] = static_cast<int>(std::floor(bmin[axis] * _invRegionSize));
+        range.last[axis]  = static_cast<int>(std::floor(bmax[axis] * _invRegionSize));
+    }
+    return range;
+}
+/** Region key. **/
+uint64_t MultiSweepAndPrune::key(glm::ivec3 const& cell)
+{
+    return ((static_cast<uint64_t>(cell.x) & 0x1fffff) << 42) |
+           ((static_cast<uint64_t>(cell.y) & 0x1fffff) << 21) |
+            (static_cast<uint64_t>(cell.z) & 0x1fffff);
+}
+/** Add object to a region. **/
+void MultiSweepAndPrune::link(size_t id, glm::ivec3 const& cell, glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    Region*& region = _regions[key(cell)];
+    if(NULL == region)
+    {
+        region = new Region(this, _axisCount);
+    }
+    Membership membership;
+    membership.cell   = cell;
+    membership.region = region;
+    membership.local  = (3 == _axisCount) ? region->sap.insert(BoundingBox(bmin, bmax))
+                                          : region->sap.insert(BoundingQuad(glm::vec2(bmin), glm::vec2(bmax)));
+    if(membership.local >= region->global.size())
+    {
+        region->global.resize(membership.local+1);
+    }
+    region->global[membership.local] = id;
+    _membership[id].push_back(membership);
+}
+/** Insert object. **/
+size_t MultiSweepAndPrune::insert(glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    size_t id;
+    if(_free.empty())
+    {
+        id = _range.size();
+        _range.push_back(Range());
+        _membership.push_back(std::vector<Membership>());
+    }
+    else
+    {
+        id = _free.back();
+        _free.pop_back();
+    }
+    
+    Range& range = _range[id];
+    range = regions(bmin, bmax);
+    glm::ivec3 cell;
+    for(cell.z=range.first.z; cell.z<=range.last.z; cell.z++)
+    {
+        for(cell.y=range.first.y; cell.y<=range.last.y; cell.y++)
+        {
+            for(cell.x=range.first.x; cell.x<=range.last.x; cell.x++)
+            {
+                link(id, cell, bmin, bmax);
+            }
+        }
+    }
+    return id;
+}
+/** Update object bounds. **/
+void MultiSweepAndPrune::move(size_t id, glm::vec3 const& bmin, glm::vec3 const& bmax)
+{
+    // Live objects always belong to at least one region.
+    if((id >= _membership.size()) || _membership[id].empty())
+    {
+        return;
+    }
+    Range range = regions(bmin, bmax);
+    Range& current = _range[id];
+    std::vector<Membership>& membership = _membership[id];
+    
+    BoundingBox  box(bmin, bmax);
+    BoundingQuad quad = BoundingQuad(glm::vec2(bmin), glm::vec2(bmax));
+    bool same = (range.first == current.first) && (range.last == current.last);
+    for(size_t i=0; i<membership.size(); )
+    {
+        Membership& m = membership[i];
+        if(same || (glm::all(glm::greaterThanEqual(m.cell, range.first)) && glm::all(glm::lessThanEqual(m.cell, range.last))))
+        {
+            if(3 == _axisCount) { m.region->sap.move(m.local, box);  }
+            else                { m.region->sap.move(m.local, quad); }
+            i++;
+        }
+        else
+        {
+            m.region->sap.remove(m.local);
+            m = membership.back();
+            membership.pop_back();
+        }
+    }
+    if(same)
+    {
+        return;
+    }
+    
+    glm::ivec3 cell;
+    for(cell.z=range.first.z; cell.z<=range.last.z; cell.z++)
+    {
+        for(cell.y=range.first.y; cell.y<=range.last.y; cell.y++)
+        {
+            for(cell.x=range.first.x; cell.x<=range.last.x; cell.x++)
+            {
+                if(glm::all(glm::greaterThanEqual(cell, current.first)) && glm::all(glm::lessThanEqual(cell, current.last)))
+                {
+                    continue;
+                }
+                link(id, cell, bmin, bmax);
+            }
+        }
+    }
+    current = range;
+}
+/**
+ * Remove object.
+ * Unknown or removed objects are ignored.
+ * @param [in] id Object identifier.
+ */
+void MultiSweepAndPrune::remove(size_t id)
+{
+    if((id >= _membership.size()) || _membership[id].empty())
+    {
+        return;
+    }
+    std::vector<Membership>& membership = _membership[id];
+    for(size_t i=0; i<membership.size(); i++)
+    {
+        membership[i].region->sap.remove(membership[i].local);
+    }
+    membership.clear();
+    // The identifier is still referenced by pending pairs until the next update.
+    _removed.push_back(id);
+}
+/**
+ * Update all regions and report pair changes.
+ */
+void MultiSweepAndPrune::update()
+{
+    for(std::unordered_map<uint64_t, Region*>::iterator it=_regions.begin(); it!=_regions.end(); )
+    {
+        Region* region = it->second;
+        region->sap.update();
+        if(0 == region->sap.size())
+        {
+            delete region;
+            it = _regions.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    _free.insert(_free.end(), _removed.begin(), _removed.end());
+    _removed.clear();
+    
+    // Increments are applied first so that a pair moving from a region
+    // to another one never drops to zero references.
+    std::vector<uint64_t> created, destroyed;
+    for(size_t i=0; i<_increments.size(); i++)
+    {
+        if(0 == _pairs[_increments[i]]++)
+        {
+            created.push_back(_increments[i]);
+        }
+    }
+    for(size_t i=0; i<_decrements.size(); i++)
+    {
+        std::unordered_map<uint64_t, unsigned int>::iterator it = _pairs.find(_decrements[i]);
+        if((it != _pairs.end()) && (0 == --it->second))
+        {
+            _pairs.erase(it);
+            destroyed.push_back(_decrements[i]);
+        }
+    }
+    _increments.clear();
+    _decrements.clear();
+    if(NULL == _listener)
+    {
+        return;
+    }
+    // Only report pairs whose state changed since the last update.
+    std::sort(created.begin(), created.end());
+    std::sort(destroyed.begin(), destroyed.end());
+    std::vector<uint64_t> changes;
+    std::set_difference(destroyed.begin(), destroyed.end(), created.begin(), created.end(), std::back_inserter(changes));
+    for(size_t i=0; i<changes.size(); i++)
+    {
+        _listener->removed(static_cast<size_t>(changes[i] >> 32), static_cast<size_t>(changes[i] & 0xffffffff));
+    }
+    changes.clear();
+    std::set_difference(created.begin(), created.end(), destroyed.begin(), destroyed.end(), std::back_inserter(changes));
+    for(size_t i=0; i<changes.size(); i++)
+    {
+        _listener->added(static_cast<size_t>(changes[i] >> 32), static_cast<size_t>(changes[i] & 0xffffffff));
+    }
+}
+/** Queue pair reference increment. **/
+void MultiSweepAndPrune::added(size_t a, size_t b)
+{
+    if(a > b)
+    {
+        std::swap(a, b);
+    }
+    _increments.push_back((static_cast<uint64_t>(a) << 32) | b);
+}
+/** Queue pair reference decrement. **/
+void MultiSweepAndPrune::removed(size_t a, size_t b)
+{
+    if(a > b)
+    {
+        std::swap(a, b);
+    }
+    _decrements.push_back((static_cast<uint64_t>(a) << 32) | b);
+}
+/**
+ * Number of objects.
+ */
+size_t MultiSweepAndPrune::size() const
+{
+    return _range.size() - _free.size() - _removed.size();
+}
+/**
+ * Number of regions.
+ */
+size_t MultiSweepAndPrune::regionCount() const
+{
+    return _regions.size();
+}
+/**
+ * Number of overlapping pairs.
+ */
+size_t MultiSweepAndPrune::pairCount() const
+{
+    return _pairs.size();
+}
+
+} // Geometry
+} // Core
+} // Dumb
@@ -13,12 +13,70 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
+#include <cmath>
 #include <DumbFramework/geometry/transform.hpp>
 
 namespace Dumb     {
 namespace Core     {
 namespace Geometry {
 
+/** Number of transforms processed at once by the batch functions. **/
+enum { Lanes = 8 };
+
+/**
+ * Dual quaternions stored as structure of arrays.
+ * Components 0 to 3 are the real part (x, y, z, w) and 4 to 7 the dual part.
+ */
+struct DualQuatLanes
+{
+    float q[8][Lanes];
+    
+    /** Set lane. **/
+    void set(size_t j, glm::fdualquat const& dq)
+    {
+        q[0][j] = dq.real.x; q[1][j] = dq.real.y; q[2][j] = dq.real.z; q[3][j] = dq.real.w;
+        q[4][j] = dq.dual.x; q[5][j] = dq.dual.y; q[6][j] = dq.dual.z; q[7][j] = dq.dual.w;
+    }
+    /** Get lane. **/
+    glm::fdualquat get(size_t j) const
+    {
+        return glm::fdualquat(glm::fquat(q[3][j], q[0][j], q[1][j], q[2][j]),
+                              glm::fquat(q[7][j], q[4][j], q[5][j], q[6][j]));
+    }
+    /** Set lanes starting from j to identity. **/
+    void identity(size_t j)
+    {
+        for(; j<Lanes; j++)
+        {
+            for(int k=0; k<8; k++)
+            {
+                q[k][j] = (3 == k) ? 1.0f : 0.0f;
+            }
+        }
+    }
+    /** Normalize all lanes. **/
+    void normalize()
+    {
+        for(size_t j=0; j<Lanes; j++)
+        {
+            float invLength = 1.0f / std::sqrt(q[0][j]*q[0][j] + q[1][j]*q[1][j] + q[2][j]*q[2][j] + q[3][j]*q[3][j]);
+            for(int k=0; k<8; k++)
+            {
+                q[k][j] *= invLength;
+            }
+        }
+    }
+    /** Dot product of the real parts. **/
+    void dot(DualQuatLanes const& b, float* d) const
+    {
+        for(size_t j=0; j<Lanes; j++)
+        {
+            d[j] = q[0][j]*b.q[0][j] + q[1][j]*b.q[1][j] + q[2][j]*b.q[2][j] + q[3][j]*b.q[3][j];
+        }
+    }
+};
+
 /**
  * Default constructor.
  */
@@ -91,6 +149,198 @@ Transform mix(Transform const& from, Transform const& to, float t)
     tr._q = glm::lerp(from._q, to._q, t);
     return tr;
 }
+/**
+ * Interpolate between 2 arrays of transforms.
+ * This is the batch version of mix. The results are normalized.
+ */
+void mix(Transform const* from, Transform const* to, float const* t, Transform* out, size_t count)
+{
+    DualQuatLanes a, b;
+    float d[Lanes], wa[Lanes], wb[Lanes];
+    for(size_t i=0; i<count; i+=Lanes)
+    {
+        size_t n = std::min(static_cast<size_t>(Lanes), count-i);
+        for(size_t j=0; j<n; j++)
+        {
+            a.set(j, from[i+j]._q);
+            b.set(j, to[i+j]._q);
+        }
+        a.identity(n);
+        b.identity(n);
+        a.dot(b, d);
+        for(size_t j=0; j<n; j++)
+        {
+            wa[j] = 1.0f - t[i+j];
+            wb[j] = t[i+j];
+        }
+        for(size_t j=n; j<Lanes; j++)
+        {
+            wa[j] = 1.0f;
+            wb[j] = 0.0f;
+        }
+        // Shortest path.
+        for(size_t j=0; j<Lanes; j++)
+        {
+            wb[j] = (d[j] < 0.0f) ? -wb[j] : wb[j];
+        }
+        for(int k=0; k<8; k++)
+        {
+            for(size_t j=0; j<Lanes; j++)
+            {
+                a.q[k][j] = wa[j]*a.q[k][j] + wb[j]*b.q[k][j];
+            }
+        }
+        a.normalize();
+        for(size_t j=0; j<n; j++)
+        {
+            out[i+j]._q = a.get(j);
+        }
+    }
+}
+/**
+ * Spherical interpolation between 2 arrays of transforms.
+ * Orientations are interpolated along the shortest arc and
+ * positions are linearly interpolated.
+ */
+void slerp(Transform const* from, Transform const* to, float const* t, Transform* out, size_t count)
+{
+    DualQuatLanes a, b;
+    float d[Lanes], wa[Lanes], wb[Lanes];
+    float pa[3][Lanes], pb[3][Lanes];
+    for(size_t i=0; i<count; i+=Lanes)
+    {
+        size_t n = std::min(static_cast<size_t>(Lanes), count-i);
+        for(size_t j=0; j<n; j++)
+        {
+            a.set(j, from[i+j]._q);
+            b.set(j, to[i+j]._q);
+        }
+        a.identity(n);
+        b.identity(n);
+        a.dot(b, d);
+        for(size_t j=0; j<n; j++)
+        {
+            wb[j] = t[i+j];
+        }
+        for(size_t j=n; j<Lanes; j++)
+        {
+            wb[j] = 0.0f;
+        }
+        
+        // Positions: 2 * dual * conjugate(real).
+        DualQuatLanes* src[2] = { &a, &b };
+        float (*dst[2])[Lanes] = { pa, pb };
+        for(int s=0; s<2; s++)
+        {
+            float (*q)[Lanes] = src[s]->q;
+            float (*p)[Lanes] = dst[s];
+            for(size_t j=0; j<Lanes; j++)
+            {
+                p[0][j] = 2.0f * (q[7][j]*-q[0][j] + q[3][j]*q[4][j] + (q[5][j]*-q[2][j] - q[6][j]*-q[1][j]));
+                p[1][j] = 2.0f * (q[7][j]*-q[1][j] + q[3][j]*q[5][j] + (q[6][j]*-q[0][j] - q[4][j]*-q[2][j]));
+                p[2][j] = 2.0f * (q[7][j]*-q[2][j] + q[3][j]*q[6][j] + (q[4][j]*-q[1][j] - q[5][j]*-q[0][j]));
+            }
+        }
+        
+        // Slerp weights, falling back to linear interpolation for close orientations.
+        for(size_t j=0; j<Lanes; j++)
+        {
+            float sign = (d[j] < 0.0f) ? -1.0f : 1.0f;
+            float cosTheta = std::min(d[j] * sign, 1.0f);
+            float theta = std::acos(cosTheta);
+            float sinTheta = std::sin(theta);
+            bool linear = (cosTheta > 0.9995f);
+            float invSin = linear ? 0.0f : (1.0f / sinTheta);
+            float la = 1.0f - wb[j], lb = wb[j];
+            wa[j] = linear ? la : (std::sin(la * theta) * invSin);
+            wb[j] = sign * (linear ? lb : (std::sin(lb * theta) * invSin));
+            
+            pa[0][j] += lb * (pb[0][j] - pa[0][j]);
+            pa[1][j] += lb * (pb[1][j] - pa[1][j]);
+            pa[2][j] += lb * (pb[2][j] - pa[2][j]);
+        }
+        for(int k=0; k<4; k++)
+        {
+            for(size_t j=0; j<Lanes; j++)
+            {
+                a.q[k][j] = wa[j]*a.q[k][j] + wb[j]*b.q[k][j];
+            }
+        }
+        for(size_t j=0; j<Lanes; j++)
+        {
+            float invLength = 1.0f / std::sqrt(a.q[0][j]*a.q[0][j] + a.q[1][j]*a.q[1][j] + a.q[2][j]*a.q[2][j] + a.q[3][j]*a.q[3][j]);
+            a.q[0][j] *= invLength;
+            a.q[1][j] *= invLength;
+            a.q[2][j] *= invLength;
+            a.q[3][j] *= invLength;
+        }
+        // Dual part: 0.5 * (0, position) * real.
+        for(size_t j=0; j<Lanes; j++)
+        {
+            float x = a.q[0][j], y = a.q[1][j], z = a.q[2][j], w = a.q[3][j];
+            a.q[4][j] = 0.5f * (w*pa[0][j] + (pa[1][j]*z - pa[2][j]*y));
+            a.q[5][j] = 0.5f * (w*pa[1][j] + (pa[2][j]*x - pa[0][j]*z));
+            a.q[6][j] = 0.5f * (w*pa[2][j] + (pa[0][j]*y - pa[1][j]*x));
+            a.q[7][j] = 0.5f * -(pa[0][j]*x + pa[1][j]*y + pa[2][j]*z);
+        }
+        for(size_t j=0; j<n; j++)
+        {
+            out[i+j]._q = a.get(j);
+        }
+    }
+}
+/**
+ * Weighted blend of several poses.
+ * Pose p is stored at poses[p*count], and the orientations are
+ * aligned on the hemisphere of the first pose.
+ */
+void accumulate(Transform const* poses, float const* weights, size_t poseCount, Transform* out, size_t count)
+{
+    DualQuatLanes first, pose, sum;
+    float d[Lanes], w[Lanes];
+    for(size_t i=0; i<count; i+=Lanes)
+    {
+        size_t n = std::min(static_cast<size_t>(Lanes), count-i);
+        for(size_t j=0; j<n; j++)
+        {
+            first.set(j, poses[i+j]._q);
+        }
+        first.identity(n);
+        for(int k=0; k<8; k++)
+        {
+            for(size_t j=0; j<Lanes; j++)
+            {
+                sum.q[k][j] = 0.0f;
+            }
+        }
+        for(size_t p=0; p<poseCount; p++)
+        {
+            Transform const* src = poses + (p*count) + i;
+            for(size_t j=0; j<n; j++)
+            {
+                pose.set(j, src[j]._q);
+            }
+            pose.identity(n);
+            first.dot(pose, d);
+            for(size_t j=0; j<Lanes; j++)
+            {
+                w[j] = (d[j] < 0.0f) ? -weights[p] : weights[p];
+            }
+            for(int k=0; k<8; k++)
+            {
+                for(size_t j=0; j<Lanes; j++)
+                {
+                    sum.q[k][j] += w[j] * pose.q[k][j];
+                }
+            }
+        }
+        sum.normalize();
+        for(size_t j=0; j<n; j++)
+        {
+            out[i+j]._q = sum.get(j);
+        }
+    }
+}
 /**
  * Concatenate transforms.
  */
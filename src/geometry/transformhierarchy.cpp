@@ -0,0 +1,427 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <DumbFramework/geometry/transformhierarchy.hpp>
+
+namespace Dumb     {
+namespace Core     {
+namespace Geometry {
+
+/** Number of nodes processed at once when computing world matrices. **/
+enum { Lanes = 8 };
+
+const size_t TransformHierarchy::None = static_cast<size_t>(-1);
+
+/**
+ * Reorder array.
+ * @param [in][out] v     Array.
+ * @param [in]      order New index to old index.
+ */
+template <typename T>
+static void reorder(std::vector<T>& v, std::vector<size_t> const& order)
+{
+    std::vector<T> tmp(v.size());
+    for(size_t i=0; i<order.size(); i++)
+    {
+        tmp[i] = v[order[i]];
+    }
+    v.swap(tmp);
+}
+
+/**
+ * Default constructor.
+ */
+TransformHierarchy::TransformHierarchy()
+    : _layout(false)
+{}
+/**
+ * Destructor.
+ */
+TransformHierarchy::~TransformHierarchy()
+{}
+/**
+ * Add node.
+ * @param [in] parent Parent node handle or None for a root node.
+ * @param [in] local  Local transform.
+ * @return Node handle or None if the parent handle is invalid.
+ */
+size_t TransformHierarchy::add(size_t parent, Transform const& local)
+{
+    size_t parentSlot = None;
+    unsigned int level = 0;
+    if(None != parent)
+    {
+        if(parent >= _slot.size())
+        {
+            return None;
+        }
+        parentSlot = _slot[parent];
+        level = _level[parentSlot] + 1;
+    }
+    
+    size_t handle = _slot.size();
+    size_t slot   = _handle.size();
+    _slot.push_back(slot);
+    _handle.push_back(handle);
+    _parent.push_back(parentSlot);
+    _level.push_back(level);
+    _firstChild.push_back(0);
+    _childCount.push_back(0);
+    _world.push_back(glm::mat4(1.0f));
+    _dirty.push_back(1);
+    
+    glm::fquat q = local.orientation();
+    glm::vec3  p = local.position();
+    _orientation[0].push_back(q.x);
+    _orientation[1].push_back(q.y);
+    _orientation[2].push_back(q.z);
+    _orientation[3].push_back(q.w);
+    _position[0].push_back(p.x);
+    _position[1].push_back(p.y);
+    _position[2].push_back(p.z);
+    
+    _layout = true;
+    return handle;
+}
+/**
+ * Remove all nodes.
+ */
+void TransformHierarchy::clear()
+{
+    _slot.clear();
+    _handle.clear();
+    _parent.clear();
+    _level.clear();
+    _firstChild.clear();
+    _childCount.clear();
+    for(int i=0; i<4; i++)
+    {
+        _orientation[i].clear();
+    }
+    for(int i=0; i<3; i++)
+    {
+        _position[i].clear();
+    }
+    _world.clear();
+    _dirty.clear();
+    _pending.clear();
+    _current.clear();
+    _layout = false;
+}
+/**
+ * Number of nodes.
+ */
+size_t TransformHierarchy::size() const
+{
+    return _slot.size();
+}
+/**
+ * Retrieve the parent of a node.
+ * @param [in] node Node handle.
+ * @return Parent handle or None for root nodes.
+ */
+size_t TransformHierarchy::parent(size_t node) const
+{
+    size_t parentSlot = _parent[_slot[node]];
+    return (None == parentSlot) ? None : _handle[parentSlot];
+}
+/**
+ * Retrieve local transform.
+ * @param [in] node Node handle.
+ */
+Transform TransformHierarchy::local(size_t node) const
+{
+    size_t slot = _slot[node];
+    glm::fquat q(_orientation[3][slot], _orientation[0][slot], _orientation[1][slot], _orientation[2][slot]);
+    glm::vec3  p(_position[0][slot], _position[1][slot], _position[2][slot]);
+    return Transform(q, p);
+}
+/**
+ * Set local transform.
+ * The node and its subtree will be updated at the next update.
+ * @param [in] node Node handle.
+ * @param [in] t    Local transform.
+ */
+void TransformHierarchy::local(size_t node, Transform const& t)
+{
+    orientation(node, t.orientation());
+    position(node, t.position());
+}
+/**
+ * Set local orientation.
+ * @param [in] node Node handle.
+ * @param [in] q    Orientation.
+ */
+void TransformHierarchy::orientation(size_t node, glm::fquat const& q)
+{
+    size_t slot = _slot[node];
+    _orientation[0][slot] = q.x;
+    _orientation[1][slot] = q.y;
+    _orientation[2][slot] = q.z;
+    _orientation[3][slot] = q.w;
+    touch(slot);
+}
+/**
+ * Set local position.
+ * @param [in] node Node handle.
+ * @param [in] p    Position.
+ */
+void TransformHierarchy::position(size_t node, glm::vec3 const& p)
+{
+    size_t slot = _slot[node];
+    _position[0][slot] = p.x;
+    _position[1][slot] = p.y;
+    _position[2][slot] = p.z;
+    touch(slot);
+}
+/**
+ * Retrieve world matrix as computed by the last update.
+ * @param [in] node Node handle.
+ */
+glm::mat4 const& TransformHierarchy::world(size_t node) const
+{
+    return _world[_slot[node]];
+}
+/** Flag node for update. **/
+void TransformHierarchy::touch(size_t slot)
+{
+    if(_dirty[slot])
+    {
+        return;
+    }
+    _dirty[slot] = 1;
+    // Newly added nodes are collected during the next build.
+    if(!_layout)
+    {
+        _pending[_level[slot]].push_back(slot);
+    }
+}
+/**
+ * Update the world matrices of all modified subtrees.
+ */
+void TransformHierarchy::update()
+{
+    build();
+    for(unsigned int level=0; level<levelCount(); level++)
+    {
+        size_t count = prepare(level);
+        if(count)
+        {
+            compute(0, count);
+        }
+    }
+}
+/**
+ * Rebuild breadth first layout if nodes were added since the
+ * last build. This must be called before any level is prepared.
+ */
+void TransformHierarchy::build()
+{
+    if(!_layout)
+    {
+        return;
+    }
+    _layout = false;
+    
+    size_t count = _handle.size();
+    
+    // Group children by parent.
+    std::vector<size_t> offset(count+1, 0);
+    for(size_t i=0; i<count; i++)
+    {
+        if(None != _parent[i])
+        {
+            offset[_parent[i]+1]++;
+        }
+    }
+    for(size_t i=0; i<count; i++)
+    {
+        offset[i+1] += offset[i];
+    }
+    std::vector<size_t> children(offset[count]);
+    std::vector<size_t> cursor(offset.begin(), offset.end()-1);
+    for(size_t i=0; i<count; i++)
+    {
+        if(None != _parent[i])
+        {
+            children[cursor[_parent[i]]++] = i;
+        }
+    }
+    
+    // Breadth first traversal, roots first.
+    std::vector<size_t> order;
+    order.reserve(count);
+    for(size_t i=0; i<count; i++)
+    {
+        if(None == _parent[i])
+        {
+            order.push_back(i);
+        }
+    }
+    for(size_t i=0; i<order.size(); i++)
+    {
+        size_t old = order[i];
+        _firstChild[old] = order.size();
+        _childCount[old] = offset[old+1] - offset[old];
+        order.insert(order.end(), children.begin()+offset[old], children.begin()+offset[old+1]);
+    }
+    
+    std::vector<size_t> slot(count);
+    for(size_t i=0; i<count; i++)
+    {
+        slot[order[i]] = i;
+    }
+    
+    reorder(_handle, order);
+    reorder(_parent, order);
+    reorder(_level, order);
+    reorder(_firstChild, order);
+    reorder(_childCount, order);
+    for(int i=0; i<4; i++)
+    {
+        reorder(_orientation[i], order);
+    }
+    for(int i=0; i<3; i++)
+    {
+        reorder(_position[i], order);
+    }
+    reorder(_world, order);
+    reorder(_dirty, order);
+    
+    for(size_t i=0; i<count; i++)
+    {
+        if(None != _parent[i])
+        {
+            _parent[i] = slot[_parent[i]];
+        }
+        _slot[_handle[i]] = i;
+    }
+    
+    // Pending nodes per level.
+    unsigned int levels = count ? (_level[count-1] + 1) : 0;
+    _pending.resize(levels);
+    for(unsigned int i=0; i<levels; i++)
+    {
+        _pending[i].clear();
+    }
+    for(size_t i=0; i<count; i++)
+    {
+        if(_dirty[i])
+        {
+            _pending[_level[i]].push_back(i);
+        }
+    }
+}
+/**
+ * Number of levels.
+ */
+unsigned int TransformHierarchy::levelCount() const
+{
+    return static_cast<unsigned int>(_pending.size());
+}
+/**
+ * Gather the dirty nodes of a level and flag their children.
+ * Levels must be prepared in order, and each level must be
+ * computed before the next one is prepared.
+ * @param [in] level Level.
+ * @return Number of nodes to compute.
+ */
+size_t TransformHierarchy::prepare(unsigned int level)
+{
+    _current.swap(_pending[level]);
+    _pending[level].clear();
+    
+    if((level+1) < _pending.size())
+    {
+        std::vector<size_t>& next = _pending[level+1];
+        for(size_t i=0; i<_current.size(); i++)
+        {
+            size_t slot = _current[i];
+            size_t last = _firstChild[slot] + _childCount[slot];
+            for(size_t child=_firstChild[slot]; child<last; child++)
+            {
+                if(!_dirty[child])
+                {
+                    _dirty[child] = 1;
+                    next.push_back(child);
+                }
+            }
+        }
+    }
+    return _current.size();
+}
+/**
+ * Compute world matrices for a range of the nodes of the last
+ * prepared level. Disjoint ranges can be computed concurrently.
+ * @param [in] first First prepared node.
+ * @param [in] last  Last prepared node (excluded).
+ */
+void TransformHierarchy::compute(size_t first, size_t last)
+{
+    float x[Lanes], y[Lanes], z[Lanes], w[Lanes];
+    float m[9][Lanes];
+    for(size_t i=first; i<last; i+=Lanes)
+    {
+        size_t n = std::min(static_cast<size_t>(Lanes), last-i);
+        size_t j;
+        for(j=0; j<n; j++)
+        {
+            size_t slot = _current[i+j];
+            x[j] = _orientation[0][slot];
+            y[j] = _orientation[1][slot];
+            z[j] = _orientation[2][slot];
+            w[j] = _orientation[3][slot];
+        }
+        for(; j<Lanes; j++)
+        {
+            x[j] = y[j] = z[j] = 0.0f;
+            w[j] = 1.0f;
+        }
+        
+        // Quaternion to rotation matrix.
+        for(j=0; j<Lanes; j++)
+        {
+            float xx = x[j]*x[j], yy = y[j]*y[j], zz = z[j]*z[j];
+            float xy = x[j]*y[j], xz = x[j]*z[j], yz = y[j]*z[j];
+            float wx = w[j]*x[j], wy = w[j]*y[j], wz = w[j]*z[j];
+            m[0][j] = 1.0f - 2.0f*(yy + zz);
+            m[1][j] =        2.0f*(xy + wz);
+            m[2][j] =        2.0f*(xz - wy);
+            m[3][j] =        2.0f*(xy - wz);
+            m[4][j] = 1.0f - 2.0f*(xx + zz);
+            m[5][j] =        2.0f*(yz + wx);
+            m[6][j] =        2.0f*(xz + wy);
+            m[7][j] =        2.0f*(yz - wx);
+            m[8][j] = 1.0f - 2.0f*(xx + yy);
+        }
+        
+        for(j=0; j<n; j++)
+        {
+            size_t slot = _current[i+j];
+            glm::mat4 local(glm::vec4(m[0][j], m[1][j], m[2][j], 0.0f),
+                            glm::vec4(m[3][j], m[4][j], m[5][j], 0.0f),
+                            glm::vec4(m[6][j], m[7][j], m[8][j], 0.0f),
+                            glm::vec4(_position[0][slot], _position[1][slot], _position[2][slot], 1.0f));
+            size_t parent = _parent[slot];
+            _world[slot] = (None == parent) ? local : (_world[parent] * local);
+            _dirty[slot] = 0;
+        }
+    }
+}
+
+} // Geometry
+} // Core
+} // Dumb
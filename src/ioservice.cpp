@@ -0,0 +1,635 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if defined(HAVE_LIBURING)
+#include <liburing.h>
+#endif
+#include <DumbFramework/ioservice.hpp>
+
+namespace Dumb {
+
+/** Read request. **/
+struct IOService::Job
+{
+    /** Request result. **/
+    Completion completion;
+    /** Completion callback. **/
+    Callback callback;
+    /** Request priority. **/
+    int priority;
+    /** Number of bytes to read. **/
+    size_t length;
+    /** Number of bytes read. **/
+    size_t done;
+    /** Number of bytes reserved in the budget. **/
+    size_t reserved;
+    /** File descriptor. **/
+    int fd;
+    /** Tell if a reader took the request. **/
+    bool running;
+    /** Tell if the request was canceled. **/
+    std::atomic<bool> canceled;
+
+    Job()
+        : completion()
+        , callback()
+        , priority(0)
+        , length(0)
+        , done(0)
+        , reserved(0)
+        , fd(-1)
+        , running(false)
+        , canceled(false)
+    {}
+};
+
+/** io_uring state. **/
+struct IOService::Ring
+{
+#if defined(HAVE_LIBURING)
+    struct io_uring ring;
+#endif
+};
+
+/** Default number of reader threads. **/
+const unsigned int IOService::DefaultThreadCount = 4;
+/** Default maximum number of bytes in flight. **/
+const size_t IOService::DefaultInflightBytes = 64 * 1024 * 1024;
+/** Number of reads submitted at once to the io_uring. **/
+const unsigned int IOService::QueueDepth = 64;
+/** Maximum number of bytes read by a single call or submission. **/
+const size_t IOService::ChunkSize = 256 * 1024;
+
+/** Constructor. **/
+IOService::IOService()
+    : _lock()
+    , _work()
+    , _space()
+    , _idle()
+    , _threads()
+    , _running(false)
+    , _backend(NONE)
+    , _last(0)
+    , _maxInflight(DefaultInflightBytes)
+    , _inflight(0)
+    , _outstanding(0)
+    , _active(0)
+    , _starving(0)
+    , _queue()
+    , _jobs()
+    , _completed()
+    , _ring(NULL)
+{}
+/** Destructor. **/
+IOService::~IOService()
+{
+    stop();
+    for(size_t i=0; i<_completed.size(); i++)
+    {
+        delete _completed[i];
+    }
+}
+/**
+ * Start reader threads.
+ * @param [in] threadCount       Number of reader threads.
+ * @param [in] maxInflightBytes  Maximum number of bytes in flight.
+ * @return false if the service is already running.
+ */
+bool IOService::start(unsigned int threadCount, size_t maxInflightBytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if(_running)
+        {
+            return false;
+        }
+        _running     = true;
+        _maxInflight = maxInflightBytes;
+    }
+#if defined(HAVE_LIBURING)
+    _ring = new Ring;
+    if(0 == io_uring_queue_init(QueueDepth, &_ring->ring, 0))
+    {
+        // Kernels prior to 5.6 have io_uring but no plain read operation.
+        struct io_uring_probe *probe = io_uring_get_probe_ring(&_ring->ring);
+        bool supported = (NULL != probe) && io_uring_opcode_supported(probe, IORING_OP_READ);
+        if(NULL != probe)
+        {
+            io_uring_free_probe(probe);
+        }
+        if(supported)
+        {
+            _backend = IO_URING;
+            _threads.push_back(std::thread(&IOService::ringRoutine, this));
+            return true;
+        }
+        io_uring_queue_exit(&_ring->ring);
+    }
+    // The kernel does not support io_uring (or it is disabled).
+    delete _ring;
+    _ring = NULL;
+#endif
+    _backend = PREAD;
+    for(unsigned int i=0; i<std::max(threadCount, 1u); i++)
+    {
+        _threads.push_back(std::thread(&IOService::readerRoutine, this));
+    }
+    return true;
+}
+/** Stop reader threads. **/
+void IOService::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if(!_running)
+        {
+            return;
+        }
+        _running = false;
+    }
+    _work.notify_all();
+    _space.notify_all();
+    for(size_t i=0; i<_threads.size(); i++)
+    {
+        _threads[i].join();
+    }
+    _threads.clear();
+#if defined(HAVE_LIBURING)
+    if(NULL != _ring)
+    {
+        io_uring_queue_exit(&_ring->ring);
+    }
+#endif
+    delete _ring;
+    _ring = NULL;
+    _backend = NONE;
+
+    // Cancel queued requests.
+    std::vector<Job*> canceled;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        for(std::set<std::pair<int, Ticket> >::const_iterator it=_queue.begin(); it!=_queue.end(); ++it)
+        {
+            canceled.push_back(_jobs[it->second]);
+        }
+        _queue.clear();
+    }
+    for(size_t i=0; i<canceled.size(); i++)
+    {
+        canceled[i]->canceled = true;
+        finish(canceled[i]);
+    }
+}
+/**
+ * Queue read request.
+ * @param [in] path      File name.
+ * @param [in] offset    Offset of the first byte to read.
+ * @param [in] length    Number of bytes to read.
+ * @param [in] priority  Request priority.
+ * @param [in] callback  Completion callback.
+ * @return Request identifier, or 0 if the service is not running.
+ */
+IOService::Ticket IOService::read(std::string const& path, off_t offset, size_t length, int priority, Callback const& callback)
+{
+    Job *job = new Job;
+    job->completion.path   = path;
+    job->completion.offset = offset;
+    job->completion.status = COMPLETED;
+    job->completion.error  = 0;
+    job->callback = callback;
+    job->priority = priority;
+    job->length   = length;
+
+    Ticket ticket;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if(!_running)
+        {
+            delete job;
+            return 0;
+        }
+        ticket = ++_last;
+        job->completion.ticket = ticket;
+        _jobs[ticket] = job;
+        _queue.insert(std::make_pair(-priority, ticket));
+        _outstanding++;
+    }
+    _work.notify_one();
+    return ticket;
+}
+/**
+ * Cancel request.
+ * @param [in] ticket  Request identifier.
+ * @return false if the request was already finished.
+ */
+bool IOService::cancel(Ticket ticket)
+{
+    Job *job = NULL;
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        std::map<Ticket, Job*>::iterator it = _jobs.find(ticket);
+        if(it == _jobs.end())
+        {
+            return false;
+        }
+        job = it->second;
+        job->canceled = true;
+        if(!job->running)
+        {
+            _queue.erase(std::make_pair(-job->priority, ticket));
+            queued = true;
+        }
+    }
+    if(queued)
+    {
+        finish(job);
+    }
+    else
+    {
+        // The reader may be waiting for some room in the budget.
+        _space.notify_all();
+    }
+    return true;
+}
+/**
+ * Run the callbacks of finished requests.
+ * @return Number of callbacks called.
+ */
+size_t IOService::poll()
+{
+    std::vector<Job*> done;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        done.swap(_completed);
+    }
+    if(done.empty())
+    {
+        return 0;
+    }
+    size_t released = 0;
+    for(size_t i=0; i<done.size(); i++)
+    {
+        if(done[i]->callback)
+        {
+            done[i]->callback(done[i]->completion);
+        }
+        released += done[i]->reserved;
+        delete done[i];
+    }
+    if(released)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _inflight -= released;
+        }
+        _space.notify_all();
+    }
+    return done.size();
+}
+/**
+ * Wait until every queued request is finished, or until the remaining
+ * ones can not start before some completions are polled.
+ */
+void IOService::wait()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while(_outstanding && !stalled())
+    {
+        _idle.wait(lock);
+    }
+}
+/** Number of bytes in flight. **/
+size_t IOService::inflight() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _inflight;
+}
+/** Number of queued or running requests. **/
+size_t IOService::outstanding() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _outstanding;
+}
+/** Current I/O backend. **/
+IOService::Backend IOService::backend() const
+{
+    return _backend;
+}
+/**
+ * Take the next request.
+ * @param [in] block  Wait until a request is available.
+ * @return NULL if there is no request or if the service stopped.
+ */
+IOService::Job* IOService::next(bool block)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while(_running && _queue.empty() && block)
+    {
+        _work.wait(lock);
+    }
+    if(!_running || _queue.empty())
+    {
+        return NULL;
+    }
+    Job *job = _jobs[_queue.begin()->second];
+    _queue.erase(_queue.begin());
+    job->running = true;
+    _active++;
+    return job;
+}
+/**
+ * Open file and compute read size.
+ * @return false if the file could not be opened.
+ */
+bool IOService::prepare(Job* job)
+{
+    job->fd = ::open(job->completion.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(job->fd < 0)
+    {
+        job->completion.error = errno;
+        return false;
+    }
+    struct stat infos;
+    if(0 != fstat(job->fd, &infos))
+    {
+        job->completion.error = errno;
+        return false;
+    }
+    size_t available = 0;
+    if(job->completion.offset < infos.st_size)
+    {
+        available = infos.st_size - job->completion.offset;
+    }
+    if((0 == job->length) || (job->length > available))
+    {
+        job->length = available;
+    }
+    return true;
+}
+/**
+ * Reserve bytes for a request.
+ * @param [in] block  Wait until the bytes fit in the budget.
+ * @return false if the bytes do not fit.
+ */
+bool IOService::reserve(Job* job, bool block)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    for(;;)
+    {
+        if(!_running)
+        {
+            job->canceled = true;
+        }
+        if(job->canceled)
+        {
+            return false;
+        }
+        if((0 == _inflight) || ((_inflight + job->length) <= _maxInflight))
+        {
+            _inflight    += job->length;
+            job->reserved = job->length;
+            return true;
+        }
+        if(!block)
+        {
+            return false;
+        }
+        _starving++;
+        if(stalled())
+        {
+            _idle.notify_all();
+        }
+        _space.wait(lock);
+        _starving--;
+    }
+}
+/**
+ * Check if every reader holding a request waits for room in the budget.
+ * Bytes are only released by IOService::poll, so nothing can progress
+ * until it is called.
+ */
+bool IOService::stalled() const
+{
+    return _starving && (_starving == _active);
+}
+/** Move request to the completion queue. **/
+void IOService::finish(Job* job)
+{
+    if(job->fd >= 0)
+    {
+        ::close(job->fd);
+        job->fd = -1;
+    }
+    Completion &completion = job->completion;
+    if(completion.error)
+    {
+        completion.status = FAILED;
+    }
+    else if(job->canceled)
+    {
+        completion.status = CANCELED;
+    }
+    if(COMPLETED == completion.status)
+    {
+        completion.data.resize(job->done);
+    }
+    else
+    {
+        std::vector<unsigned char>().swap(completion.data);
+    }
+
+    std::lock_guard<std::mutex> lock(_lock);
+    _jobs.erase(completion.ticket);
+    _completed.push_back(job);
+    _outstanding--;
+    if(job->running)
+    {
+        _active--;
+    }
+    if((0 == _outstanding) || stalled())
+    {
+        _idle.notify_all();
+    }
+}
+/** Reader thread routine (@c pread backend). **/
+void IOService::readerRoutine()
+{
+    Job *job;
+    while(NULL != (job = next(true)))
+    {
+        if(prepare(job) && job->length && reserve(job, true))
+        {
+            std::vector<unsigned char> &data = job->completion.data;
+            data.resize(job->length);
+            // Read in chunks so that a cancelation stops large reads.
+            while((job->done < job->length) && !job->canceled)
+            {
+                size_t chunk = std::min(job->length - job->done, ChunkSize);
+                ssize_t count = pread(job->fd, &data[job->done], chunk, job->completion.offset + job->done);
+                if(count < 0)
+                {
+                    if(EINTR == errno)
+                    {
+                        continue;
+                    }
+                    job->completion.error = errno;
+                    break;
+                }
+                if(0 == count)
+                {
+                    break;
+                }
+                job->done += count;
+            }
+        }
+        finish(job);
+    }
+}
+/** Reader thread routine (io_uring backend). **/
+void IOService::ringRoutine()
+{
+#if defined(HAVE_LIBURING)
+    struct io_uring *ring = &_ring->ring;
+    unsigned int submitted = 0;
+    Job *deferred = NULL;
+
+    // Each submission reads at most one chunk, so that a cancelation
+    // stops large reads and lengths fit the submission entry.
+    auto push = [ring](Job *job)
+    {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+        unsigned int chunk = static_cast<unsigned int>(std::min(job->length - job->done, ChunkSize));
+        io_uring_prep_read(sqe, job->fd, &job->completion.data[job->done], chunk, job->completion.offset + job->done);
+        io_uring_sqe_set_data(sqe, job);
+    };
+
+    for(;;)
+    {
+        // Fill the ring. Only sleep when nothing is in flight, otherwise
+        // completions would not be reaped and the budget never released.
+        unsigned int queued = 0;
+        while((submitted + queued) < QueueDepth)
+        {
+            bool empty = (0 == (submitted + queued));
+            Job *job = deferred;
+            deferred = NULL;
+            if(NULL == job)
+            {
+                job = next(empty);
+                if(NULL == job)
+                {
+                    break;
+                }
+                if(!prepare(job) || (0 == job->length))
+                {
+                    finish(job);
+                    continue;
+                }
+            }
+            if(!reserve(job, empty))
+            {
+                if(job->canceled)
+                {
+                    finish(job);
+                    continue;
+                }
+                deferred = job;
+                break;
+            }
+            job->completion.data.resize(job->length);
+            push(job);
+            queued++;
+        }
+        if(queued)
+        {
+            io_uring_submit(ring);
+            submitted += queued;
+        }
+        if(0 == submitted)
+        {
+            if(NULL != deferred)
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(_lock);
+            if(!_running)
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Reap completions.
+        struct io_uring_cqe *cqe;
+        int ret = io_uring_wait_cqe(ring, &cqe);
+        if(ret < 0)
+        {
+            continue;
+        }
+        unsigned int resubmitted = 0;
+        do
+        {
+            Job *job = static_cast<Job*>(io_uring_cqe_get_data(cqe));
+            int res = cqe->res;
+            io_uring_cqe_seen(ring, cqe);
+            submitted--;
+            if((-EINTR == res) || (-EAGAIN == res))
+            {
+                res = 0;
+            }
+            else if(res < 0)
+            {
+                job->completion.error = -res;
+                finish(job);
+                continue;
+            }
+            else if(0 == res)
+            {
+                // End of file.
+                finish(job);
+                continue;
+            }
+            job->done += res;
+            if((job->done >= job->length) || job->canceled)
+            {
+                finish(job);
+                continue;
+            }
+            // Short read or next chunk, queue the remaining bytes.
+            push(job);
+            resubmitted++;
+        } while(0 == io_uring_peek_cqe(ring, &cqe));
+        if(resubmitted)
+        {
+            io_uring_submit(ring);
+            submitted += resubmitted;
+        }
+    }
+    if(NULL != deferred)
+    {
+        deferred->canceled = true;
+        finish(deferred);
+    }
+#endif
+}
+
+} // Dumb
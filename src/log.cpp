@@ -13,45 +13,276 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#include <errno.h>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <ctime>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cerrno>
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
 #include <DumbFramework/log.hpp>
 
 namespace Dumb {
 namespace Log  {
-    
+
+namespace {
+    /** Monotonic time in nanoseconds. **/
+    uint64_t timestamp()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    /** Identifier of the calling thread. **/
+    unsigned int threadId()
+    {
+        static std::atomic<unsigned int> next(1);
+        static thread_local unsigned int id = 0;
+        if(0 == id)
+        {
+            id = next++;
+        }
+        return id;
+    }
+    /** Build message from a format string and variable arguments. **/
+    bool build(BaseLogBuilder* builder, std::string & out, Dumb::Module::Identifier const & module, Dumb::Severity const & severity, SourceInfos const & infos, char const * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        bool ret = builder->build(out, module, severity, infos, format, args);
+        va_end(args);
+        return ret;
+    }
+
+    /** Threshold table. **/
+    struct ThresholdTable
+    {
+        /** Protects the table. **/
+        pthread_mutex_t lock;
+        /** Default threshold. **/
+        uint8_t defaultThreshold;
+        /** Tell if a module has its own threshold. **/
+        bool custom[Dumb::Module::Identifier::Capacity];
+
+        ThresholdTable()
+            : lock(PTHREAD_MUTEX_INITIALIZER)
+            , defaultThreshold(Dumb::Severity::Info)
+        {
+            memset(custom, 0, sizeof(custom));
+        }
+        static ThresholdTable& instance()
+        {
+            static ThresholdTable table;
+            return table;
+        }
+    };
+} // anonymous
+
+    /** Size of the packed argument buffer. **/
+    const size_t Record::ArgumentSize;
+
+    /** Module thresholds. Zero initialized, ie Dumb::Severity::Info. **/
+    std::atomic<uint8_t> Thresholds::_thresholds[Dumb::Module::Identifier::Capacity];
+
+    /**
+     * Set default threshold.
+     * @param [in] severity  Minimum severity.
+     */
+    void Thresholds::set(Dumb::Severity const & severity)
+    {
+        ThresholdTable& table = ThresholdTable::instance();
+        pthread_mutex_lock(&table.lock);
+        table.defaultThreshold = severity.value;
+        for(uint32_t i=0; i<Dumb::Module::Identifier::Capacity; i++)
+        {
+            if(!table.custom[i])
+            {
+                _thresholds[i].store(table.defaultThreshold, std::memory_order_relaxed);
+            }
+        }
+        pthread_mutex_unlock(&table.lock);
+    }
+    /**
+     * Set module threshold.
+     * @param [in] module    Module ID.
+     * @param [in] severity  Minimum severity.
+     */
+    void Thresholds::set(Dumb::Module::Identifier const & module, Dumb::Severity const & severity)
+    {
+        ThresholdTable& table = ThresholdTable::instance();
+        pthread_mutex_lock(&table.lock);
+        table.custom[module.id()] = true;
+        _thresholds[module.id()].store(severity.value, std::memory_order_relaxed);
+        pthread_mutex_unlock(&table.lock);
+    }
+    /**
+     * Discard every message of a module.
+     * @param [in] module    Module ID.
+     */
+    void Thresholds::disable(Dumb::Module::Identifier const & module)
+    {
+        ThresholdTable& table = ThresholdTable::instance();
+        pthread_mutex_lock(&table.lock);
+        table.custom[module.id()] = true;
+        _thresholds[module.id()].store(0xff, std::memory_order_relaxed);
+        pthread_mutex_unlock(&table.lock);
+    }
+    /** Remove module thresholds and restore the default one. **/
+    void Thresholds::reset()
+    {
+        ThresholdTable& table = ThresholdTable::instance();
+        pthread_mutex_lock(&table.lock);
+        table.defaultThreshold = Dumb::Severity::Info;
+        for(uint32_t i=0; i<Dumb::Module::Identifier::Capacity; i++)
+        {
+            table.custom[i] = false;
+            _thresholds[i].store(table.defaultThreshold, std::memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&table.lock);
+    }
+
     /** Constructor. */
     BaseLogBuilder::BaseLogBuilder()
     {}
     /** Destructor. */
     BaseLogBuilder::~BaseLogBuilder()
     {}
+    /** Tell if a message will be kept. */
+    bool BaseLogBuilder::accept(Dumb::Module::Identifier const & /*module*/, Dumb::Severity const & /*severity*/)
+    {
+        return true;
+    }
+    /** Default number of queued messages. **/
+    const size_t LogProcessor::DefaultCapacity = 4096;
+    /** Maximum number of messages dequeued at once. **/
+    const size_t LogProcessor::BatchSize = 64;
+
+    /** Message queue and its counters. **/
+    struct LogProcessor::Staging
+    {
+        /** Queued records. **/
+        BoundedQueue<Record> *queue;
+        /** Number of messages pushed. **/
+        std::atomic<uint64_t> queued;
+        /** Number of messages discarded (including evicted ones). **/
+        std::atomic<uint64_t> dropped;
+        /** Number of queued messages discarded by DROP_OLDEST. **/
+        std::atomic<uint64_t> evicted;
+        /**
+         * Timestamp of the message being emitted by the owner,
+         * Reserving while it reads the clock, or 0.
+         */
+        std::atomic<uint64_t> pending;
+        /** Pending value published before reading the clock. **/
+        static const uint64_t Reserving = 1;
+        /** Tell if a thread uses this queue. **/
+        std::atomic<bool> owned;
+        /** Identifier of the owner thread. **/
+        std::atomic<unsigned int> thread;
+        /** Next thread queue. **/
+        Staging *next;
+
+        explicit Staging(size_t capacity)
+            : queue(new BoundedQueue<Record>(capacity))
+            , queued(0)
+            , dropped(0)
+            , evicted(0)
+            , pending(0)
+            , owned(false)
+            , thread(0)
+            , next(NULL)
+        {}
+        ~Staging()
+        {
+            delete queue;
+        }
+        /** Reset counters and resize queue if needed. **/
+        void reset(size_t capacity)
+        {
+            if((queue->capacity() < capacity) || (queue->capacity() >= (capacity*2)))
+            {
+                delete queue;
+                queue = new BoundedQueue<Record>(capacity);
+            }
+            queued.store(0);
+            dropped.store(0);
+            evicted.store(0);
+        }
+    };
     /** Constructor. */
     LogProcessor::LogProcessor()
         : _lock(PTHREAD_MUTEX_INITIALIZER)
-        , _alive(PTHREAD_MUTEX_INITIALIZER)
-        , _empty(PTHREAD_COND_INITIALIZER)
+        , _wakeup(PTHREAD_COND_INITIALIZER)
+        , _space(PTHREAD_COND_INITIALIZER)
+        , _drained(PTHREAD_COND_INITIALIZER)
         , _task()
-        , _msgQueue()
+        , _shared(NULL)
+        , _stagings(NULL)
+        , _overflow(BLOCK)
+        , _formatting(IMMEDIATE)
+        , _queueing(SHARED)
+        , _capacity(DefaultCapacity)
+        , _direct(false)
+        , _batch()
+        , _pending()
+        , _order()
+        , _text()
+        , _message()
+        , _running(false)
+        , _sleeping(false)
+        , _waiting(0)
+        , _flushing(0)
+        , _processed(0)
+        , _synced(0)
+        , _written(0)
+        , _lastSync()
         , _builder(NULL)
         , _output(NULL)
     {}
     /** Constructor. */
     LogProcessor::LogProcessor(LogProcessor const &)
         : _lock(PTHREAD_MUTEX_INITIALIZER)
-        , _alive(PTHREAD_MUTEX_INITIALIZER)
-        , _empty(PTHREAD_COND_INITIALIZER)
+        , _wakeup(PTHREAD_COND_INITIALIZER)
+        , _space(PTHREAD_COND_INITIALIZER)
+        , _drained(PTHREAD_COND_INITIALIZER)
         , _task()
-        , _msgQueue()
+        , _shared(NULL)
+        , _stagings(NULL)
+        , _overflow(BLOCK)
+        , _formatting(IMMEDIATE)
+        , _queueing(SHARED)
+        , _capacity(DefaultCapacity)
+        , _direct(false)
+        , _batch()
+        , _pending()
+        , _order()
+        , _text()
+        , _message()
+        , _running(false)
+        , _sleeping(false)
+        , _waiting(0)
+        , _flushing(0)
+        , _processed(0)
+        , _synced(0)
+        , _written(0)
+        , _lastSync()
         , _builder(NULL)
         , _output(NULL)
     {}
     /** Destructor. */
     LogProcessor::~LogProcessor()
-    {}
+    {
+        delete _shared;
+        for(Staging *staging=_stagings.load(); NULL != staging; )
+        {
+            Staging *next = staging->next;
+            delete staging;
+            staging = next;
+        }
+    }
     /** Copy operator. */
     LogProcessor& LogProcessor::operator= (LogProcessor const &)
     { return *this; }
@@ -67,9 +298,7 @@ namespace Log  {
      */
     void* LogProcessor::taskRoutine(void *param)
     {
-        bool ret = true;
         LogProcessor* processor = reinterpret_cast<LogProcessor*>(param);
-        std::string msg;
 
         if((NULL == param) || (NULL == processor))
         {
@@ -79,13 +308,26 @@ namespace Log  {
         {
             return NULL;
         }
-        while(!processor->mustStop() || ret)
+        for(;;)
         {
-            ret = processor->dequeueMessage(msg);
-            if(ret)
+            if(processor->drain())
+            {
+                continue;
+            }
+            if(!processor->_running.load(std::memory_order_acquire))
+            {
+                // Write what was queued before the stop request.
+                while(processor->drain()) {}
+                processor->drain(true);
+                processor->sync();
+                break;
+            }
+            // Let the output coalesce writes until a flush is due.
+            if(processor->due())
             {
-                processor->_output->write(msg);
+                processor->sync();
             }
+            processor->park();
         }
         return NULL;
     }
@@ -93,23 +335,57 @@ namespace Log  {
      * Start logging task.
      * @param [in] builder       Log message builder.
      * @param [in] outputPolicy  Filter and log output.
+     * @param [in] overflow      What to do when the queue is full.
+     * @param [in] capacity      Maximum number of queued messages.
+     * @param [in] formatting    Which thread builds the messages.
+     * @param [in] queueing      Where messages are queued.
      */
-    bool LogProcessor::start(BaseLogBuilder* builder, OutputPolicyBase* outputPolicy)
+    bool LogProcessor::start(BaseLogBuilder* builder, OutputPolicyBase* outputPolicy, OverflowPolicy overflow, size_t capacity, Formatting formatting, Queueing queueing)
     {
-        if((NULL == builder) || (NULL == outputPolicy))
+        if((NULL == builder) || (NULL == outputPolicy) || (0 == capacity))
+        {
+            return false;
+        }
+        if(_running.load(std::memory_order_acquire))
         {
             return false;
         }
-        _builder = builder;
-        _output  = outputPolicy;
+        _builder    = builder;
+        _output     = outputPolicy;
+        _overflow   = overflow;
+        _formatting = formatting;
+        _queueing   = queueing;
+        _capacity   = capacity;
+        _direct     = _output->concurrent();
         if(!_output->setup())
         {
             return false;
         }
-        pthread_mutex_init(&_lock, NULL);
-        pthread_mutex_init(&_alive, NULL);
-        pthread_mutex_lock(&_alive);
+        if(NULL == _shared)
+        {
+            _shared = new Staging(capacity);
+        }
+        else
+        {
+            _shared->reset(capacity);
+        }
+        for(Staging *staging=_stagings.load(); NULL != staging; staging=staging->next)
+        {
+            staging->reset(capacity);
+        }
+        _batch.resize(BatchSize);
+        _pending.clear();
+        _processed.store(0);
+        _synced.store(0);
+        _written.store(0);
+        _lastSync = std::chrono::steady_clock::now();
+        _running.store(true, std::memory_order_release);
         int ret = pthread_create(&_task, NULL, taskRoutine, this);
+        if(ret != 0)
+        {
+            _running.store(false);
+            _output->teardown();
+        }
         return (ret == 0);
     }
     /** Stop logging task. **/
@@ -117,7 +393,15 @@ namespace Log  {
     {
         int   ret;
         void *data;
-        pthread_mutex_unlock(&_alive);
+        if(!_running.exchange(false))
+        {
+            return false;
+        }
+        pthread_mutex_lock(&_lock);
+        pthread_cond_signal(&_wakeup);
+        pthread_cond_broadcast(&_space);
+        pthread_cond_broadcast(&_drained);
+        pthread_mutex_unlock(&_lock);
         ret = pthread_join(_task, &data);
         if(_output) { _output->teardown(); }
         return (ret == 0);
@@ -129,55 +413,442 @@ namespace Log  {
      */
     void LogProcessor::flush()
     {
+        if(!_running.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        uint64_t target = queued();
+        _flushing++;
+        _waiting++;
+        wakeup();
         pthread_mutex_lock(&_lock);
-        pthread_cond_wait(&_empty, &_lock);
+        while((_synced.load() < target) && _running.load())
+        {
+            pthread_cond_wait(&_drained, &_lock);
+        }
         pthread_mutex_unlock(&_lock);
+        _waiting--;
+        _flushing--;
+    }
+    /** Number of messages written by the output policy. **/
+    uint64_t LogProcessor::written() const
+    {
+        return _written.load(std::memory_order_relaxed);
     }
-    /** Return true if the thread must stop. **/
-    bool LogProcessor::mustStop()
+    /** Number of messages discarded because the queue was full. **/
+    uint64_t LogProcessor::dropped() const
     {
-        int ret = pthread_mutex_trylock(&_alive);
-        if(ret == EBUSY)
+        uint64_t count = (NULL != _shared) ? _shared->dropped.load(std::memory_order_relaxed) : 0;
+        for(Staging *staging=_stagings.load(std::memory_order_acquire); NULL != staging; staging=staging->next)
         {
-            return false;
+            count += staging->dropped.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+    /**
+     * Get per thread message counters.
+     * @param [out] statistics  Message counters.
+     */
+    void LogProcessor::statistics(std::vector<ThreadStatistics> & statistics) const
+    {
+        statistics.clear();
+        for(Staging *staging=_stagings.load(std::memory_order_acquire); NULL != staging; staging=staging->next)
+        {
+            ThreadStatistics entry;
+            entry.thread  = staging->thread.load(std::memory_order_relaxed);
+            entry.emitted = staging->queued.load(std::memory_order_relaxed);
+            entry.dropped = staging->dropped.load(std::memory_order_relaxed);
+            statistics.push_back(entry);
         }
-        else if(ret == 0)
+    }
+    /** Number of queued messages that will reach the processor thread. **/
+    uint64_t LogProcessor::queued() const
+    {
+        // Evictions are counted before the push that caused them, so
+        // reading the pushes first never overestimates the result.
+        uint64_t count = _shared->queued.load();
+        count -= _shared->evicted.load();
+        for(Staging *staging=_stagings.load(); NULL != staging; staging=staging->next)
         {
-            pthread_mutex_unlock(&_alive);
+            count += staging->queued.load();
+            count -= staging->evicted.load();
         }
-        return true;
+        return count;
+    }
+    /** Get the staging queue of the calling thread. **/
+    LogProcessor::Staging* LogProcessor::staging()
+    {
+        /** Give the queue back when the thread exits. **/
+        struct Owner
+        {
+            Staging *staging;
+            ~Owner()
+            {
+                if(NULL != staging)
+                {
+                    staging->owned.store(false, std::memory_order_release);
+                }
+            }
+        };
+        static thread_local Owner owner = { NULL };
+        if(NULL != owner.staging)
+        {
+            return owner.staging;
+        }
+        // Reuse the queue of an exited thread.
+        Staging *staging = _stagings.load(std::memory_order_acquire);
+        for(; NULL != staging; staging=staging->next)
+        {
+            bool owned = false;
+            if(!staging->owned.load(std::memory_order_relaxed) && staging->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            {
+                break;
+            }
+        }
+        if(NULL == staging)
+        {
+            staging = new Staging(_capacity);
+            staging->owned.store(true, std::memory_order_relaxed);
+            staging->next = _stagings.load(std::memory_order_relaxed);
+            while(!_stagings.compare_exchange_weak(staging->next, staging, std::memory_order_release, std::memory_order_relaxed))
+            {}
+        }
+        staging->thread.store(threadId(), std::memory_order_relaxed);
+        owner.staging = staging;
+        return staging;
     }
     /**
-     * Add string to message queue.
-     * @param [in] msg  Log message.
+     * Add record to message queue.
+     * @param [in] local   Destination queue.
+     * @param [in] writer  Functor filling the queued record.
      */
-    void LogProcessor::queueMessage(std::string const & msg)
+    template <typename F>
+    void LogProcessor::queueMessage(Staging* local, F & writer)
     {
-        pthread_mutex_lock(&_lock);
-        _msgQueue.push_back(msg);
-        pthread_mutex_unlock(&_lock);
+        BoundedQueue<Record> *queue = local->queue;
+        if(queue->emplace(writer))
+        {
+            local->queued++;
+            wakeup();
+            return;
+        }
+        switch(_overflow)
+        {
+            case DROP_NEWEST:
+                local->dropped++;
+                break;
+            case DROP_OLDEST:
+                {
+                    Record evicted;
+                    while(!queue->emplace(writer))
+                    {
+                        if(queue->pop(evicted))
+                        {
+                            local->evicted++;
+                            local->dropped++;
+                        }
+                    }
+                    local->queued++;
+                    wakeup();
+                }
+                break;
+            case BLOCK:
+            default:
+                {
+                    bool pushed;
+                    _waiting++;
+                    pthread_mutex_lock(&_lock);
+                    while(!(pushed = queue->emplace(writer)) && _running.load())
+                    {
+                        pthread_cond_wait(&_space, &_lock);
+                    }
+                    pthread_mutex_unlock(&_lock);
+                    _waiting--;
+                    if(pushed)
+                    {
+                        local->queued++;
+                        wakeup();
+                    }
+                    else
+                    {
+                        local->dropped++;
+                    }
+                }
+                break;
+        }
     }
     /**
-     * Retrieve log message from queue.
-     * @param [out] msg  Log message.
-     * @return false if the queue is empty.
+     * Retrieve a batch of log messages and write them.
+     * @param [in] all  Write every staged message.
+     * @return Number of messages dequeued or written.
      */
-    bool LogProcessor::dequeueMessage(std::string & msg)
+    size_t LogProcessor::drain(bool all)
     {
-        bool ret;
-        pthread_mutex_lock(&_lock);
-        ret = !_msgQueue.empty();
-        if(ret)
+        if(PER_THREAD == _queueing)
+        {
+            return collect(all);
+        }
+        size_t count = 0;
+        while((count < _batch.size()) && _shared->queue->pop(_batch[count]))
+        {
+            count++;
+        }
+        if(0 == count)
+        {
+            return 0;
+        }
+        // Slots are free, let blocked producers go while we write.
+        release();
+        uint64_t written = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            std::string *msg = build(_batch[i]);
+            if((NULL != msg) && _output->write(*msg))
+            {
+                written++;
+            }
+        }
+        _written   += written;
+        _processed += count;
+        if(_flushing.load(std::memory_order_relaxed))
+        {
+            sync();
+        }
+        else
+        {
+            release();
+        }
+        return count;
+    }
+    /**
+     * Retrieve messages from the thread queues and write them in
+     * timestamp order.
+     * @param [in] all  Write every staged message.
+     * @return Number of messages dequeued or written.
+     */
+    size_t LogProcessor::collect(bool all)
+    {
+        // Messages stamped before this limit are either already queued
+        // or held by a thread that published its pending time.
+        uint64_t limit = UINT64_MAX;
+        if(!all)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            limit = timestamp();
+            for(Staging *staging=_stagings.load(); NULL != staging; staging=staging->next)
+            {
+                uint64_t pending = staging->pending.load();
+                if(Staging::Reserving == pending)
+                {
+                    // The stamp is not known yet, it may be older than
+                    // anything staged.
+                    limit = 0;
+                    break;
+                }
+                if(pending && (pending < limit))
+                {
+                    limit = pending;
+                }
+            }
+        }
+
+        size_t popped = 0;
+        for(Staging *staging=_stagings.load(); NULL != staging; staging=staging->next)
+        {
+            for(size_t i=0; i<BatchSize; i++)
+            {
+                _pending.resize(_pending.size()+1);
+                if(!staging->queue->pop(_pending.back()))
+                {
+                    _pending.pop_back();
+                    break;
+                }
+                popped++;
+            }
+        }
+        if(popped)
+        {
+            // Slots are free, let blocked producers go while we write.
+            release();
+        }
+
+        _order.clear();
+        for(size_t i=0; i<_pending.size(); i++)
+        {
+            if(_pending[i].infos.timestamp < limit)
+            {
+                _order.push_back(i);
+            }
+        }
+        std::vector<Record> const & pending = _pending;
+        std::sort(_order.begin(), _order.end(), [&pending](size_t a, size_t b)
+        {
+            SourceInfos const & left  = pending[a].infos;
+            SourceInfos const & right = pending[b].infos;
+            return (left.timestamp < right.timestamp) || ((left.timestamp == right.timestamp) && (left.thread < right.thread));
+        });
+
+        uint64_t written = 0;
+        for(size_t i=0; i<_order.size(); i++)
+        {
+            std::string *msg = build(_pending[_order[i]]);
+            if((NULL != msg) && _output->write(*msg))
+            {
+                written++;
+            }
+        }
+        // Keep the messages that are too recent for the next round.
+        size_t kept = 0;
+        for(size_t i=0; i<_pending.size(); i++)
+        {
+            if(_pending[i].infos.timestamp >= limit)
+            {
+                if(kept != i)
+                {
+                    std::swap(_pending[kept], _pending[i]);
+                }
+                kept++;
+            }
+        }
+        _pending.resize(kept);
+
+        _written   += written;
+        _processed += _order.size();
+        if(_flushing.load(std::memory_order_relaxed))
+        {
+            sync();
+        }
+        else
+        {
+            release();
+        }
+        return popped + _order.size();
+    }
+    /** Tell if there is nothing to write. **/
+    bool LogProcessor::idle() const
+    {
+        if(PER_THREAD != _queueing)
+        {
+            return _shared->queue->empty();
+        }
+        uint64_t oldest = UINT64_MAX;
+        for(size_t i=0; i<_pending.size(); i++)
+        {
+            oldest = std::min(oldest, _pending[i].infos.timestamp);
+        }
+        bool blocked = false;
+        for(Staging *staging=_stagings.load(); NULL != staging; staging=staging->next)
+        {
+            if(!staging->queue->empty())
+            {
+                return false;
+            }
+            uint64_t pending = staging->pending.load();
+            blocked = blocked || (pending && (pending <= oldest));
+        }
+        // Staged messages wait for a thread that will wake us up.
+        return _pending.empty() || blocked;
+    }
+    /**
+     * Build record message.
+     * @param [in,out] record  Dequeued record.
+     * @return Message to output or NULL if it was filtered out.
+     */
+    std::string* LogProcessor::build(Record & record)
+    {
+        if(Record::BUILT == record.kind)
+        {
+            return &record.text;
+        }
+        if(Record::PACKED == record.kind)
         {
-            msg = _msgQueue.front();
-            _msgQueue.pop_front();
+            unpackArguments(_text, record.arguments + record.size, record.arguments, record.size);
         }
         else
         {
-            pthread_cond_signal(&_empty);
+            _text.assign(record.arguments);
         }
+        if(!Log::build(_builder, _message, record.module, record.severity, record.infos, "%s", _text.c_str()))
+        {
+            return NULL;
+        }
+        return &_message;
+    }
+    /** Tell if written messages have to be flushed now. **/
+    bool LogProcessor::due() const
+    {
+        if(_synced.load() >= _processed.load())
+        {
+            return false;
+        }
+        if(_flushing.load())
+        {
+            return true;
+        }
+        return (std::chrono::steady_clock::now() - _lastSync) >= std::chrono::milliseconds(_output->flushInterval());
+    }
+    /** Wait until a message is queued, a flush is due or the processor stops. **/
+    void LogProcessor::park()
+    {
+        // Unflushed messages bound the wait to the end of the flush interval.
+        bool timed = (_synced.load() < _processed.load());
+        struct timespec deadline;
+        if(timed)
+        {
+            std::chrono::steady_clock::duration remaining = std::chrono::milliseconds(_output->flushInterval()) - (std::chrono::steady_clock::now() - _lastSync);
+            long long ns = std::max<long long>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count());
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            ns += deadline.tv_nsec;
+            deadline.tv_sec  += ns / 1000000000LL;
+            deadline.tv_nsec  = ns % 1000000000LL;
+        }
+        pthread_mutex_lock(&_lock);
+        _sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while(idle() && !due() && _running.load())
+        {
+            if(!timed)
+            {
+                pthread_cond_wait(&_wakeup, &_lock);
+            }
+            else if(ETIMEDOUT == pthread_cond_timedwait(&_wakeup, &_lock, &deadline))
+            {
+                break;
+            }
+        }
+        _sleeping.store(false, std::memory_order_relaxed);
         pthread_mutex_unlock(&_lock);
-        return ret;
+    }
+    /** Wake up the processor thread if it is sleeping. **/
+    void LogProcessor::wakeup()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(_sleeping.load(std::memory_order_relaxed))
+        {
+            pthread_mutex_lock(&_lock);
+            pthread_cond_signal(&_wakeup);
+            pthread_mutex_unlock(&_lock);
+        }
+    }
+    /** Flush output and wake up threads waiting for a flush. **/
+    void LogProcessor::sync()
+    {
+        _output->flush();
+        _lastSync = std::chrono::steady_clock::now();
+        _synced.store(_processed.load());
+        release();
+    }
+    /** Wake up threads waiting for free slots or for a flush. **/
+    void LogProcessor::release()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(_waiting.load(std::memory_order_relaxed))
+        {
+            pthread_mutex_lock(&_lock);
+            pthread_cond_broadcast(&_space);
+            pthread_cond_broadcast(&_drained);
+            pthread_mutex_unlock(&_lock);
+        }
     }
 
     /**
@@ -190,44 +861,123 @@ namespace Log  {
      */
     void LogProcessor::write(Dumb::Module::Identifier const & module, Dumb::Severity const & severity, SourceInfos const & infos, char const * format, ...)
     {
-        if(NULL == _builder)
+        if(!_running.load(std::memory_order_acquire) || (NULL == _builder))
         {
             return;
         }
 
-        std::string buffer;
+        SourceInfos stamped(infos);
+        stamped.thread = threadId();
+
+        Staging *local = _shared;
+        if((PER_THREAD == _queueing) && !_direct)
+        {
+            // Tell the processor thread that an older message may be
+            // on its way. The reservation is visible before the clock
+            // is read, so the processor cannot pick a limit past the
+            // stamp.
+            local = staging();
+            local->pending.store(Staging::Reserving);
+            stamped.timestamp = timestamp();
+            local->pending.store(stamped.timestamp);
+        }
+        else
+        {
+            stamped.timestamp = timestamp();
+        }
+
         va_list args;
         va_start(args, format);
-        if(_builder->build(buffer, module, severity, infos, format, args))
+        if(_direct)
+        {
+            // The output is thread safe, bypass the queue.
+            std::string buffer;
+            if(_builder->build(buffer, module, severity, stamped, format, args) && _output->write(buffer))
+            {
+                _written++;
+            }
+        }
+        else if(DEFERRED == _formatting)
+        {
+            if(_builder->accept(module, severity))
+            {
+                auto writer = [&](Record & record)
+                {
+                    record.module   = module;
+                    record.severity = severity;
+                    record.infos    = stamped;
+                    record.kind     = Record::PACKED;
+                    // The format string is copied as well since it may not
+                    // outlive the record.
+                    size_t length = strlen(format) + 1;
+                    if(packArguments(record.arguments, Record::ArgumentSize, record.size, format, args) &&
+                       (length <= (Record::ArgumentSize - record.size)))
+                    {
+                        memcpy(record.arguments + record.size, format, length);
+                    }
+                    else
+                    {
+                        vsnprintf(record.arguments, Record::ArgumentSize, format, args);
+                        record.kind = Record::EXPANDED;
+                    }
+                };
+                queueMessage(local, writer);
+            }
+        }
+        else
         {
-            queueMessage(buffer);
+            std::string buffer;
+            if(_builder->build(buffer, module, severity, stamped, format, args))
+            {
+                auto writer = [&](Record & record)
+                {
+                    record.kind  = Record::BUILT;
+                    record.infos = stamped;
+                    record.text.swap(buffer);
+                };
+                queueMessage(local, writer);
+            }
         }
         va_end(args);
+
+        if(local != _shared)
+        {
+            local->pending.store(0);
+            wakeup();
+        }
     }
     
     SourceInfos::SourceInfos()
         : filename("")
         , line(0)
         , function("")
+        , timestamp(0)
+        , thread(0)
     {}
 
     SourceInfos::SourceInfos(char const * name, size_t num, char const * fnctl)
         : filename(name)
         , line(num)
         , function(fnctl)
+        , timestamp(0)
+        , thread(0)
     {}
 
     SourceInfos::SourceInfos(SourceInfos const & infos)
         : filename(infos.filename)
         , line(infos.line)
         , function(infos.function)
+        , timestamp(infos.timestamp)
+        , thread(infos.thread)
     {}
 
     SourceInfos& SourceInfos::operator= (SourceInfos const & infos)
     {
-        filename = infos.filename;
-        line     = infos.line;
-        function = infos.function;
+        filename  = infos.filename;
+        line      = infos.line;
+        function  = infos.function;
+        timestamp = infos.timestamp;
+        thread    = infos.thread;
         return *this;
     }
 
@@ -278,49 +1028,245 @@ namespace Log  {
         return true;
     }
 
+    /** Default buffer size in bytes. **/
+    const size_t FileOutputPolicy::DefaultBufferSize = 64 * 1024;
+    /** Default flush interval in milliseconds. **/
+    const unsigned int FileOutputPolicy::DefaultFlushInterval = 1000;
+
     /** Contructor. **/
     FileOutputPolicy::FileOutputPolicy()
-        : _filename("")
+        : _prefix("log")
+        , _filename("")
+        , _file()
+        , _buffer()
+        , _bufferSize(DefaultBufferSize)
+        , _flushInterval(DefaultFlushInterval)
+        , _maxSize(0)
+        , _maxAge(0)
+        , _compress(false)
+        , _fileSize(0)
+        , _sequence(0)
+        , _base("")
+        , _opened()
+        , _lastFlush()
+        , _compressor()
     {}
     /** Destructor. **/
     FileOutputPolicy::~FileOutputPolicy()
-    {}
+    {
+        teardown();
+    }
+    /**
+     * Set filename prefix.
+     * @param [in] prefix  Filename prefix. It may contain a directory.
+     */
+    void FileOutputPolicy::setPrefix(std::string const & prefix)
+    {
+        _prefix = prefix;
+    }
+    /**
+     * Set buffer size.
+     * @param [in] size  Buffer size in bytes.
+     */
+    void FileOutputPolicy::setBufferSize(size_t size)
+    {
+        _bufferSize = size;
+    }
+    /**
+     * Set flush interval.
+     * @param [in] milliseconds  Maximum delay between two writes of the
+     *                           buffer.
+     */
+    void FileOutputPolicy::setFlushInterval(unsigned int milliseconds)
+    {
+        _flushInterval = milliseconds;
+    }
+    /**
+     * Set rotation.
+     * @param [in] maxSize  Maximum file size in bytes (0 means no limit).
+     * @param [in] maxAge   Maximum file age in seconds (0 means no limit).
+     */
+    void FileOutputPolicy::setRotation(size_t maxSize, unsigned int maxAge)
+    {
+        _maxSize = maxSize;
+        _maxAge  = maxAge;
+    }
+    /**
+     * Enable or disable compression of rotated files.
+     * @param [in] enable  Compress rotated files.
+     */
+    void FileOutputPolicy::setCompression(bool enable)
+    {
+        _compress = enable;
+    }
+    /** Current log filename. **/
+    std::string const & FileOutputPolicy::filename() const
+    {
+        return _filename;
+    }
     /** 
-     * Build log filename using current datetime.
-     * @return Allways true
+     * Build log filename using current datetime and open it.
+     * @return false if the file could not be opened.
      */
     bool FileOutputPolicy::setup()
     {
-        std::time_t  t  = std::time(NULL);
-        std::tm     *tm = std::localtime(&t);
-        
-        char buffer[256];
-        std::strftime(buffer, sizeof(buffer), "log_%H%M%S_%d%m%Y.txt", tm);
-        _filename = buffer;
+        _buffer.reserve(_bufferSize + SimpleMessageFormat::MaxBufferLen);
+        bool ret = open();
         std::cout << _filename << std::endl;
-        return true;
+        return ret;
+    }
+    /** Write buffer and close file. **/
+    void FileOutputPolicy::teardown()
+    {
+        if(_file.isOpened())
+        {
+            flush();
+            _file.sync();
+            _file.close();
+        }
+        if(_compressor.joinable())
+        {
+            _compressor.join();
+        }
     }
     /**
-     * Write to log file.
+     * Append message to the file buffer.
      * @param [in] msg Log message.
-     * @return true if the message was succesfully written to
-     *         the file.
+     * @return false if the buffer could not be written.
      */
     bool FileOutputPolicy::write(std::string & msg)
     {
-        static File::OpenMode mode = File::WRITE_ONLY;
-        File out;
+        if(!_file.isOpened())
+        {
+            return false;
+        }
+        _buffer += msg;
+        if(msg.empty() || (msg[msg.size()-1] != '\n'))
+        {
+            _buffer += '\n';
+        }
+        if(_buffer.size() >= _bufferSize)
+        {
+            return flush();
+        }
+        if((std::chrono::steady_clock::now() - _lastFlush) >= std::chrono::milliseconds(_flushInterval))
+        {
+            return flush();
+        }
+        return true;
+    }
+    /**
+     * Write buffer to file.
+     * @return false if the buffer could not be written.
+     */
+    bool FileOutputPolicy::flush()
+    {
+        if(_buffer.empty() || !_file.isOpened())
+        {
+            return true;
+        }
+        size_t wlen = _buffer.size();
+        size_t rlen = _file.write(&_buffer[0], wlen);
+        bool ret = (rlen == wlen) && _file.flush();
 
-        bool ret = out.open(_filename.c_str(), mode);
-        if(true != ret) return ret;
-        mode = File::APPEND;
+        _fileSize += rlen;
+        _buffer.clear();
+        _lastFlush = std::chrono::steady_clock::now();
 
-        size_t wlen = msg.size();
-        size_t rlen = out.write((void*)msg.c_str(), wlen);
-        if(rlen != wlen) return false;
+        bool expired = _maxAge && ((_lastFlush - _opened) >= std::chrono::seconds(_maxAge));
+        if((_maxSize && (_fileSize >= _maxSize)) || expired)
+        {
+            ret = rotate() && ret;
+        }
+        return ret;
+    }
+    /** Flush interval in milliseconds. **/
+    unsigned int FileOutputPolicy::flushInterval() const
+    {
+        return _flushInterval;
+    }
+    /** Open a new log file. **/
+    bool FileOutputPolicy::open()
+    {
+        std::time_t  t  = std::time(NULL);
+        std::tm     *tm = std::localtime(&t);
+        
+        char buffer[256];
+        std::strftime(buffer, sizeof(buffer), "_%H%M%S_%d%m%Y", tm);
 
-        out.close();
-        return true;
+        std::string base = _prefix + buffer;
+        if(base == _base)
+        {
+            // Several files were created during the same second.
+            snprintf(buffer, sizeof(buffer), "_%u", ++_sequence);
+            _filename = base + buffer + ".txt";
+        }
+        else
+        {
+            _base     = base;
+            _sequence = 0;
+            _filename = base + ".txt";
+        }
+        _fileSize  = 0;
+        _opened    = std::chrono::steady_clock::now();
+        _lastFlush = _opened;
+        return _file.open(_filename, File::WRITE_ONLY);
+    }
+    /** Close the current file and open a new one. **/
+    bool FileOutputPolicy::rotate()
+    {
+        std::string previous = _filename;
+        _file.sync();
+        _file.close();
+        bool ret = open();
+        if(_compress)
+        {
+            if(_compressor.joinable())
+            {
+                _compressor.join();
+            }
+            _compressor = std::thread(compress, previous);
+        }
+        return ret;
+    }
+    /**
+     * Compress file and remove it.
+     * @param [in] filename  Name of the file to compress.
+     */
+    void FileOutputPolicy::compress(std::string filename)
+    {
+#if defined(HAVE_ZLIB)
+        File in;
+        if(!in.open(filename, File::READ_ONLY))
+        {
+            return;
+        }
+        std::string compressed = filename + ".gz";
+        gzFile out = gzopen(compressed.c_str(), "wb");
+        if(NULL == out)
+        {
+            return;
+        }
+        bool ret = true;
+        char buffer[64 * 1024];
+        size_t len;
+        while(ret && ((len = in.read(buffer, sizeof(buffer))) > 0))
+        {
+            ret = (gzwrite(out, buffer, (unsigned int)len) == (int)len);
+        }
+        ret = (Z_OK == gzclose(out)) && ret;
+        in.close();
+        if(ret)
+        {
+            remove(filename.c_str());
+        }
+        else
+        {
+            remove(compressed.c_str());
+        }
+#else
+        (void)filename;
+#endif
     }
 
 } // Log
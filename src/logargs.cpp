@@ -0,0 +1,403 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <DumbFramework/logargs.hpp>
+
+namespace Dumb {
+namespace Log  {
+
+namespace {
+    /** Storage type of a conversion argument. **/
+    enum Type
+    {
+        NONE,       /**< Escaped percent sign. **/
+        INT,
+        LONG,
+        LONG_LONG,
+        INTMAX,
+        SIZE,
+        PTRDIFF,
+        DOUBLE,
+        LONG_DOUBLE,
+        POINTER,
+        STRING,
+        INVALID     /**< Conversion that can not be deferred. **/
+    };
+    /** Length modifiers. **/
+    enum Length
+    {
+        DEFAULT_LENGTH,
+        CHAR_LENGTH,
+        SHORT_LENGTH,
+        LONG_LENGTH,
+        LONG_LONG_LENGTH,
+        INTMAX_LENGTH,
+        SIZE_LENGTH,
+        PTRDIFF_LENGTH,
+        LONG_DOUBLE_LENGTH
+    };
+    /** Conversion specification. **/
+    struct Conversion
+    {
+        char const* begin;  /**< Points to the '%' character. **/
+        size_t      length; /**< Length of the specification. **/
+        int         stars;  /**< Number of '*' width/precision arguments. **/
+        Type        type;   /**< Argument type. **/
+    };
+    /**
+     * Parse conversion specification.
+     * @param [in]  p           Points to a '%' character.
+     * @param [out] conversion  Conversion specification.
+     * @return Pointer to the first character after the conversion.
+     */
+    char const* parse(char const* p, Conversion & conversion)
+    {
+        conversion.begin = p++;
+        conversion.stars = 0;
+        conversion.type  = INVALID;
+        // Flags.
+        while(*p && strchr("-+ #0'", *p))
+        {
+            p++;
+        }
+        // Width.
+        if('*' == *p)
+        {
+            conversion.stars++;
+            p++;
+        }
+        else
+        {
+            while((*p >= '0') && (*p <= '9')) { p++; }
+        }
+        // Precision.
+        if('.' == *p)
+        {
+            p++;
+            if('*' == *p)
+            {
+                conversion.stars++;
+                p++;
+            }
+            else
+            {
+                while((*p >= '0') && (*p <= '9')) { p++; }
+            }
+        }
+        // Length modifier.
+        Length length = DEFAULT_LENGTH;
+        switch(*p)
+        {
+            case 'h':
+                p++;
+                if('h' == *p) { p++; length = CHAR_LENGTH; }
+                else          { length = SHORT_LENGTH; }
+                break;
+            case 'l':
+                p++;
+                if('l' == *p) { p++; length = LONG_LONG_LENGTH; }
+                else          { length = LONG_LENGTH; }
+                break;
+            case 'q': p++; length = LONG_LONG_LENGTH;   break;
+            case 'j': p++; length = INTMAX_LENGTH;      break;
+            case 'z': p++; length = SIZE_LENGTH;        break;
+            case 't': p++; length = PTRDIFF_LENGTH;     break;
+            case 'L': p++; length = LONG_DOUBLE_LENGTH; break;
+            default: break;
+        }
+        // Conversion.
+        switch(*p)
+        {
+            case 'd': case 'i':
+            case 'u': case 'o': case 'x': case 'X':
+                switch(length)
+                {
+                    case DEFAULT_LENGTH:
+                    case CHAR_LENGTH:
+                    case SHORT_LENGTH:     conversion.type = INT;       break;
+                    case LONG_LENGTH:      conversion.type = LONG;      break;
+                    case LONG_LONG_LENGTH: conversion.type = LONG_LONG; break;
+                    case INTMAX_LENGTH:    conversion.type = INTMAX;    break;
+                    case SIZE_LENGTH:      conversion.type = SIZE;      break;
+                    case PTRDIFF_LENGTH:   conversion.type = PTRDIFF;   break;
+                    default: break;
+                }
+                break;
+            case 'c':
+                if((DEFAULT_LENGTH == length) || (LONG_LENGTH == length))
+                {
+                    conversion.type = INT;
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E':
+            case 'g': case 'G': case 'a': case 'A':
+                if(LONG_DOUBLE_LENGTH == length)      { conversion.type = LONG_DOUBLE; }
+                else if(DEFAULT_LENGTH == length)     { conversion.type = DOUBLE; }
+                else if(LONG_LENGTH == length)        { conversion.type = DOUBLE; }
+                break;
+            case 's':
+                if(DEFAULT_LENGTH == length) { conversion.type = STRING; }
+                break;
+            case 'p':
+                conversion.type = POINTER;
+                break;
+            case '%':
+                if((conversion.begin+1) == p) { conversion.type = NONE; }
+                break;
+            default:
+                break;
+        }
+        if(*p) { p++; }
+        conversion.length = p - conversion.begin;
+        return p;
+    }
+    /** Append value to packed buffer. **/
+    template <typename T>
+    bool store(char* buffer, size_t capacity, size_t & used, T value)
+    {
+        if((used + sizeof(T)) > capacity)
+        {
+            return false;
+        }
+        memcpy(buffer+used, &value, sizeof(T));
+        used += sizeof(T);
+        return true;
+    }
+    /** Read value from packed buffer. **/
+    template <typename T>
+    T load(char const* data, size_t size, size_t & offset)
+    {
+        T value = T();
+        if((offset + sizeof(T)) <= size)
+        {
+            memcpy(&value, data+offset, sizeof(T));
+            offset += sizeof(T);
+        }
+        return value;
+    }
+    /** Format a single conversion with its '*' arguments. **/
+    template <typename T>
+    int print(char* buffer, size_t size, char const* spec, int stars, int const* star, T value)
+    {
+        switch(stars)
+        {
+            case 0:  return snprintf(buffer, size, spec, value);
+            case 1:  return snprintf(buffer, size, spec, star[0], value);
+            default: return snprintf(buffer, size, spec, star[0], star[1], value);
+        }
+    }
+    /** Append a single formatted conversion to the output string. **/
+    template <typename T>
+    void append(std::string & out, char const* spec, int stars, int const* star, T value)
+    {
+        char buffer[256];
+        int count = print(buffer, sizeof(buffer), spec, stars, star, value);
+        if(count < 0)
+        {
+            return;
+        }
+        if((size_t)count < sizeof(buffer))
+        {
+            out.append(buffer, count);
+            return;
+        }
+        size_t start = out.size();
+        out.resize(start + count + 1);
+        print(&out[start], count + 1, spec, stars, star, value);
+        out.resize(start + count);
+    }
+} // anonymous
+
+    /**
+     * Pack format arguments.
+     * @param [out] buffer    Destination buffer.
+     * @param [in]  capacity  Destination buffer size.
+     * @param [out] used      Number of bytes written to @a buffer.
+     * @param [in]  format    Format string.
+     * @param [in]  args      Format string arguments.
+     * @return false if the arguments could not be packed.
+     */
+    bool packArguments(char* buffer, size_t capacity, size_t & used, char const* format, va_list args)
+    {
+        va_list ap;
+        bool ret = true;
+        used = 0;
+
+        va_copy(ap, args);
+        for(char const* p=format; ret && *p; )
+        {
+            if('%' != *p)
+            {
+                p++;
+                continue;
+            }
+            Conversion conversion;
+            p = parse(p, conversion);
+            for(int i=0; ret && (i<conversion.stars); i++)
+            {
+                ret = store(buffer, capacity, used, va_arg(ap, int));
+            }
+            if(!ret)
+            {
+                break;
+            }
+            switch(conversion.type)
+            {
+                case NONE:
+                    break;
+                case INT:
+                    ret = store(buffer, capacity, used, va_arg(ap, int));
+                    break;
+                case LONG:
+                    ret = store(buffer, capacity, used, va_arg(ap, long));
+                    break;
+                case LONG_LONG:
+                    ret = store(buffer, capacity, used, va_arg(ap, long long));
+                    break;
+                case INTMAX:
+                    ret = store(buffer, capacity, used, va_arg(ap, intmax_t));
+                    break;
+                case SIZE:
+                    ret = store(buffer, capacity, used, va_arg(ap, size_t));
+                    break;
+                case PTRDIFF:
+                    ret = store(buffer, capacity, used, va_arg(ap, ptrdiff_t));
+                    break;
+                case DOUBLE:
+                    ret = store(buffer, capacity, used, va_arg(ap, double));
+                    break;
+                case LONG_DOUBLE:
+                    ret = store(buffer, capacity, used, va_arg(ap, long double));
+                    break;
+                case POINTER:
+                    ret = store(buffer, capacity, used, va_arg(ap, void*));
+                    break;
+                case STRING:
+                    {
+                        char const* str = va_arg(ap, char const*);
+                        if(NULL == str) { str = "(null)"; }
+                        size_t len = strlen(str) + 1;
+                        ret = ((used + len) <= capacity);
+                        if(ret)
+                        {
+                            memcpy(buffer+used, str, len);
+                            used += len;
+                        }
+                    }
+                    break;
+                case INVALID:
+                default:
+                    ret = false;
+                    break;
+            }
+        }
+        va_end(ap);
+        return ret;
+    }
+    /**
+     * Format packed arguments.
+     * @param [out] out     Output string.
+     * @param [in]  format  Format string used to pack the arguments.
+     * @param [in]  data    Packed arguments.
+     * @param [in]  size    Size of packed arguments.
+     */
+    void unpackArguments(std::string & out, char const* format, char const* data, size_t size)
+    {
+        size_t offset = 0;
+        char spec[64];
+
+        out.clear();
+        for(char const* p=format; *p; )
+        {
+            if('%' != *p)
+            {
+                char const* q = p;
+                while(*q && ('%' != *q)) { q++; }
+                out.append(p, q-p);
+                p = q;
+                continue;
+            }
+            Conversion conversion;
+            p = parse(p, conversion);
+            if(NONE == conversion.type)
+            {
+                out += '%';
+                continue;
+            }
+            if(conversion.length >= sizeof(spec))
+            {
+                out.append(conversion.begin, conversion.length);
+                continue;
+            }
+            memcpy(spec, conversion.begin, conversion.length);
+            spec[conversion.length] = '\0';
+
+            int star[2] = { 0, 0 };
+            for(int i=0; i<conversion.stars; i++)
+            {
+                star[i] = load<int>(data, size, offset);
+            }
+            switch(conversion.type)
+            {
+                case INT:
+                    append(out, spec, conversion.stars, star, load<int>(data, size, offset));
+                    break;
+                case LONG:
+                    append(out, spec, conversion.stars, star, load<long>(data, size, offset));
+                    break;
+                case LONG_LONG:
+                    append(out, spec, conversion.stars, star, load<long long>(data, size, offset));
+                    break;
+                case INTMAX:
+                    append(out, spec, conversion.stars, star, load<intmax_t>(data, size, offset));
+                    break;
+                case SIZE:
+                    append(out, spec, conversion.stars, star, load<size_t>(data, size, offset));
+                    break;
+                case PTRDIFF:
+                    append(out, spec, conversion.stars, star, load<ptrdiff_t>(data, size, offset));
+                    break;
+                case DOUBLE:
+                    append(out, spec, conversion.stars, star, load<double>(data, size, offset));
+                    break;
+                case LONG_DOUBLE:
+                    append(out, spec, conversion.stars, star, load<long double>(data, size, offset));
+                    break;
+                case POINTER:
+                    append(out, spec, conversion.stars, star, load<void*>(data, size, offset));
+                    break;
+                case STRING:
+                    {
+                        char const* str = "";
+                        if(offset < size)
+                        {
+                            str = data + offset;
+                            offset += strnlen(str, size - offset) + 1;
+                        }
+                        append(out, spec, conversion.stars, star, str);
+                    }
+                    break;
+                default:
+                    out.append(conversion.begin, conversion.length);
+                    break;
+            }
+        }
+    }
+
+} // Log
+} // Dumb
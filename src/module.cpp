@@ -13,36 +13,104 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <map>
+#include <atomic>
+#include <pthread.h>
 #include <DumbFramework/module.hpp>
 
 namespace Dumb   {
 namespace Module {
 
+namespace {
+    /// Module name registry.
+    struct Registry
+    {
+        /// Protects name insertion.
+        pthread_mutex_t lock;
+        /// Module index by name.
+        std::map<std::string, uint32_t> ids;
+        /// Module names by index. They point to the keys of @b ids.
+        std::atomic<std::string const*> names[Identifier::Capacity];
+        /// Number of registered modules.
+        std::atomic<uint32_t> count;
+
+        Registry()
+            : lock(PTHREAD_MUTEX_INITIALIZER)
+            , ids()
+            , count(0)
+        {
+            for(uint32_t i=0; i<Identifier::Capacity; i++)
+            {
+                names[i].store(NULL, std::memory_order_relaxed);
+            }
+            // Built-in modules, in the order of their index.
+            intern("Base");
+            intern("App");
+            intern("Render");
+        }
+        /// Get module index, register the name if needed.
+        uint32_t intern(std::string const& name)
+        {
+            pthread_mutex_lock(&lock);
+            uint32_t id = 0;
+            std::map<std::string, uint32_t>::const_iterator it = ids.find(name);
+            if(it != ids.end())
+            {
+                id = it->second;
+            }
+            else
+            {
+                id = count.load(std::memory_order_relaxed);
+                if(id < Identifier::Capacity)
+                {
+                    it = ids.insert(std::make_pair(name, id)).first;
+                    names[id].store(&it->first, std::memory_order_release);
+                    count.store(id+1, std::memory_order_release);
+                }
+                else
+                {
+                    id = 0;
+                }
+            }
+            pthread_mutex_unlock(&lock);
+            return id;
+        }
+        static Registry& instance()
+        {
+            static Registry registry;
+            return registry;
+        }
+    };
+} // anonymous
+
+/// Built-in module identifiers.
+struct BuiltIn
+{
+    static constexpr Identifier make(uint32_t id) { return Identifier(id); }
+};
+
+/// Base module identifier.
+const Identifier Base(BuiltIn::make(0));
+/// App module identifier.
+const Identifier App(BuiltIn::make(1));
+/// Render module identifier.
+const Identifier Render(BuiltIn::make(2));
+
 /// Constructor.
 /// @param [in] name Module name.
 Identifier::Identifier(std::string const& name)
-    : _name(name)
-{}
-/// Destructor.
-Identifier::~Identifier()
+    : _id(Registry::instance().intern(name))
 {}
 /// Get module name.
 /// @return Module name.
 std::string const& Identifier::toString() const
 {
-    return _name;
-}
-/// Check if two identifiers are equal.
-/// @param [in] id Module identifier.
-bool Identifier::operator== (Identifier const& id)
-{
-    return (_name == id._name);
+    return *Registry::instance().names[_id].load(std::memory_order_acquire);
 }
-/// Check if two identifiers are different.
-/// @param [in] id Module identifier.
-bool Identifier::operator!= (Identifier const& id)
+/// Number of registered modules.
+uint32_t Identifier::count()
 {
-    return (_name != id._name);
+    return Registry::instance().count.load(std::memory_order_acquire);
 }
 
 } // Module
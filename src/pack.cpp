@@ -0,0 +1,682 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#include <DumbFramework/blockcodec.hpp>
+#include <DumbFramework/pack.hpp>
+
+namespace Dumb {
+
+namespace {
+
+/** Archive header. **/
+struct Header
+{
+    /** "DPAK". **/
+    char     magic[4];
+    /** Format version. **/
+    uint32_t version;
+    /** Number of entries. **/
+    uint32_t count;
+    /** Number of hash table slots (power of two). **/
+    uint32_t slotCount;
+    /** Offset of the path table. **/
+    uint64_t pathsOffset;
+    /** Size of the path table. **/
+    uint32_t pathsSize;
+    /** Entry alignment. **/
+    uint32_t alignment;
+    /** Offset of the first entry data. **/
+    uint64_t dataOffset;
+};
+
+const char Magic[4] = { 'D', 'P', 'A', 'K' };
+const uint32_t Version = 1;
+
+/** FNV-1a hash. **/
+uint32_t hash(char const* str, size_t len)
+{
+    uint32_t h = 2166136261U;
+    for(size_t i=0; i<len; i++)
+    {
+        h = (h ^ (unsigned char)str[i]) * 16777619U;
+    }
+    return h;
+}
+
+uint32_t nextPowerOfTwo(uint32_t value)
+{
+    uint32_t p = 1;
+    while(p < value)
+    {
+        p <<= 1;
+    }
+    return p;
+}
+
+inline uint32_t read32(unsigned char const* ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline void write32(unsigned char* ptr, uint32_t value)
+{
+    memcpy(ptr, &value, sizeof(value));
+}
+
+/** Block table of an entry compressed with the BLOCKS method. **/
+struct BlockTable
+{
+    /** Uncompressed block size. **/
+    uint32_t size;
+    /** Number of blocks. **/
+    uint32_t count;
+    /** End offset of each block. **/
+    unsigned char const* ends;
+    /** Blocks data. **/
+    unsigned char const* data;
+    /** Blocks data size. **/
+    uint64_t dataSize;
+};
+
+/**
+ * Read block table.
+ * @return false if the table does not match the entry.
+ */
+bool readBlockTable(unsigned char const* stored, Pack::Entry const& entry, BlockTable& table)
+{
+    if(entry.storedSize < 8)
+    {
+        return false;
+    }
+    table.size  = read32(stored);
+    table.count = read32(stored + 4);
+    if((0 == table.size) || (table.count != ((entry.size + table.size - 1) / table.size)))
+    {
+        return false;
+    }
+    uint64_t header = 8 + (4 * (uint64_t)table.count);
+    if(header > entry.storedSize)
+    {
+        return false;
+    }
+    table.ends     = stored + 8;
+    table.data     = stored + header;
+    table.dataSize = entry.storedSize - header;
+    return true;
+}
+
+/** Mounted pack. **/
+struct Mount
+{
+    Pack *pack;
+    std::string directory;
+};
+
+std::mutex& mountLock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+std::vector<Mount>& mounts()
+{
+    static std::vector<Mount> mounted;
+    return mounted;
+}
+
+} // anonymous
+
+/** Default entry alignment in bytes. **/
+const uint32_t Pack::DefaultAlignment = 16;
+/** Default uncompressed block size in bytes. **/
+const uint32_t Pack::DefaultBlockSize = 128 * 1024;
+
+/** Constructor. **/
+Pack::Builder::Builder()
+    : _sources()
+    , _blockSize(Pack::DefaultBlockSize)
+    , _storedSize(0)
+    , _originalSize(0)
+{}
+/**
+ * Add file.
+ * @param [in] path         Path of the entry in the archive.
+ * @param [in] filename     Name of the file to store.
+ * @param [in] compression  Compression method.
+ */
+void Pack::Builder::add(std::string const& path, std::string const& filename, Pack::Compression compression)
+{
+    Source source;
+    source.path        = path;
+    source.filename    = filename;
+    source.compression = compression;
+    _sources.push_back(source);
+}
+/**
+ * Set block size.
+ * @param [in] size  Uncompressed size in bytes of the blocks.
+ */
+void Pack::Builder::setBlockSize(uint32_t size)
+{
+    _blockSize = size ? size : Pack::DefaultBlockSize;
+}
+/**
+ * Write archive.
+ * @param [in] filename   Archive file name.
+ * @param [in] alignment  Entry alignment in bytes.
+ * @return false if the archive could not be written.
+ */
+bool Pack::Builder::write(std::string const& filename, uint32_t alignment)
+{
+    _storedSize = _originalSize = 0;
+    std::sort(_sources.begin(), _sources.end(), [](Source const& a, Source const& b) { return a.path < b.path; });
+    for(size_t i=1; i<_sources.size(); i++)
+    {
+        if(_sources[i-1].path == _sources[i].path)
+        {
+            return false;
+        }
+    }
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version   = Version;
+    header.count     = (uint32_t)_sources.size();
+    header.slotCount = nextPowerOfTwo(std::max(2 * header.count, 1U));
+    header.alignment = nextPowerOfTwo(std::max(alignment, 1U));
+
+    // Table of contents and paths.
+    std::vector<Entry> entries(header.count);
+    std::vector<uint32_t> slots(header.slotCount, 0);
+    std::string paths;
+    for(uint32_t i=0; i<header.count; i++)
+    {
+        Entry &entry = entries[i];
+        std::string const& path = _sources[i].path;
+        entry.hash        = hash(path.data(), path.size());
+        entry.pathOffset  = (uint32_t)paths.size();
+        entry.pathLength  = (uint32_t)path.size();
+        entry.compression = Pack::NONE;
+        paths += path;
+
+        uint32_t mask = header.slotCount - 1;
+        uint32_t j;
+        for(j=entry.hash & mask; slots[j]; j=(j+1) & mask)
+        {}
+        slots[j] = i + 1;
+    }
+    header.pathsOffset = sizeof(Header) + (header.count * sizeof(Entry)) + (header.slotCount * sizeof(uint32_t));
+    header.pathsSize   = (uint32_t)paths.size();
+    uint64_t mask = header.alignment - 1;
+    header.dataOffset  = (header.pathsOffset + header.pathsSize + mask) & ~mask;
+
+    File output;
+    if(!output.open(filename, File::WRITE_ONLY) || !output.seek(header.dataOffset, File::START))
+    {
+        return false;
+    }
+
+    // Entries data.
+    uint64_t offset = header.dataOffset;
+    std::vector<unsigned char> compressed;
+    for(uint32_t i=0; i<header.count; i++)
+    {
+        Entry &entry = entries[i];
+        File input;
+        if(!input.open(_sources[i].filename, File::READ_ONLY) || !input.map(File::SEQUENTIAL))
+        {
+            return false;
+        }
+        unsigned char const* data = input.data();
+        entry.size       = input.size();
+        entry.storedSize = entry.size;
+#if defined(HAVE_ZLIB)
+        if((Pack::DEFLATE == _sources[i].compression) && entry.size)
+        {
+            uLongf len = compressBound(entry.size);
+            compressed.resize(len);
+            if((Z_OK == compress2(&compressed[0], &len, data, entry.size, Z_BEST_COMPRESSION)) && (len < entry.size))
+            {
+                data = &compressed[0];
+                entry.storedSize  = len;
+                entry.compression = Pack::DEFLATE;
+            }
+        }
+#endif
+        if((Pack::BLOCKS == _sources[i].compression) && entry.size && (entry.size < 0xffffffffULL))
+        {
+            uint32_t count = (uint32_t)((entry.size + _blockSize - 1) / _blockSize);
+            size_t table = 8 + (4 * count);
+            compressed.resize(table + (count * BlockCodec::bound(_blockSize)));
+            write32(&compressed[0], _blockSize);
+            write32(&compressed[4], count);
+            size_t end = table;
+            for(uint32_t j=0; j<count; j++)
+            {
+                size_t first = (size_t)j * _blockSize;
+                size_t len = std::min((size_t)_blockSize, (size_t)entry.size - first);
+                size_t packed = BlockCodec::compress(data + first, len, &compressed[end], compressed.size() - end);
+                if((0 == packed) || (packed >= len))
+                {
+                    // Store the block as is.
+                    memcpy(&compressed[end], data + first, len);
+                    packed = len;
+                }
+                end += packed;
+                write32(&compressed[8 + (4 * j)], (uint32_t)(end - table));
+            }
+            if(end < entry.size)
+            {
+                data = &compressed[0];
+                entry.storedSize  = end;
+                entry.compression = Pack::BLOCKS;
+            }
+        }
+        // Skipped bytes read as zeros. Empty entries are not aligned so
+        // that they never lie past the end of the archive.
+        uint64_t start = entry.storedSize ? ((offset + mask) & ~mask) : offset;
+        if((start != offset) && !output.seek(start, File::START))
+        {
+            return false;
+        }
+        entry.offset = start;
+        if(output.write(const_cast<unsigned char*>(data), entry.storedSize) != entry.storedSize)
+        {
+            return false;
+        }
+        offset = start + entry.storedSize;
+        _storedSize   += entry.storedSize;
+        _originalSize += entry.size;
+    }
+
+    // Header, table of contents, hash table and paths.
+    bool ret = output.seek(0, File::START);
+    ret = ret && (output.write(&header, sizeof(Header)) == sizeof(Header));
+    if(header.count)
+    {
+        ret = ret && (output.write(&entries[0], entries.size() * sizeof(Entry)) == (entries.size() * sizeof(Entry)));
+    }
+    ret = ret && (output.write(&slots[0], slots.size() * sizeof(uint32_t)) == (slots.size() * sizeof(uint32_t)));
+    if(!paths.empty())
+    {
+        ret = ret && (output.write(&paths[0], paths.size()) == paths.size());
+    }
+    ret = ret && output.flush();
+    output.close();
+    return ret;
+}
+/** Number of bytes stored in the last written archive. **/
+uint64_t Pack::Builder::storedSize() const
+{
+    return _storedSize;
+}
+/** Number of bytes of the files of the last written archive. **/
+uint64_t Pack::Builder::originalSize() const
+{
+    return _originalSize;
+}
+
+/** Constructor. **/
+Pack::Pack()
+    : _file()
+    , _entries(NULL)
+    , _slots(NULL)
+    , _paths(NULL)
+    , _count(0)
+    , _slotCount(0)
+{}
+/** Destructor. **/
+Pack::~Pack()
+{
+    close();
+}
+/**
+ * Open and map archive.
+ * @param [in] filename  Archive file name.
+ * @return false if the file is not a valid archive.
+ */
+bool Pack::open(std::string const& filename)
+{
+    close();
+    if(!_file.open(filename, File::READ_ONLY) || !_file.map(File::RANDOM))
+    {
+        _file.close();
+        return false;
+    }
+    unsigned char const* base = _file.data();
+    uint64_t fileSize = _file.size();
+
+    // Check that every table lies within the file.
+    bool ret = (fileSize >= sizeof(Header));
+    Header const* header = reinterpret_cast<Header const*>(base);
+    ret = ret && (0 == memcmp(header->magic, Magic, sizeof(Magic))) && (Version == header->version);
+    ret = ret && header->slotCount && (0 == (header->slotCount & (header->slotCount - 1))) && (header->count < header->slotCount);
+    uint64_t tables = sizeof(Header) + ((uint64_t)header->count * sizeof(Entry)) + ((uint64_t)header->slotCount * sizeof(uint32_t));
+    ret = ret && (tables <= header->pathsOffset) && (header->pathsOffset <= fileSize) && (header->pathsSize <= (fileSize - header->pathsOffset));
+    if(!ret)
+    {
+        _file.close();
+        return false;
+    }
+    _entries   = reinterpret_cast<Entry const*>(base + sizeof(Header));
+    _slots     = reinterpret_cast<uint32_t const*>(_entries + header->count);
+    _paths     = reinterpret_cast<char const*>(base + header->pathsOffset);
+    _count     = header->count;
+    _slotCount = header->slotCount;
+
+    for(uint32_t i=0; ret && (i<_count); i++)
+    {
+        Entry const& entry = _entries[i];
+        ret = (entry.pathOffset <= header->pathsSize) && (entry.pathLength <= (header->pathsSize - entry.pathOffset));
+        ret = ret && (entry.offset <= fileSize) && (entry.storedSize <= (fileSize - entry.offset));
+        ret = ret && ((Pack::DEFLATE == entry.compression) || (Pack::BLOCKS == entry.compression) ||
+                      ((Pack::NONE == entry.compression) && (entry.storedSize == entry.size)));
+    }
+    for(uint32_t i=0; ret && (i<_slotCount); i++)
+    {
+        ret = (_slots[i] <= _count);
+    }
+    if(!ret)
+    {
+        close();
+    }
+    return ret;
+}
+/** Close archive. **/
+void Pack::close()
+{
+    unmount(this);
+    _file.close();
+    _entries   = NULL;
+    _slots     = NULL;
+    _paths     = NULL;
+    _count     = 0;
+    _slotCount = 0;
+}
+/** Check if the archive is opened. **/
+bool Pack::isOpened() const
+{
+    return (NULL != _entries);
+}
+/** Number of entries. **/
+size_t Pack::count() const
+{
+    return _count;
+}
+/**
+ * Get entry.
+ * @param [in] index  Entry index.
+ */
+Pack::Entry const& Pack::entry(size_t index) const
+{
+    return _entries[index];
+}
+/** Get entry path. **/
+std::string Pack::path(Entry const& entry) const
+{
+    return std::string(_paths + entry.pathOffset, entry.pathLength);
+}
+/**
+ * Find entry.
+ * @param [in] path  Entry path.
+ * @return NULL if the archive does not contain @a path.
+ */
+Pack::Entry const* Pack::find(std::string const& path) const
+{
+    if(0 == _count)
+    {
+        return NULL;
+    }
+    uint32_t h = hash(path.data(), path.size());
+    uint32_t mask = _slotCount - 1;
+    // The table is at most half full, an empty slot ends the probe.
+    for(uint32_t i=h & mask, n=0; n<_slotCount; i=(i+1) & mask, n++)
+    {
+        uint32_t slot = _slots[i];
+        if(0 == slot)
+        {
+            break;
+        }
+        Entry const& entry = _entries[slot - 1];
+        if((entry.hash == h) && (entry.pathLength == path.size()) &&
+           (0 == memcmp(_paths + entry.pathOffset, path.data(), path.size())))
+        {
+            return &entry;
+        }
+    }
+    return NULL;
+}
+/**
+ * Get stored data.
+ * @return Pointer to the Entry::storedSize bytes of the entry.
+ */
+unsigned char const* Pack::data(Entry const& entry) const
+{
+    return _file.data() + entry.offset;
+}
+/**
+ * Read entry content.
+ * @param [in]  entry    Archive entry.
+ * @param [out] out      Uncompressed content.
+ * @param [in]  threads  Maximum number of decompression threads.
+ * @return false if the entry could not be decompressed.
+ */
+bool Pack::extract(Entry const& entry, std::vector<unsigned char>& out, unsigned int threads) const
+{
+    if(Pack::NONE == entry.compression)
+    {
+        unsigned char const* stored = data(entry);
+        out.assign(stored, stored + entry.size);
+        return true;
+    }
+    out.resize(entry.size);
+    if(0 == entry.size)
+    {
+        return true;
+    }
+    size_t count = blockCount(entry);
+    std::atomic<bool> ret(count > 0);
+    // Each thread decompresses every n-th block.
+    auto decompress = [this, &entry, &out, &ret, count](size_t first, size_t step)
+    {
+        for(size_t i=first; ret && (i<count); i+=step)
+        {
+            if(!extractBlock(entry, i, &out[0]))
+            {
+                ret = false;
+            }
+        }
+    };
+    size_t step = std::max(std::min((size_t)threads, count), (size_t)1);
+    std::vector<std::thread> workers;
+    for(size_t i=1; i<step; i++)
+    {
+        workers.push_back(std::thread(decompress, i, step));
+    }
+    decompress(0, step);
+    for(size_t i=0; i<workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    if(!ret)
+    {
+        out.clear();
+    }
+    return ret;
+}
+/**
+ * Get the number of blocks of an entry.
+ * @return 0 if the block table is invalid.
+ */
+size_t Pack::blockCount(Entry const& entry) const
+{
+    if(Pack::BLOCKS != entry.compression)
+    {
+        return 1;
+    }
+    BlockTable table;
+    return readBlockTable(data(entry), entry, table) ? table.count : 0;
+}
+/** Get the uncompressed block size of an entry. **/
+size_t Pack::blockSize(Entry const& entry) const
+{
+    BlockTable table;
+    if((Pack::BLOCKS == entry.compression) && readBlockTable(data(entry), entry, table))
+    {
+        return table.size;
+    }
+    return entry.size;
+}
+/**
+ * Read entry block.
+ * @param [in]  entry  Archive entry.
+ * @param [in]  index  Block index.
+ * @param [out] out    Destination of the whole entry content.
+ * @return false if the block could not be decompressed.
+ */
+bool Pack::extractBlock(Entry const& entry, size_t index, unsigned char* out) const
+{
+    unsigned char const* stored = data(entry);
+    if(Pack::BLOCKS == entry.compression)
+    {
+        BlockTable table;
+        if(!readBlockTable(stored, entry, table) || (index >= table.count))
+        {
+            return false;
+        }
+        uint64_t start = index ? read32(table.ends + (4 * (index - 1))) : 0;
+        uint64_t end   = read32(table.ends + (4 * index));
+        if((start > end) || (end > table.dataSize))
+        {
+            return false;
+        }
+        uint64_t offset = (uint64_t)index * table.size;
+        size_t len = (size_t)std::min((uint64_t)table.size, entry.size - offset);
+        if((end - start) == len)
+        {
+            memcpy(out + offset, table.data + start, len);
+            return true;
+        }
+        return BlockCodec::decompress(table.data + start, end - start, out + offset, len);
+    }
+    if(0 != index)
+    {
+        return false;
+    }
+    if(Pack::NONE == entry.compression)
+    {
+        memcpy(out, stored, entry.size);
+        return true;
+    }
+#if defined(HAVE_ZLIB)
+    if((Pack::DEFLATE == entry.compression) && entry.size)
+    {
+        uLongf len = entry.size;
+        return (Z_OK == uncompress(out, &len, stored, entry.storedSize)) && (len == entry.size);
+    }
+#endif
+    return (0 == entry.size);
+}
+/**
+ * Mount archive.
+ * @param [in] pack       Archive.
+ * @param [in] directory  Mount point.
+ * @return false if the archive is not opened.
+ */
+bool Pack::mount(Pack* pack, std::string const& directory)
+{
+    if((NULL == pack) || !pack->isOpened())
+    {
+        return false;
+    }
+    Mount mount;
+    mount.pack = pack;
+    mount.directory = directory;
+    while((mount.directory.size() > 1) && ('/' == mount.directory[mount.directory.size()-1]))
+    {
+        mount.directory.erase(mount.directory.size()-1);
+    }
+    std::lock_guard<std::mutex> lock(mountLock());
+    mounts().push_back(mount);
+    return true;
+}
+/** Unmount archive. **/
+void Pack::unmount(Pack* pack)
+{
+    std::lock_guard<std::mutex> lock(mountLock());
+    std::vector<Mount> &mounted = mounts();
+    for(size_t i=mounted.size(); i-->0; )
+    {
+        if(pack == mounted[i].pack)
+        {
+            mounted.erase(mounted.begin() + i);
+        }
+    }
+}
+/**
+ * Resolve file name against the mounted packs.
+ * @param [in]  filename  File name.
+ * @param [out] entry     Archive entry.
+ * @return Pack containing the file, or NULL.
+ */
+Pack const* Pack::resolve(std::string const& filename, Entry const*& entry)
+{
+    std::lock_guard<std::mutex> lock(mountLock());
+    std::vector<Mount> const& mounted = mounts();
+    for(size_t i=mounted.size(); i-->0; )
+    {
+        std::string const& directory = mounted[i].directory;
+        size_t start = 0;
+        if(directory.empty())
+        {
+            if(filename.empty() || ('/' == filename[0]))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            if((filename.size() <= directory.size()) || ('/' != filename[directory.size()]) ||
+               (0 != filename.compare(0, directory.size(), directory)))
+            {
+                continue;
+            }
+            start = directory.size() + 1;
+        }
+        while(0 == filename.compare(start, 2, "./"))
+        {
+            start += 2;
+        }
+        entry = mounted[i].pack->find(filename.substr(start));
+        if(NULL != entry)
+        {
+            return mounted[i].pack;
+        }
+    }
+    entry = NULL;
+    return NULL;
+}
+
+} // Dumb
@@ -15,6 +15,7 @@
  */
 #include <DumbFramework/config.hpp>
 #include <DumbFramework/file.hpp>
+#include <io.h>
 
 namespace Dumb {
 
@@ -53,4 +54,54 @@ std::string File::executableDirectory()
     return std::string(buffer);
 }
 
+/**
+ * @brief Synchronize file to storage.
+ *
+ * Flush stream buffer and wait until the data reached the
+ * storage device.
+ * @return true if the file was successfully synchronized.
+ */
+bool File::sync()
+{
+    if(!flush())
+    {
+        return false;
+    }
+    return (0 == _commit(_fileno(_handle)));
+}
+
+/**
+ * @brief Map file content in memory.
+ *
+ * The file is read into an internal buffer.
+ * @param [in] access Expected access pattern (unused).
+ * @return true if the file content is available.
+ */
+bool File::map(File::Access /*access*/)
+{
+    if(NULL != _data)
+    {
+        return true;
+    }
+    if((NULL == _handle) || (File::READ_ONLY != _mode))
+    {
+        return false;
+    }
+    return copy();
+}
+
+/** @brief Release the mapped file content. */
+void File::unmap()
+{
+    if(_packed)
+    {
+        // The content belongs to the pack.
+        return;
+    }
+    std::vector<unsigned char>().swap(_buffer);
+    _data = NULL;
+    _dataSize = 0;
+    _memoryMapped = false;
+}
+
 } // Dumb
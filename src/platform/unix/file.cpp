@@ -15,6 +15,7 @@
  */
 #include <DumbFramework/config.hpp>
 #include <DumbFramework/file.hpp>
+#include <sys/mman.h>
 
 namespace Dumb {
 
@@ -41,18 +42,105 @@ std::string File::currentWorkingDirectory()
  */
 std::string File::executableDirectory()
 {
-    char buffer[1024]; // May be big enough.
-    size_t pathLength;
+    // The executable does not move, it is only resolved once.
+    static const std::string directory = []() -> std::string
+    {
+        char buffer[1024]; // May be big enough.
+        size_t pathLength;
     
-    // readlink does not add '\0' at the end.
-    pathLength = readlink("/proc/self/exe", buffer, sizeof(buffer)-1);
-    if(std::string::npos == pathLength)
+        // readlink does not add '\0' at the end.
+        pathLength = readlink("/proc/self/exe", buffer, sizeof(buffer)-1);
+        if(std::string::npos == pathLength)
+        {
+            return std::string();
+        }
+        // Append '\0'.
+        buffer[pathLength] = '\0';
+        return std::string( dirname(buffer) );
+    }();
+    return directory;
+}
+
+/**
+ * @brief Synchronize file to storage.
+ *
+ * Flush stream buffer and wait until the data reached the
+ * storage device.
+ * @return true if the file was successfully synchronized.
+ */
+bool File::sync()
+{
+    if(!flush())
     {
-        return std::string();
+        return false;
+    }
+    return (0 == fsync(fileno(_handle)));
+}
+
+/**
+ * @brief Map file content in memory.
+ *
+ * Map the file with @c mmap, or read it into an internal buffer if
+ * the mapping failed.
+ * @param [in] access Expected access pattern.
+ * @return true if the file content is available.
+ */
+bool File::map(File::Access access)
+{
+    if(NULL != _data)
+    {
+        return true;
+    }
+    if((NULL == _handle) || (File::READ_ONLY != _mode))
+    {
+        return false;
+    }
+    size_t len = size();
+    if(0 == len)
+    {
+        return copy();
+    }
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(_handle), 0);
+    if(MAP_FAILED == map)
+    {
+        return copy();
+    }
+    int advice;
+    switch(access)
+    {
+        case File::SEQUENTIAL:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case File::RANDOM:
+            advice = MADV_RANDOM;
+            break;
+        default:
+            advice = MADV_NORMAL;
+            break;
+    }
+    madvise(map, len, advice);
+    _data = static_cast<unsigned char*>(map);
+    _dataSize = len;
+    _memoryMapped = true;
+    return true;
+}
+
+/** @brief Release the mapped file content. */
+void File::unmap()
+{
+    if(_packed)
+    {
+        // The content belongs to the pack.
+        return;
+    }
+    if(_memoryMapped && (NULL != _data))
+    {
+        munmap(const_cast<unsigned char*>(_data), _dataSize);
     }
-    // Append '\0'.
-    buffer[pathLength] = '\0';
-    return std::string( dirname(buffer) );
+    std::vector<unsigned char>().swap(_buffer);
+    _data = NULL;
+    _dataSize = 0;
+    _memoryMapped = false;
 }
 
 } // Dumb
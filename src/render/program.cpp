@@ -248,7 +248,7 @@ void Program::infoLog(Dumb::Severity severity) const
     }
 
     glGetProgramInfoLog(*_id, maxLogLength, &logLength, log);
-    Log_Ex(Dumb::Module::Render, severity, log);
+    Log_Ex(Dumb::Module::Render, severity, "%s", log);
 
     delete [] log;
 }
@@ -361,7 +361,7 @@ int Program::getAttribLocation(char const* name)
 }
 
 #if defined(SANITY_CHECK)
-#define CHECK_GL_ERRORS do { GLenum err = glGetError(); if(GL_NO_ERROR != err) {Log_Error(Dumb::Module::Render, (const char*)gluErrorString(err)); } } while(0); \
+#define CHECK_GL_ERRORS do { GLenum err = glGetError(); if(GL_NO_ERROR != err) {Log_Error(Dumb::Module::Render, "%s", (const char*)gluErrorString(err)); } } while(0); \
 
 #else
 #define CHECK_GL_ERRORS
@@ -48,7 +48,7 @@ bool Context::create()
     GLenum err = glGetError(); 
     if(GL_NO_ERROR != err)
     {
-        Log_Error(Dumb::Module::Render, (const char*)gluErrorString(err));
+        Log_Error(Dumb::Module::Render, "%s", (const char*)gluErrorString(err));
         return false;
     }
     
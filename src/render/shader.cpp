@@ -145,7 +145,7 @@ void Shader::infoLog(Dumb::Severity severity) const
     }
 
     glGetShaderInfoLog(_id, maxLogLength, &loglength, log);
-    Log_Ex(Dumb::Module::Render, severity, log);
+    Log_Ex(Dumb::Module::Render, severity, "%s", log);
     delete [] log;
 }
 
@@ -14,12 +14,32 @@
  * limitations under the License.
  */
 #include <DumbFramework/log.hpp>
+#include <DumbFramework/file.hpp>
 #include <DumbFramework/render/textureloader.hpp>
 
 namespace Dumb    {
 namespace Render  {
 namespace Texture {
 
+/**
+ * Decode image file.
+ * The file is mapped in memory and decoded in place.
+ * @param [in]  filename  Image filename.
+ * @param [out] size      Image size.
+ * @param [out] comp      Number of components per pixel.
+ * @return Decoded image (to be released with @c stbi_image_free), or
+ *         nullptr if the image could not be read.
+ */
+static unsigned char* loadImage(std::string const& filename, glm::ivec2& size, int& comp)
+{
+    Dumb::File input;
+    if(!input.open(filename, Dumb::File::READ_ONLY) || !input.map(Dumb::File::SEQUENTIAL))
+    {
+        return nullptr;
+    }
+    return stbi_load_from_memory(input.data(), (int)input.size(), &size.x, &size.y, &comp, 0);
+}
+
 // [todo] Should be moved to pixel format constructor.
 PixelFormat compToFormat(int comp)
 {
@@ -52,7 +72,7 @@ bool load(Texture2D& out, std::string const& filename, PixelFormat const& format
     glm::ivec2 imageSize;
     int comp;
     
-    data = stbi_load(filename.c_str(), &imageSize.x, &imageSize.y, &comp, 0);
+    data = loadImage(filename, imageSize, comp);
     if(nullptr == data)
     {
         Log_Error(Dumb::Module::Base, "Failed to load image: %s", filename.c_str());
@@ -137,7 +157,7 @@ bool loadLayer(Texture2D& out, std::string const& filename, int layer)
     int comp;
     bool ret = true;
     
-    data = stbi_load(filename.c_str(), &size.x, &size.y, &comp, 0);
+    data = loadImage(filename, size, comp);
     if(nullptr == data)
     {
         Log_Error(Dumb::Module::Base, "Failed to load image: %s", filename.c_str());
@@ -209,7 +229,7 @@ bool load(Texture2D& out, std::vector<std::string> const& filenameList, PixelFor
 
     bool ret;
 
-    data = stbi_load(filenameList[0].c_str(), &imageSize.x, &imageSize.y, &comp, 0);
+    data = loadImage(filenameList[0], imageSize, comp);
     if(nullptr == data)
     {
         Log_Error(Dumb::Module::Base, "Failed to load image: %s", filenameList[0].c_str());
@@ -20,6 +20,7 @@
 #include <string>
 #include <sstream>
 
+#include <DumbFramework/file.hpp>
 #include <DumbFramework/render/textureloader.hpp>
 #include <DumbFramework/sprite.hpp>
 
@@ -457,8 +458,15 @@ namespace Dumb {
             tinyxml2::XMLDocument xml;
             int err;
 
-            // Load xml file.
-            err = xml.LoadFile(filename.c_str());
+            // Load xml file (it may come from a mounted pack).
+            Dumb::File input;
+            if(!input.open(filename, Dumb::File::READ_ONLY) || !input.map(Dumb::File::SEQUENTIAL))
+            {
+                Log_Error(Dumb::Module::Render, "Failed to open %s", filename.c_str());
+                return false;
+            }
+            err = xml.Parse(reinterpret_cast<const char*>(input.data()), input.size());
+            input.close();
             if(tinyxml2::XML_NO_ERROR != err)
             {
                 Log_Error(Dumb::Module::Render, "An error occured while parsing %s: %s (%s)", filename.c_str(), xml.GetErrorStr1(), xml.GetErrorStr2());
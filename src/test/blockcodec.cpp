@@ -0,0 +1,111 @@
+#include <UnitTest++/UnitTest++.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <DumbFramework/blockcodec.hpp>
+
+using namespace Dumb;
+
+SUITE(BlockCodec)
+{
+    static bool roundTrip(std::vector<unsigned char> const& input, size_t& compressedSize)
+    {
+        std::vector<unsigned char> compressed(BlockCodec::bound(input.size()));
+        compressedSize = BlockCodec::compress(input.data(), input.size(), compressed.data(), compressed.size());
+        if(0 == compressedSize)
+        {
+            return false;
+        }
+        std::vector<unsigned char> output(input.size() + 1);
+        if(!BlockCodec::decompress(compressed.data(), compressedSize, output.data(), input.size()))
+        {
+            return false;
+        }
+        // The exact size is required.
+        if(BlockCodec::decompress(compressed.data(), compressedSize, output.data(), input.size() + 1))
+        {
+            return false;
+        }
+        return input.empty() || (0 == memcmp(input.data(), output.data(), input.size()));
+    }
+
+    TEST(RoundTrip)
+    {
+        size_t size;
+        std::vector<unsigned char> data;
+        CHECK(roundTrip(data, size));
+        CHECK_EQUAL(1U, size);
+
+        data.assign(5, 'a');
+        CHECK(roundTrip(data, size));
+
+        // Long runs (overlapping matches and long lengths).
+        data.assign(100000, 'a');
+        CHECK(roundTrip(data, size));
+        CHECK(size < 1000U);
+
+        // Text.
+        std::string text;
+        for(int i=0; i<2000; i++)
+        {
+            text += "<frame x=\"" + std::to_string(i % 37) + "\" y=\"" + std::to_string(i % 11) + "\"/>\n";
+        }
+        data.assign(text.begin(), text.end());
+        CHECK(roundTrip(data, size));
+        CHECK(size < (data.size() / 3));
+
+        // Noise does not fit in less than its size.
+        uint32_t seed = 1;
+        data.resize(65536);
+        for(size_t i=0; i<data.size(); i++)
+        {
+            seed = seed * 1664525U + 1013904223U;
+            data[i] = (unsigned char)(seed >> 24);
+        }
+        CHECK(roundTrip(data, size));
+        CHECK(size <= BlockCodec::bound(data.size()));
+        CHECK(size > data.size());
+
+        // Not enough room.
+        std::vector<unsigned char> small(data.size() / 2);
+        CHECK_EQUAL(0U, BlockCodec::compress(data.data(), data.size(), small.data(), small.size()));
+    }
+
+    TEST(Malformed)
+    {
+        std::string text;
+        for(int i=0; i<1000; i++)
+        {
+            text += "abcdefgh" + std::to_string(i % 13);
+        }
+        std::vector<unsigned char> compressed(BlockCodec::bound(text.size()));
+        size_t size = BlockCodec::compress(reinterpret_cast<unsigned char const*>(text.data()), text.size(), compressed.data(), compressed.size());
+        CHECK(size > 0);
+
+        // Truncated input.
+        std::vector<unsigned char> output(text.size());
+        for(size_t i=0; i<size; i+=7)
+        {
+            CHECK(!BlockCodec::decompress(compressed.data(), i, output.data(), output.size()));
+        }
+        // Corrupted input never writes out of the buffer.
+        uint32_t seed = 7;
+        for(int n=0; n<1000; n++)
+        {
+            std::vector<unsigned char> damaged(compressed.begin(), compressed.begin() + size);
+            seed = seed * 1664525U + 1013904223U;
+            damaged[seed % size] ^= (unsigned char)(1 + (seed >> 24) % 255);
+            std::vector<unsigned char> guarded(output.size() + 64, 0xcd);
+            BlockCodec::decompress(damaged.data(), damaged.size(), guarded.data(), output.size());
+            bool intact = true;
+            for(size_t i=output.size(); i<guarded.size(); i++)
+            {
+                intact = intact && (0xcd == guarded[i]);
+            }
+            CHECK(intact);
+        }
+        // Reference before the start of the output.
+        unsigned char invalid[] = { 0x10, 'a', 0x02, 0x00 };
+        CHECK(!BlockCodec::decompress(invalid, sizeof(invalid), output.data(), 5));
+    }
+}
@@ -160,7 +160,7 @@ SUITE(BoundingSphere)
 
         box = BoundingBox(glm::vec3(-10.25f), glm::vec3( 10.75f));
         res = sphere.contains(box);
-        CHECK_EQUAL(ContainmentType::Disjoints, res);
+        CHECK_EQUAL(ContainmentType::Intersects, res);
         
         box = BoundingBox(glm::vec3(0.0f, 0.0f,-120.0f), glm::vec3(1.0f, 1.0f, -80.0f));
         res = sphere.contains(box);
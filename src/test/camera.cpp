@@ -0,0 +1,91 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/camera.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+static bool equal(glm::vec3 const& v0, glm::vec3 const& v1)
+{
+    return glm::all(glm::lessThanEqual(glm::abs(v0 - v1), glm::vec3(1.0e-4f)));
+}
+
+static bool equal(glm::mat4 const& m0, glm::mat4 const& m1)
+{
+    for(int i=0; i<4; i++)
+    {
+        if(!glm::all(glm::lessThanEqual(glm::abs(m0[i] - m1[i]), glm::vec4(1.0e-5f))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+SUITE(Camera)
+{
+    TEST(Cache)
+    {
+        Camera camera;
+        glm::ivec2 size(640, 480);
+        camera.lookAt(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(0.0f, 0.0f, 10.0f));
+        camera.perspective(glm::radians(60.0f), 0.5f, 100.0f);
+
+        glm::mat4 view = camera.viewMatrix();
+        glm::mat4 projection = camera.projectionMatrix(size);
+        CHECK(view == camera.viewMatrix());
+        CHECK(projection * view == camera.viewProjectionMatrix(size));
+        CHECK(equal(glm::perspective(glm::radians(60.0f), 640.0f/480.0f, 0.5f, 100.0f), projection));
+
+        // Camera changes invalidate the cached matrices.
+        camera.lookAt(glm::vec3(-1.0f, 2.0f, 3.0f), glm::vec3(0.0f, 0.0f, 10.0f));
+        CHECK(view != camera.viewMatrix());
+        CHECK(projection == camera.projectionMatrix(size));
+        camera.perspective(glm::radians(45.0f), 0.5f, 100.0f);
+        CHECK(projection != camera.projectionMatrix(size));
+        projection = camera.projectionMatrix(size);
+        CHECK(projection != camera.projectionMatrix(glm::ivec2(480, 480)));
+        CHECK(camera.projectionMatrix(glm::ivec2(480, 480)) * camera.viewMatrix() == camera.frustum(glm::ivec2(480, 480)).getProjectionMatrix() * camera.frustum(glm::ivec2(480, 480)).getCameraMatrix());
+
+        // Copies keep their own cache.
+        Camera copy(camera);
+        camera.lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        CHECK(copy.viewMatrix() != camera.viewMatrix());
+
+        // Empty viewports keep a usable projection.
+        projection = camera.projectionMatrix(glm::ivec2(640, 0));
+        CHECK(equal(glm::perspective(glm::radians(45.0f), 1.0f, 0.5f, 100.0f), projection));
+    }
+
+    TEST(ScreenPositions)
+    {
+        Camera camera;
+        glm::ivec2 size(800, 600);
+        camera.lookAt(glm::vec3(0.0f, 5.0f, -10.0f), glm::vec3(0.0f));
+        camera.perspective(glm::radians(70.0f), 1.0f, 50.0f);
+
+        size_t count = 1001;
+        std::vector<glm::vec3> world(count);
+        for(size_t i=0; i<count; i++)
+        {
+            world[i] = glm::linearRand(glm::vec3(-30.0f), glm::vec3(30.0f));
+        }
+        std::vector<glm::vec3> screen(count);
+        std::vector<uint8_t> visible(count);
+        size_t total = camera.screenPositions(&world[0], count, size, &screen[0], &visible[0]);
+
+        size_t expected = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            glm::vec4 clip = camera.viewProjectionMatrix(size) * glm::vec4(world[i], 1.0f);
+            bool inside = (clip.w > 0.0f) && glm::all(glm::lessThanEqual(glm::abs(glm::vec3(clip)), glm::vec3(clip.w)));
+            CHECK_EQUAL(inside ? 1 : 0, visible[i]);
+            CHECK(equal(camera.screenPosition(world[i], size), screen[i]));
+            expected += inside ? 1 : 0;
+        }
+        CHECK_EQUAL(expected, total);
+        CHECK(total > 0);
+        CHECK(total < count);
+    }
+}
@@ -0,0 +1,76 @@
+#include <UnitTest++/UnitTest++.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <DumbFramework/file.hpp>
+
+using namespace Dumb;
+
+SUITE(File)
+{
+    TEST(Size)
+    {
+        File file;
+        std::string content(10000, 'a');
+        CHECK(file.open("test_file.bin", File::WRITE_ONLY));
+        CHECK_EQUAL(0U, file.size());
+        CHECK_EQUAL(content.size(), file.write(&content[0], content.size()));
+        // Buffered data is counted.
+        CHECK_EQUAL(content.size(), file.size());
+        CHECK(!file.map());
+        file.close();
+
+        CHECK(file.open("test_file.bin", File::READ_ONLY));
+        CHECK_EQUAL(content.size(), file.size());
+        // Size does not move the file offset.
+        char buffer[16];
+        CHECK_EQUAL(16U, file.read(buffer, 16));
+        CHECK_EQUAL(content.size(), file.size());
+        CHECK_EQUAL(16, file.tell());
+        file.close();
+        remove("test_file.bin");
+    }
+
+    TEST(Map)
+    {
+        File file;
+        std::string content;
+        for(int i=0; i<100000; i++)
+        {
+            content += (char)('a' + (i*7)%26);
+        }
+        CHECK(file.open("test_file.bin", File::WRITE_ONLY));
+        file.write(&content[0], content.size());
+        file.close();
+
+        CHECK(file.open("test_file.bin", File::READ_ONLY));
+        CHECK(!file.isMapped());
+        CHECK(NULL == file.data());
+        CHECK(file.map(File::RANDOM));
+        CHECK(file.isMapped());
+        CHECK(NULL != file.data());
+        CHECK_EQUAL(content.size(), file.size());
+        CHECK(0 == memcmp(content.c_str(), file.data(), content.size()));
+        // Buffered reads are still available.
+        char buffer[8];
+        CHECK(file.seek(26, File::START));
+        CHECK_EQUAL(8U, file.read(buffer, 8));
+        CHECK(0 == memcmp(content.c_str()+26, buffer, 8));
+        file.unmap();
+        CHECK(!file.isMapped());
+        CHECK(file.map(File::SEQUENTIAL));
+        CHECK(0 == memcmp(content.c_str(), file.data(), content.size()));
+        file.close();
+        CHECK(!file.isMapped());
+
+        // Empty file.
+        CHECK(file.open("test_file.bin", File::WRITE_ONLY));
+        file.close();
+        CHECK(file.open("test_file.bin", File::READ_ONLY));
+        CHECK(file.map());
+        CHECK(NULL != file.data());
+        CHECK_EQUAL(0U, file.size());
+        file.close();
+        remove("test_file.bin");
+    }
+}
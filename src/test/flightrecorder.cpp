@@ -0,0 +1,197 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <thread>
+#include <cstdio>
+#include <fstream>
+#include <DumbFramework/flightrecorder.hpp>
+
+using namespace Dumb;
+
+SUITE(FlightRecorder)
+{
+    TEST(ReadBack)
+    {
+        remove("test_flight.ring");
+        Log::FlightRecorder recorder("test_flight.ring", 4096);
+        CHECK(recorder.setup());
+        CHECK_EQUAL(4096U, recorder.capacity());
+
+        std::string msg[3] = { "first", "second message", "" };
+        for(int i=0; i<3; i++)
+        {
+            CHECK(recorder.append(msg[i].c_str(), msg[i].size(), i));
+        }
+
+        // The ring can be read while it is still mapped, like after a crash.
+        std::vector<Log::FlightRecorder::Entry> entries;
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK_EQUAL(3U, entries.size());
+        for(size_t i=0; (i<3) && (i<entries.size()); i++)
+        {
+            CHECK_EQUAL(msg[i], entries[i].message);
+            CHECK_EQUAL(i, entries[i].timestamp);
+        }
+        recorder.teardown();
+
+        // The previous ring is kept.
+        CHECK(recorder.setup());
+        CHECK(Log::FlightRecorder::read("test_flight.ring.1", entries));
+        CHECK_EQUAL(3U, entries.size());
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK_EQUAL(0U, entries.size());
+        recorder.teardown();
+
+        CHECK(!Log::FlightRecorder::read("src/test/flightrecorder.cpp", entries));
+
+        remove("test_flight.ring");
+        remove("test_flight.ring.1");
+    }
+
+    TEST(Wrap)
+    {
+        remove("test_flight.ring");
+        Log::FlightRecorder recorder("test_flight.ring", 4096);
+        CHECK(recorder.setup());
+
+        const int count = 1000;
+        char buffer[64];
+        for(int i=0; i<count; i++)
+        {
+            int len = snprintf(buffer, sizeof(buffer), "message %d", i);
+            recorder.append(buffer, len, i);
+        }
+        // Oversized messages are truncated.
+        std::string large(2048, 'x');
+        recorder.append(large.c_str(), large.size(), count);
+        recorder.teardown();
+
+        std::vector<Log::FlightRecorder::Entry> entries;
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK(entries.size() > 10U);
+        CHECK(entries.size() < (size_t)count);
+        // Only the newest messages are left, in order and without gaps.
+        size_t last = entries.size() - 1;
+        CHECK_EQUAL((uint64_t)count, entries[last].timestamp);
+        CHECK_EQUAL(1024U - 24U, entries[last].message.size());
+        for(size_t i=0; i<last; i++)
+        {
+            uint64_t expected = count - last + i;
+            CHECK_EQUAL(expected, entries[i].timestamp);
+            snprintf(buffer, sizeof(buffer), "message %d", (int)expected);
+            CHECK_EQUAL(std::string(buffer), entries[i].message);
+        }
+        remove("test_flight.ring");
+    }
+
+    TEST(Torn)
+    {
+        remove("test_flight.ring");
+        Log::FlightRecorder recorder("test_flight.ring", 4096);
+        CHECK(recorder.setup());
+
+        std::string msg[3] = { "before", "corrupted", "after" };
+        for(int i=0; i<3; i++)
+        {
+            recorder.append(msg[i].c_str(), msg[i].size(), i);
+        }
+        recorder.teardown();
+
+        // Damage the payload of the second entry (header 64 bytes, entry
+        // header 24 bytes, first entry 32 bytes).
+        std::fstream file("test_flight.ring", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 32 + 24);
+        file.write("X", 1);
+        file.close();
+
+        std::vector<Log::FlightRecorder::Entry> entries;
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK_EQUAL(2U, entries.size());
+        if(2U == entries.size())
+        {
+            CHECK_EQUAL(msg[0], entries[0].message);
+            CHECK_EQUAL(msg[2], entries[1].message);
+        }
+        remove("test_flight.ring");
+    }
+
+    TEST(Concurrent)
+    {
+        remove("test_flight.ring");
+        Log::FlightRecorder recorder("test_flight.ring", 1 << 20);
+        CHECK(recorder.setup());
+
+        const int threadCount = 4;
+        const int msgCount = 1000;
+        std::vector<std::thread> threads;
+        for(int t=0; t<threadCount; t++)
+        {
+            threads.push_back(std::thread([&recorder, t, msgCount]()
+            {
+                char buffer[64];
+                for(int i=0; i<msgCount; i++)
+                {
+                    int len = snprintf(buffer, sizeof(buffer), "%d %d", t, i);
+                    recorder.append(buffer, len, t);
+                }
+            }));
+        }
+        for(size_t t=0; t<threads.size(); t++)
+        {
+            threads[t].join();
+        }
+
+        std::vector<Log::FlightRecorder::Entry> entries;
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK_EQUAL((size_t)(threadCount*msgCount), entries.size());
+
+        std::vector<int> last(threadCount, -1);
+        bool ordered = true;
+        for(size_t i=0; i<entries.size(); i++)
+        {
+            int t, n;
+            sscanf(entries[i].message.c_str(), "%d %d", &t, &n);
+            ordered = ordered && (t == (int)entries[i].timestamp) && (n == (last[t]+1));
+            last[t] = n;
+        }
+        CHECK(ordered);
+        recorder.teardown();
+        remove("test_flight.ring");
+    }
+
+    struct PlainMessageFormat
+    {
+        void build(std::string & buffer, Module::Identifier const &, Severity const &, Log::SourceInfos const &,
+                   char const * format, va_list args)
+        {
+            char data[256];
+            vsnprintf(data, 256, format, args);
+            buffer = data;
+        }
+    };
+
+    TEST(Direct)
+    {
+        remove("test_flight.ring");
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        Log::FlightRecorder recorder("test_flight.ring", 4096);
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &recorder));
+        Log_Info(Module::Base, "direct %d", 0);
+        Log_Error(Module::Base, "direct %d", 1);
+
+        // Messages are in the ring as soon as they are emitted.
+        std::vector<Log::FlightRecorder::Entry> entries;
+        CHECK(Log::FlightRecorder::read("test_flight.ring", entries));
+        CHECK_EQUAL(2U, entries.size());
+        if(2U == entries.size())
+        {
+            CHECK_EQUAL("direct 0", entries[0].message);
+            CHECK_EQUAL("direct 1", entries[1].message);
+        }
+        CHECK_EQUAL(2U, processor.written());
+        processor.stop();
+        remove("test_flight.ring");
+        remove("test_flight.ring.1");
+    }
+}
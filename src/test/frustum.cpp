@@ -137,7 +137,31 @@ SUITE(Frustum)
 
     TEST(ContainsBox)
     {
-        /// @todo
+        glm::vec3 eye   ( 0.0f, 0.0f, 0.0f);
+        glm::vec3 target( 0.0f, 0.0f,-1.0f);
+        glm::vec3 up    ( 0.0f, 1.0f, 0.0f);
+        
+        glm::mat4 camera     = glm::lookAt(eye, target, up);
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 1.0f, 100.0f);
+        
+        Frustum frustum(camera, projection);
+        
+        ContainmentType::Value ret;
+        
+        ret = frustum.contains(BoundingBox(glm::vec3(-1.0f, -1.0f, -12.0f), glm::vec3(1.0f, 1.0f, -10.0f)));
+        CHECK_EQUAL(ContainmentType::Contains, ret);
+        
+        ret = frustum.contains(BoundingBox(glm::vec3(-1.0f, -1.0f, -2.0f), glm::vec3(1.0f, 1.0f, 2.0f)));
+        CHECK_EQUAL(ContainmentType::Intersects, ret);
+        
+        ret = frustum.contains(BoundingBox(glm::vec3(-1.0f, -1.0f, -120.0f), glm::vec3(1.0f, 1.0f, -90.0f)));
+        CHECK_EQUAL(ContainmentType::Intersects, ret);
+        
+        ret = frustum.contains(BoundingBox(glm::vec3(30.0f, -1.0f, -12.0f), glm::vec3(32.0f, 1.0f, -10.0f)));
+        CHECK_EQUAL(ContainmentType::Disjoints, ret);
+        
+        ret = frustum.contains(BoundingBox(glm::vec3(-1.0f, -1.0f, 2.0f), glm::vec3(1.0f, 1.0f, 4.0f)));
+        CHECK_EQUAL(ContainmentType::Disjoints, ret);
     }
 
     TEST(IntersectsRay)
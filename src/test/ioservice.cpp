@@ -0,0 +1,264 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cerrno>
+#include <thread>
+#include <DumbFramework/ioservice.hpp>
+
+using namespace Dumb;
+
+SUITE(IOService)
+{
+    static void createFile(char const* path, size_t size)
+    {
+        FILE *out = fopen(path, "wb");
+        for(size_t i=0; i<size; i++)
+        {
+            fputc(i & 0xff, out);
+        }
+        fclose(out);
+    }
+
+    static bool checkData(std::vector<unsigned char> const& data, size_t offset)
+    {
+        for(size_t i=0; i<data.size(); i++)
+        {
+            if(data[i] != ((offset + i) & 0xff))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    TEST(Read)
+    {
+        createFile("test_io.bin", 100000);
+
+        IOService service;
+        CHECK_EQUAL(IOService::NONE, service.backend());
+        CHECK_EQUAL(0U, service.read("test_io.bin", 0, 0, 0, nullptr));
+        CHECK(service.start());
+        CHECK(!service.start());
+        CHECK(IOService::NONE != service.backend());
+
+        std::vector<IOService::Completion> results;
+        IOService::Callback store = [&results](IOService::Completion &completion)
+        {
+            results.push_back(IOService::Completion());
+            results.back().ticket = completion.ticket;
+            results.back().status = completion.status;
+            results.back().error  = completion.error;
+            results.back().offset = completion.offset;
+            results.back().data.swap(completion.data);
+        };
+
+        IOService::Ticket whole   = service.read("test_io.bin", 0, 0, 0, store);
+        IOService::Ticket partial = service.read("test_io.bin", 1000, 5000, 0, store);
+        IOService::Ticket tail    = service.read("test_io.bin", 99000, 5000, 0, store);
+        IOService::Ticket missing = service.read("test_io.missing", 0, 0, 0, store);
+        CHECK(whole && partial && tail && missing);
+        service.wait();
+        CHECK_EQUAL(0U, service.outstanding());
+        CHECK_EQUAL(4U, service.poll());
+        CHECK_EQUAL(0U, service.poll());
+        CHECK_EQUAL(0U, service.inflight());
+        CHECK_EQUAL(4U, results.size());
+
+        for(size_t i=0; i<results.size(); i++)
+        {
+            IOService::Completion &completion = results[i];
+            if(missing == completion.ticket)
+            {
+                CHECK_EQUAL(IOService::FAILED, completion.status);
+                CHECK_EQUAL(ENOENT, completion.error);
+                CHECK(completion.data.empty());
+                continue;
+            }
+            CHECK_EQUAL(IOService::COMPLETED, completion.status);
+            CHECK(checkData(completion.data, completion.offset));
+            if(whole == completion.ticket)
+            {
+                CHECK_EQUAL(100000U, completion.data.size());
+            }
+            else if(partial == completion.ticket)
+            {
+                CHECK_EQUAL(5000U, completion.data.size());
+            }
+            else if(tail == completion.ticket)
+            {
+                // The end of the file was reached.
+                CHECK_EQUAL(1000U, completion.data.size());
+            }
+        }
+        service.stop();
+        CHECK_EQUAL(IOService::NONE, service.backend());
+        remove("test_io.bin");
+    }
+
+    TEST(Priority)
+    {
+        createFile("test_io.bin", 1024);
+
+        // Nothing else is started until the first request is polled.
+        IOService service;
+        CHECK(service.start(1, 1));
+
+        std::vector<int> order;
+        IOService::Ticket first = service.read("test_io.bin", 0, 1024, 0, [&order](IOService::Completion&) { order.push_back(0); });
+        service.wait();
+        CHECK(service.inflight() > 0);
+
+        // The reader waits for the budget with this one.
+        service.read("test_io.bin", 0, 1024, 9,  [&order](IOService::Completion&) { order.push_back(9); });
+        service.read("test_io.bin", 0, 1024, 1,  [&order](IOService::Completion&) { order.push_back(1); });
+        service.read("test_io.bin", 0, 1024, 5,  [&order](IOService::Completion&) { order.push_back(5); });
+        service.read("test_io.bin", 0, 1024, 3,  [&order](IOService::Completion&) { order.push_back(3); });
+        service.read("test_io.bin", 0, 1024, 5,  [&order](IOService::Completion&) { order.push_back(6); });
+        CHECK(!service.cancel(first));
+
+        while(service.outstanding() || service.poll())
+        {
+            service.poll();
+        }
+        int expected[] = { 0, 9, 5, 6, 3, 1 };
+        CHECK(std::vector<int>(expected, expected+6) == order);
+        service.stop();
+        remove("test_io.bin");
+    }
+
+    TEST(Wait)
+    {
+        createFile("test_io.bin", 1024);
+
+        IOService service;
+        CHECK(service.start(1, 1));
+
+        int count = 0;
+        for(int i=0; i<3; i++)
+        {
+            service.read("test_io.bin", 0, 0, 0, [&count](IOService::Completion&) { count++; });
+        }
+        // The second request waits for the budget held by the first one.
+        service.wait();
+        CHECK_EQUAL(2U, service.outstanding());
+        while(service.outstanding())
+        {
+            service.poll();
+            service.wait();
+        }
+        service.poll();
+        CHECK_EQUAL(3, count);
+        CHECK_EQUAL(0U, service.inflight());
+        service.stop();
+        remove("test_io.bin");
+    }
+
+    TEST(Cancel)
+    {
+        createFile("test_io.bin", 4096);
+
+        IOService service;
+        CHECK(service.start(1, 1));
+
+        std::vector<IOService::Status> status(4, IOService::FAILED);
+        IOService::Ticket ticket[4];
+        for(int i=0; i<4; i++)
+        {
+            ticket[i] = service.read("test_io.bin", 0, 0, 0, [&status, i](IOService::Completion &completion)
+            {
+                status[i] = completion.status;
+                if(IOService::CANCELED == completion.status)
+                {
+                    CHECK(completion.data.empty());
+                }
+            });
+        }
+        // The first request is blocking the budget.
+        while(3U < service.outstanding())
+        {
+            std::this_thread::yield();
+        }
+        CHECK(service.cancel(ticket[3]));
+        CHECK(!service.cancel(ticket[0]));
+        // The remaining request is canceled when the service stops.
+        service.stop();
+        CHECK_EQUAL(0U, service.outstanding());
+        CHECK_EQUAL(4U, service.poll());
+
+        CHECK_EQUAL(IOService::COMPLETED, status[0]);
+        CHECK_EQUAL(IOService::CANCELED, status[3]);
+        CHECK_EQUAL(IOService::CANCELED, status[1]);
+        CHECK_EQUAL(IOService::CANCELED, status[2]);
+        remove("test_io.bin");
+    }
+
+    TEST(Chunks)
+    {
+        // Large reads are split into several calls or submissions.
+        size_t size = (3 * IOService::ChunkSize) + 123;
+        createFile("test_io.bin", size);
+
+        IOService service;
+        CHECK(service.start(2));
+        std::vector<IOService::Completion> results(2);
+        for(int i=0; i<2; i++)
+        {
+            IOService::Completion *result = &results[i];
+            service.read("test_io.bin", i * 1000, 0, 0, [result](IOService::Completion &completion)
+            {
+                result->status = completion.status;
+                result->offset = completion.offset;
+                result->data.swap(completion.data);
+            });
+        }
+        while(service.outstanding())
+        {
+            service.wait();
+            service.poll();
+        }
+        service.stop();
+
+        for(int i=0; i<2; i++)
+        {
+            CHECK_EQUAL(IOService::COMPLETED, results[i].status);
+            CHECK_EQUAL(size - (i * 1000), results[i].data.size());
+            CHECK(checkData(results[i].data, results[i].offset));
+        }
+        remove("test_io.bin");
+    }
+
+    TEST(Budget)
+    {
+        const int count = 32;
+        const size_t size = 10000;
+        createFile("test_io.bin", size);
+
+        IOService service;
+        CHECK(service.start(4, 3*size));
+
+        size_t total = 0;
+        bool bounded = true;
+        for(int i=0; i<count; i++)
+        {
+            service.read("test_io.bin", 0, 0, 0, [&total, size](IOService::Completion &completion)
+            {
+                CHECK_EQUAL(size, completion.data.size());
+                CHECK(checkData(completion.data, 0));
+                total += completion.data.size();
+            });
+        }
+        while(service.outstanding())
+        {
+            bounded = bounded && (service.inflight() <= 3*size);
+            service.poll();
+        }
+        service.poll();
+        CHECK(bounded);
+        CHECK_EQUAL(count*size, total);
+        CHECK_EQUAL(0U, service.inflight());
+        service.stop();
+        remove("test_io.bin");
+    }
+}
@@ -16,6 +16,13 @@
 #include <UnitTest++/UnitTest++.h>
 #include <iostream>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <glob.h>
 #include <DumbFramework/log.hpp>
 
 using namespace Dumb;
@@ -109,4 +116,584 @@ SUITE(Log)
 
         processor.stop();
     }
+
+    struct IntervalOutputPolicy : public Log::OutputPolicyBase
+    {
+        std::atomic<unsigned int> flushes;
+
+        IntervalOutputPolicy() : flushes(0) {}
+
+        bool write(std::string &) { return true; }
+        bool flush()
+        {
+            flushes++;
+            return true;
+        }
+        unsigned int flushInterval() const { return 300; }
+    };
+
+    TEST(FlushInterval)
+    {
+        Log::LogBuilder<Log::AllPassFilter, DummyMessageFormat> msgBuilder;
+        IntervalOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output));
+
+        // Idle periods do not flush before the interval elapsed.
+        for(int i=0; i<5; i++)
+        {
+            Log_Info(Module::Base, "%d", i);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        while(processor.written() < 5) { std::this_thread::yield(); }
+        CHECK_EQUAL(0U, output.flushes.load());
+
+        // The interval is honored without any new message.
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while((0 == output.flushes) && (std::chrono::steady_clock::now() < deadline))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        CHECK_EQUAL(1U, output.flushes.load());
+
+        // Explicit flushes do not wait.
+        Log_Info(Module::Base, "%d", 5);
+        processor.flush();
+        CHECK_EQUAL(2U, output.flushes.load());
+        processor.stop();
+    }
+
+    struct GatedOutputPolicy : public Log::OutputPolicyBase
+    {
+        std::vector<std::string> msgList;
+        std::atomic<bool> entered;
+        std::atomic<bool> open;
+
+        GatedOutputPolicy() : msgList(), entered(false), open(false) {}
+
+        bool write(std::string & msg)
+        {
+            entered = true;
+            while(!open) { std::this_thread::yield(); }
+            msgList.push_back(msg);
+            return true;
+        }
+    };
+
+    struct PlainMessageFormat
+    {
+        void build(std::string & buffer, Module::Identifier const &, Severity const &, Log::SourceInfos const &, 
+                   char const * format, va_list args)
+        {
+            char data[256];
+            vsnprintf(data, 256, format, args);
+            buffer = data;
+        }
+    };
+
+    TEST(DropNewest)
+    {
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        GatedOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::DROP_NEWEST, 4));
+
+        // The first message is held by the output, the 4 next ones fill
+        // the queue and the rest is discarded.
+        Log_Info(Module::Base, "%d", 0);
+        while(!output.entered) { std::this_thread::yield(); }
+        for(int i=1; i<11; i++)
+        {
+            Log_Info(Module::Base, "%d", i);
+        }
+        CHECK_EQUAL(6U, processor.dropped());
+        output.open = true;
+        processor.flush();
+
+        CHECK_EQUAL(5U, processor.written());
+        CHECK_EQUAL(5U, output.msgList.size());
+        for(size_t i=0; i<output.msgList.size(); i++)
+        {
+            CHECK_EQUAL(std::to_string(i), output.msgList[i]);
+        }
+        processor.stop();
+    }
+
+    TEST(DropOldest)
+    {
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        GatedOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::DROP_OLDEST, 4));
+
+        Log_Info(Module::Base, "%d", 0);
+        while(!output.entered) { std::this_thread::yield(); }
+        for(int i=1; i<11; i++)
+        {
+            Log_Info(Module::Base, "%d", i);
+        }
+        CHECK_EQUAL(6U, processor.dropped());
+        output.open = true;
+        processor.flush();
+
+        const char* expected[] = { "0", "7", "8", "9", "10" };
+        CHECK_EQUAL(5U, processor.written());
+        CHECK_EQUAL(5U, output.msgList.size());
+        for(size_t i=0; (i<output.msgList.size()) && (i<5); i++)
+        {
+            CHECK_EQUAL(expected[i], output.msgList[i]);
+        }
+        processor.stop();
+    }
+
+    TEST(Block)
+    {
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        StringListOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::BLOCK, 16));
+
+        const int threadCount = 4;
+        const int msgCount = 2000;
+        std::vector<std::thread> threads;
+        for(int t=0; t<threadCount; t++)
+        {
+            threads.push_back(std::thread([t, msgCount]()
+            {
+                for(int i=0; i<msgCount; i++)
+                {
+                    Log_Info(Module::Base, "%d %d", t, i);
+                }
+            }));
+        }
+        for(size_t t=0; t<threads.size(); t++)
+        {
+            threads[t].join();
+        }
+        processor.flush();
+        CHECK_EQUAL(0U, processor.dropped());
+        CHECK_EQUAL((uint64_t)(threadCount*msgCount), processor.written());
+        processor.stop();
+
+        // Messages from a given thread keep their order.
+        std::vector<int> last(threadCount, -1);
+        bool ordered = true;
+        for(size_t i=0; i<output.msgList.size(); i++)
+        {
+            int t, n;
+            sscanf(output.msgList[i].c_str(), "%d %d", &t, &n);
+            ordered = ordered && (n == (last[t]+1));
+            last[t] = n;
+        }
+        CHECK(ordered);
+        CHECK_EQUAL((size_t)(threadCount*msgCount), output.msgList.size());
+    }
+
+    struct TimestampMessageFormat
+    {
+        void build(std::string & buffer, Module::Identifier const &, Severity const &, Log::SourceInfos const & infos,
+                   char const * format, va_list args)
+        {
+            char data[256];
+            int len = snprintf(data, 256, "%llu %u ", (unsigned long long)infos.timestamp, infos.thread);
+            vsnprintf(data+len, 256-len, format, args);
+            buffer = data;
+        }
+    };
+
+    TEST(PerThread)
+    {
+        Log::LogBuilder<Log::AllPassFilter, TimestampMessageFormat> msgBuilder;
+        StringListOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::BLOCK, 16, Log::LogProcessor::IMMEDIATE, Log::LogProcessor::PER_THREAD));
+
+        const int threadCount = 4;
+        const int msgCount = 2000;
+        std::vector<std::thread> threads;
+        for(int t=0; t<threadCount; t++)
+        {
+            threads.push_back(std::thread([t, msgCount]()
+            {
+                for(int i=0; i<msgCount; i++)
+                {
+                    Log_Info(Module::Base, "%d %d", t, i);
+                }
+            }));
+        }
+        for(size_t t=0; t<threads.size(); t++)
+        {
+            threads[t].join();
+        }
+        processor.flush();
+        CHECK_EQUAL(0U, processor.dropped());
+        CHECK_EQUAL((uint64_t)(threadCount*msgCount), processor.written());
+
+        std::vector<Log::LogProcessor::ThreadStatistics> statistics;
+        processor.statistics(statistics);
+        uint64_t emitted = 0;
+        for(size_t i=0; i<statistics.size(); i++)
+        {
+            emitted += statistics[i].emitted;
+            CHECK_EQUAL(0U, statistics[i].dropped);
+        }
+        CHECK((size_t)threadCount <= statistics.size());
+        CHECK_EQUAL((uint64_t)(threadCount*msgCount), emitted);
+        processor.stop();
+
+        // Messages are written in timestamp order.
+        std::vector<int> last(threadCount, -1);
+        unsigned long long previous = 0;
+        bool ordered = true;
+        for(size_t i=0; i<output.msgList.size(); i++)
+        {
+            unsigned long long timestamp;
+            unsigned int thread;
+            int t, n;
+            sscanf(output.msgList[i].c_str(), "%llu %u %d %d", &timestamp, &thread, &t, &n);
+            ordered = ordered && (n == (last[t]+1)) && (timestamp >= previous);
+            last[t]  = n;
+            previous = timestamp;
+        }
+        CHECK(ordered);
+        CHECK_EQUAL((size_t)(threadCount*msgCount), output.msgList.size());
+    }
+
+    TEST(PerThreadOrder)
+    {
+        Log::LogBuilder<Log::AllPassFilter, TimestampMessageFormat> msgBuilder;
+        StringListOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::BLOCK, 4, Log::LogProcessor::DEFERRED, Log::LogProcessor::PER_THREAD));
+
+        // Many producers with small queues keep the processor thread
+        // collecting while messages are being stamped.
+        const int threadCount = 8;
+        const int msgCount = 1000;
+        std::vector<std::thread> threads;
+        for(int t=0; t<threadCount; t++)
+        {
+            threads.push_back(std::thread([t, msgCount]()
+            {
+                for(int i=0; i<msgCount; i++)
+                {
+                    Log_Info(Module::Base, "%d %d", t, i);
+                    if(0 == (i % 64))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+        for(size_t t=0; t<threads.size(); t++)
+        {
+            threads[t].join();
+        }
+        processor.flush();
+        processor.stop();
+
+        CHECK_EQUAL((size_t)(threadCount*msgCount), output.msgList.size());
+        unsigned long long previous = 0;
+        size_t disordered = 0;
+        for(size_t i=0; i<output.msgList.size(); i++)
+        {
+            unsigned long long timestamp;
+            unsigned int thread;
+            sscanf(output.msgList[i].c_str(), "%llu %u", &timestamp, &thread);
+            if(timestamp < previous)
+            {
+                disordered++;
+            }
+            previous = timestamp;
+        }
+        CHECK_EQUAL(0U, disordered);
+    }
+
+    static std::string packAndFormat(size_t capacity, bool & packed, char const* format, ...)
+    {
+        char buffer[512];
+        size_t used = 0;
+        std::string out;
+        va_list args;
+        va_start(args, format);
+        packed = Log::packArguments(buffer, capacity, used, format, args);
+        va_end(args);
+        if(packed)
+        {
+            Log::unpackArguments(out, format, buffer, used);
+        }
+        return out;
+    }
+
+    static std::string expand(char const* format, ...)
+    {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return buffer;
+    }
+
+    TEST(PackArguments)
+    {
+        bool packed;
+        int i = -42;
+        long l = 1234567890L;
+        long long ll = -9876543210LL;
+        size_t z = 4096;
+        double d = 3.14159;
+        long double ld = 2.5L;
+        void *p = &i;
+        char const* str = "packed";
+
+        CHECK_EQUAL(expand("%d %5i|%-4x|%08X %c%%", i, i, 255, 255, 'z'),
+                    packAndFormat(512, packed, "%d %5i|%-4x|%08X %c%%", i, i, 255, 255, 'z'));
+        CHECK(packed);
+        CHECK_EQUAL(expand("%ld %lld %zu %hhd %hu", l, ll, z, 300, 70000),
+                    packAndFormat(512, packed, "%ld %lld %zu %hhd %hu", l, ll, z, 300, 70000));
+        CHECK(packed);
+        CHECK_EQUAL(expand("%f %.2e %g %Lf %p", d, d, d, ld, p),
+                    packAndFormat(512, packed, "%f %.2e %g %Lf %p", d, d, d, ld, p));
+        CHECK(packed);
+        CHECK_EQUAL(expand("[%s] [%10s] [%.3s] [%*d] [%-*.*f]", str, str, str, 6, i, 8, 2, d),
+                    packAndFormat(512, packed, "[%s] [%10s] [%.3s] [%*d] [%-*.*f]", str, str, str, 6, i, 8, 2, d));
+        CHECK(packed);
+
+        // Not enough room.
+        packAndFormat(8, packed, "%s", "a string longer than 8 bytes");
+        CHECK(!packed);
+        packAndFormat(8, packed, "%d %d %d", 1, 2, 3);
+        CHECK(!packed);
+        // Conversions that can not be deferred.
+        packAndFormat(512, packed, "%ls", L"wide");
+        CHECK(!packed);
+    }
+
+    struct NoWarningFilter
+    {
+        bool eval(Module::Identifier const &, Severity const & severity)
+        {
+            return (Severity::Warning != severity.value);
+        }
+    };
+
+    TEST(Deferred)
+    {
+        Log::LogBuilder<NoWarningFilter, DummyMessageFormat> msgBuilder;
+        StringListOutputPolicy output;
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output, Log::LogProcessor::BLOCK, 64, Log::LogProcessor::DEFERRED));
+
+        char name[16] = "brick0001.png";
+        std::string large(400, 'x');
+
+        Log_Info(Module::Render, "Loading %s (%d/%d) %.1f%%", name, 1, 10, 10.0);
+        // The string is copied when the message is emitted.
+        name[0] = 'B';
+        Log_Warning(Module::Base, "filtered %d", 0);
+        Log_Error(Module::App, "%s", large.c_str());
+        Log_Info(Module::Base, "no arguments");
+        // So is the format string.
+        char* format = new char[16];
+        strcpy(format, "format %d");
+        Log_Info(Module::Base, format, 2);
+        strcpy(format, "overwritten %d");
+        delete [] format;
+
+        processor.flush();
+        processor.stop();
+
+        CHECK_EQUAL(4U, output.msgList.size());
+        if(4 == output.msgList.size())
+        {
+            CHECK_EQUAL("[info][Render] RunImpl Loading brick0001.png (1/10) 10.0%", output.msgList[0]);
+            // Arguments that do not fit in the record are formatted right away and truncated.
+            CHECK_EQUAL("[error][App] RunImpl " + large.substr(0, Log::Record::ArgumentSize-1), output.msgList[1]);
+            CHECK_EQUAL("[info][Base] RunImpl no arguments", output.msgList[2]);
+            CHECK_EQUAL("[info][Base] RunImpl format 2", output.msgList[3]);
+        }
+    }
+
+    TEST(ModuleIdentifier)
+    {
+        CHECK_EQUAL("Base",   Module::Base.toString());
+        CHECK_EQUAL("App",    Module::App.toString());
+        CHECK_EQUAL("Render", Module::Render.toString());
+
+        // Names are interned, identifiers with the same name are equal.
+        Module::Identifier render("Render");
+        CHECK(render == Module::Render);
+        CHECK_EQUAL(Module::Render.id(), render.id());
+        CHECK(render != Module::App);
+
+        uint32_t count = Module::Identifier::count();
+        Module::Identifier physics("Physics");
+        Module::Identifier other("Physics");
+        CHECK(physics == other);
+        CHECK_EQUAL("Physics", other.toString());
+        CHECK(physics.id() < Module::Identifier::Capacity);
+        CHECK(count <= Module::Identifier::count());
+
+        Module::Identifier copy;
+        CHECK(copy == Module::Base);
+        copy = physics;
+        CHECK(copy == physics);
+    }
+
+    TEST(Thresholds)
+    {
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        StringListOutputPolicy output;
+        int evaluated = 0;
+
+        CHECK(Log::Thresholds::enabled(Module::Render, Severity::Info));
+
+        Log::Thresholds::set(Severity::Warning);
+        Log::Thresholds::set(Module::Render, Severity::Error);
+        Log::Thresholds::disable(Module::App);
+        CHECK(!Log::Thresholds::enabled(Module::Base, Severity::Info));
+        CHECK(Log::Thresholds::enabled(Module::Base, Severity::Warning));
+        CHECK(!Log::Thresholds::enabled(Module::Render, Severity::Warning));
+        CHECK(Log::Thresholds::enabled(Module::Render, Severity::Error));
+        CHECK(!Log::Thresholds::enabled(Module::App, Severity::Error));
+        // Thresholds are bound to the module name, not to the identifier instance.
+        CHECK(!Log::Thresholds::enabled(Module::Identifier("Render"), Severity::Warning));
+
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        processor.start(&msgBuilder, &output);
+
+        // Arguments of discarded messages are not evaluated.
+        Log_Info(Module::Base,      "%d", evaluated++);
+        Log_Warning(Module::Render, "%d", evaluated++);
+        Log_Error(Module::App,      "%d", evaluated++);
+        Log_Ex(Module::Base, Severity::Info, "%d", evaluated++);
+        CHECK_EQUAL(0, evaluated);
+
+        Log_Warning(Module::Base,   "base %d", evaluated++);
+        Log_Error(Module::Render,   "render %d", evaluated++);
+        CHECK_EQUAL(2, evaluated);
+
+        Log::Thresholds::reset();
+        Log_Info(Module::App, "app %d", evaluated++);
+        CHECK_EQUAL(3, evaluated);
+
+        processor.flush();
+        processor.stop();
+
+        CHECK_EQUAL(3U, output.msgList.size());
+        if(3 == output.msgList.size())
+        {
+            CHECK_EQUAL("base 0", output.msgList[0]);
+            CHECK_EQUAL("render 1", output.msgList[1]);
+            CHECK_EQUAL("app 2", output.msgList[2]);
+        }
+    }
+
+    static std::vector<std::string> listFiles(std::string const & pattern)
+    {
+        std::vector<std::string> files;
+        glob_t result;
+        if(0 == glob(pattern.c_str(), 0, NULL, &result))
+        {
+            for(size_t i=0; i<result.gl_pathc; i++)
+            {
+                files.push_back(result.gl_pathv[i]);
+            }
+        }
+        globfree(&result);
+        return files;
+    }
+
+    static std::string readFile(std::string const & filename)
+    {
+        std::ifstream in(filename.c_str(), std::ios::binary);
+        std::ostringstream oss;
+        oss << in.rdbuf();
+        return oss.str();
+    }
+
+    static void removeFiles(std::string const & pattern)
+    {
+        std::vector<std::string> files = listFiles(pattern);
+        for(size_t i=0; i<files.size(); i++)
+        {
+            remove(files[i].c_str());
+        }
+    }
+
+    TEST(FileOutput)
+    {
+        removeFiles("test_log_a_*");
+        removeFiles("test_log_b_*");
+
+        Log::FileOutputPolicy a, b;
+        a.setPrefix("test_log_a");
+        b.setPrefix("test_log_b");
+        CHECK(a.setup());
+        CHECK(b.setup());
+
+        std::string msg[4] = { "first", "second\n", "third", "fourth" };
+        CHECK(a.write(msg[0]));
+        CHECK(b.write(msg[1]));
+        CHECK(a.write(msg[2]));
+        CHECK(b.write(msg[3]));
+        // Nothing is written until the buffer is flushed.
+        CHECK_EQUAL(std::string(), readFile(a.filename()));
+        CHECK(a.flush());
+        CHECK_EQUAL(std::string("first\nthird\n"), readFile(a.filename()));
+        a.teardown();
+        b.teardown();
+        CHECK_EQUAL(std::string("second\nfourth\n"), readFile(b.filename()));
+
+        removeFiles("test_log_a_*");
+        removeFiles("test_log_b_*");
+    }
+
+    TEST(FileRotation)
+    {
+        removeFiles("test_log_rotation_*");
+
+        Log::LogBuilder<Log::AllPassFilter, PlainMessageFormat> msgBuilder;
+        Log::FileOutputPolicy output;
+        output.setPrefix("test_log_rotation");
+        output.setBufferSize(64);
+        output.setRotation(256, 0);
+#if defined(HAVE_ZLIB)
+        output.setCompression(true);
+#endif
+        Log::LogProcessor& processor = Log::LogProcessor::instance();
+        CHECK(processor.start(&msgBuilder, &output));
+        for(int i=0; i<100; i++)
+        {
+            Log_Info(Module::Base, "message %03d", i);
+        }
+        processor.stop();
+
+        // 100 messages of 12 bytes, rotated every 256 bytes (at most 64
+        // more because of the buffer).
+        std::vector<std::string> files = listFiles("test_log_rotation_*.txt");
+#if defined(HAVE_ZLIB)
+        CHECK_EQUAL(1U, files.size());
+        CHECK(listFiles("test_log_rotation_*.gz").size() >= 4U);
+#else
+        CHECK(files.size() >= 4U);
+        std::string content;
+        for(size_t i=0; i<files.size(); i++)
+        {
+            std::string data = readFile(files[i]);
+            CHECK(data.size() <= (256U + 64U));
+            content += data;
+        }
+        CHECK_EQUAL(1200U, content.size());
+#endif
+        removeFiles("test_log_rotation_*");
+    }
 }
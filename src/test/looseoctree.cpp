@@ -0,0 +1,220 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/boundingsphere.hpp>
+#include <DumbFramework/geometry/frustum.hpp>
+#include <DumbFramework/logic/looseoctree.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+typedef Dumb::Logic::LooseOctree::Tree<int> Octree;
+
+static BoundingBox randomBox(float range, float size)
+{
+    glm::vec3 center = glm::linearRand(glm::vec3(-range), glm::vec3(range));
+    glm::vec3 extent = glm::linearRand(glm::vec3(0.05f), glm::vec3(size));
+    return BoundingBox(center - extent, center + extent);
+}
+
+struct Counter : public Octree::Visitor
+{
+    Counter() : cells(0), depth(0), elements(0) {}
+    void enter(const BoundingBox&) { cells++; depth++; }
+    void exit(const BoundingBox&) { depth--; }
+    void inspect(int**, unsigned int count) { elements += count; }
+    void inspect(int*) { elements++; }
+    unsigned int cells;
+    unsigned int depth;
+    unsigned int elements;
+};
+
+struct Scene
+{
+    Scene() : tree(BoundingBox(glm::vec3(-64.0f), glm::vec3(64.0f)), 5) 
+    {
+        ids.reserve(600);
+        for(int i=0; i<600; i++)
+        {
+            ids.push_back(i);
+            boxes.push_back(randomBox(72.0f, (i % 10) ? 1.0f : 12.0f));
+            alive.push_back(true);
+            handles.push_back(tree.add(&ids[i], boxes[i]));
+        }
+        // Small moves stay in place, large ones relocate.
+        for(int i=0; i<600; i+=2)
+        {
+            glm::vec3 offset = glm::linearRand(glm::vec3(-0.5f), glm::vec3(0.5f));
+            if(0 == (i % 6))
+            {
+                offset *= 100.0f;
+            }
+            boxes[i] = BoundingBox(boxes[i].getMin() + offset, boxes[i].getMax() + offset);
+            tree.move(handles[i], boxes[i]);
+        }
+        for(int i=0; i<600; i+=5)
+        {
+            alive[i] = false;
+            tree.remove(handles[i]);
+        }
+    }
+
+    template <typename S>
+    std::vector<int> expected(S volume)
+    {
+        std::vector<int> result;
+        for(size_t i=0; i<boxes.size(); i++)
+        {
+            if(alive[i] && (ContainmentType::Disjoints != volume.contains(boxes[i])))
+            {
+                result.push_back(ids[i]);
+            }
+        }
+        return result;
+    }
+
+    std::vector<int> expected(Ray3 const& ray)
+    {
+        std::vector<int> result;
+        float distance;
+        for(size_t i=0; i<boxes.size(); i++)
+        {
+            if(alive[i] && boxes[i].intersects(ray, distance))
+            {
+                result.push_back(ids[i]);
+            }
+        }
+        return result;
+    }
+
+    template <typename S>
+    std::vector<int> retrieve(S const& volume)
+    {
+        std::vector<int*> buffer(ids.size());
+        unsigned int count = tree.retrieve(volume, &buffer[0], buffer.size());
+        std::vector<int> result;
+        for(unsigned int i=0; i<count; i++)
+        {
+            result.push_back(*buffer[i]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<int> ids;
+    std::vector<BoundingBox> boxes;
+    std::vector<bool> alive;
+    std::vector<unsigned int> handles;
+    Octree tree;
+};
+
+SUITE(LooseOctree)
+{
+    TEST(Elements)
+    {
+        Scene scene;
+        CHECK_EQUAL(480U, scene.tree.size());
+        for(size_t i=0; i<scene.ids.size(); i++)
+        {
+            if(scene.alive[i])
+            {
+                CHECK_EQUAL(&scene.ids[i], scene.tree.element(scene.handles[i]));
+                CHECK(scene.boxes[i].getMin() == scene.tree.box(scene.handles[i]).getMin());
+            }
+        }
+        // Removed handles are reused.
+        int extra = 1000;
+        unsigned int handle = scene.tree.add(&extra, randomBox(10.0f, 1.0f));
+        CHECK_EQUAL(scene.handles[595], handle);
+        CHECK_EQUAL(481U, scene.tree.size());
+    }
+
+    TEST(QueryBox)
+    {
+        Scene scene;
+        for(int i=0; i<20; i++)
+        {
+            BoundingBox box = randomBox(64.0f, 24.0f);
+            std::vector<int> result = scene.retrieve(box);
+            CHECK(scene.expected(box) == result);
+        }
+        BoundingBox all(glm::vec3(-1000.0f), glm::vec3(1000.0f));
+        CHECK_EQUAL(480U, scene.retrieve(all).size());
+    }
+
+    TEST(QuerySphere)
+    {
+        Scene scene;
+        for(int i=0; i<20; i++)
+        {
+            BoundingSphere sphere(glm::linearRand(glm::vec3(-64.0f), glm::vec3(64.0f)), glm::linearRand(1.0f, 40.0f));
+            std::vector<int> result = scene.retrieve(sphere);
+            CHECK(scene.expected(sphere) == result);
+        }
+    }
+
+    TEST(QueryFrustum)
+    {
+        Scene scene;
+        glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 1.0f, 100.0f);
+        for(int i=0; i<10; i++)
+        {
+            glm::vec3 eye = glm::linearRand(glm::vec3(-64.0f), glm::vec3(64.0f));
+            glm::vec3 target = glm::linearRand(glm::vec3(-64.0f), glm::vec3(64.0f));
+            Frustum frustum(glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)), projection);
+            std::vector<int> result = scene.retrieve(frustum);
+            CHECK(scene.expected(frustum) == result);
+        }
+    }
+
+    TEST(QueryRay)
+    {
+        Scene scene;
+        for(int i=0; i<20; i++)
+        {
+            Ray3 ray(glm::linearRand(glm::vec3(-80.0f), glm::vec3(80.0f)), glm::normalize(glm::linearRand(glm::vec3(-1.0f), glm::vec3(1.0f))));
+            std::vector<int> result = scene.retrieve(ray);
+            CHECK(scene.expected(ray) == result);
+        }
+    }
+
+    TEST(Visitor)
+    {
+        Scene scene;
+        Counter counter;
+        scene.tree.visit(counter);
+        CHECK_EQUAL(480U, counter.elements);
+        CHECK_EQUAL(0U, counter.depth);
+        CHECK(counter.cells > 1);
+
+        // Fully contained cells are fetched in bulk.
+        std::vector<int*> buffer(scene.ids.size());
+        Counter partial;
+        BoundingBox all(glm::vec3(-1000.0f), glm::vec3(1000.0f));
+        unsigned int count = scene.tree.retrieve(all, &buffer[0], buffer.size(), &partial);
+        CHECK_EQUAL(count, partial.elements);
+        CHECK_EQUAL(0U, partial.depth);
+
+        // Buffer size is honored.
+        count = scene.tree.retrieve(all, &buffer[0], 17);
+        CHECK_EQUAL(17U, count);
+    }
+
+    TEST(Empty)
+    {
+        Scene scene;
+        for(size_t i=0; i<scene.ids.size(); i++)
+        {
+            if(scene.alive[i])
+            {
+                scene.tree.remove(scene.handles[i]);
+            }
+        }
+        CHECK_EQUAL(0U, scene.tree.size());
+        Counter counter;
+        scene.tree.visit(counter);
+        CHECK_EQUAL(1U, counter.cells);
+    }
+}
@@ -0,0 +1,134 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <DumbFramework/geometry/occlusionbuffer.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+static const float fovy = glm::radians(60.0f);
+static const float zNear = 1.0f;
+static const float zFar  = 100.0f;
+
+/** Normalized device depth of a point at a given view distance. **/
+static float ndcDepth(float distance)
+{
+    float z = (zFar + zNear) / (zFar - zNear) - (2.0f * zFar * zNear) / ((zFar - zNear) * distance);
+    return z * 0.5f + 0.5f;
+}
+
+static void quad(std::vector<float>& vertices, std::vector<uint32_t>& indices, glm::vec3 const& p0, glm::vec3 const& p1, glm::vec3 const& p2, glm::vec3 const& p3)
+{
+    uint32_t first = static_cast<uint32_t>(vertices.size() / 3);
+    glm::vec3 p[4] = { p0, p1, p2, p3 };
+    for(int i=0; i<4; i++)
+    {
+        vertices.push_back(p[i].x);
+        vertices.push_back(p[i].y);
+        vertices.push_back(p[i].z);
+    }
+    uint32_t idx[6] = { 0, 1, 2, 0, 2, 3 };
+    for(int i=0; i<6; i++)
+    {
+        indices.push_back(first + idx[i]);
+    }
+}
+
+SUITE(OcclusionBuffer)
+{
+    TEST(Wall)
+    {
+        glm::ivec2 screen(1280, 640);
+        OcclusionBuffer buffer(glm::ivec2(256, 128), glm::ivec2(64, 32));
+        buffer.setup(glm::perspective(fovy, 2.0f, zNear, zFar));
+        buffer.clear();
+        
+        // Wall covering the left half of the screen.
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        quad(vertices, indices, glm::vec3(-100.0f, -100.0f, -10.0f), glm::vec3(0.0f, -100.0f, -10.0f), glm::vec3(0.0f, 100.0f, -10.0f), glm::vec3(-100.0f, 100.0f, -10.0f));
+        buffer.add(&vertices[0], vertices.size()/3, &indices[0], indices.size()/3, glm::mat4(1.0f));
+        buffer.rasterize();
+        
+        float expected = ndcDepth(10.0f);
+        glm::ivec2 size = buffer.size();
+        for(int y=0; y<size.y; y++)
+        {
+            for(int x=0; x<size.x; x++)
+            {
+                CHECK_CLOSE((x < (size.x/2)) ? expected : 1.0f, buffer.depth(x, y), 0.0001f);
+            }
+        }
+        
+        CHECK_EQUAL(false, buffer.visible(BoundingBox(glm::vec3(-6.0f, -1.0f, -22.0f), glm::vec3(-4.0f, 1.0f, -20.0f))));
+        CHECK_EQUAL(true,  buffer.visible(BoundingBox(glm::vec3( 4.0f, -1.0f, -22.0f), glm::vec3( 6.0f, 1.0f, -20.0f))));
+        CHECK_EQUAL(true,  buffer.visible(BoundingBox(glm::vec3(-3.0f, -1.0f,  -7.0f), glm::vec3(-2.0f, 1.0f,  -5.0f))));
+        // Partially hidden.
+        CHECK_EQUAL(true,  buffer.visible(BoundingBox(glm::vec3(-1.0f, -1.0f, -22.0f), glm::vec3( 1.0f, 1.0f, -20.0f))));
+        // Behind the camera, crossing the near plane, outside of the screen.
+        CHECK_EQUAL(true,  buffer.visible(BoundingBox(glm::vec3(-1.0f, -1.0f,  -2.0f), glm::vec3( 1.0f, 1.0f,   2.0f))));
+        CHECK_EQUAL(false, buffer.visible(BoundingBox(glm::vec3(40.0f, -1.0f, -22.0f), glm::vec3(42.0f, 1.0f, -20.0f))));
+    }
+    
+    TEST(Floor)
+    {
+        const float aspect = 2.0f;
+        OcclusionBuffer buffer(glm::ivec2(256, 128));
+        buffer.setup(glm::perspective(fovy, aspect, zNear, zFar));
+        buffer.clear();
+        
+        // Floor going behind the camera, so that it is clipped by the near plane.
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        quad(vertices, indices, glm::vec3(-20.0f, -1.0f, 5.0f), glm::vec3(20.0f, -1.0f, 5.0f), glm::vec3(20.0f, -1.0f, -50.0f), glm::vec3(-20.0f, -1.0f, -50.0f));
+        buffer.add(&vertices[0], vertices.size()/3, &indices[0], indices.size()/3, glm::mat4(1.0f));
+        for(size_t i=0; i<buffer.tileCount(); i++)
+        {
+            buffer.rasterize(i);
+        }
+        
+        glm::ivec2 size = buffer.size();
+        float tanHalf = std::tan(fovy / 2.0f);
+        size_t checked = 0;
+        for(int y=0; y<size.y; y++)
+        {
+            for(int x=0; x<size.x; x++)
+            {
+                glm::vec2 ndc((x + 0.5f) / size.x * 2.0f - 1.0f, (y + 0.5f) / size.y * 2.0f - 1.0f);
+                glm::vec3 direction(ndc.x * tanHalf * aspect, ndc.y * tanHalf, -1.0f);
+                float expected = 1.0f;
+                if(direction.y < 0.0f)
+                {
+                    float distance = -1.0f / direction.y;
+                    float hit = direction.x * distance;
+                    // Skip pixels on the floor edges.
+                    if((std::abs(distance - 50.0f) < 2.0f) || (std::abs(std::abs(hit) - 20.0f) < 1.0f))
+                    {
+                        continue;
+                    }
+                    if((distance < 50.0f) && (std::abs(hit) < 20.0f))
+                    {
+                        expected = ndcDepth(distance);
+                    }
+                }
+                CHECK_CLOSE(expected, buffer.depth(x, y), 0.0005f);
+                checked++;
+            }
+        }
+        CHECK(checked > (size_t)(size.x * size.y / 2));
+        
+        // Object standing behind a wall seen from a camera.
+        Camera camera;
+        camera.lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        camera.perspective(fovy, zNear, zFar);
+        buffer.setup(camera, glm::ivec2(1280, 640));
+        buffer.clear();
+        vertices.clear();
+        indices.clear();
+        quad(vertices, indices, glm::vec3(-5.0f, -5.0f, 10.0f), glm::vec3(5.0f, -5.0f, 10.0f), glm::vec3(5.0f, 5.0f, 10.0f), glm::vec3(-5.0f, 5.0f, 10.0f));
+        buffer.add(&vertices[0], vertices.size()/3, &indices[0], indices.size()/3, glm::mat4(1.0f));
+        buffer.rasterize();
+        CHECK_EQUAL(false, buffer.visible(BoundingBox(glm::vec3(-4.0f, -4.0f, 12.0f), glm::vec3(4.0f, 4.0f, 14.0f))));
+        CHECK_EQUAL(false, buffer.visible(BoundingBox(glm::vec3(-1.0f, -1.0f, 20.0f), glm::vec3(1.0f, 1.0f, 22.0f))));
+        CHECK_EQUAL(true,  buffer.visible(BoundingBox(glm::vec3(-1.0f, -1.0f,  6.0f), glm::vec3(1.0f, 1.0f,  8.0f))));
+    }
+}
@@ -0,0 +1,269 @@
+#include <UnitTest++/UnitTest++.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <DumbFramework/pack.hpp>
+
+using namespace Dumb;
+
+SUITE(Pack)
+{
+    static void createFile(char const* path, std::string const& content)
+    {
+        File file;
+        file.open(path, File::WRITE_ONLY);
+        file.write(const_cast<char*>(content.data()), content.size());
+        file.close();
+    }
+
+    TEST(Build)
+    {
+        std::string text;
+        for(int i=0; i<5000; i++)
+        {
+            text += "<sprite name=\"dummy\"/>\n";
+        }
+        std::string binary;
+        for(int i=0; i<1000; i++)
+        {
+            binary += (char)((i * 2654435761U) >> 24);
+        }
+        createFile("test_pack_a.bin", text);
+        createFile("test_pack_b.bin", binary);
+        createFile("test_pack_c.bin", "");
+
+        Pack::Builder builder;
+        builder.add("sprites/atlas.xml", "test_pack_a.bin", Pack::DEFLATE);
+        builder.add("textures/atlas.png", "test_pack_b.bin");
+        builder.add("empty", "test_pack_c.bin");
+        CHECK(builder.write("test_pack.pack", 64));
+        CHECK_EQUAL((uint64_t)(text.size() + binary.size()), builder.originalSize());
+
+        Pack pack;
+        CHECK(pack.open("test_pack.pack"));
+        CHECK_EQUAL(3U, pack.count());
+        // Entries are sorted by path.
+        CHECK_EQUAL("empty", pack.path(pack.entry(0)));
+        CHECK_EQUAL("sprites/atlas.xml", pack.path(pack.entry(1)));
+        CHECK_EQUAL("textures/atlas.png", pack.path(pack.entry(2)));
+
+        CHECK(NULL == pack.find("sprites/atlas"));
+        CHECK(NULL == pack.find("missing"));
+        Pack::Entry const* entry = pack.find("textures/atlas.png");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL(0U, entry->offset % 64);
+            CHECK_EQUAL((uint32_t)Pack::NONE, entry->compression);
+            CHECK(0 == memcmp(binary.data(), pack.data(*entry), binary.size()));
+        }
+        entry = pack.find("sprites/atlas.xml");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL(0U, entry->offset % 64);
+            CHECK_EQUAL(text.size(), entry->size);
+#if defined(HAVE_ZLIB)
+            CHECK_EQUAL((uint32_t)Pack::DEFLATE, entry->compression);
+            CHECK(entry->storedSize < entry->size);
+#endif
+            std::vector<unsigned char> content;
+            CHECK(pack.extract(*entry, content));
+            CHECK(std::string(content.begin(), content.end()) == text);
+        }
+        entry = pack.find("empty");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL(0U, entry->size);
+        }
+        pack.close();
+        CHECK(!pack.isOpened());
+
+        // Alignment larger than a page. The empty entry is the last one.
+        Pack::Builder aligned;
+        aligned.add("a", "test_pack_b.bin");
+        aligned.add("b", "test_pack_c.bin");
+        CHECK(aligned.write("test_pack_aligned.pack", 16384));
+        CHECK(pack.open("test_pack_aligned.pack"));
+        entry = pack.find("a");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL(0U, entry->offset % 16384);
+            CHECK(0 == memcmp(binary.data(), pack.data(*entry), binary.size()));
+        }
+        CHECK(NULL != pack.find("b"));
+        pack.close();
+
+        // Duplicated paths are rejected.
+        builder.add("empty", "test_pack_c.bin");
+        CHECK(!builder.write("test_pack_dup.pack"));
+
+        // Invalid archives.
+        CHECK(!pack.open("test_pack_a.bin"));
+        std::fstream file("test_pack.pack", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(12);
+        file.write("\xff\xff\xff\x0f", 4);
+        file.close();
+        CHECK(!pack.open("test_pack.pack"));
+
+        remove("test_pack_a.bin");
+        remove("test_pack_b.bin");
+        remove("test_pack_c.bin");
+        remove("test_pack.pack");
+        remove("test_pack_dup.pack");
+        remove("test_pack_aligned.pack");
+    }
+
+    TEST(Blocks)
+    {
+        // Several blocks with different contents, the last one is partial.
+        std::string content;
+        uint32_t seed = 3;
+        for(int i=0; i<40000; i++)
+        {
+            seed = seed * 1664525U + 1013904223U;
+            if(i < 30000)
+            {
+                content += "vertex " + std::to_string(i % 100) + "\n";
+            }
+            else
+            {
+                content += (char)(seed >> 24);
+            }
+        }
+        createFile("test_pack_a.bin", content);
+        createFile("test_pack_b.bin", std::string(100, 'x'));
+
+        Pack::Builder builder;
+        builder.setBlockSize(16 * 1024);
+        builder.add("mesh", "test_pack_a.bin", Pack::BLOCKS);
+        builder.add("small", "test_pack_b.bin", Pack::BLOCKS);
+        CHECK(builder.write("test_pack.pack"));
+        CHECK(builder.storedSize() < builder.originalSize());
+
+        Pack pack;
+        CHECK(pack.open("test_pack.pack"));
+        Pack::Entry const* entry = pack.find("mesh");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL((uint32_t)Pack::BLOCKS, entry->compression);
+            CHECK(entry->storedSize < entry->size);
+            CHECK_EQUAL(16U * 1024U, pack.blockSize(*entry));
+            size_t count = pack.blockCount(*entry);
+            CHECK_EQUAL((content.size() + 16*1024 - 1) / (16*1024), count);
+
+            std::vector<unsigned char> out;
+            for(unsigned int threads=1; threads<=4; threads++)
+            {
+                CHECK(pack.extract(*entry, out, threads));
+                CHECK(std::string(out.begin(), out.end()) == content);
+            }
+            // Blocks can be decompressed in any order.
+            std::vector<unsigned char> streamed(entry->size);
+            for(size_t i=count; i-->0; )
+            {
+                CHECK(pack.extractBlock(*entry, i, streamed.data()));
+            }
+            CHECK(streamed == out);
+            CHECK(!pack.extractBlock(*entry, count, streamed.data()));
+
+            // Loaders see the uncompressed content.
+            CHECK(Pack::mount(&pack, "resources"));
+            File file;
+            CHECK(file.open("resources/mesh", File::READ_ONLY));
+            CHECK(file.isPacked());
+            CHECK(file.map());
+            CHECK_EQUAL(content.size(), file.size());
+            CHECK(0 == memcmp(content.data(), file.data(), content.size()));
+            file.close();
+        }
+        entry = pack.find("small");
+        CHECK(NULL != entry);
+        if(entry)
+        {
+            CHECK_EQUAL(1U, pack.blockCount(*entry));
+            std::vector<unsigned char> out;
+            CHECK(pack.extract(*entry, out, 4));
+            CHECK(std::string(out.begin(), out.end()) == std::string(100, 'x'));
+        }
+        pack.close();
+
+        remove("test_pack_a.bin");
+        remove("test_pack_b.bin");
+        remove("test_pack.pack");
+    }
+
+    TEST(Mount)
+    {
+        std::string content = "packed content";
+        createFile("test_pack_a.bin", content);
+        createFile("test_pack_b.bin", "disk content");
+        Pack::Builder builder;
+        builder.add("data/file.txt", "test_pack_a.bin", Pack::DEFLATE);
+        CHECK(builder.write("test_pack.pack"));
+
+        Pack pack;
+        File file;
+        CHECK(!Pack::mount(&pack, "resources"));
+        CHECK(pack.open("test_pack.pack"));
+        CHECK(Pack::mount(&pack, "resources/"));
+
+        CHECK(file.open("resources/data/file.txt", File::READ_ONLY));
+        CHECK(file.isPacked());
+        CHECK(file.isOpened());
+        CHECK_EQUAL(content.size(), file.size());
+        CHECK(file.map());
+        CHECK(0 == memcmp(content.data(), file.data(), content.size()));
+        // Stream functions work on packed files.
+        char buffer[16];
+        CHECK(file.seek(7, File::START));
+        CHECK_EQUAL(7, file.tell());
+        CHECK_EQUAL(7U, file.read(buffer, sizeof(buffer)));
+        CHECK(0 == memcmp("content", buffer, 7));
+        CHECK(file.eof());
+        CHECK(file.seek(-7, File::END));
+        CHECK_EQUAL(7U, file.read(buffer, 7));
+        CHECK(!file.seek(-100, File::CURRENT));
+        // The content stays available until the file is closed.
+        file.unmap();
+        CHECK(file.isMapped());
+        file.close();
+        CHECK(!file.isPacked());
+        CHECK(!file.isOpened());
+
+        CHECK(file.open("resources/./data/file.txt", File::READ_ONLY));
+        CHECK(file.isPacked());
+        file.close();
+        // Only files opened for reading are served by packs.
+        CHECK(!file.open("resources/data/file.txt", File::READ_WRITE) || !file.isPacked());
+        file.close();
+        CHECK(!file.open("resources/data/missing.txt", File::READ_ONLY));
+        CHECK(!file.open("other/data/file.txt", File::READ_ONLY));
+        CHECK(!file.open("resourcesdata/file.txt", File::READ_ONLY));
+
+        // Files outside the mount point still come from the disk.
+        CHECK(file.open("test_pack_b.bin", File::READ_ONLY));
+        CHECK(!file.isPacked());
+        file.close();
+
+        // Relative mount point.
+        CHECK(Pack::mount(&pack, ""));
+        CHECK(file.open("data/file.txt", File::READ_ONLY));
+        CHECK(file.isPacked());
+        file.close();
+
+        // Closing the pack unmounts it.
+        pack.close();
+        CHECK(!file.open("resources/data/file.txt", File::READ_ONLY));
+        CHECK(!file.open("data/file.txt", File::READ_ONLY));
+
+        remove("test_pack_a.bin");
+        remove("test_pack_b.bin");
+        remove("test_pack.pack");
+    }
+}
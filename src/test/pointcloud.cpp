@@ -0,0 +1,119 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <glm/gtc/random.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <DumbFramework/geometry/pointcloud.hpp>
+#include <DumbFramework/geometry/boundingbox.hpp>
+#include <DumbFramework/geometry/boundingsphere.hpp>
+#include <DumbFramework/geometry/boundingquad.hpp>
+#include <DumbFramework/geometry/boundingcircle.hpp>
+#include <DumbFramework/geometry/frustum.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+SUITE(PointCloud)
+{
+    TEST(Bounds)
+    {
+        // 5 floats per point, odd count so that the tail loop is used.
+        std::vector<float> pointList;
+        size_t count = 37;
+        glm::vec3 pmin(std::numeric_limits<float>::max()), pmax(-std::numeric_limits<float>::max());
+        for(size_t i=0; i<count; i++)
+        {
+            glm::vec3 dummy = glm::vec3(1.0f, -2.0f, 3.5f) + glm::ballRand(5.0f);
+            pmin = glm::min(pmin, dummy);
+            pmax = glm::max(pmax, dummy);
+            pointList.push_back(dummy.x);
+            pointList.push_back(dummy.y);
+            pointList.push_back(dummy.z);
+            pointList.push_back(0.0f);
+            pointList.push_back(0.0f);
+        }
+        BoundingBox box(reinterpret_cast<const uint8_t*>(&pointList[0]), count, 5*sizeof(float));
+        CHECK_EQUAL(pmin, box.getMin());
+        CHECK_EQUAL(pmax, box.getMax());
+        
+        BoundingQuad quad(&pointList[0], count*5/2, 0);
+        glm::vec2 qmin(pointList[0], pointList[1]), qmax = qmin;
+        for(size_t i=1; i<(count*5/2); i++)
+        {
+            glm::vec2 p(pointList[2*i], pointList[2*i+1]);
+            qmin = glm::min(qmin, p);
+            qmax = glm::max(qmax, p);
+        }
+        CHECK_EQUAL(qmin, quad.getMin());
+        CHECK_EQUAL(qmax, quad.getMax());
+    }
+    
+    TEST(BoundingSphere)
+    {
+        std::vector<float> pointList;
+        size_t count = 1001;
+        glm::vec3 pmin(std::numeric_limits<float>::max()), pmax(-std::numeric_limits<float>::max());
+        for(size_t i=0; i<count; i++)
+        {
+            glm::vec3 dummy = glm::vec3(-4.0f, 2.0f, 7.0f) + glm::ballRand(3.0f) * glm::vec3(1.0f, 0.5f, 2.0f);
+            pmin = glm::min(pmin, dummy);
+            pmax = glm::max(pmax, dummy);
+            pointList.push_back(dummy.x);
+            pointList.push_back(dummy.y);
+            pointList.push_back(dummy.z);
+        }
+        BoundingSphere sphere(reinterpret_cast<const uint8_t*>(&pointList[0]), count, 3*sizeof(float));
+        CHECK_EQUAL(ContainmentType::Contains, sphere.contains(&pointList[0], count, 0));
+        // Never worse than the sphere enclosing the bounding box.
+        CHECK(sphere.getRadius() <= (glm::distance(pmin, pmax) / 2.0f));
+    }
+
+    TEST(BoundingCircle)
+    {
+        std::vector<float> pointList;
+        size_t count = 333;
+        glm::vec2 pmin(std::numeric_limits<float>::max()), pmax(-std::numeric_limits<float>::max());
+        for(size_t i=0; i<count; i++)
+        {
+            glm::vec2 dummy = glm::vec2(5.0f, -1.0f) + glm::diskRand(2.0f);
+            pmin = glm::min(pmin, dummy);
+            pmax = glm::max(pmax, dummy);
+            pointList.push_back(dummy.x);
+            pointList.push_back(dummy.y);
+            pointList.push_back(-1.0f);
+        }
+        BoundingCircle circle(&pointList[0], count, 1);
+        CHECK_EQUAL(ContainmentType::Contains, circle.contains(&pointList[0], count, 1));
+        // Never worse than the circle enclosing the bounding quad.
+        CHECK(circle.getRadius() <= (glm::distance(pmin, pmax) / 2.0f));
+    }
+    
+    TEST(Planes)
+    {
+        glm::mat4 camera     = glm::lookAt(glm::vec3(1.1f, 7.8f, 11.2f), glm::vec3(5.7f, 5.1f, 8.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f/9.0f, 2.0f, 100.0f);
+        Frustum frustum(camera, projection);
+        Plane planes[6] =
+        {
+            frustum.getNear(), frustum.getFar(), frustum.getLeft(),
+            frustum.getRight(), frustum.getTop(), frustum.getBottom()
+        };
+        
+        std::vector<float> pointList;
+        size_t count = 203;
+        size_t expected = 0;
+        for(size_t i=0; i<count; i++)
+        {
+            glm::vec3 dummy = glm::vec3(5.7f, 5.1f, 8.0f) + glm::ballRand(60.0f);
+            bool inside = true;
+            for(size_t j=0; j<6; j++)
+            {
+                inside = inside && (Side::Back != planes[j].classify(dummy));
+            }
+            expected += inside ? 1 : 0;
+            pointList.push_back(dummy.x);
+            pointList.push_back(dummy.y);
+            pointList.push_back(dummy.z);
+        }
+        size_t inside = PointCloud::countInside(reinterpret_cast<const uint8_t*>(&pointList[0]), count, 3*sizeof(float), planes, 6);
+        CHECK_EQUAL(expected, inside);
+    }
+}
@@ -0,0 +1,89 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/raypacket.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+SUITE(RayPacket)
+{
+    TEST(IntersectsBox)
+    {
+        BoundingBox box(glm::vec3(-3.1f, 1.2f, -2.6f), glm::vec3(4.5f, 6.7f, 5.1f));
+        Ray3 rays[4] = 
+        {
+            Ray3(glm::vec3(-1.4f, 3.2f, 1.1f), glm::vec3(-1.0f, 1.0f, 0.5f)),
+            Ray3(glm::vec3(6.25f,-2.7f,-8.8f), glm::vec3(-1.0f, 0.0f,-1.0f)),
+            Ray3(glm::vec3(6.25f,-2.7f,-8.8f), glm::vec3(-1.0f,-1.0f, 1.0f)),
+            Ray3(glm::vec3(5.7f, 8.95f, 6.25f), glm::vec3(-1.0f,-1.0f,-1.0f))
+        };
+        RayPacket4 packet(rays, 4);
+        float distance[4];
+        unsigned int hit = intersects(box, packet, distance);
+        CHECK_EQUAL(0x09U, hit);
+        // The first ray starts inside the box.
+        CHECK_CLOSE(0.0f, distance[0], 0.0001f);
+        
+        float expected;
+        CHECK_EQUAL(true, box.intersects(rays[3], expected));
+        CHECK_CLOSE(expected, distance[3], 0.0001f);
+        
+        // Inactive lanes never hit.
+        packet = RayPacket4(rays, 2);
+        hit = intersects(box, packet, distance);
+        CHECK_EQUAL(0x01U, hit);
+        
+        // Inactive lanes are never assigned a box, even if their
+        // (null) ray is inside it.
+        BoundingBox boxes[2] =
+        {
+            BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f)),
+            box
+        };
+        int index[4];
+        hit = intersects(boxes, 2, packet, index, distance);
+        CHECK_EQUAL(0x01U, hit);
+        CHECK_EQUAL(1, index[0]);
+        for(int i=1; i<4; i++)
+        {
+            CHECK_EQUAL(-1, index[i]);
+        }
+    }
+    
+    TEST(ScalarMatch)
+    {
+        std::vector<BoundingBox> boxes;
+        for(size_t i=0; i<64; i++)
+        {
+            glm::vec3 center = glm::ballRand(40.0f);
+            glm::vec3 extent = glm::abs(glm::ballRand(4.0f)) + glm::vec3(0.1f);
+            boxes.push_back(BoundingBox(center-extent, center+extent));
+        }
+        
+        for(size_t n=0; n<32; n++)
+        {
+            Ray3 rays[8];
+            glm::vec3 origin = glm::ballRand(10.0f);
+            for(size_t i=0; i<8; i++)
+            {
+                rays[i] = Ray3(origin, glm::sphericalRand(1.0f));
+            }
+            RayPacket8 packet(rays, 8);
+            int index[8];
+            float distance[8];
+            unsigned int hit = intersects(&boxes[0], boxes.size(), packet, index, distance);
+            for(size_t i=0; i<8; i++)
+            {
+                int expectedIndex;
+                float expectedDistance;
+                bool ret = intersects(&boxes[0], boxes.size(), rays[i], expectedIndex, expectedDistance);
+                CHECK_EQUAL(ret, 0 != (hit & (1 << i)));
+                CHECK_EQUAL(expectedIndex, index[i]);
+                if(ret)
+                {
+                    CHECK_CLOSE(expectedDistance, distance[i], 0.001f);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,437 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <algorithm>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/logic/searchtree.hpp>
+#include <DumbFramework/logic/searchregion.hpp>
+
+namespace {
+
+/** Square region split into 4 quadrants (in Z-order). **/
+struct Region
+{
+    Region() {}
+    Region(glm::vec2 const& lo, glm::vec2 const& hi) : min(lo), max(hi) {}
+    bool contains(glm::vec2 const& p) const
+    {
+        return (p.x >= min.x) && (p.y >= min.y) && (p.x < max.x) && (p.y < max.y);
+    }
+    unsigned int dimension() const { return 4; }
+    Region* divide() const
+    {
+        glm::vec2 center = (min + max) / 2.0f;
+        Region* regions = new Region[4];
+        regions[0] = Region(min, center);
+        regions[1] = Region(glm::vec2(center.x, min.y), glm::vec2(max.x, center.y));
+        regions[2] = Region(glm::vec2(min.x, center.y), glm::vec2(center.x, max.y));
+        regions[3] = Region(center, max);
+        return regions;
+    }
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+struct Entity
+{
+    glm::vec2 const& key() const { return position; }
+    void key(glm::vec2 const& p) { position = p; }
+    glm::vec2 position;
+    bool alive;
+};
+
+/** Disc search function. **/
+struct Disc
+{
+    Disc(glm::vec2 const& c, float r) : center(c), radius(r) {}
+    int contains(Region const& region) const
+    {
+        glm::vec2 nearest = glm::clamp(center, region.min, region.max);
+        if(glm::distance(nearest, center) > radius) { return -1; }
+        glm::vec2 farthest = glm::max(glm::abs(center - region.min), glm::abs(center - region.max));
+        return (glm::length(farthest) <= radius) ? 1 : 0;
+    }
+    bool contains(glm::vec2 const& p) const { return glm::distance(p, center) <= radius; }
+    glm::vec2 center;
+    float radius;
+};
+
+template <typename V>
+struct Point
+{
+    V const& key() const { return position; }
+    void key(V const& p) { position = p; }
+    V position;
+};
+
+typedef Dumb::Logic::SearchTree::Node<glm::vec2, Region, Entity> Tree;
+typedef Dumb::Logic::SearchTree::Linear<glm::vec2, Region, Entity> LinearTree;
+
+struct Counter : public Tree::Visitor
+{
+    Counter() : depth(0), elements(0) {}
+    void enter(Region const&) { depth++; }
+    void exit(Region const&) { depth--; }
+    void inspect(Entity**, unsigned int count) { elements += count; }
+    void inspect(Entity*) { elements++; }
+    int depth;
+    unsigned int elements;
+};
+
+struct Scene
+{
+    Scene() : region(glm::vec2(-100.0f), glm::vec2(100.0f)), tree(&region, 8), entities(3000)
+    {
+        for(size_t i=0; i<entities.size(); i++)
+        {
+            entities[i].position = glm::linearRand(glm::vec2(-99.0f), glm::vec2(99.0f));
+            entities[i].alive = true;
+            tree.add(&entities[i]);
+        }
+        for(size_t i=0; i<entities.size(); i+=3)
+        {
+            entities[i].alive = false;
+            tree.remove(&entities[i]);
+        }
+    }
+
+    std::vector<Entity*> expected(Disc const& disc)
+    {
+        std::vector<Entity*> result;
+        for(size_t i=0; i<entities.size(); i++)
+        {
+            if(entities[i].alive && disc.contains(entities[i].position))
+            {
+                result.push_back(&entities[i]);
+            }
+        }
+        return result;
+    }
+
+    template <typename T>
+    std::vector<Entity*> retrieve(T const& t, Disc const& disc)
+    {
+        std::vector<Entity*> buffer(entities.size());
+        unsigned int count = t.retrieve(disc, &buffer[0], buffer.size());
+        buffer.resize(count);
+        std::sort(buffer.begin(), buffer.end());
+        return buffer;
+    }
+
+    Region region;
+    Tree tree;
+    std::vector<Entity> entities;
+};
+
+}
+
+SUITE(SearchTree)
+{
+    TEST(Retrieve)
+    {
+        Scene scene;
+        for(int i=0; i<20; i++)
+        {
+            Disc disc(glm::linearRand(glm::vec2(-100.0f), glm::vec2(100.0f)), glm::linearRand(1.0f, 60.0f));
+            CHECK(scene.expected(disc) == scene.retrieve(scene.tree, disc));
+        }
+        Counter counter;
+        scene.tree.visit(counter);
+        CHECK_EQUAL(2000U, counter.elements);
+        CHECK_EQUAL(0, counter.depth);
+    }
+
+    TEST(Linear)
+    {
+        Scene scene;
+        LinearTree linear(scene.tree);
+        CHECK_EQUAL(2000U, linear.size());
+        for(int i=0; i<20; i++)
+        {
+            Disc disc(glm::linearRand(glm::vec2(-100.0f), glm::vec2(100.0f)), glm::linearRand(1.0f, 60.0f));
+            CHECK(scene.expected(disc) == scene.retrieve(linear, disc));
+        }
+
+        Counter counter;
+        linear.visit(counter);
+        CHECK_EQUAL(2000U, counter.elements);
+        CHECK_EQUAL(0, counter.depth);
+
+        Counter partial;
+        std::vector<Entity*> buffer(scene.entities.size());
+        Disc disc(glm::vec2(0.0f), 50.0f);
+        unsigned int count = linear.retrieve(disc, &buffer[0], buffer.size(), &partial);
+        CHECK_EQUAL(count, partial.elements);
+        CHECK_EQUAL(0, partial.depth);
+
+        // Rebuild after changes.
+        for(size_t i=1; i<scene.entities.size(); i+=3)
+        {
+            scene.entities[i].alive = false;
+            scene.tree.remove(&scene.entities[i]);
+        }
+        linear.build(scene.tree);
+        CHECK_EQUAL(1000U, linear.size());
+        CHECK(scene.expected(disc) == scene.retrieve(linear, disc));
+    }
+
+    TEST(Query)
+    {
+        Scene scene;
+        LinearTree linear(scene.tree);
+        Disc disc(glm::vec2(10.0f, -5.0f), 40.0f);
+        std::vector<Entity*> expected = scene.expected(disc);
+        CHECK(expected.size() > 64);
+
+        // Growable output.
+        std::vector<Entity*> output;
+        CHECK_EQUAL(expected.size(), scene.tree.retrieve(disc, output));
+        std::sort(output.begin(), output.end());
+        CHECK(expected == output);
+        output.clear();
+        CHECK_EQUAL(expected.size(), linear.retrieve(disc, output));
+        std::sort(output.begin(), output.end());
+        CHECK(expected == output);
+
+        // Early out.
+        unsigned int count = 0;
+        bool done = scene.tree.query(disc, [&count](Entity*) { return ++count < 10; });
+        CHECK(!done);
+        CHECK_EQUAL(10U, count);
+        count = 0;
+        done = linear.query(disc, [&count](Entity*) { return ++count < 10; });
+        CHECK(!done);
+        CHECK_EQUAL(10U, count);
+        count = 0;
+        done = scene.tree.query(disc, [&count](Entity*) { ++count; return true; });
+        CHECK(done);
+        CHECK_EQUAL(expected.size(), count);
+
+        // Small buffers are filled with matching elements only.
+        Entity* buffer[16];
+        count = scene.tree.retrieve(disc, buffer, 16);
+        CHECK_EQUAL(16U, count);
+        for(unsigned int i=0; i<count; i++)
+        {
+            CHECK(disc.contains(buffer[i]->position));
+        }
+        count = linear.retrieve(disc, buffer, 16);
+        CHECK_EQUAL(16U, count);
+        for(unsigned int i=0; i<count; i++)
+        {
+            CHECK(disc.contains(buffer[i]->position));
+        }
+    }
+
+    TEST(Build)
+    {
+        Scene scene;
+        std::vector<Entity*> alive;
+        for(size_t i=0; i<scene.entities.size(); i++)
+        {
+            if(scene.entities[i].alive)
+            {
+                alive.push_back(&scene.entities[i]);
+            }
+        }
+        Region region(glm::vec2(-100.0f), glm::vec2(100.0f));
+        Tree tree(&region, 8);
+        tree.build(&alive[0], alive.size());
+        Counter counter;
+        tree.visit(counter);
+        CHECK_EQUAL(alive.size(), counter.elements);
+        for(int i=0; i<20; i++)
+        {
+            Disc disc(glm::linearRand(glm::vec2(-100.0f), glm::vec2(100.0f)), glm::linearRand(1.0f, 60.0f));
+            CHECK(scene.expected(disc) == scene.retrieve(tree, disc));
+        }
+
+        // The tree stays usable after a build.
+        tree.remove(alive[0]);
+        scene.entities[alive[0] - &scene.entities[0]].alive = false;
+        Disc disc(alive[0]->position, 10.0f);
+        CHECK(scene.expected(disc) == scene.retrieve(tree, disc));
+
+        // Rebuild replaces the content.
+        tree.build(&alive[0], 100);
+        Counter rebuilt;
+        tree.visit(rebuilt);
+        CHECK_EQUAL(100U, rebuilt.elements);
+    }
+
+    TEST(DuplicateKeys)
+    {
+        // More elements than the cardinality share a key.
+        std::vector<Entity> entities(100);
+        std::vector<Entity*> pointers;
+        for(size_t i=0; i<entities.size(); i++)
+        {
+            entities[i].position = (i < 40) ? glm::vec2(12.5f, -3.0f) : glm::linearRand(glm::vec2(-99.0f), glm::vec2(99.0f));
+            entities[i].alive = true;
+            pointers.push_back(&entities[i]);
+        }
+        Region region(glm::vec2(-100.0f), glm::vec2(100.0f));
+        Tree built(&region, 8);
+        built.build(&pointers[0], pointers.size());
+        Tree added(&region, 8);
+        for(size_t i=0; i<entities.size(); i++)
+        {
+            added.add(&entities[i]);
+        }
+
+        Disc disc(glm::vec2(12.5f, -3.0f), 0.5f);
+        std::vector<Entity*> output;
+        CHECK_EQUAL(40U, built.retrieve(disc, output));
+        output.clear();
+        CHECK_EQUAL(40U, added.retrieve(disc, output));
+        Counter counter;
+        added.visit(counter);
+        CHECK_EQUAL(100U, counter.elements);
+
+        // Oversized leaves shrink back through removals.
+        for(size_t i=0; i<40; i+=2)
+        {
+            added.remove(&entities[i]);
+            built.remove(&entities[i]);
+        }
+        output.clear();
+        CHECK_EQUAL(20U, added.retrieve(disc, output));
+        output.clear();
+        CHECK_EQUAL(20U, built.retrieve(disc, output));
+    }
+
+    TEST(Move)
+    {
+        Scene scene;
+        std::vector<Entity*> moved;
+        std::vector<glm::vec2> keys;
+        for(size_t i=1; i<scene.entities.size(); i+=2)
+        {
+            if(!scene.entities[i].alive)
+            {
+                continue;
+            }
+            glm::vec2 offset = (i % 5) ? glm::linearRand(glm::vec2(-1.0f), glm::vec2(1.0f)) : glm::linearRand(glm::vec2(-50.0f), glm::vec2(50.0f));
+            moved.push_back(&scene.entities[i]);
+            keys.push_back(glm::clamp(scene.entities[i].position + offset, glm::vec2(-99.0f), glm::vec2(99.0f)));
+        }
+        scene.tree.move(&moved[0], &keys[0], moved.size());
+        for(size_t i=0; i<moved.size(); i++)
+        {
+            CHECK(keys[i] == moved[i]->position);
+        }
+
+        // Single move.
+        glm::vec2 key(-98.0f, 97.0f);
+        scene.tree.move(&scene.entities[2], key);
+        CHECK(key == scene.entities[2].position);
+
+        Counter counter;
+        scene.tree.visit(counter);
+        CHECK_EQUAL(2000U, counter.elements);
+        for(int i=0; i<20; i++)
+        {
+            Disc disc(glm::linearRand(glm::vec2(-100.0f), glm::vec2(100.0f)), glm::linearRand(1.0f, 60.0f));
+            CHECK(scene.expected(disc) == scene.retrieve(scene.tree, disc));
+        }
+
+        // Move everything to a corner and back.
+        std::vector<Entity*> all;
+        std::vector<glm::vec2> corner, back;
+        for(size_t i=0; i<scene.entities.size(); i++)
+        {
+            if(scene.entities[i].alive)
+            {
+                all.push_back(&scene.entities[i]);
+                back.push_back(scene.entities[i].position);
+                corner.push_back(glm::vec2(-90.0f) + glm::linearRand(glm::vec2(0.0f), glm::vec2(1.0f)));
+            }
+        }
+        scene.tree.move(&all[0], &corner[0], all.size());
+        scene.tree.move(&all[0], &back[0], all.size());
+        Counter after;
+        scene.tree.visit(after);
+        CHECK_EQUAL(2000U, after.elements);
+        Disc disc(glm::vec2(0.0f), 60.0f);
+        CHECK(scene.expected(disc) == scene.retrieve(scene.tree, disc));
+    }
+
+    TEST(Nearest)
+    {
+        using Dumb::Core::Geometry::BoundingQuad;
+        typedef Dumb::Logic::SearchTree::QuadRegion QuadRegion;
+        typedef Dumb::Logic::SearchTree::Node<glm::vec2, QuadRegion, Point<glm::vec2> > QuadTree;
+
+        QuadRegion region(BoundingQuad(glm::vec2(-100.0f), glm::vec2(100.0f)));
+        QuadTree tree(&region);
+        std::vector<Point<glm::vec2> > points(2000);
+        for(size_t i=0; i<points.size(); i++)
+        {
+            points[i].position = glm::linearRand(glm::vec2(-99.0f), glm::vec2(99.0f));
+            tree.add(&points[i]);
+        }
+
+        const unsigned int k = 12;
+        Point<glm::vec2>* buffer[k];
+        float distances[k];
+        for(int i=0; i<20; i++)
+        {
+            glm::vec2 key = glm::linearRand(glm::vec2(-120.0f), glm::vec2(120.0f));
+            std::vector<float> expected;
+            for(size_t j=0; j<points.size(); j++)
+            {
+                expected.push_back(glm::distance(key, points[j].position));
+            }
+            std::sort(expected.begin(), expected.end());
+
+            unsigned int count = tree.nearest(key, k, buffer, distances);
+            CHECK_EQUAL(k, count);
+            for(unsigned int j=0; j<count; j++)
+            {
+                CHECK_CLOSE(expected[j], distances[j], 1.0e-4f);
+                CHECK_CLOSE(expected[j], glm::distance(key, buffer[j]->position), 1.0e-4f);
+            }
+
+            // Limited radius.
+            float radius = expected[5];
+            count = tree.nearest(key, k, buffer, distances, radius);
+            CHECK_EQUAL(6U, count);
+
+            // Radius query.
+            std::vector<Point<glm::vec2>*> output;
+            CHECK_EQUAL(6U, tree.within(key, radius, output));
+            for(size_t j=0; j<output.size(); j++)
+            {
+                CHECK(glm::distance(key, output[j]->position) <= radius);
+            }
+        }
+        CHECK_EQUAL(0U, tree.nearest(glm::vec2(0.0f), 0, buffer));
+
+        unsigned int count = 0;
+        CHECK(!tree.within(glm::vec2(0.0f), 50.0f, [&count](Point<glm::vec2>*) { return ++count < 3; }));
+        CHECK_EQUAL(3U, count);
+    }
+
+    TEST(NearestBox)
+    {
+        using Dumb::Core::Geometry::BoundingBox;
+        typedef Dumb::Logic::SearchTree::BoxRegion BoxRegion;
+        typedef Dumb::Logic::SearchTree::Node<glm::vec3, BoxRegion, Point<glm::vec3> > Octree;
+
+        BoxRegion region(BoundingBox(glm::vec3(0.0f), glm::vec3(64.0f)));
+        Octree tree(&region);
+        std::vector<Point<glm::vec3> > points(1500);
+        for(size_t i=0; i<points.size(); i++)
+        {
+            points[i].position = glm::linearRand(glm::vec3(0.0f), glm::vec3(63.0f));
+            tree.add(&points[i]);
+        }
+        glm::vec3 key(20.0f, 40.0f, 10.0f);
+        Point<glm::vec3>* nearest;
+        float distance;
+        CHECK_EQUAL(1U, tree.nearest(key, 1, &nearest, &distance));
+        for(size_t i=0; i<points.size(); i++)
+        {
+            CHECK(distance <= glm::distance(key, points[i].position));
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/logic/searchregion.hpp>
+#include <DumbFramework/logic/snapshot.hpp>
+
+using Dumb::Core::Geometry::BoundingQuad;
+using Dumb::Logic::SearchTree::QuadRegion;
+
+namespace {
+
+struct Entity
+{
+    glm::vec2 const& key() const { return position; }
+    void key(glm::vec2 const& p) { position = p; }
+    glm::vec2 position;
+};
+
+typedef Dumb::Logic::SearchTree::Node<glm::vec2, QuadRegion, Entity> Tree;
+typedef Dumb::Logic::SearchTree::Snapshots<glm::vec2, QuadRegion, Entity> Snapshots;
+
+const glm::vec2 Left(-50.0f, 0.0f);
+const glm::vec2 Right(50.0f, 0.0f);
+
+/** Move all entities around the left or right point. **/
+void scatter(Tree& tree, std::vector<Entity>& entities, glm::vec2 const& center)
+{
+    std::vector<Entity*> elements(entities.size());
+    std::vector<glm::vec2> keys(entities.size());
+    for(size_t i=0; i<entities.size(); i++)
+    {
+        elements[i] = &entities[i];
+        keys[i] = center + glm::diskRand(40.0f);
+    }
+    tree.move(&elements[0], &keys[0], elements.size());
+}
+
+}
+
+SUITE(Snapshot)
+{
+    TEST(View)
+    {
+        QuadRegion region(BoundingQuad(glm::vec2(-100.0f), glm::vec2(100.0f)));
+        Tree tree(&region);
+        std::vector<Entity> entities(300);
+        for(size_t i=0; i<entities.size(); i++)
+        {
+            entities[i].position = Left + glm::diskRand(40.0f);
+            tree.add(&entities[i]);
+        }
+        Snapshots snapshots(2);
+        {
+            Snapshots::View view(snapshots, 0);
+            CHECK_EQUAL(1U, view.epoch());
+            CHECK_EQUAL(0U, view->size());
+        }
+        CHECK_EQUAL(2U, snapshots.publish(tree));
+
+        Snapshots::View view(snapshots, 0);
+        CHECK_EQUAL(2U, view.epoch());
+        std::vector<Entity*> output;
+        CHECK_EQUAL(300U, view->within(Left, 45.0f, output));
+
+        // The view is not affected by later changes.
+        scatter(tree, entities, Right);
+        snapshots.publish(tree);
+        snapshots.publish(tree);
+        output.clear();
+        CHECK_EQUAL(300U, view->within(Left, 45.0f, output));
+        Entity* nearest[4];
+        CHECK_EQUAL(4U, view->nearest(Left, 4, nearest));
+
+        Snapshots::View other(snapshots, 1);
+        CHECK_EQUAL(4U, other.epoch());
+        output.clear();
+        CHECK_EQUAL(0U, other->within(Left, 45.0f, output));
+        CHECK_EQUAL(300U, other->within(Right, 45.0f, output));
+    }
+
+    TEST(Concurrent)
+    {
+        const unsigned int readers = 3;
+        const size_t count = 500;
+        QuadRegion region(BoundingQuad(glm::vec2(-100.0f), glm::vec2(100.0f)));
+        Tree tree(&region);
+        std::vector<Entity> entities(count);
+        for(size_t i=0; i<count; i++)
+        {
+            entities[i].position = Left + glm::diskRand(40.0f);
+            tree.add(&entities[i]);
+        }
+        Snapshots snapshots(readers);
+        std::atomic<bool> done(false);
+        std::atomic<unsigned int> errors(0);
+        std::atomic<unsigned int> queries(0);
+
+        std::vector<std::thread> threads;
+        for(unsigned int r=0; r<readers; r++)
+        {
+            threads.push_back(std::thread([&, r]()
+            {
+                std::vector<Entity*> output;
+                while(!done.load())
+                {
+                    Snapshots::View view(snapshots, r);
+                    output.clear();
+                    unsigned int left = view->within(Left, 45.0f, output);
+                    unsigned int right = view->within(Right, 45.0f, output);
+                    // Frame 'n' is published at epoch 'n+2'. Even frames are on the left.
+                    uint64_t epoch = view.epoch();
+                    unsigned int expected = (epoch < 2) ? 0 : ((epoch % 2) ? 0 : count);
+                    if((left != expected) || ((left + right) != ((epoch < 2) ? 0 : count)))
+                    {
+                        errors++;
+                    }
+                    queries++;
+                }
+            }));
+        }
+        for(int frame=0; frame<200; frame++)
+        {
+            scatter(tree, entities, (frame % 2) ? Right : Left);
+            snapshots.publish(tree);
+        }
+        while(queries.load() < 100) { std::this_thread::yield(); }
+        done = true;
+        for(unsigned int r=0; r<readers; r++)
+        {
+            threads[r].join();
+        }
+        CHECK_EQUAL(0U, errors.load());
+        // Copies are recycled.
+        CHECK(snapshots.capacity() <= (readers + 2));
+    }
+}
@@ -0,0 +1,120 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <algorithm>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/spatialgrid.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+static BoundingQuad randomQuad()
+{
+    glm::vec2 center = glm::linearRand(glm::vec2(-100.0f), glm::vec2(100.0f));
+    glm::vec2 extent = glm::linearRand(glm::vec2(0.1f), glm::vec2(6.0f));
+    return BoundingQuad(center - extent, center + extent);
+}
+
+static bool overlap(BoundingQuad const& q0, BoundingQuad const& q1)
+{
+    return (q0.getMin().x <= q1.getMax().x) && (q1.getMin().x <= q0.getMax().x) &&
+           (q0.getMin().y <= q1.getMax().y) && (q1.getMin().y <= q0.getMax().y);
+}
+
+SUITE(SpatialGrid)
+{
+    TEST(Query)
+    {
+        SpatialGrid grid(4.0f, 64);
+        std::vector<BoundingQuad> quads;
+        std::vector<bool> alive;
+        for(size_t i=0; i<500; i++)
+        {
+            quads.push_back(randomQuad());
+            alive.push_back(true);
+            CHECK_EQUAL(i, grid.insert(quads.back()));
+        }
+        // Move and remove some objects.
+        for(size_t i=0; i<500; i+=3)
+        {
+            quads[i] = randomQuad();
+            grid.move(i, quads[i]);
+        }
+        for(size_t i=1; i<500; i+=7)
+        {
+            grid.remove(i);
+            alive[i] = false;
+        }
+        CHECK_EQUAL(500U - 72U, grid.size());
+        // Removed or unknown objects can not be moved.
+        grid.move(1, randomQuad());
+        grid.move(500, randomQuad());
+        CHECK_EQUAL(500U - 72U, grid.size());
+        
+        for(size_t k=0; k<20; k++)
+        {
+            BoundingQuad region = randomQuad();
+            std::vector<size_t> found, expected;
+            grid.query(region, found);
+            for(size_t i=0; i<quads.size(); i++)
+            {
+                if(alive[i] && overlap(quads[i], region)) { expected.push_back(i); }
+            }
+            std::sort(found.begin(), found.end());
+            CHECK(expected == found);
+            
+            BoundingCircle circle(region.getCenter(), 9.0f);
+            found.clear(); expected.clear();
+            grid.query(circle, found);
+            for(size_t i=0; i<quads.size(); i++)
+            {
+                glm::vec2 delta = glm::clamp(circle.getCenter(), quads[i].getMin(), quads[i].getMax()) - circle.getCenter();
+                if(alive[i] && (glm::dot(delta, delta) <= circle.getSquareRadius())) { expected.push_back(i); }
+            }
+            std::sort(found.begin(), found.end());
+            CHECK(expected == found);
+            
+            Ray2 ray(region.getCenter(), glm::circularRand(1.0f));
+            found.clear(); expected.clear();
+            grid.query(ray, 40.0f, found);
+            for(size_t i=0; i<quads.size(); i++)
+            {
+                BoundingQuad segment(glm::min(ray.origin, ray.origin + ray.direction * 40.0f), glm::max(ray.origin, ray.origin + ray.direction * 40.0f));
+                if(alive[i] && quads[i].intersects(ray) && overlap(quads[i], segment))
+                {
+                    // Check that the ray hits the quad before the end of the segment.
+                    glm::vec2 t0 = (quads[i].getMin() - ray.origin) / ray.direction;
+                    glm::vec2 t1 = (quads[i].getMax() - ray.origin) / ray.direction;
+                    glm::vec2 t2 = glm::min(t0, t1);
+                    if(glm::max(t2.x, t2.y) <= 40.0f) { expected.push_back(i); }
+                }
+            }
+            std::sort(found.begin(), found.end());
+            CHECK(expected == found);
+        }
+    }
+    
+    TEST(Pairs)
+    {
+        SpatialGrid grid(8.0f, 256);
+        std::vector<BoundingQuad> quads;
+        for(size_t i=0; i<400; i++)
+        {
+            quads.push_back(randomQuad());
+            grid.insert(quads.back());
+        }
+        // Large object spanning many cells.
+        quads.push_back(BoundingQuad(glm::vec2(-50.0f), glm::vec2(50.0f)));
+        grid.insert(quads.back());
+        
+        std::vector<std::pair<size_t, size_t>> found, expected;
+        grid.pairs(found);
+        for(size_t i=0; i<quads.size(); i++)
+        {
+            for(size_t j=i+1; j<quads.size(); j++)
+            {
+                if(overlap(quads[i], quads[j])) { expected.push_back(std::make_pair(i, j)); }
+            }
+        }
+        CHECK_EQUAL(expected.size(), found.size());
+        CHECK(expected == found);
+    }
+}
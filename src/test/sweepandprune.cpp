@@ -0,0 +1,230 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <set>
+#include <utility>
+#include <glm/gtc/random.hpp>
+#include <DumbFramework/geometry/sweepandprune.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+/** Keep track of reported pairs. **/
+struct PairSet : public SweepAndPrune::Listener
+{
+    PairSet() : changes(0) {}
+    void added(size_t a, size_t b)
+    {
+        CHECK(a < b);
+        CHECK(pairs.insert(std::make_pair(a, b)).second);
+        changes++;
+    }
+    void removed(size_t a, size_t b)
+    {
+        CHECK(a < b);
+        CHECK_EQUAL(1U, pairs.erase(std::make_pair(a, b)));
+        changes++;
+    }
+    std::set<std::pair<size_t, size_t>> pairs;
+    size_t changes;
+};
+
+static BoundingBox randomBox(float size)
+{
+    glm::vec3 center = glm::linearRand(glm::vec3(-size), glm::vec3(size));
+    glm::vec3 extent = glm::linearRand(glm::vec3(0.5f), glm::vec3(4.0f));
+    return BoundingBox(center - extent, center + extent);
+}
+
+static std::set<std::pair<size_t, size_t>> bruteForce(std::vector<BoundingBox> const& boxes, std::vector<bool> const& alive, int axisCount)
+{
+    std::set<std::pair<size_t, size_t>> pairs;
+    for(size_t i=0; i<boxes.size(); i++)
+    {
+        for(size_t j=i+1; j<boxes.size(); j++)
+        {
+            bool overlap = alive[i] && alive[j];
+            for(int k=0; overlap && (k<axisCount); k++)
+            {
+                overlap = (boxes[i].getMin()[k] < boxes[j].getMax()[k]) && (boxes[j].getMin()[k] < boxes[i].getMax()[k]);
+            }
+            if(overlap) { pairs.insert(std::make_pair(i, j)); }
+        }
+    }
+    return pairs;
+}
+
+template <typename sap_t>
+static void run(sap_t& sap, int axisCount)
+{
+    PairSet listener;
+    sap.listener(&listener);
+    
+    std::vector<BoundingBox> boxes;
+    std::vector<bool> alive;
+    for(size_t i=0; i<300; i++)
+    {
+        boxes.push_back(randomBox(40.0f));
+        alive.push_back(true);
+        CHECK_EQUAL(i, sap.insert(boxes.back()));
+    }
+    sap.update();
+    CHECK(bruteForce(boxes, alive, axisCount) == listener.pairs);
+    CHECK_EQUAL(listener.pairs.size(), sap.pairCount());
+    
+    for(int frame=0; frame<20; frame++)
+    {
+        for(size_t i=0; i<boxes.size(); i++)
+        {
+            if(!alive[i]) { continue; }
+            glm::vec3 delta = glm::ballRand(1.5f);
+            boxes[i] = BoundingBox(boxes[i].getMin() + delta, boxes[i].getMax() + delta);
+            sap.move(i, boxes[i]);
+        }
+        // Remove a few overlapping objects at once.
+        if(5 == frame)
+        {
+            for(size_t i=0; i<boxes.size(); i+=11)
+            {
+                sap.remove(i);
+                alive[i] = false;
+            }
+        }
+        if(9 == frame)
+        {
+            // Identifiers of removed objects are reused.
+            for(size_t i=0; i<boxes.size(); i+=11)
+            {
+                BoundingBox box = randomBox(40.0f);
+                size_t id = sap.insert(box);
+                CHECK(!alive[id]);
+                boxes[id] = box;
+                alive[id] = true;
+            }
+        }
+        sap.update();
+        CHECK(bruteForce(boxes, alive, axisCount) == listener.pairs);
+    }
+}
+
+template <typename sap_t>
+static void runQuads(sap_t& sap)
+{
+    PairSet listener;
+    sap.listener(&listener);
+    std::vector<BoundingBox> boxes;
+    std::vector<bool> alive(200, true);
+    for(size_t i=0; i<200; i++)
+    {
+        BoundingBox box = randomBox(30.0f);
+        boxes.push_back(BoundingBox(glm::vec3(glm::vec2(box.getMin()), 0.0f), glm::vec3(glm::vec2(box.getMax()), 0.0f)));
+        sap.insert(BoundingQuad(glm::vec2(box.getMin()), glm::vec2(box.getMax())));
+    }
+    sap.update();
+    CHECK(!listener.pairs.empty());
+    CHECK(bruteForce(boxes, alive, 2) == listener.pairs);
+    
+    for(int frame=0; frame<10; frame++)
+    {
+        for(size_t i=0; i<boxes.size(); i++)
+        {
+            glm::vec3 delta(glm::circularRand(1.5f), 0.0f);
+            boxes[i] = BoundingBox(boxes[i].getMin() + delta, boxes[i].getMax() + delta);
+            sap.move(i, BoundingQuad(glm::vec2(boxes[i].getMin()), glm::vec2(boxes[i].getMax())));
+        }
+        sap.update();
+        CHECK(bruteForce(boxes, alive, 2) == listener.pairs);
+    }
+}
+
+template <typename sap_t>
+static void runRemoveTwice(sap_t& sap)
+{
+    PairSet listener;
+    sap.listener(&listener);
+    size_t a = sap.insert(BoundingBox(glm::vec3(-2.0f), glm::vec3(2.0f)));
+    size_t b = sap.insert(BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f)));
+    size_t c = sap.insert(BoundingBox(glm::vec3(0.0f), glm::vec3(3.0f)));
+    sap.update();
+    CHECK_EQUAL(3U, listener.pairs.size());
+    
+    // Duplicate and unknown identifiers are ignored.
+    sap.remove(b);
+    sap.remove(b);
+    sap.remove(42);
+    sap.update();
+    CHECK_EQUAL(2U, sap.size());
+    CHECK_EQUAL(1U, listener.pairs.size());
+    CHECK(listener.pairs.count(std::make_pair(a, c)));
+    sap.remove(b);
+    sap.move(b, BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f)));
+    sap.update();
+    CHECK_EQUAL(2U, sap.size());
+    CHECK_EQUAL(1U, listener.pairs.size());
+    
+    // The identifier is handed out only once.
+    size_t d = sap.insert(BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f)));
+    size_t e = sap.insert(BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f)));
+    CHECK_EQUAL(b, d);
+    CHECK(d != e);
+    sap.update();
+    CHECK_EQUAL(4U, sap.size());
+    CHECK_EQUAL(6U, listener.pairs.size());
+}
+
+SUITE(SweepAndPrune)
+{
+    TEST(Boxes)
+    {
+        SweepAndPrune sap;
+        run(sap, 3);
+    }
+    
+    TEST(Quads)
+    {
+        SweepAndPrune sap(2);
+        runQuads(sap);
+    }
+    
+    TEST(QuadsDefaultAxis)
+    {
+        // Quads are flat on the third axis.
+        SweepAndPrune sap;
+        runQuads(sap);
+        MultiSweepAndPrune multi(16.0f);
+        runQuads(multi);
+    }
+    
+    TEST(Multi)
+    {
+        MultiSweepAndPrune sap(16.0f);
+        run(sap, 3);
+        CHECK(sap.regionCount() > 1);
+    }
+    
+    TEST(MultiMigration)
+    {
+        MultiSweepAndPrune sap(16.0f);
+        PairSet listener;
+        sap.listener(&listener);
+        sap.insert(BoundingBox(glm::vec3(-40.0f), glm::vec3(40.0f)));
+        size_t id = sap.insert(BoundingBox(glm::vec3(-39.0f), glm::vec3(-38.0f)));
+        sap.update();
+        CHECK_EQUAL(1U, listener.changes);
+        // The small object crosses regions that all hold the large one.
+        for(int i=0; i<5; i++)
+        {
+            float offset = (i * 16.0f) - 32.0f;
+            sap.move(id, BoundingBox(glm::vec3(offset + 1.0f), glm::vec3(offset + 2.0f)));
+            sap.update();
+        }
+        CHECK_EQUAL(1U, listener.changes);
+        CHECK_EQUAL(1U, listener.pairs.size());
+    }
+    
+    TEST(RemoveTwice)
+    {
+        SweepAndPrune sap;
+        runRemoveTwice(sap);
+        MultiSweepAndPrune multi(16.0f);
+        runRemoveTwice(multi);
+    }
+}
@@ -40,4 +40,93 @@ SUITE(Transform)
         CHECK_CLOSE(expected.y, position.y, 0.0001f);
         CHECK_CLOSE(expected.z, position.z, 0.0001f);
     }
+    
+    TEST(Mix)
+    {
+        const size_t count = 37;
+        std::vector<Transform> from(count), to(count), out(count);
+        std::vector<float> t(count);
+        for(size_t i=0; i<count; i++)
+        {
+            from[i] = Transform(glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f)), glm::ballRand(10.0f));
+            to[i]   = Transform(glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f)), glm::ballRand(10.0f));
+            t[i]    = glm::linearRand(0.0f, 1.0f);
+        }
+        mix(&from[0], &to[0], &t[0], &out[0], count);
+        for(size_t i=0; i<count; i++)
+        {
+            // The scalar version does not normalize its result.
+            Transform expected = mix(from[i], to[i], t[i]);
+            glm::fquat q = expected.orientation();
+            float squareLength = glm::dot(q, q);
+            q = glm::normalize(q);
+            glm::vec3 p = expected.position() / squareLength;
+            
+            glm::fquat orientation = out[i].orientation();
+            glm::vec3  position    = out[i].position();
+            CHECK_CLOSE(q.x, orientation.x, 0.0001f);
+            CHECK_CLOSE(q.y, orientation.y, 0.0001f);
+            CHECK_CLOSE(q.z, orientation.z, 0.0001f);
+            CHECK_CLOSE(q.w, orientation.w, 0.0001f);
+            CHECK_CLOSE(p.x, position.x, 0.001f);
+            CHECK_CLOSE(p.y, position.y, 0.001f);
+            CHECK_CLOSE(p.z, position.z, 0.001f);
+        }
+    }
+    
+    TEST(Slerp)
+    {
+        const size_t count = 21;
+        std::vector<Transform> from(count), to(count), out(count);
+        std::vector<float> t(count);
+        for(size_t i=0; i<count; i++)
+        {
+            from[i] = Transform(glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f)), glm::ballRand(10.0f));
+            to[i]   = Transform(glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f)), glm::ballRand(10.0f));
+            t[i]    = glm::linearRand(0.0f, 1.0f);
+        }
+        // Nearly identical orientations.
+        to[3] = Transform(from[3].orientation(), to[3].position());
+        slerp(&from[0], &to[0], &t[0], &out[0], count);
+        for(size_t i=0; i<count; i++)
+        {
+            glm::fquat q = glm::slerp(from[i].orientation(), to[i].orientation(), t[i]);
+            glm::vec3  p = glm::mix(from[i].position(), to[i].position(), t[i]);
+            
+            glm::fquat orientation = out[i].orientation();
+            glm::vec3  position    = out[i].position();
+            CHECK_CLOSE(1.0f, glm::abs(glm::dot(q, orientation)), 0.0001f);
+            CHECK_CLOSE(p.x, position.x, 0.001f);
+            CHECK_CLOSE(p.y, position.y, 0.001f);
+            CHECK_CLOSE(p.z, position.z, 0.001f);
+        }
+    }
+    
+    TEST(Accumulate)
+    {
+        const size_t count = 13;
+        std::vector<Transform> poses(2*count), out(count), expected(count);
+        std::vector<float> t(count, 0.3f);
+        for(size_t i=0; i<poses.size(); i++)
+        {
+            poses[i] = Transform(glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f)), glm::ballRand(10.0f));
+        }
+        float weights[2] = { 0.7f, 0.3f };
+        accumulate(&poses[0], weights, 2, &out[0], count);
+        mix(&poses[0], &poses[count], &t[0], &expected[0], count);
+        for(size_t i=0; i<count; i++)
+        {
+            glm::fquat q = expected[i].orientation();
+            glm::vec3  p = expected[i].position();
+            glm::fquat orientation = out[i].orientation();
+            glm::vec3  position    = out[i].position();
+            CHECK_CLOSE(q.x, orientation.x, 0.0001f);
+            CHECK_CLOSE(q.y, orientation.y, 0.0001f);
+            CHECK_CLOSE(q.z, orientation.z, 0.0001f);
+            CHECK_CLOSE(q.w, orientation.w, 0.0001f);
+            CHECK_CLOSE(p.x, position.x, 0.001f);
+            CHECK_CLOSE(p.y, position.y, 0.001f);
+            CHECK_CLOSE(p.z, position.z, 0.001f);
+        }
+    }
 }
@@ -0,0 +1,128 @@
+#include <UnitTest++/UnitTest++.h>
+#include <vector>
+#include <cstdlib>
+#include <glm/gtc/random.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <DumbFramework/geometry/transformhierarchy.hpp>
+
+using namespace Dumb::Core::Geometry;
+
+static Transform randomTransform()
+{
+    glm::fquat q = glm::angleAxis(glm::linearRand(-3.0f, 3.0f), glm::sphericalRand(1.0f));
+    return Transform(q, glm::ballRand(10.0f));
+}
+
+static glm::mat4 referenceWorld(TransformHierarchy const& hierarchy, std::vector<Transform> const& locals, size_t node)
+{
+    glm::mat4 m(1.0f);
+    for(size_t i=node; TransformHierarchy::None != i; i=hierarchy.parent(i))
+    {
+        m = glm::translate(glm::mat4(1.0f), locals[i].position()) * glm::mat4_cast(locals[i].orientation()) * m;
+    }
+    return m;
+}
+
+static void checkWorld(TransformHierarchy const& hierarchy, std::vector<Transform> const& locals)
+{
+    for(size_t i=0; i<hierarchy.size(); i++)
+    {
+        glm::mat4 expected = referenceWorld(hierarchy, locals, i);
+        glm::mat4 const& world = hierarchy.world(i);
+        for(int j=0; j<4; j++)
+        {
+            for(int k=0; k<4; k++)
+            {
+                CHECK_CLOSE(expected[j][k], world[j][k], 0.001f);
+            }
+        }
+    }
+}
+
+SUITE(TransformHierarchy)
+{
+    TEST(Update)
+    {
+        TransformHierarchy hierarchy;
+        std::vector<Transform> locals;
+        std::vector<size_t> parents;
+        
+        CHECK_EQUAL(TransformHierarchy::None, hierarchy.add(3, Transform()));
+        
+        for(size_t i=0; i<300; i++)
+        {
+            size_t parent = ((i % 7) == 0) ? TransformHierarchy::None : (std::rand() % i);
+            locals.push_back(randomTransform());
+            parents.push_back(parent);
+            size_t node = hierarchy.add(parent, locals.back());
+            CHECK_EQUAL(i, node);
+        }
+        hierarchy.update();
+        for(size_t i=0; i<hierarchy.size(); i++)
+        {
+            CHECK_EQUAL(parents[i], hierarchy.parent(i));
+        }
+        checkWorld(hierarchy, locals);
+        
+        // Move a few nodes.
+        for(size_t i=0; i<5; i++)
+        {
+            size_t node = (std::rand() % locals.size());
+            locals[node] = randomTransform();
+            hierarchy.local(node, locals[node]);
+        }
+        hierarchy.position(17, glm::vec3(1.0f, 2.0f, 3.0f));
+        locals[17].position(glm::vec3(1.0f, 2.0f, 3.0f));
+        hierarchy.update();
+        checkWorld(hierarchy, locals);
+        
+        // Grow hierarchy.
+        for(size_t i=0; i<50; i++)
+        {
+            size_t parent = (std::rand() % locals.size());
+            locals.push_back(randomTransform());
+            hierarchy.add(parent, locals.back());
+        }
+        locals[0] = randomTransform();
+        hierarchy.local(0, locals[0]);
+        hierarchy.update();
+        checkWorld(hierarchy, locals);
+    }
+    
+    TEST(Levels)
+    {
+        TransformHierarchy hierarchy;
+        std::vector<Transform> locals;
+        size_t parent = TransformHierarchy::None;
+        for(size_t i=0; i<4; i++)
+        {
+            locals.push_back(randomTransform());
+            parent = hierarchy.add(parent, locals.back());
+        }
+        locals.push_back(randomTransform());
+        hierarchy.add(1, locals.back());
+        
+        hierarchy.build();
+        CHECK_EQUAL(4U, hierarchy.levelCount());
+        // Compute each level in 2 halves.
+        for(unsigned int level=0; level<hierarchy.levelCount(); level++)
+        {
+            size_t count = hierarchy.prepare(level);
+            hierarchy.compute(count/2, count);
+            hierarchy.compute(0, count/2);
+        }
+        checkWorld(hierarchy, locals);
+        
+        // Only the subtree of node 2 is updated.
+        hierarchy.build();
+        locals[2] = randomTransform();
+        hierarchy.local(2, locals[2]);
+        CHECK_EQUAL(0U, hierarchy.prepare(0));
+        CHECK_EQUAL(0U, hierarchy.prepare(1));
+        CHECK_EQUAL(1U, hierarchy.prepare(2));
+        hierarchy.compute(0, 1);
+        CHECK_EQUAL(1U, hierarchy.prepare(3));
+        hierarchy.compute(0, 1);
+        checkWorld(hierarchy, locals);
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include <DumbFramework/flightrecorder.hpp>
+
+// Print the messages stored in a flight recorder ring file, from the
+// oldest to the newest.
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s ring_file\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Dumb::Log::FlightRecorder::Entry> entries;
+    if(!Dumb::Log::FlightRecorder::read(argv[1], entries))
+    {
+        fprintf(stderr, "%s: not a flight recorder file\n", argv[1]);
+        return 1;
+    }
+
+    for(size_t i=0; i<entries.size(); i++)
+    {
+        std::time_t seconds = (std::time_t)(entries[i].timestamp / 1000000000ULL);
+        unsigned int micro  = (unsigned int)((entries[i].timestamp / 1000ULL) % 1000000ULL);
+        char date[64];
+        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+        printf("%s.%06u %s", date, micro, entries[i].message.c_str());
+        if(entries[i].message.empty() || ('\n' != entries[i].message[entries[i].message.size()-1]))
+        {
+            printf("\n");
+        }
+    }
+    return 0;
+}
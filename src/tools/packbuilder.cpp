@@ -0,0 +1,121 @@
+/*
+ * Copyright 2015 MooZ
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <DumbFramework/pack.hpp>
+
+// Recursively add the regular files of a directory.
+static size_t addDirectory(Dumb::Pack::Builder& builder, std::string const& root, std::string const& relative, Dumb::Pack::Compression compression)
+{
+    std::string directory = relative.empty() ? root : (root + "/" + relative);
+    DIR *dir = opendir(directory.c_str());
+    if(NULL == dir)
+    {
+        fprintf(stderr, "%s: can not open directory\n", directory.c_str());
+        return 0;
+    }
+    size_t count = 0;
+    struct dirent *item;
+    while(NULL != (item = readdir(dir)))
+    {
+        if(('.' == item->d_name[0]) && (('\0' == item->d_name[1]) || (('.' == item->d_name[1]) && ('\0' == item->d_name[2]))))
+        {
+            continue;
+        }
+        std::string path = relative.empty() ? item->d_name : (relative + "/" + item->d_name);
+        std::string filename = root + "/" + path;
+        struct stat infos;
+        if(0 != stat(filename.c_str(), &infos))
+        {
+            continue;
+        }
+        if(S_ISDIR(infos.st_mode))
+        {
+            count += addDirectory(builder, root, path, compression);
+        }
+        else if(S_ISREG(infos.st_mode))
+        {
+            builder.add(path, filename, compression);
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+// Store the files of a directory into a pack. The entry paths are
+// relative to the directory.
+int main(int argc, char** argv)
+{
+    Dumb::Pack::Compression compression = Dumb::Pack::NONE;
+    uint32_t alignment = Dumb::Pack::DefaultAlignment;
+    uint32_t blockSize = Dumb::Pack::DefaultBlockSize;
+    int i;
+    for(i=1; (i<argc) && ('-' == argv[i][0]); i++)
+    {
+        if(0 == strcmp(argv[i], "-z"))
+        {
+            compression = Dumb::Pack::DEFLATE;
+        }
+        else if(0 == strcmp(argv[i], "-l"))
+        {
+            compression = Dumb::Pack::BLOCKS;
+        }
+        else if((0 == strcmp(argv[i], "-b")) && ((i+1) < argc))
+        {
+            blockSize = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if((0 == strcmp(argv[i], "-a")) && ((i+1) < argc))
+        {
+            alignment = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else
+        {
+            break;
+        }
+    }
+    if((argc - i) != 2)
+    {
+        fprintf(stderr, "usage: %s [-z|-l] [-b block_size] [-a alignment] archive directory\n"
+                        "  -z             compress entries with zlib when it saves space\n"
+                        "  -l             compress entries with the fast block codec when it saves space\n"
+                        "  -b block_size  uncompressed block size in bytes (default %u)\n"
+                        "  -a alignment   entry alignment in bytes (default %u)\n",
+                        argv[0], Dumb::Pack::DefaultBlockSize, Dumb::Pack::DefaultAlignment);
+        return 1;
+    }
+
+    std::string root = argv[i+1];
+    while((root.size() > 1) && ('/' == root[root.size()-1]))
+    {
+        root.erase(root.size()-1);
+    }
+    Dumb::Pack::Builder builder;
+    builder.setBlockSize(blockSize);
+    size_t count = addDirectory(builder, root, "", compression);
+    if(!builder.write(argv[i], alignment))
+    {
+        fprintf(stderr, "%s: failed to write archive\n", argv[i]);
+        return 1;
+    }
+    printf("%s: %zu files, %llu bytes stored (%llu bytes)\n", argv[i], count,
+           (unsigned long long)builder.storedSize(), (unsigned long long)builder.originalSize());
+    return 0;
+}